@@ -80,6 +80,7 @@ extern "C"
 #define SERVICE_ID_BATT      0x0D
 //added for proxreporter markel
 #define SERVICE_ID_PROX      0x0E
+#define SERVICE_ID_RECORDER  0x0F
 
 /*********************************************************************
  * MACROS
@@ -98,7 +99,9 @@ extern "C"
 #define ST_ACCEL_READ_EVT                    Event_Id_08         // Add from keyfob
 #define ST_PROXIMITY_EVT                     Event_Id_09         // Add from keyfob
 #define ST_TOGGLE_BUZZER_EVT                 Event_Id_10         // Add from keyfob
-#define ST_CONN_EVT_END_EVT                  Event_Id_30         // Add
+#define ST_REC_SAMPLE_EVT                    Event_Id_11         // Recorder
+#define ST_REC_DOWNLOAD_EVT                  Event_Id_12         // Recorder
+#define ST_ECC_KEYS_EVT                      Event_Id_13         // Pairing keys
 
 #define ST_ALL_EVENTS                        (ST_ICALL_EVT                 | \
                                               ST_QUEUE_EVT                 | \
@@ -112,7 +115,12 @@ extern "C"
                                               ST_ACCEL_READ_EVT            | \
                                               ST_PROXIMITY_EVT             | \
                                               ST_TOGGLE_BUZZER_EVT         | \
-                                              ST_CONN_EVT_END_EVT)
+                                              ST_REC_SAMPLE_EVT            | \
+                                              ST_REC_DOWNLOAD_EVT          | \
+                                              ST_ECC_KEYS_EVT)
+
+// Stack event flags (ICall_Stack_Event event_flag, 16 bits)
+#define ST_CONN_EVT_END_EVT                  0x0001
 
 // sensortagAlertState values from Key Fob
 #define ALERT_STATE_OFF                       0
@@ -0,0 +1,221 @@
+/******************************************************************************
+
+ @file  sensortag_boot.c
+
+ @brief This file contains the Sensor Tag sample application, boot
+        profiler. The time each boot phase is reached is exposed through
+        the Diagnostic service.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef EXCLUDE_BOOT_PROFILE
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <inc/hw_memmap.h>
+#include <driverlib/aon_rtc.h>
+
+#include "bcomdef.h"
+
+#include "diagservice.h"
+#include "sensortag_boot.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Boot profile value of a phase not reached yet
+#define ST_BOOT_NOT_REACHED       0xFFFF
+
+// Largest time that can be reported (milliseconds)
+#define ST_BOOT_MAX_TIME          0xFFFE
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Time (16.16 seconds) at each phase. The AON RTC keeps counting through
+// a system reset, but the kernel clears it again in BIOS_start, after the
+// phases marked in main(). bootRtcOffset carries the time counted before
+// such a clear, so the times keep increasing; they are reported relative
+// to ST_BOOT_MAIN.
+static uint32_t bootTime[ST_BOOT_NUM_PHASES];
+
+// RTC value at the last mark, and the time lost to RTC clears
+static uint32_t bootLastRtc;
+static uint32_t bootRtcOffset;
+
+// Bit map of the phases reached
+static uint16_t bootReached;
+
+static bool bootServiceAdded = false;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SensorTagBoot_publish(void);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SensorTagBoot_init
+ *
+ * @brief   Initialization function for the boot profiler. Adds the
+ *          Diagnostic service and publishes the phases reached so far.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagBoot_init(void)
+{
+  // Add service
+  if (Diag_addService() == SUCCESS)
+  {
+    bootServiceAdded = true;
+
+    SensorTagBoot_publish();
+  }
+}
+
+/*********************************************************************
+ * @fn      SensorTagBoot_mark
+ *
+ * @brief   Record the time a boot phase is reached. Later marks of the
+ *          same phase are ignored. An RTC value below the one of the
+ *          previous mark means the RTC has been cleared in between; the
+ *          time from that mark to the clear is not counted.
+ *
+ * @param   phase - ST_BOOT_MAIN ... ST_BOOT_DEFERRED_INIT
+ *
+ * @return  none
+ */
+void SensorTagBoot_mark(uint8_t phase)
+{
+  uint32_t rtc;
+
+  if ((phase >= ST_BOOT_NUM_PHASES) || (bootReached & (1 << phase)))
+  {
+    return;
+  }
+
+  rtc = AONRTCCurrentCompareValueGet();
+  if (rtc < bootLastRtc)
+  {
+    bootRtcOffset += bootLastRtc;
+  }
+  bootLastRtc = rtc;
+
+  bootTime[phase] = rtc + bootRtcOffset;
+  bootReached |= (1 << phase);
+
+  if (bootServiceAdded)
+  {
+    SensorTagBoot_publish();
+  }
+}
+
+/*********************************************************************
+* Private functions
+*/
+
+/*********************************************************************
+ * @fn      SensorTagBoot_publish
+ *
+ * @brief   Update the boot profile characteristic: for each phase the
+ *          milliseconds since main() was entered, 0xFFFF if the phase
+ *          has not been reached or its time is not after main().
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagBoot_publish(void)
+{
+  uint8_t profile[ST_BOOT_NUM_PHASES * 2];
+  uint8_t i;
+
+  for (i = 0; i < ST_BOOT_NUM_PHASES; i++)
+  {
+    uint16_t ms = ST_BOOT_NOT_REACHED;
+
+    if ((bootReached & (1 << i)) && (bootReached & (1 << ST_BOOT_MAIN)) &&
+        (bootTime[i] >= bootTime[ST_BOOT_MAIN]))
+    {
+      uint32_t elapsed = bootTime[i] - bootTime[ST_BOOT_MAIN];
+      uint32_t elapsedMs = (uint32_t)(((uint64_t)elapsed * 1000) >> 16);
+
+      ms = (elapsedMs > ST_BOOT_MAX_TIME) ? ST_BOOT_MAX_TIME : elapsedMs;
+    }
+
+    profile[i*2] = LO_UINT16(ms);
+    profile[i*2 + 1] = HI_UINT16(ms);
+  }
+
+  Diag_setParameter(DIAG_BOOT_PROFILE, sizeof(profile), profile);
+}
+
+/*********************************************************************
+*********************************************************************/
+#endif // EXCLUDE_BOOT_PROFILE
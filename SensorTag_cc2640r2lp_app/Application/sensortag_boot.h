@@ -0,0 +1,111 @@
+/******************************************************************************
+
+ @file  sensortag_boot.h
+
+ @brief This file contains the Sensor Tag sample application, boot
+        profiler.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef SENSORTAG_BOOT_H
+#define SENSORTAG_BOOT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "sensortag.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Boot phases, in the order they are reached
+#define ST_BOOT_MAIN              0 // main() entered
+#define ST_BOOT_ICALL_INIT        1 // ICall_init() done
+#define ST_BOOT_GAPROLE_TASK      2 // GAPRole_createTask() done
+#define ST_BOOT_APP_TASK          3 // Application task running
+#define ST_BOOT_APP_INIT          4 // SensorTag_init() done
+#define ST_BOOT_STARTED           5 // GAP Role started
+#define ST_BOOT_ADVERTISING       6 // First advertisement
+#define ST_BOOT_DEFERRED_INIT     7 // Deferred initialization done
+#define ST_BOOT_NUM_PHASES        8
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+#ifndef EXCLUDE_BOOT_PROFILE
+/*
+ * Initialization for the Diagnostic Service, publishes the boot profile
+ */
+extern void SensorTagBoot_init(void);
+
+/*
+ * Record the time a boot phase is reached. Only the first time counts.
+ * Callable from main() before the kernel is started.
+ */
+extern void SensorTagBoot_mark(uint8_t phase);
+
+#else
+
+/* Boot profiler not included */
+
+#define SensorTagBoot_init()
+#define SensorTagBoot_mark(phase)
+
+#endif // EXCLUDE_BOOT_PROFILE
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSORTAG_BOOT_H */
@@ -64,7 +64,9 @@
 #include <ti/sysbios/knl/Semaphore.h>
 
 #include "gatt.h"
+#include "linkdb.h"
 #include "gattservapp.h"
+#include "gatt_tx_queue.h"
 #include "sensortag_conn_ctrl.h"
 #include "ccservice.h"
 
@@ -81,6 +83,41 @@
  * CONSTANTS
  */
 
+// Connection parameters while streaming (units of 1.25ms, 8=10ms, 16=20ms)
+#define CC_STREAM_MIN_INTERVAL          8
+#define CC_STREAM_MAX_INTERVAL          16
+#define CC_STREAM_SLAVE_LATENCY         0
+
+// Connection parameters while idle (units of 1.25ms, 400=500ms, 800=1s)
+#define CC_IDLE_MIN_INTERVAL            400
+#define CC_IDLE_MAX_INTERVAL            800
+#define CC_IDLE_SLAVE_LATENCY           3
+
+// Supervision timeout (units of 10ms, 1000=10s). Must exceed
+// (1 + slave latency) * max interval * 2 in both modes.
+#define CC_CONN_TIMEOUT                 1000
+
+// Notifications per evaluation period to enter streaming, and at or below
+// which a period counts as quiet
+#define CC_STREAM_ENTER_RATE            10
+#define CC_STREAM_EXIT_RATE             2
+
+// Quiet periods before streaming falls back to idle
+#define CC_IDLE_HOLD_PERIODS            5
+
+// Periods to wait after connection, leaving room for the update the GAP
+// Role starts itself (DEFAULT_CONN_PAUSE_PERIPHERAL)
+#define CC_START_DELAY_PERIODS          8
+
+// Periods to wait after a failed update, doubled on each failure
+#define CC_BACKOFF_PERIODS              4
+#define CC_BACKOFF_MAX_PERIODS          64
+
+// Policy modes
+#define CC_MODE_NONE                    0
+#define CC_MODE_IDLE                    1
+#define CC_MODE_STREAMING               2
+
 /*******************************************************************************
  * TYPEDEFS
  */
@@ -101,10 +138,25 @@
  * LOCAL VARIABLES
  */
 
+// Connection parameter policy
+static uint16_t ccConnHandle = INVALID_CONNHANDLE;
+static uint8_t ccMode = CC_MODE_NONE;     // Mode last requested
+static uint8_t ccQuietPeriods = 0;
+static uint8_t ccHoldOff = 0;
+static uint8_t ccBackoff = CC_BACKOFF_PERIODS;
+static uint8_t ccFailures = 0;
+static uint8_t ccManual = FALSE;          // Parameters set through CCSERVICE_CHAR2
+static uint16_t ccNotiSent = 0;
+
+// GAP Role parameter update callback
+static gapRolesParamUpdateCB_t ccParamUpdateCB = SensorTagConnControl_paramUpdateCB;
+
 /*******************************************************************************
  * LOCAL FUNCTIONS
  */
 static void ccChangeCB(uint8_t newParamID);
+static uint8_t ccClassifyLoad(uint16_t rate, uint8_t depth);
+static bStatus_t ccRequestMode(uint8_t mode);
 
 /*******************************************************************************
  * PROFILE CALLBACKS
@@ -130,6 +182,9 @@ void SensorTagConnectionControl_init(void)
   // Add service
   CcService_addService();
   CcService_registerAppCBs(&sensorTag_ccCBs);
+
+  // Report parameter updates to the service and the policy
+  GAPRole_RegisterAppCBs(&ccParamUpdateCB);
 }
 
 /*******************************************************************************
@@ -180,6 +235,10 @@ void SensorTagConnControl_processCharChangeEvt(uint8_t paramID)
     // Get new connection parameters
     CcService_getParameter(CCSERVICE_CHAR2, buf);
 
+    // Parameters chosen by the peer take over from the policy until the
+    // connection ends
+    ccManual = TRUE;
+
     // Update connection parameters
     GAPRole_SendUpdateParam(BUILD_UINT16(buf[0],buf[1]),
                             BUILD_UINT16(buf[2],buf[3]), // minConnInterval, maxConnInterval
@@ -221,6 +280,108 @@ void SensorTagConnControl_paramUpdateCB(uint16_t connInterval,
   buf[5] = HI_UINT16(connTimeout);
 
   CcService_setParameter(CCSERVICE_CHAR1,sizeof(buf),buf);
+
+  // An update went through, failures start backing off from scratch
+  ccBackoff = CC_BACKOFF_PERIODS;
+}
+
+/*******************************************************************************
+ * @fn      SensorTagConnControl_processPeriodicEvt
+ *
+ * @brief   Evaluate the link load and request connection parameters to
+ *          match: short intervals while notifications stream or the
+ *          transmit queue holds data, long intervals with slave latency
+ *          once the link has been quiet for a while. Requests use
+ *          GAPROLE_NO_ACTION, so a rejected or timed out update never
+ *          drops the link, and back off exponentially instead.
+ *
+ *          Call once per ST_PERIODIC_EVT_PERIOD. Nothing is done while
+ *          not connected.
+ *
+ * @return  none
+ */
+void SensorTagConnControl_processPeriodicEvt(void)
+{
+  gattTxQueueStats_t stats;
+  uint16_t connHandle;
+  uint16_t rate;
+  uint8_t failures;
+  uint8_t mode;
+
+  GAPRole_GetParameter(GAPROLE_CONNHANDLE, &connHandle);
+  if (connHandle == INVALID_CONNHANDLE)
+  {
+    return;
+  }
+
+  GAPRole_GetParameter(GAPROLE_PARAM_UPDATE_FAILURES, &failures);
+  GATTTxQueue_getStats(&stats);
+
+  if (connHandle != ccConnHandle)
+  {
+    // New connection, start from the parameters negotiated by the GAP Role
+    SensorTagConnControl_reset();
+    ccConnHandle = connHandle;
+    ccFailures = failures;
+    ccNotiSent = stats.notiSent;
+
+    return;
+  }
+
+  rate = stats.notiSent - ccNotiSent;
+  ccNotiSent = stats.notiSent;
+
+  mode = ccClassifyLoad(rate, stats.depth);
+
+  if (failures != ccFailures)
+  {
+    // The last request was rejected or timed out; try again later
+    ccFailures = failures;
+    ccMode = CC_MODE_NONE;
+    ccHoldOff = ccBackoff;
+    ccBackoff = MIN(ccBackoff * 2, CC_BACKOFF_MAX_PERIODS);
+  }
+
+  if (ccHoldOff > 0)
+  {
+    ccHoldOff--;
+  }
+  else if ((ccManual == FALSE) && (mode != ccMode))
+  {
+    bStatus_t status = ccRequestMode(mode);
+
+    if (status == SUCCESS)
+    {
+      ccMode = mode;
+
+      // Give the peer time to answer before looking again
+      ccHoldOff = 1;
+    }
+    else if (status == bleInvalidRange)
+    {
+      // Link already uses these parameters
+      ccMode = mode;
+    }
+  }
+}
+
+/*******************************************************************************
+ * @fn      SensorTagConnControl_reset
+ *
+ * @brief   Reset the connection parameter policy. Parameters set through
+ *          CCSERVICE_CHAR2 and the failure backoff do not carry over to
+ *          the next connection, even if it gets the same handle.
+ *
+ * @return  none
+ */
+void SensorTagConnControl_reset(void)
+{
+  ccConnHandle = INVALID_CONNHANDLE;
+  ccMode = CC_MODE_NONE;
+  ccQuietPeriods = 0;
+  ccHoldOff = CC_START_DELAY_PERIODS;
+  ccBackoff = CC_BACKOFF_PERIODS;
+  ccManual = FALSE;
 }
 
 /*******************************************************************************
@@ -241,6 +402,72 @@ static void ccChangeCB(uint8_t paramID)
   // Wake up the application thread
   SensorTag_charValueChangeCB(SERVICE_ID_CC, paramID);
 }
+
+/*******************************************************************************
+ * @fn      ccClassifyLoad
+ *
+ * @brief   Decide the mode for the last period. Streaming is entered at
+ *          once and left only after CC_IDLE_HOLD_PERIODS quiet periods, so
+ *          short pauses in a stream do not make the link flap.
+ *
+ * @param   rate - notifications sent in the period
+ *
+ * @param   depth - transmit queue depth
+ *
+ * @return  CC_MODE_IDLE or CC_MODE_STREAMING
+ */
+static uint8_t ccClassifyLoad(uint16_t rate, uint8_t depth)
+{
+  if ((rate >= CC_STREAM_ENTER_RATE) || (depth > 0))
+  {
+    ccQuietPeriods = 0;
+
+    return (CC_MODE_STREAMING);
+  }
+
+  if (ccMode != CC_MODE_STREAMING)
+  {
+    return (CC_MODE_IDLE);
+  }
+
+  if (rate > CC_STREAM_EXIT_RATE)
+  {
+    // Between the thresholds, keep streaming
+    ccQuietPeriods = 0;
+  }
+  else if (++ccQuietPeriods >= CC_IDLE_HOLD_PERIODS)
+  {
+    ccQuietPeriods = 0;
+
+    return (CC_MODE_IDLE);
+  }
+
+  return (CC_MODE_STREAMING);
+}
+
+/*******************************************************************************
+ * @fn      ccRequestMode
+ *
+ * @brief   Request the connection parameters of a mode
+ *
+ * @param   mode - CC_MODE_IDLE or CC_MODE_STREAMING
+ *
+ * @return  status of GAPRole_SendUpdateParam
+ */
+static bStatus_t ccRequestMode(uint8_t mode)
+{
+  if (mode == CC_MODE_STREAMING)
+  {
+    return (GAPRole_SendUpdateParam(CC_STREAM_MIN_INTERVAL,
+                                    CC_STREAM_MAX_INTERVAL,
+                                    CC_STREAM_SLAVE_LATENCY, CC_CONN_TIMEOUT,
+                                    GAPROLE_NO_ACTION));
+  }
+
+  return (GAPRole_SendUpdateParam(CC_IDLE_MIN_INTERVAL, CC_IDLE_MAX_INTERVAL,
+                                  CC_IDLE_SLAVE_LATENCY, CC_CONN_TIMEOUT,
+                                  GAPROLE_NO_ACTION));
+}
 #endif // #ifndef EXCLUDE_OAD
 
 /*******************************************************************************
@@ -93,6 +93,16 @@ extern void SensorTagConnControl_processCharChangeEvt(uint8_t paramID);
 void SensorTagConnControl_paramUpdateCB(uint16_t connInterval,
     uint16_t connSlaveLatency, uint16_t connTimeout);
 
+/*
+ * Periodic evaluation of the connection parameter policy
+ */
+extern void SensorTagConnControl_processPeriodicEvt(void);
+
+/*
+ * Reset the connection parameter policy, on connection and disconnection
+ */
+extern void SensorTagConnControl_reset(void);
+
 #else
 
 /* Connection control module only required by OAD */
@@ -101,6 +111,8 @@ void SensorTagConnControl_paramUpdateCB(uint16_t connInterval,
 #define SensorTagConnectionControl_update()
 #define SensorTagConnControl_processCharChangeEvt(paramID)
 #define SensorTagConnControl_paramUpdateCB(connInterval,connSlaveLatency,connTimeout)
+#define SensorTagConnControl_processPeriodicEvt()
+#define SensorTagConnControl_reset()
 
 #endif // #ifndef EXCLUDE_OAD
 
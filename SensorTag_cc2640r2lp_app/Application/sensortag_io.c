@@ -59,6 +59,7 @@
  * INCLUDES
  */
 
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 
 #include "gatt.h"
@@ -129,10 +130,17 @@
 static uint8_t ioMode;
 static uint8_t ioValue;
 
+// LED blinking, driven by the clock
+static Clock_Struct blinkClock;
+static uint8_t blinkLed;
+static uint16_t blinkToggles;  // LED changes left
+static bool blinkOn;
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 static void ioChangeCB(uint8_t newParamID);
+static void SensorTagIO_blinkHandler(UArg arg);
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -162,6 +170,10 @@ void SensorTagIO_init(void)
   Io_addService();
   Io_registerAppCBs(&sensorTag_ioCBs);
 
+  // Create the LED blink clock
+  Util_constructClock(&blinkClock, SensorTagIO_blinkHandler,
+                      BLINK_DURATION, BLINK_DURATION, false, 0);
+
   // Initialize the module's state variables
   ioMode = IO_MODE_LOCAL;
   ioValue = 0;
@@ -317,6 +329,7 @@ void SensorTagIO_reset(void)
   Io_setParameter(SENSOR_CONF, 1, &ioMode);
 
   // Normal mode; make sure LEDs and buzzer are off
+  SensorTagIO_blinkLed(IOID_RED_LED, 0);
   PIN_setOutputValue(hGpioPin, IOID_RED_LED, Board_LED_OFF);
 #ifdef IOID_GREEN_LED
   PIN_setOutputValue(hGpioPin, IOID_GREEN_LED, Board_LED_OFF);
@@ -343,23 +356,47 @@ uint8_t SensorTagIO_GetMode(void)
 /*******************************************************************************
  * @fn      SensorTagIO_blinkLed
  *
- * @brief   Blinks a led 'n' times, duty-cycle 50-50
+ * @brief   Blinks a led 'n' times, duty-cycle 50-50. Returns at once,
+ *          a clock drives the blinking. A blinking still in progress is
+ *          stopped with its led off.
  * @param   led - led identifier
- * @param   nBlinks - number of blinks
+ * @param   nBlinks - number of blinks, 0 only stops the blinking
  *
  * @return  none
  */
 void SensorTagIO_blinkLed(uint8_t led, uint8_t nBlinks)
 {
-  uint8_t i;
+  Util_stopClock(&blinkClock);
+
+  if (blinkToggles > 0)
+  {
+    blinkToggles = 0;
+    PIN_setOutputValue(hGpioPin, blinkLed, Board_LED_OFF);
+  }
 
-  for (i = 0; i<nBlinks; i++)
+  if (nBlinks == 0)
   {
-    PIN_setOutputValue(hGpioPin, led, Board_LED_ON);
-    DELAY_MS(BLINK_DURATION);
-    PIN_setOutputValue(hGpioPin, led, Board_LED_OFF);
-    DELAY_MS(BLINK_DURATION);
+    return;
   }
+
+  blinkLed = led;
+  blinkToggles = (nBlinks * 2) - 1;
+  blinkOn = true;
+  PIN_setOutputValue(hGpioPin, led, Board_LED_ON);
+
+  Util_startClock(&blinkClock);
+}
+
+/*******************************************************************************
+ * @fn      SensorTagIO_isBlinking
+ *
+ * @brief   Whether a led is blinking
+ *
+ * @return  true if blinking
+ */
+bool SensorTagIO_isBlinking(void)
+{
+  return (blinkToggles > 0);
 }
 
 /*********************************************************************
@@ -380,6 +417,32 @@ static void ioChangeCB(uint8_t paramID)
   // Wake up the application thread
   SensorTag_charValueChangeCB(SERVICE_ID_IO, paramID);
 }
+
+/*********************************************************************
+ * @fn      SensorTagIO_blinkHandler
+ *
+ * @brief   Blink clock handler, toggles the led.
+ *
+ * @param   arg - not used
+ *
+ * @return  none
+ */
+static void SensorTagIO_blinkHandler(UArg arg)
+{
+  if (blinkToggles == 0)
+  {
+    return;
+  }
+
+  blinkOn = !blinkOn;
+  PIN_setOutputValue(hGpioPin, blinkLed,
+                     blinkOn ? Board_LED_ON : Board_LED_OFF);
+
+  if (--blinkToggles == 0)
+  {
+    Util_stopClock(&blinkClock);
+  }
+}
 #endif // EXCLUDE_IO
 
 /*********************************************************************
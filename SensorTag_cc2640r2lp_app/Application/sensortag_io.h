@@ -120,10 +120,15 @@ extern void SensorTagIO_processCharChangeEvt(uint8_t paramID);
 extern void SensorTagIO_reset(void);
 
 /*
- * Function to blink LEDs 'n' times
+ * Function to blink LEDs 'n' times, without blocking
  */
 extern void SensorTagIO_blinkLed(uint8_t led, uint8_t nBlinks);
 
+/*
+ * Whether a LED is blinking
+ */
+extern bool SensorTagIO_isBlinking(void);
+
 #else
 
 /* IO module not included */
@@ -132,6 +137,7 @@ extern void SensorTagIO_blinkLed(uint8_t led, uint8_t nBlinks);
 #define SensorTagIO_reset()
 #define SensorTagIO_processCharChangeEvt(paramID)
 #define SensorTagIO_blinkLed(led,nBlinks)
+#define SensorTagIO_isBlinking() (false)
 
 #endif // EXCLUDE_IO
 
@@ -62,6 +62,7 @@
  */
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/knl/Task.h>
 
 #include "gatt.h"
 #include "gattservapp.h"
@@ -259,6 +260,12 @@ void SensorTagKeys_processEvent(void)
       // Indicate that we're entering factory reset
       SensorTagIO_blinkLed(IOID_RED_LED, 10);
 #ifdef FACTORY_IMAGE
+      // Let the blinking finish, applying the image reboots
+      while (SensorTagIO_isBlinking())
+      {
+        Task_sleep(10000 / Clock_tickPeriod);
+      }
+
       // Apply factory image and reboot
       SensorTagFactoryReset_applyFactoryImage();
 #endif
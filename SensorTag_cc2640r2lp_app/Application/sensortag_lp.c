@@ -75,6 +75,8 @@
 #include "gapgattserver.h"
 #include "gattservapp.h"
 #include "gatt_profile_uuid.h"
+#include "gatt_db_hash.h"
+#include "gatt_tx_queue.h"
 #include "gapbondmgr.h"
 #include "osal_snv.h"
 #include "util.h"
@@ -100,6 +102,8 @@
 #endif //FEATURE_OAD || IMAGE_INVALIDATE
 
 #include "sensortag_register.h"
+#include "sensortag_recorder.h"
+#include "sensortag_boot.h"
 
 // On-board devices
 #include "sensortag_keys.h"
@@ -110,10 +114,21 @@
 
 #include "icall_api.h"
 
+#if defined(BLE_V42_FEATURES) && (BLE_V42_FEATURES & SECURE_CONNS_CFG)
+#include "ecc/ECCROMCC26XX.h"
+#include "TRNGCC26XX.h"
+#endif // BLE_V42_FEATURES & SECURE_CONNS_CFG
+
 /*******************************************************************************
  * CONSTANTS
  */
 
+// Precompute the LE Secure Connections key pair while advertising
+#if defined(BLE_V42_FEATURES) && (BLE_V42_FEATURES & SECURE_CONNS_CFG) && \
+    ECCROMCC26XX_STATIC_WORKZONE
+#define ST_PRECOMPUTE_ECC_KEYS
+#endif
+
 //keyfob add
 // Number of beeps before buzzer stops by itself
 #define BUZZER_MAX_BEEPS                      5
@@ -245,10 +260,6 @@ PIN_State pinGpioState;
 PIN_Handle hGpioPin;
 uint32_t events;
 
-// Globals used for ATT Response retransmission added from Project Zero
-static gattMsgEvent_t *pAttRsp = NULL;
-static uint8_t rspTxRetry = 0;
-
 /*******************************************************************************
  * LOCAL VARIABLES
  */
@@ -279,6 +290,9 @@ static Queue_Handle appMsgQueue;
 // self-test result
 static uint8_t selfTestMap;
 
+// Start-up work left until advertising has started
+static bool deferredInitDone = false;
+
 // GAP - SCAN RSP data (max size = 31 bytes)
 static uint8_t scanRspData[] =
 {
@@ -371,6 +385,9 @@ static uint8_t buzzer_beep_count = 0;
 // Accelerometer Profile Parameters
 static uint8_t accelEnabler = FALSE;
 
+// Set while the GATT transmit queue asks producers to hold back data
+static uint8_t txBackpressure = FALSE;
+
 // Pins that are actively used by the application
 static PIN_Config SensortagAppPinTable[] =
 {
@@ -401,18 +418,23 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState) ;
 static void SensorTag_processCharValueChangeEvt(uint8_t serviceID, uint8_t paramID) ;
 static void SensorTag_performPeriodicTask(void);
 static void SensorTag_stateChangeCB(gaprole_States_t newState);
-static void SensorTag_sendAttRsp(void);
-static void SensorTag_freeAttRsp(uint8_t status);
+static void SensorTag_txBackpressureCB(uint8 backpressure);
+static void SensorTag_linkSizeCB(uint16_t connHandle, uint16_t attMtu,
+                                 uint16_t txOctets);
 
 #ifndef FEATURE_OAD_ONCHIP
 void SensorTag_charValueChangeCB(uint8_t serviceID, uint8_t paramID);
 #endif //!FEATURE_OAD_ONCHIP
 
 static void SensorTag_resetAllModules(void);
+static void SensorTag_deferredInit(void);
 static void SensorTag_clockHandler(UArg arg);
 static void SensorTag_enqueueMsg(uint8_t event, uint8_t serviceID, uint8_t paramID);
 static void SensorTag_callback(PIN_Handle handle, PIN_Id pinId);
 static void SensorTag_setDeviceInfo(void);
+#ifdef ST_PRECOMPUTE_ECC_KEYS
+static void SensorTag_precomputeEccKeys(void);
+#endif // ST_PRECOMPUTE_ECC_KEYS
 
 static void SensorTag_performAlert(void);
 static void SensorTag_proximityAttrCB(uint8_t attrParamID);
@@ -433,6 +455,9 @@ static gapRolesCBs_t sensorTag_gapRoleCBs =
   SensorTag_stateChangeCB     // Profile State Change Callbacks
 };
 
+// GAP Role Link Size Callback
+static gapRolesLinkSizeCB_t sensorTag_linkSizeCB = SensorTag_linkSizeCB;
+
 // GAP Bond Manager Callbacks
 static gapBondCBs_t sensorTag_bondMgrCBs =
 {
@@ -587,14 +612,24 @@ static void SensorTag_init(void)
   GGS_SetParameter(GGS_DEVICE_NAME_ATT, GAP_DEVICE_NAME_LEN,
                    (void*)attDeviceName);
 
-  // Set advertising interval
+  // Set advertising interval, in a single round trip to the stack
   {
-    uint16_t advInt = DEFAULT_ADVERTISING_INTERVAL;
+    static const uint8_t advIntParams[] =
+    {
+      TGAP_LIM_DISC_ADV_INT_MIN, TGAP_LIM_DISC_ADV_INT_MAX,
+      TGAP_GEN_DISC_ADV_INT_MIN, TGAP_GEN_DISC_ADV_INT_MAX
+    };
+    icall_liteCall_t calls[sizeof(advIntParams)];
+    uint8_t i;
 
-    GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MIN, advInt);
-    GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MAX, advInt);
-    GAP_SetParamValue(TGAP_GEN_DISC_ADV_INT_MIN, advInt);
-    GAP_SetParamValue(TGAP_GEN_DISC_ADV_INT_MAX, advInt);
+    for (i = 0; i < sizeof(advIntParams); i++)
+    {
+      calls[i].directAPI = IDX_GAP_SetParamValue;
+      calls[i].param[0] = advIntParams[i];
+      calls[i].param[1] = DEFAULT_ADVERTISING_INTERVAL;
+    }
+
+    icall_directAPIBatch(ICALL_SERVICE_CLASS_BLE, calls, sizeof(advIntParams));
   }
 
   // Setup the GAP Bond Manager
@@ -626,6 +661,9 @@ static void SensorTag_init(void)
   SensorTagKeys_init();                           // Simple Keys
   SensorTagIO_init();                             // IO (LED+buzzer+self test)
   SensorTagRegister_init();                       // Register Service
+  SensorTagRecorder_init();                       // Flash sample recorder
+  SensorTagConnectionControl_init();              // Connection Control
+  SensorTagBoot_init();                           // Diagnostic (boot profile)
   //SensorTagOad_init();                          // Over the Air Download
 #ifdef IMAGE_INVALIDATE
   Reset_addService();
@@ -664,15 +702,25 @@ static void SensorTag_init(void)
   // Start the Device
   VOID GAPRole_StartDevice(&sensorTag_gapRoleCBs);
 
+  // Be told about the ATT_MTU and data length negotiated on connection
+  GAPRole_RegisterLinkSizeCB(&sensorTag_linkSizeCB);
+
   // Start Bond Manager
   VOID GAPBondMgr_Register(&sensorTag_bondMgrCBs);
 
+  // Check the GATT database against the one bonded clients have cached
+  VOID GATTDbHash_commit();
+
   // Register with GAP for HCI/Host messages
   GAP_RegisterForMsgs(selfEntityMain); //added by Markel
 
   // Register for GATT local events and ATT Responses pending for transmission
   GATT_RegisterForMsgs(selfEntityMain); //added by Markel
 
+  // Drain the GATT transmit queue on connection event end
+  GATTTxQueue_register(selfEntityMain, ST_CONN_EVT_END_EVT,
+                       SensorTag_txBackpressureCB);
+
   // Enable interrupt handling for keys and relay
   PIN_registerIntCb(hGpioPin, SensorTag_callback);
 }
@@ -690,9 +738,13 @@ static void SensorTag_taskFxn(UArg a0, UArg a1)
 {
 
   //uint32_t events; // re-declared as extern at sensortag.h
+  SensorTagBoot_mark(ST_BOOT_APP_TASK);
+
   // Initialize application
   SensorTag_init();
 
+  SensorTagBoot_mark(ST_BOOT_APP_INIT);
+
   // Application main loop
   for (;;)
   {
@@ -724,8 +776,11 @@ static void SensorTag_taskFxn(UArg a0, UArg a1)
               // Event received when a connection event is completed
               if (pEvt->event_flag & ST_CONN_EVT_END_EVT)
               {
-                  // Try to retransmit pending ATT Response (if any)
-                 SensorTag_sendAttRsp();
+                // Retransmit queued ATT Responses and notifications
+                GATTTxQueue_process();
+
+                // Refill the buffers the connection event freed
+                SensorTagRecorder_processDownloadEvt();
               }
             }
             else // It's a message from the stack and not an event.
@@ -786,6 +841,16 @@ static void SensorTag_taskFxn(UArg a0, UArg a1)
         SensorTagBatt_processSensorEvent();
       }
 
+      if (events & ST_REC_SAMPLE_EVT)
+      {
+        SensorTagRecorder_processSampleEvt();
+      }
+
+      if (events & ST_REC_DOWNLOAD_EVT)
+      {
+        SensorTagRecorder_processDownloadEvt();
+      }
+
       if (!!(events & ST_PERIODIC_EVT))
       {
 
@@ -807,6 +872,14 @@ static void SensorTag_taskFxn(UArg a0, UArg a1)
           SensorTagIO_blinkLed(IOID_GREEN_LED, 1);
         }
       }
+
+#ifdef ST_PRECOMPUTE_ECC_KEYS
+      // Lowest priority, after all other work of this round
+      if (events & ST_ECC_KEYS_EVT)
+      {
+        SensorTag_precomputeEccKeys();
+      }
+#endif // ST_PRECOMPUTE_ECC_KEYS
     }
   } // task loop
 }
@@ -898,7 +971,7 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       uint8_t ownAddress[B_ADDR_LEN];
       uint8_t systemId[DEVINFO_SYSTEM_ID_LEN];
 
-      SensorTagIO_blinkLed(IOID_GREEN_LED, 5);
+      SensorTagBoot_mark(ST_BOOT_STARTED);
 
       GAPRole_GetParameter(GAPROLE_BD_ADDR, ownAddress);
 
@@ -921,6 +994,14 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
     break;
 
   case GAPROLE_ADVERTISING:
+    SensorTagBoot_mark(ST_BOOT_ADVERTISING);
+
+    // Start-up work that need not delay advertising
+    if (!deferredInitDone)
+    {
+      SensorTag_deferredInit();
+    }
+
     // Start the clock
     if (!Util_isActive(&periodicClock))
     {
@@ -929,6 +1010,12 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
 
     // Make sure key presses are not stuck
     SensorTag_updateAdvertisingData(0);
+
+#ifdef ST_PRECOMPUTE_ECC_KEYS
+    // Have a key pair ready before a central starts pairing, computed
+    // once the task has nothing else to do
+    Event_post(syncEvent, ST_ECC_KEYS_EVT);
+#endif // ST_PRECOMPUTE_ECC_KEYS
     break;
 
   case GAPROLE_CONNECTED:
@@ -970,7 +1057,12 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       PIN_setOutputValue(hGpioPin, BP_GLED, Board_LED_OFF);
 #endif
 
+      // New link, start the connection parameter policy afresh
+      SensorTagConnControl_reset();
       SensorTagConnectionControl_update(); //currently EXCLUDE_OAD
+
+      // The central can download the samples now
+      SensorTagRecorder_stop();
     }
     break;
 
@@ -983,6 +1075,9 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       // or advertising timed out
       sensortagProximityState = ST_PROXSTATE_INITIALIZED;
 
+      // Drop whatever was still queued for the link
+      GATTTxQueue_flush(INVALID_CONNHANDLE);
+
       // Turn off immediate alert.
       ProxReporter_SetParameter(PP_IM_ALERT_LEVEL, sizeof(valFalse), &valFalse);
       sensortagProxIMAlertLevel = PP_ALERT_LEVEL_NO;
@@ -1002,6 +1097,11 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       PIN_setOutputValue(hGpioPin, BP_GLED, Board_LED_OFF);
 #endif
       //SensorTag_resetAllModules();
+      SensorTagConnControl_reset();
+
+      // Stop any download and record samples again
+      SensorTagRecorder_reset();
+      SensorTagRecorder_start();
 
       // Stop alert if it was active.
       if(sensortagAlertState != ALERT_STATE_OFF)
@@ -1015,6 +1115,9 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       // The link was dropped due to supervision timeout.
       sensortagProximityState = ST_PROXSTATE_LINK_LOSS;
 
+      // Drop whatever was still queued for the link
+      GATTTxQueue_flush(INVALID_CONNHANDLE);
+
       // Turn off immediate alert
       ProxReporter_SetParameter(PP_IM_ALERT_LEVEL, sizeof(valFalse), &valFalse);
       sensortagProxIMAlertLevel = PP_ALERT_LEVEL_NO;
@@ -1033,6 +1136,10 @@ static void SensorTag_processStateChangeEvt(gaprole_States_t newState)
       }
 
       SensorTag_resetAllModules();
+      SensorTagConnControl_reset();
+
+      // Record samples again
+      SensorTagRecorder_start();
     }
     break;
 
@@ -1097,6 +1204,10 @@ static void SensorTag_processCharValueChangeEvt(uint8_t serviceID,
     SensorTagRegister_processCharChangeEvt(paramID);
     break;
 
+  case SERVICE_ID_RECORDER:
+    SensorTagRecorder_processCharChangeEvt(paramID);
+    break;
+
   case SERVICE_ID_CC:
     SensorTagConnControl_processCharChangeEvt(paramID);
     break;
@@ -1130,6 +1241,11 @@ static uint8_t SensorTag_processStackMsg(ICall_Hdr *pMsg)
       safeToDealloc = SensorTag_processGATTMsg((gattMsgEvent_t *)pMsg);
       break;
 
+    case ICALL_LITE_DIRECT_API_ASYNC_CMD_ID:
+      // Asynchronous stack call completed or turned down, e.g. a notification
+      icall_directAPIAsyncComplete(pMsg);
+      break;
+
     case HCI_GAP_EVENT_EVENT:
     {
         // Process HCI message
@@ -1140,6 +1256,19 @@ static uint8_t SensorTag_processStackMsg(ICall_Hdr *pMsg)
             Log_info0("HCI Command Complete Event received");
             break;
 
+          case HCI_LE_EVENT_CODE:
+            {
+              hciEvt_BLEDataLengthChange_t *pEvt =
+                (hciEvt_BLEDataLengthChange_t *)pMsg;
+
+              if (pEvt->BLEEventCode == HCI_BLE_DATA_LENGTH_CHANGE_EVENT)
+              {
+                GAPRole_DataLenUpdated(pEvt->connHandle, pEvt->maxTxOctets,
+                                       pEvt->maxRxOctets);
+              }
+            }
+            break;
+
           default:
             break;
         }
@@ -1171,18 +1300,14 @@ static uint8_t SensorTag_processGATTMsg(gattMsgEvent_t *pMsg)
 
       // No HCI buffer was available. Let's try to retransmit the response
       // on the next connection event.
-      if (HCI_EXT_ConnEventNoticeCmd(pMsg->connHandle, selfEntityMain,
-                                     ST_CONN_EVT_END_EVT) == SUCCESS)
+      if (GATTTxQueue_enqueueRsp(pMsg) == SUCCESS)
       {
-        // First free any pending response
-        SensorTag_freeAttRsp(FAILURE);
-
-        // Hold on to the response message for retransmission
-        pAttRsp = pMsg;
-
-        // Don't free the response message yet
+        // The queue frees the response message once it is sent
         return (FALSE);
       }
+
+      Log_error1("Gave up message with opcode 0x%02x. Transmit queue full",
+        pMsg->method);
     }
     else if (pMsg->method == ATT_FLOW_CTRL_VIOLATED_EVENT)
     {
@@ -1198,6 +1323,8 @@ static uint8_t SensorTag_processGATTMsg(gattMsgEvent_t *pMsg)
     {
       // MTU size updated
       Log_info1("MTU Size change: %d bytes", pMsg->msg.mtuEvt.MTU);
+
+      GAPRole_MtuUpdated(pMsg->connHandle, pMsg->msg.mtuEvt.MTU);
     }
     else
     {
@@ -1211,89 +1338,49 @@ static uint8_t SensorTag_processGATTMsg(gattMsgEvent_t *pMsg)
     return (TRUE);
 }
 
-/*
- *  Application error handling functions
- *****************************************************************************/
-
-/*
- * @brief   Send a pending ATT response message.
+/*******************************************************************************
+ * @fn      SensorTag_txBackpressureCB
  *
- *          The message is one that the stack was trying to send based on a
- *          peer request, but the response couldn't be sent because the
- *          user application had filled the TX queue with other data.
+ * @brief   Called by the GATT transmit queue when it runs full or has
+ *          drained again. Periodic data is held back meanwhile.
  *
- * @param   none
+ * @param   backpressure - TRUE if producers should hold back data
  *
  * @return  none
  */
-static void SensorTag_sendAttRsp(void)
+static void SensorTag_txBackpressureCB(uint8 backpressure)
 {
-  // See if there's a pending ATT Response to be transmitted
-  if (pAttRsp != NULL)
-  {
-    uint8_t status;
+  gattTxQueueStats_t stats;
 
-    // Increment retransmission count
-    rspTxRetry++;
+  GATTTxQueue_getStats(&stats);
 
-    // Try to retransmit ATT response till either we're successful or
-    // the ATT Client times out (after 30s) and drops the connection.
-    status = GATT_SendRsp(pAttRsp->connHandle, pAttRsp->method, &(pAttRsp->msg));
-    if ((status != blePending) && (status != MSG_BUFFER_NOT_AVAIL))
-    {
-      // Disable connection event end notice
-      HCI_EXT_ConnEventNoticeCmd(pAttRsp->connHandle, selfEntityMain, 0);
+  Log_warning3("TX queue backpressure %d. Depth %d, notifications dropped %d",
+    backpressure, stats.depth, stats.notiDropped);
 
-      // We're done with the response message
-      SensorTag_freeAttRsp(status);
-    }
-    else
-    {
-      // Continue retrying
-      Log_warning2("Retrying message with opcode 0x%02x. Attempt %d",
-        pAttRsp->method, rspTxRetry);
-    }
-  }
+  txBackpressure = backpressure;
 }
 
 
-/*
- * @brief   Free ATT response message.
+/*******************************************************************************
+ * @fn      SensorTag_linkSizeCB
  *
- * @param   status - response transmit status
+ * @brief   Called by the GAP Role when the ATT_MTU or the data length of
+ *          the connection changes. Notifications are read into buffers
+ *          sized by the ATT_MTU, so the profiles need no update.
+ *
+ * @param   connHandle - connection handle
+ * @param   attMtu - ATT_MTU
+ * @param   txOctets - maximum LL transmit payload
  *
  * @return  none
  */
-static void SensorTag_freeAttRsp(uint8_t status)
+static void SensorTag_linkSizeCB(uint16_t connHandle, uint16_t attMtu,
+                                 uint16_t txOctets)
 {
-  // See if there's a pending ATT response message
-  if (pAttRsp != NULL)
-  {
-    // See if the response was sent out successfully
-    if (status == SUCCESS)
-    {
-      Log_info2("Sent message with opcode 0x%02x. Attempt %d",
-        pAttRsp->method, rspTxRetry);
-    }
-    else
-    {
-      Log_error2("Gave up message with opcode 0x%02x. Status: %d",
-        pAttRsp->method, status);
-
-      // Free response payload
-      GATT_bm_free(&pAttRsp->msg, pAttRsp->method);
-    }
-
-    // Free response message
-    ICall_freeMsg(pAttRsp);
-
-    // Reset our globals
-    pAttRsp = NULL;
-    rspTxRetry = 0;
-  }
+  Log_info3("Link size of connection %d: ATT_MTU %d, TX octets %d",
+    connHandle, attMtu, txOctets);
 }
 
-
 /*******************************************************************************
  * @fn      SensorTag_performPeriodicTask
  *
@@ -1306,6 +1393,7 @@ static void SensorTag_freeAttRsp(uint8_t status)
 static void SensorTag_performPeriodicTask(void)
 {
   SensorTagRegister_update();
+  SensorTagConnControl_processPeriodicEvt();
 }
 
 /*******************************************************************************
@@ -1363,10 +1451,97 @@ static void SensorTag_resetAllModules(void)
 {
   SensorTagIO_reset();
   SensorTagRegister_reset();
+  SensorTagRecorder_reset();
   SensorTagBatt_reset();
   SensorTagKeys_reset();
 }
 
+/*******************************************************************************
+ * @fn      SensorTag_deferredInit
+ *
+ * @brief   Start-up work that is not needed to start advertising and
+ *          does not change the GATT database: opening the flash log,
+ *          which may erase and program flash on the stack thread, and
+ *          the start-up blink. Runs when advertising first starts. The
+ *          services are all added in SensorTag_init, so the GATT
+ *          database is complete before a central can connect.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTag_deferredInit(void)
+{
+  deferredInitDone = true;
+
+  // Find the flash log and record samples until a central connects
+  SensorTagRecorder_open();
+  SensorTagRecorder_start();
+
+  SensorTagIO_blinkLed(IOID_GREEN_LED, 5);
+
+  SensorTagBoot_mark(ST_BOOT_DEFERRED_INIT);
+}
+
+#ifdef ST_PRECOMPUTE_ECC_KEYS
+/*******************************************************************************
+ * @fn      SensorTag_precomputeEccKeys
+ *
+ * @brief   Generate the P-256 key pair for the next Secure Connections
+ *          pairing, so that it does not have to be computed (and its
+ *          workzone allocated) while the pairing is in progress. Runs
+ *          on ST_ECC_KEYS_EVT while advertising. The key generation
+ *          blocks the task, so it waits until no other event is
+ *          pending: connection and stack work posted meanwhile goes
+ *          first.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTag_precomputeEccKeys(void)
+{
+  ECCROMCC26XX_Params params;
+  uint8_t randomBits[ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES];
+
+  // The previous pair has not been used yet
+  if (ECCROMCC26XX_hasPrecomputedKeys())
+  {
+    return;
+  }
+
+  // A central has connected and may be pairing; the stack computes the
+  // pair itself then. Advertising again posts the event again.
+  if (gapProfileState != GAPROLE_ADVERTISING)
+  {
+    return;
+  }
+
+  // Let pending work run first and try again after it
+  if (Event_getPostedEvents(syncEvent) != 0)
+  {
+    Event_post(syncEvent, ST_ECC_KEYS_EVT);
+    return;
+  }
+
+  if (TRNGCC26XX_getBytes(NULL, randomBits, sizeof(randomBits))
+      != TRNGCC26XX_STATUS_SUCCESS)
+  {
+    return;
+  }
+
+  ECCROMCC26XX_init();
+  ECCROMCC26XX_Params_init(&params);
+
+  // Leave it to the stack if it is using the ECC driver right now
+  params.timeout = 0;
+
+  ECCROMCC26XX_precomputeKeys(randomBits, &params);
+
+  memset(randomBits, 0, sizeof(randomBits));
+}
+#endif // ST_PRECOMPUTE_ECC_KEYS
+
 /*!*****************************************************************************
  *  @fn         SensorTag_callback
  *
@@ -1676,8 +1851,11 @@ static void SensorTag_processAccelEnablerChangeEvt(void)
     }
     else
     {
-      // Stop the accelerometer
-      Acc_stop();
+      // Stop the accelerometer, unless the recorder samples it
+      if (!SensorTagRecorder_isRecording())
+      {
+        Acc_stop();
+      }
 
       Util_stopClock(&accelReadClock);
     }
@@ -1706,8 +1884,12 @@ static void SensorTag_processAccelReadEvt(void)
         Util_startClock(&accelReadClock);
       }
 
-      // Read accelerometer data.
-      SensorTag_accelRead();
+      // Read accelerometer data, unless the previous samples are still
+      // waiting for a transmit buffer.
+      if (!txBackpressure)
+      {
+        SensorTag_accelRead();
+      }
     }
     else
     {
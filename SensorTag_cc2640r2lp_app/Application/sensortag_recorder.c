@@ -0,0 +1,1049 @@
+/******************************************************************************
+
+ @file  sensortag_recorder.c
+
+ @brief This file contains the Sensor Tag sample application, flash
+        sample recorder.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef EXCLUDE_RECORDER
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Event.h>
+
+#include <inc/hw_memmap.h>
+#include <driverlib/aon_rtc.h>
+#include <driverlib/vims.h>
+
+#include <icall.h>
+#include "bcomdef.h"
+#include "util.h"
+#include "gatt_tx_queue.h"
+
+#include "recorderservice.h"
+#include "sensortag_recorder.h"
+#include "sensortag.h"
+#include "bma250.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Reading within the deadband of the last stored one
+#define ST_REC_NEAR(a, b)         ((((a) - (b)) <= ST_REC_DEADBAND) && \
+                                   (((b) - (a)) <= ST_REC_DEADBAND))
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Flash pages reserved for the log (.recorder in the linker command
+// file). They are used as a ring: when the newest page is full the
+// oldest one is erased and reused, so the pages wear evenly.
+#ifndef ST_REC_NUM_PAGES
+#define ST_REC_NUM_PAGES          3
+#endif
+#define ST_REC_PAGE_SIZE          4096
+
+// How often to sample the accelerometer (milliseconds)
+#ifndef ST_REC_SAMPLE_PERIOD
+#define ST_REC_SAMPLE_PERIOD      1000
+#endif
+
+// A reading within this distance of the last stored one on all axes
+// is not stored
+#define ST_REC_DEADBAND           2
+
+// Samples buffered in RAM before they are written as one record
+#define ST_REC_MAX_SAMPLES        32
+
+// Stack flash wrapper (hal_flash_wrapper.c), appended to the stack's
+// jump table (bleAPItable in ble_dispatch_JT.c). Called through the ICall
+// direct API, the flash operations run on the stack thread, in turn with
+// the stack's own NV operations.
+#define ST_REC_IDX_FLASH_WRITE    240 // HalFlashWrite
+#define ST_REC_IDX_FLASH_ERASE    241 // HalFlashEraseSector
+
+// Page header: magic (2), reserved (2), sequence number (4)
+#define ST_REC_PAGE_MAGIC         0x5243
+#define ST_REC_PAGE_HDR_LEN       8
+#define ST_REC_SEQ_NONE           0xFFFFFFFF
+
+// Record: payload length (1), type (1), payload, CRC-16 (2). A length
+// of 0xFF is erased flash, the end of the records in a page.
+#define ST_REC_REC_HDR_LEN        2
+#define ST_REC_REC_OVERHEAD       4
+#define ST_REC_FREE               0xFF
+
+// Record types
+#define ST_REC_TYPE_BOOT          0x01 // Time
+#define ST_REC_TYPE_ACCEL         0x02 // Time, period, samples
+
+// Time: RTC seconds (4) and 1/65536 seconds (2) since reset
+#define ST_REC_TIME_LEN           6
+
+// Accelerometer record: time of the first sample, sample period in
+// milliseconds (2), then per sample the number of periods skipped since
+// the previous one (1) and x, y, z (1 each)
+#define ST_REC_ACCEL_HDR_LEN      (ST_REC_TIME_LEN + 2)
+#define ST_REC_SAMPLE_LEN         4
+#define ST_REC_MAX_SKIP           0xFF
+#define ST_REC_MAX_PAYLOAD        (ST_REC_ACCEL_HDR_LEN + \
+                                   (ST_REC_MAX_SAMPLES * ST_REC_SAMPLE_LEN))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// The log. Erased and programmed through the flash controller only,
+// the linker leaves it out of the image.
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_SECTION(recorderFlash, ".recorder")
+static volatile const uint8_t recorderFlash[ST_REC_NUM_PAGES][ST_REC_PAGE_SIZE];
+#else
+static volatile const uint8_t recorderFlash[ST_REC_NUM_PAGES][ST_REC_PAGE_SIZE]
+  __attribute__((section(".recorder")));
+#endif
+
+// Sequence number of each page, ST_REC_SEQ_NONE if it holds no log.
+// A log offset is the sequence number times the page size plus the
+// offset in the page, so offsets keep growing as pages are reused.
+static uint32_t recPageSeq[ST_REC_NUM_PAGES];
+
+// Page that takes new records
+static uint8_t recHeadPage;
+static uint32_t recHeadSeq;
+static uint16_t recWriteOffset;
+
+// Record being assembled: header, payload, room for the CRC
+static uint8_t recFrame[ST_REC_REC_OVERHEAD + ST_REC_MAX_PAYLOAD];
+static uint8_t recNumSamples;
+static uint8_t recSkip;
+static int8_t recLast[3];
+
+static bool recOpen;
+static bool recRecording;
+static bool recBootLogged;
+
+// Download state
+static bool recDownloading;
+static uint32_t recDownloadOffset;
+static uint16_t recDownloadConnHandle;
+
+static Clock_Struct sampleClock;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SensorTagRecorder_clockHandler(UArg arg);
+static void recorderChangeCB(uint8_t paramID);
+static void SensorTagRecorder_mount(void);
+static bStatus_t SensorTagRecorder_openPage(uint8_t page, uint32_t seq);
+static bStatus_t SensorTagRecorder_writeRecord(uint8_t type, uint8_t len);
+static void SensorTagRecorder_flushSamples(void);
+static void SensorTagRecorder_eraseLog(void);
+static void SensorTagRecorder_startDownload(uint32_t offset);
+static void SensorTagRecorder_stopDownload(void);
+static uint32_t SensorTagRecorder_oldest(void);
+static uint32_t SensorTagRecorder_end(void);
+static void SensorTagRecorder_updateStatus(void);
+static void SensorTagRecorder_putTime(uint8_t *pBuf);
+static uint16_t SensorTagRecorder_crc16(const uint8_t *pBuf, uint16_t len);
+static uint32_t SensorTagRecorder_disableCache(void);
+static bStatus_t SensorTagRecorder_flashErase(uint8_t page);
+static bStatus_t SensorTagRecorder_flashProgram(uint8_t page, uint16_t offset,
+                                                uint8_t *pBuf, uint16_t len);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+static sensorCBs_t sensorCallbacks =
+{
+  recorderChangeCB,  // Characteristic value change callback
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_init
+ *
+ * @brief   Initialization function for the flash sample recorder. The
+ *          log is found in flash by SensorTagRecorder_open, recording
+ *          starts with SensorTagRecorder_start.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_init(void)
+{
+  // Add service
+  Recorder_addService();
+
+  // Register callbacks with profile
+  Recorder_registerAppCBs(&sensorCallbacks);
+
+  // Create the sample clock
+  Util_constructClock(&sampleClock, SensorTagRecorder_clockHandler,
+                      ST_REC_SAMPLE_PERIOD, ST_REC_SAMPLE_PERIOD, false,
+                      ST_REC_SAMPLE_EVT);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_open
+ *
+ * @brief   Find the log in flash. A blank or foreign region is
+ *          formatted, which erases a page, so this is left out of
+ *          SensorTagRecorder_init.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_open(void)
+{
+  SensorTagRecorder_mount();
+  recOpen = true;
+
+  SensorTagRecorder_updateStatus();
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_processCharChangeEvt
+ *
+ * @brief   Recorder service event handling
+ *
+ * @param   paramID - identifies the characteristic that was changed
+ *
+ * @return  none
+ */
+void SensorTagRecorder_processCharChangeEvt(uint8_t paramID)
+{
+  uint8_t cmd[RECORDER_COMMAND_LEN];
+
+  if (paramID != RECORDER_COMMAND)
+  {
+    return;
+  }
+
+  Recorder_getParameter(RECORDER_COMMAND, cmd);
+
+  switch (cmd[0])
+  {
+  case RECORDER_CMD_STOP:
+    SensorTagRecorder_stopDownload();
+    break;
+
+  case RECORDER_CMD_START:
+    SensorTagRecorder_startDownload(BUILD_UINT32(cmd[1], cmd[2],
+                                                 cmd[3], cmd[4]));
+    break;
+
+  case RECORDER_CMD_ERASE:
+    SensorTagRecorder_stopDownload();
+    SensorTagRecorder_eraseLog();
+    break;
+
+  default:
+    break;
+  }
+
+  SensorTagRecorder_updateStatus();
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_reset
+ *
+ * @brief   Stop a download, typically when a connection is terminated.
+ *          Recording is not affected.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_reset(void)
+{
+  SensorTagRecorder_stopDownload();
+
+  SensorTagRecorder_updateStatus();
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_start
+ *
+ * @brief   Start recording accelerometer samples, once the log is
+ *          open. The first start after a reset logs a boot record,
+ *          which begins a new time base.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_start(void)
+{
+  if (recRecording || !recOpen)
+  {
+    return;
+  }
+
+  if (!recBootLogged)
+  {
+    SensorTagRecorder_putTime(&recFrame[ST_REC_REC_HDR_LEN]);
+    VOID SensorTagRecorder_writeRecord(ST_REC_TYPE_BOOT, ST_REC_TIME_LEN);
+    recBootLogged = true;
+  }
+
+  Acc_init();
+
+  recRecording = true;
+  Util_startClock(&sampleClock);
+
+  SensorTagRecorder_updateStatus();
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_stop
+ *
+ * @brief   Stop recording and write out the buffered samples.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_stop(void)
+{
+  if (!recRecording)
+  {
+    return;
+  }
+
+  Util_stopClock(&sampleClock);
+  recRecording = false;
+
+  SensorTagRecorder_flushSamples();
+
+  Acc_stop();
+
+  SensorTagRecorder_updateStatus();
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_isRecording
+ *
+ * @brief   Whether samples are being recorded. The accelerometer is
+ *          left running for the recorder meanwhile.
+ *
+ * @param   none
+ *
+ * @return  true if recording
+ */
+bool SensorTagRecorder_isRecording(void)
+{
+  return (recRecording);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_processSampleEvt
+ *
+ * @brief   Read the accelerometer and buffer the reading unless it is
+ *          within the deadband of the last stored one. A full buffer
+ *          is written to flash as one record.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_processSampleEvt(void)
+{
+  int8_t x, y, z;
+  uint8_t *pSample;
+
+  if (!recRecording)
+  {
+    return;
+  }
+
+  Acc_readAcc(&x, &y, &z);
+
+  // Skip readings that hardly changed, up to what the count can hold
+  if ((recNumSamples > 0) && (recSkip < ST_REC_MAX_SKIP) &&
+      ST_REC_NEAR(x, recLast[0]) &&
+      ST_REC_NEAR(y, recLast[1]) &&
+      ST_REC_NEAR(z, recLast[2]))
+  {
+    recSkip++;
+    return;
+  }
+
+  if (recNumSamples == 0)
+  {
+    // First sample of a record
+    SensorTagRecorder_putTime(&recFrame[ST_REC_REC_HDR_LEN]);
+    recFrame[ST_REC_REC_HDR_LEN + ST_REC_TIME_LEN] =
+      LO_UINT16(ST_REC_SAMPLE_PERIOD);
+    recFrame[ST_REC_REC_HDR_LEN + ST_REC_TIME_LEN + 1] =
+      HI_UINT16(ST_REC_SAMPLE_PERIOD);
+    recSkip = 0;
+  }
+
+  pSample = &recFrame[ST_REC_REC_HDR_LEN + ST_REC_ACCEL_HDR_LEN +
+                      (recNumSamples * ST_REC_SAMPLE_LEN)];
+  pSample[0] = recSkip;
+  pSample[1] = (uint8_t)x;
+  pSample[2] = (uint8_t)y;
+  pSample[3] = (uint8_t)z;
+
+  recLast[0] = x;
+  recLast[1] = y;
+  recLast[2] = z;
+  recSkip = 0;
+
+  if (++recNumSamples == ST_REC_MAX_SAMPLES)
+  {
+    SensorTagRecorder_flushSamples();
+  }
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_processDownloadEvt
+ *
+ * @brief   Send the log from the download offset until the stack runs
+ *          out of buffers. Called when a download starts and at the end
+ *          of every connection event, which has freed the buffers the
+ *          previous one sent, so every connection event is filled
+ *          without polling. A notification with only the offset marks
+ *          the end of the log and ends the download.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void SensorTagRecorder_processDownloadEvt(void)
+{
+  while (recDownloading)
+  {
+    uint32_t seq = recDownloadOffset / ST_REC_PAGE_SIZE;
+    uint16_t pageOffset = recDownloadOffset % ST_REC_PAGE_SIZE;
+    const uint8_t *pData = NULL;
+    uint16_t len = 0;
+    uint16_t sent;
+    bStatus_t status;
+
+    if (recDownloadOffset < SensorTagRecorder_end())
+    {
+      uint8_t page;
+
+      for (page = 0; page < ST_REC_NUM_PAGES; page++)
+      {
+        if (recPageSeq[page] == seq)
+        {
+          break;
+        }
+      }
+
+      if (page == ST_REC_NUM_PAGES)
+      {
+        // The page was reused or lost, go on with the next one
+        recDownloadOffset = (seq + 1) * ST_REC_PAGE_SIZE;
+        continue;
+      }
+
+      len = ((seq == recHeadSeq) ? recWriteOffset : ST_REC_PAGE_SIZE) -
+            pageOffset;
+      pData = (const uint8_t *)&recorderFlash[page][pageOffset];
+    }
+
+    status = Recorder_sendData(recDownloadOffset, pData, len, &sent);
+    if (status == bleNoResources)
+    {
+      // Go on at the end of the next connection event
+      break;
+    }
+
+    if ((status != SUCCESS) || (len == 0))
+    {
+      // End of the log sent, or the client is gone
+      SensorTagRecorder_stopDownload();
+      SensorTagRecorder_updateStatus();
+      break;
+    }
+
+    recDownloadOffset += sent;
+  }
+}
+
+
+/*********************************************************************
+* Private functions
+*/
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_mount
+ *
+ * @brief   Find the log pages and the end of the newest one. A blank
+ *          or foreign region is formatted.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_mount(void)
+{
+  uint16_t offset;
+  uint8_t page;
+  bool found = false;
+
+  for (page = 0; page < ST_REC_NUM_PAGES; page++)
+  {
+    volatile const uint8_t *pHdr = recorderFlash[page];
+
+    recPageSeq[page] = ST_REC_SEQ_NONE;
+
+    if (BUILD_UINT16(pHdr[0], pHdr[1]) == ST_REC_PAGE_MAGIC)
+    {
+      recPageSeq[page] = BUILD_UINT32(pHdr[4], pHdr[5], pHdr[6], pHdr[7]);
+
+      if (!found || (recPageSeq[page] > recHeadSeq))
+      {
+        recHeadPage = page;
+        recHeadSeq = recPageSeq[page];
+        found = true;
+      }
+    }
+  }
+
+  if (!found)
+  {
+    recHeadPage = 0;
+    recHeadSeq = 0;
+    recWriteOffset = ST_REC_PAGE_SIZE;
+
+    VOID SensorTagRecorder_openPage(0, 0);
+    return;
+  }
+
+  // Walk the records of the newest page. A torn record still has its
+  // length, its CRC tells the reader to drop it.
+  offset = ST_REC_PAGE_HDR_LEN;
+  while ((offset + ST_REC_REC_OVERHEAD <= ST_REC_PAGE_SIZE) &&
+         (recorderFlash[recHeadPage][offset] != ST_REC_FREE))
+  {
+    offset += ST_REC_REC_OVERHEAD + recorderFlash[recHeadPage][offset];
+  }
+
+  recWriteOffset = MIN(offset, ST_REC_PAGE_SIZE);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_openPage
+ *
+ * @brief   Erase a page and make it the newest page of the log.
+ *
+ * @param   page - page to open
+ * @param   seq - sequence number of the page
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t SensorTagRecorder_openPage(uint8_t page, uint32_t seq)
+{
+  uint8_t hdr[ST_REC_PAGE_HDR_LEN];
+
+  // The old contents are gone even if the erase fails
+  recPageSeq[page] = ST_REC_SEQ_NONE;
+
+  if (SensorTagRecorder_flashErase(page) != SUCCESS)
+  {
+    return (FAILURE);
+  }
+
+  hdr[0] = LO_UINT16(ST_REC_PAGE_MAGIC);
+  hdr[1] = HI_UINT16(ST_REC_PAGE_MAGIC);
+  hdr[2] = 0xFF;
+  hdr[3] = 0xFF;
+  hdr[4] = BREAK_UINT32(seq, 0);
+  hdr[5] = BREAK_UINT32(seq, 1);
+  hdr[6] = BREAK_UINT32(seq, 2);
+  hdr[7] = BREAK_UINT32(seq, 3);
+
+  if (SensorTagRecorder_flashProgram(page, 0, hdr, sizeof(hdr)) != SUCCESS)
+  {
+    return (FAILURE);
+  }
+
+  recPageSeq[page] = seq;
+  recHeadPage = page;
+  recHeadSeq = seq;
+  recWriteOffset = ST_REC_PAGE_HDR_LEN;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_writeRecord
+ *
+ * @brief   Append the record assembled in recFrame to the log, moving
+ *          on to the next page of the ring if it does not fit.
+ *
+ * @param   type - record type
+ * @param   len - payload length
+ *
+ * @return  SUCCESS or FAILURE, the record is dropped on failure
+ */
+static bStatus_t SensorTagRecorder_writeRecord(uint8_t type, uint8_t len)
+{
+  uint16_t size = ST_REC_REC_OVERHEAD + len;
+  uint16_t crc;
+
+  if (recWriteOffset + size > ST_REC_PAGE_SIZE)
+  {
+    if (SensorTagRecorder_openPage((recHeadPage + 1) % ST_REC_NUM_PAGES,
+                                   recHeadSeq + 1) != SUCCESS)
+    {
+      return (FAILURE);
+    }
+  }
+
+  recFrame[0] = len;
+  recFrame[1] = type;
+
+  crc = SensorTagRecorder_crc16(recFrame, ST_REC_REC_HDR_LEN + len);
+  recFrame[ST_REC_REC_HDR_LEN + len] = LO_UINT16(crc);
+  recFrame[ST_REC_REC_HDR_LEN + len + 1] = HI_UINT16(crc);
+
+  if (SensorTagRecorder_flashProgram(recHeadPage, recWriteOffset,
+                                     recFrame, size) != SUCCESS)
+  {
+    // Do not write behind a damaged record, start a new page next time
+    recWriteOffset = ST_REC_PAGE_SIZE;
+    return (FAILURE);
+  }
+
+  recWriteOffset += size;
+
+  SensorTagRecorder_updateStatus();
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_flushSamples
+ *
+ * @brief   Write the buffered samples to the log.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_flushSamples(void)
+{
+  if (recNumSamples > 0)
+  {
+    VOID SensorTagRecorder_writeRecord(ST_REC_TYPE_ACCEL,
+                                       ST_REC_ACCEL_HDR_LEN +
+                                       (recNumSamples * ST_REC_SAMPLE_LEN));
+    recNumSamples = 0;
+  }
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_eraseLog
+ *
+ * @brief   Discard the log. Sequence numbers keep counting, so an
+ *          offset held by a client lies before the new log.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_eraseLog(void)
+{
+  uint8_t page;
+
+  recNumSamples = 0;
+
+  for (page = 1; page < ST_REC_NUM_PAGES; page++)
+  {
+    recPageSeq[page] = ST_REC_SEQ_NONE;
+    VOID SensorTagRecorder_flashErase(page);
+  }
+
+  if (SensorTagRecorder_openPage(0, recHeadSeq + 1) != SUCCESS)
+  {
+    // Try the next page with the next record
+    recHeadPage = 0;
+    recWriteOffset = ST_REC_PAGE_SIZE;
+  }
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_startDownload
+ *
+ * @brief   Start sending the log. An offset before the oldest page
+ *          starts there, one past the end only sends the end marker.
+ *          The connection event end notice is held for the client
+ *          meanwhile, it paces the download.
+ *
+ * @param   offset - log offset to resume from
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_startDownload(uint32_t offset)
+{
+  uint32_t oldest = SensorTagRecorder_oldest();
+  uint32_t end = SensorTagRecorder_end();
+
+  if (offset < oldest)
+  {
+    offset = oldest;
+  }
+  else if (offset > end)
+  {
+    offset = end;
+  }
+
+  recDownloadConnHandle = Recorder_getConnHandle();
+  if (GATTTxQueue_holdConnEvt(recDownloadConnHandle, TRUE) != SUCCESS)
+  {
+    // Nothing would drive the download
+    return;
+  }
+
+  recDownloadOffset = offset;
+  recDownloading = true;
+
+  // Fill the first connection event
+  Event_post(syncEvent, ST_REC_DOWNLOAD_EVT);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_stopDownload
+ *
+ * @brief   Stop sending the log.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_stopDownload(void)
+{
+  if (recDownloading)
+  {
+    recDownloading = false;
+
+    VOID GATTTxQueue_holdConnEvt(recDownloadConnHandle, FALSE);
+  }
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_oldest
+ *
+ * @brief   Log offset of the oldest page.
+ *
+ * @param   none
+ *
+ * @return  log offset
+ */
+static uint32_t SensorTagRecorder_oldest(void)
+{
+  uint32_t seq = recHeadSeq;
+  uint8_t page;
+
+  for (page = 0; page < ST_REC_NUM_PAGES; page++)
+  {
+    if (recPageSeq[page] < seq)
+    {
+      seq = recPageSeq[page];
+    }
+  }
+
+  return (seq * ST_REC_PAGE_SIZE);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_end
+ *
+ * @brief   Log offset where the next record goes.
+ *
+ * @param   none
+ *
+ * @return  log offset
+ */
+static uint32_t SensorTagRecorder_end(void)
+{
+  return ((recHeadSeq * ST_REC_PAGE_SIZE) + recWriteOffset);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_updateStatus
+ *
+ * @brief   Update the status read from the control characteristic.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_updateStatus(void)
+{
+  uint8_t status[RECORDER_STATUS_LEN];
+  uint32_t oldest = SensorTagRecorder_oldest();
+  uint32_t end = SensorTagRecorder_end();
+
+  if (recDownloading)
+  {
+    status[0] = RECORDER_STATE_DOWNLOAD;
+  }
+  else if (recRecording)
+  {
+    status[0] = RECORDER_STATE_RECORDING;
+  }
+  else
+  {
+    status[0] = RECORDER_STATE_IDLE;
+  }
+
+  status[1] = BREAK_UINT32(oldest, 0);
+  status[2] = BREAK_UINT32(oldest, 1);
+  status[3] = BREAK_UINT32(oldest, 2);
+  status[4] = BREAK_UINT32(oldest, 3);
+  status[5] = BREAK_UINT32(end, 0);
+  status[6] = BREAK_UINT32(end, 1);
+  status[7] = BREAK_UINT32(end, 2);
+  status[8] = BREAK_UINT32(end, 3);
+
+  Recorder_setParameter(RECORDER_STATUS, sizeof(status), status);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_putTime
+ *
+ * @brief   Store the RTC time since reset as seconds (4) and
+ *          1/65536 seconds (2).
+ *
+ * @param   pBuf - destination
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_putTime(uint8_t *pBuf)
+{
+  uint64_t rtc = AONRTCCurrent64BitValueGet(); // 32.32 format
+  uint32_t sec = (uint32_t)(rtc >> 32);
+  uint16_t frac = (uint16_t)(rtc >> 16);
+
+  pBuf[0] = BREAK_UINT32(sec, 0);
+  pBuf[1] = BREAK_UINT32(sec, 1);
+  pBuf[2] = BREAK_UINT32(sec, 2);
+  pBuf[3] = BREAK_UINT32(sec, 3);
+  pBuf[4] = LO_UINT16(frac);
+  pBuf[5] = HI_UINT16(frac);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_crc16
+ *
+ * @brief   CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+ *
+ * @param   pBuf - data
+ * @param   len - length of the data
+ *
+ * @return  CRC
+ */
+static uint16_t SensorTagRecorder_crc16(const uint8_t *pBuf, uint16_t len)
+{
+  uint16_t crc = 0xFFFF;
+  uint8_t bit;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)(*pBuf++) << 8;
+
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+
+  return (crc);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_disableCache
+ *
+ * @brief   Turn off the flash cache, so reads after an erase or
+ *          program do not return stale lines.
+ *
+ * @param   none
+ *
+ * @return  previous cache mode
+ */
+static uint32_t SensorTagRecorder_disableCache(void)
+{
+  uint32_t mode = VIMSModeGet(VIMS_BASE);
+
+  if (mode != VIMS_MODE_DISABLED)
+  {
+    VIMSModeSet(VIMS_BASE, VIMS_MODE_DISABLED);
+    while (VIMSModeGet(VIMS_BASE) != VIMS_MODE_DISABLED);
+  }
+
+  return (mode);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_flashErase
+ *
+ * @brief   Erase a log page through the stack's flash wrapper, which
+ *          runs it on the stack thread so it can not interleave with
+ *          an SNV operation. The wrapper returns no status, the page
+ *          is read back instead.
+ *
+ * @param   page - log page
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t SensorTagRecorder_flashErase(uint8_t page)
+{
+  uint32_t mode = SensorTagRecorder_disableCache();
+  uint16_t i;
+
+  VOID icall_directAPI(ICALL_SERVICE_CLASS_BLE, ST_REC_IDX_FLASH_ERASE,
+                       (uint32_t)recorderFlash[page]);
+
+  // Read back with the cache still off
+  i = 0;
+  while ((i < ST_REC_PAGE_SIZE) && (recorderFlash[page][i] == 0xFF))
+  {
+    i++;
+  }
+
+  VIMSModeSet(VIMS_BASE, mode);
+
+  return ((i == ST_REC_PAGE_SIZE) ? SUCCESS : FAILURE);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_flashProgram
+ *
+ * @brief   Program bytes of a log page through the stack's flash
+ *          wrapper, see SensorTagRecorder_flashErase.
+ *
+ * @param   page - log page
+ * @param   offset - offset in the page
+ * @param   pBuf - data
+ * @param   len - length of the data
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t SensorTagRecorder_flashProgram(uint8_t page, uint16_t offset,
+                                                uint8_t *pBuf, uint16_t len)
+{
+  uint32_t mode = SensorTagRecorder_disableCache();
+  uint16_t i;
+
+  VOID icall_directAPI(ICALL_SERVICE_CLASS_BLE, ST_REC_IDX_FLASH_WRITE,
+                       (uint32_t)&recorderFlash[page][offset], pBuf, len);
+
+  // Read back with the cache still off
+  i = 0;
+  while ((i < len) && (recorderFlash[page][offset + i] == pBuf[i]))
+  {
+    i++;
+  }
+
+  VIMSModeSet(VIMS_BASE, mode);
+
+  return ((i == len) ? SUCCESS : FAILURE);
+}
+
+/*********************************************************************
+ * @fn      SensorTagRecorder_clockHandler
+ *
+ * @brief   Handler function for clock time-outs.
+ *
+ * @param   arg - event type
+ *
+ * @return  none
+ */
+static void SensorTagRecorder_clockHandler(UArg arg)
+{
+  // Wake up the application.
+  Event_post(syncEvent, arg);
+}
+
+/*********************************************************************
+ * @fn      recorderChangeCB
+ *
+ * @brief   Callback from Recorder Service indicating a value change
+ *
+ * @param   paramID - parameter ID of the value that was changed.
+ *
+ * @return  none
+ */
+static void recorderChangeCB(uint8_t paramID)
+{
+  // Wake up the application thread
+  SensorTag_charValueChangeCB(SERVICE_ID_RECORDER, paramID);
+}
+#endif // EXCLUDE_RECORDER
+
+/*********************************************************************
+*********************************************************************/
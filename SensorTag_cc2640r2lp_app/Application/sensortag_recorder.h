@@ -0,0 +1,142 @@
+/******************************************************************************
+
+ @file  sensortag_recorder.h
+
+ @brief This file contains the Sensor Tag sample application, flash
+        sample recorder.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef SENSORTAG_RECORDER_H
+#define SENSORTAG_RECORDER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "sensortag.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+#ifndef EXCLUDE_RECORDER
+/*
+ * Initialization for the Recorder Service, mounts the flash log
+ */
+extern void SensorTagRecorder_init(void);
+
+/*
+ * Find the log in flash, formatting a blank region
+ */
+extern void SensorTagRecorder_open(void);
+
+/*
+ * Task Event Processor for Recorder Service
+ */
+extern void SensorTagRecorder_processCharChangeEvt(uint8_t paramID);
+
+/*
+ * Reset the Recorder service, any download is stopped
+ */
+extern void SensorTagRecorder_reset(void);
+
+/*
+ * Start recording samples, typically when no central is connected
+ */
+extern void SensorTagRecorder_start(void);
+
+/*
+ * Stop recording samples and write out the buffered ones
+ */
+extern void SensorTagRecorder_stop(void);
+
+/*
+ * Whether samples are being recorded
+ */
+extern bool SensorTagRecorder_isRecording(void);
+
+/*
+ * Take a sample (ST_REC_SAMPLE_EVT)
+ */
+extern void SensorTagRecorder_processSampleEvt(void);
+
+/*
+ * Send the next part of the log (ST_REC_DOWNLOAD_EVT and the connection
+ * event end event)
+ */
+extern void SensorTagRecorder_processDownloadEvt(void);
+
+#else
+
+/* Recorder module not included */
+
+#define SensorTagRecorder_init()
+#define SensorTagRecorder_open()
+#define SensorTagRecorder_processCharChangeEvt(paramID)
+#define SensorTagRecorder_reset()
+#define SensorTagRecorder_start()
+#define SensorTagRecorder_stop()
+#define SensorTagRecorder_isRecording() (false)
+#define SensorTagRecorder_processSampleEvt()
+#define SensorTagRecorder_processDownloadEvt()
+
+#endif // EXCLUDE_RECORDER
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSORTAG_RECORDER_H */
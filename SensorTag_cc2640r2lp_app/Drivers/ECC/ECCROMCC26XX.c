@@ -77,6 +77,20 @@
 // Total buffer size
 #define ECC_BUF_TOTAL_LEN(len)         ((len) + ECC_KEY_OFFSET) 
 
+// Number of key buffers used by key generation and shared secret generation.
+#define ECC_GEN_KEYS_NUM_BUFS          3
+#define ECC_GEN_DHKEY_NUM_BUFS         5
+
+// Total memory needed by an operation: workzone and key buffers.
+#define ECC_OPERATION_LEN(wz, len, n)  ((wz) + ECC_BUF_TOTAL_LEN(len) * (n))
+
+#if ECCROMCC26XX_STATIC_WORKZONE
+// Static workzone size. Fits any NIST P-256 operation with window size 3.
+#define ECC_STATIC_WORKZONE_LEN        ECC_OPERATION_LEN(ECCROMCC26XX_NIST_P256_WORKZONE_LEN_IN_BYTES, \
+                                                         ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES,      \
+                                                         ECC_GEN_DHKEY_NUM_BUFS)
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+
 /*********************************************************************
  * EXTERNS
  */
@@ -114,11 +128,32 @@ extern uint32_t NIST_Curve_P256_Gy;
 // ECC driver semaphore used to synchronize access.
 static Semaphore_Handle ECC_semaphore;
 
+#if ECCROMCC26XX_STATIC_WORKZONE
+// Workzone kept for the lifetime of the application, so that pairing does not
+// need a large heap allocation.
+static uint32_t ECC_workzone[ECC_UINT32_BLK_LEN(ECC_STATIC_WORKZONE_LEN)];
+
+// NIST P-256 key pair computed ahead of time by ECCROMCC26XX_precomputeKeys.
+// Protected by ECC_semaphore.
+static uint8_t ECC_nextPrivateKey[ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES];
+static uint8_t ECC_nextPublicKeyX[ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES];
+static uint8_t ECC_nextPublicKeyY[ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES];
+static volatile uint8_t ECC_nextKeysValid = 0;
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 
 static void ECC_initGlobals(ECCROMCC26XX_CurveParams *pCurve);
+static uint8_t ECC_allocWorkzone(ECCROMCC26XX_Params *params, uint8_t numBufs);
+static void ECC_freeWorkzone(ECCROMCC26XX_Params *params, uint8_t numBufs);
+static int8_t ECC_genKeys(uint8_t *privateKey, uint8_t *publicKeyX,
+                          uint8_t *publicKeyY, ECCROMCC26XX_Params *params);
+#if ECCROMCC26XX_STATIC_WORKZONE
+static uint8_t ECC_isNistP256(ECCROMCC26XX_CurveParams *pCurve);
+static void ECC_clearNextKeys(void);
+#endif // ECCROMCC26XX_STATIC_WORKZONE
 
 /*********************************************************************
  * PUBLIC FUNCTIONS
@@ -186,9 +221,6 @@ int8_t ECCROMCC26XX_genKeys(uint8_t *privateKey, uint8_t *publicKeyX,
                             uint8_t *publicKeyY, ECCROMCC26XX_Params *params)
 {
   int8_t  status;
-  uint8_t *randStrBuf;
-  uint8_t *pubKeyXBuf;
-  uint8_t *pubKeyYBuf;
   
   // Check key buffers and params.
   if (privateKey == NULL || publicKeyX == NULL || publicKeyY == NULL || 
@@ -215,66 +247,109 @@ int8_t ECCROMCC26XX_genKeys(uint8_t *privateKey, uint8_t *publicKeyX,
     return ECCROMCC26XX_STATUS_TIMEOUT;
   }
   
-  // Allocate total memory for operation: workzone and 3 buffers
-  if (!(eccRom_workzone = (uint32_t *)params->malloc(params->curve.workzoneLen + ECC_BUF_TOTAL_LEN(params->curve.keyLen) * 3)))
+#if ECCROMCC26XX_STATIC_WORKZONE
+  // Hand out the precomputed key pair if there is one for this curve. The
+  // client's random string is replaced by the precomputed private key.
+  if (ECC_nextKeysValid && ECC_isNistP256(&params->curve))
   {
-    // Post Semaphore.
-    Semaphore_post(ECC_semaphore);
+    memcpy(privateKey, ECC_nextPrivateKey, params->curve.keyLen);
+    memcpy(publicKeyX, ECC_nextPublicKeyX, params->curve.keyLen);
+    memcpy(publicKeyY, ECC_nextPublicKeyY, params->curve.keyLen);
     
-    // Store status.
-    params->status = ECCROMCC26XX_STATUS_MALLOC_FAIL;
+    // A key pair is only handed out once.
+    ECC_clearNextKeys();
     
-    return ECCROMCC26XX_STATUS_MALLOC_FAIL;
+    status = ECCROMCC26XX_STATUS_SUCCESS;
+  }
+  else
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+  {
+    status = ECC_genKeys(privateKey, publicKeyX, publicKeyY, params);
   }
   
-  // Split allocated memory into buffers
-  randStrBuf = (uint8_t *) eccRom_workzone + params->curve.workzoneLen;
-  pubKeyXBuf = randStrBuf + ECC_BUF_TOTAL_LEN(params->curve.keyLen);
-  pubKeyYBuf = pubKeyXBuf + ECC_BUF_TOTAL_LEN(params->curve.keyLen);
-
-  // Initialize ECC curve and globals.
-  ECC_initGlobals(&params->curve);
-    
-  // Set length of keys in words in the first word of each buffer.
-  *((uint32_t *)&randStrBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
-  *((uint32_t *)&pubKeyXBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
-  *((uint32_t *)&pubKeyYBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
-  
-  // Copy in random string at key start offset.
-  memcpy(randStrBuf + ECC_KEY_OFFSET, privateKey, params->curve.keyLen);
+  // Post Semaphore.
+  Semaphore_post(ECC_semaphore);
   
-  // Generate ECC private/public key pair.
-  // Note: the random string is an exact copy of the private key.
-  status = eccRom_genKeys((uint32_t *)randStrBuf, 
-                          (uint32_t *)randStrBuf, 
-                          (uint32_t *)pubKeyXBuf, 
-                          (uint32_t *)pubKeyYBuf);
+  // Store status.
+  params->status = status;
   
-  // Move ECC buffer values to client buffers.
-  memcpy(publicKeyX, pubKeyXBuf + ECC_KEY_OFFSET, params->curve.keyLen);
-  memcpy(publicKeyY, pubKeyYBuf + ECC_KEY_OFFSET, params->curve.keyLen);
+  return status;
+}
+
+#if ECCROMCC26XX_STATIC_WORKZONE
+/*
+ *  ======== ECCROMCC26XX_precomputeKeys ========
+ */
+int8_t ECCROMCC26XX_precomputeKeys(uint8_t *privateKey,
+                                   ECCROMCC26XX_Params *params)
+{
+  int8_t status;
   
-  // zero out workzone and 3 buffers as a precautionary measure.
-  memset(eccRom_workzone, 0x00, params->curve.workzoneLen + params->curve.keyLen * 3);
+  // Check key buffer and params. Only NIST P-256 key pairs are kept.
+  if (privateKey == NULL || params == NULL || 
+      !ECC_isNistP256(&params->curve))
+  {
+    // Store status.
+    if (params)
+    {
+      params->status = ECCROMCC26XX_STATUS_ILLEGAL_PARAM;
+    }
+    
+    return ECCROMCC26XX_STATUS_ILLEGAL_PARAM;
+  }
   
-  // Free allocated memory.
-  params->free((uint8_t *)eccRom_workzone);
+  // Pend on Semaphore.
+  params->status = Semaphore_pend(ECC_semaphore, params->timeout);
   
-  // Post Semaphore.
-  Semaphore_post(ECC_semaphore);
+  // If execution returned due to a timeout
+  if (!params->status)
+  {
+    // Store status.
+    params->status = ECCROMCC26XX_STATUS_TIMEOUT;
+    
+    return ECCROMCC26XX_STATUS_TIMEOUT;
+  }
   
-  // Map success code.
-  if (((uint8_t)status) == ECCROMCC26XX_STATUS_ECDH_KEYGEN_OK)
+  // Keep the key pair already waiting to be used.
+  if (ECC_nextKeysValid)
   {
     status = ECCROMCC26XX_STATUS_SUCCESS;
   }
+  else
+  {
+    memcpy(ECC_nextPrivateKey, privateKey, params->curve.keyLen);
+    
+    status = ECC_genKeys(ECC_nextPrivateKey, ECC_nextPublicKeyX,
+                         ECC_nextPublicKeyY, params);
     
+    if (status == ECCROMCC26XX_STATUS_SUCCESS)
+    {
+      ECC_nextKeysValid = 1;
+    }
+    else
+    {
+      ECC_clearNextKeys();
+    }
+  }
+  
+  // Post Semaphore.
+  Semaphore_post(ECC_semaphore);
+  
   // Store status.
   params->status = status;
   
   return status;
 }
 
+/*
+ *  ======== ECCROMCC26XX_hasPrecomputedKeys ========
+ */
+uint8_t ECCROMCC26XX_hasPrecomputedKeys(void)
+{
+  return ECC_nextKeysValid;
+}
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+
 /*
  *  ======== ECCROMCC26XX_genDHKey ========
  */
@@ -315,8 +390,8 @@ int8_t ECCROMCC26XX_genDHKey(uint8_t *privateKey, uint8_t *publicKeyX,
     return ECCROMCC26XX_STATUS_TIMEOUT;
   }
   
-  // Allocate total memory for operation: workzone and 5 key buffers.
-  if (!(eccRom_workzone = (uint32_t *)params->malloc(params->curve.workzoneLen + ECC_BUF_TOTAL_LEN(params->curve.keyLen) * 5)))
+  // Get memory for operation: workzone and 5 key buffers.
+  if (!ECC_allocWorkzone(params, ECC_GEN_DHKEY_NUM_BUFS))
   {
     // Post Semaphore.
     Semaphore_post(ECC_semaphore);
@@ -360,11 +435,8 @@ int8_t ECCROMCC26XX_genDHKey(uint8_t *privateKey, uint8_t *publicKeyX,
   memcpy(dHKeyX, DHKeyXBuf + ECC_KEY_OFFSET, params->curve.keyLen);
   memcpy(dHKeyY, DHKeyYBuf + ECC_KEY_OFFSET, params->curve.keyLen);
 
- // zero out workzone and 5 buffers as a precautionary measure.
-  memset(eccRom_workzone, 0x00, params->curve.workzoneLen + params->curve.keyLen * 5);
-  
-  // Free allocated memory.
-  params->free((uint8_t *)eccRom_workzone);
+  // Clear and release workzone and 5 buffers.
+  ECC_freeWorkzone(params, ECC_GEN_DHKEY_NUM_BUFS);
   
   // Post Semaphore.
   Semaphore_post(ECC_semaphore);
@@ -397,3 +469,146 @@ static void ECC_initGlobals(ECCROMCC26XX_CurveParams *pCurve)
   // Initialize window size
   eccRom_windowSize = pCurve->windowSize;
 }
+
+/*
+ *  ======== ECC_allocWorkzone ========
+ */
+static uint8_t ECC_allocWorkzone(ECCROMCC26XX_Params *params, uint8_t numBufs)
+{
+  uint16_t len = ECC_OPERATION_LEN(params->curve.workzoneLen,
+                                   params->curve.keyLen, numBufs);
+  
+#if ECCROMCC26XX_STATIC_WORKZONE
+  // Use the static workzone when the operation fits.
+  if (len <= sizeof(ECC_workzone))
+  {
+    eccRom_workzone = ECC_workzone;
+    
+    return (1);
+  }
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+  
+  if (params->malloc == NULL)
+  {
+    eccRom_workzone = NULL;
+  }
+  else
+  {
+    eccRom_workzone = (uint32_t *)params->malloc(len);
+  }
+  
+  return (eccRom_workzone != NULL);
+}
+
+/*
+ *  ======== ECC_freeWorkzone ========
+ */
+static void ECC_freeWorkzone(ECCROMCC26XX_Params *params, uint8_t numBufs)
+{
+  // zero out workzone and buffers as a precautionary measure.
+  memset(eccRom_workzone, 0x00, ECC_OPERATION_LEN(params->curve.workzoneLen,
+                                                  params->curve.keyLen,
+                                                  numBufs));
+  
+#if ECCROMCC26XX_STATIC_WORKZONE
+  if (eccRom_workzone == ECC_workzone)
+  {
+    return;
+  }
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+  
+  // Free allocated memory.
+  params->free((uint8_t *)eccRom_workzone);
+}
+
+/*
+ *  ======== ECC_genKeys ========
+ *
+ *  Generate a key pair. Must be called with ECC_semaphore taken.
+ */
+static int8_t ECC_genKeys(uint8_t *privateKey, uint8_t *publicKeyX,
+                          uint8_t *publicKeyY, ECCROMCC26XX_Params *params)
+{
+  int8_t  status;
+  uint8_t *randStrBuf;
+  uint8_t *pubKeyXBuf;
+  uint8_t *pubKeyYBuf;
+  
+  // Get memory for operation: workzone and 3 buffers
+  if (!ECC_allocWorkzone(params, ECC_GEN_KEYS_NUM_BUFS))
+  {
+    return ECCROMCC26XX_STATUS_MALLOC_FAIL;
+  }
+  
+  // Split allocated memory into buffers
+  randStrBuf = (uint8_t *) eccRom_workzone + params->curve.workzoneLen;
+  pubKeyXBuf = randStrBuf + ECC_BUF_TOTAL_LEN(params->curve.keyLen);
+  pubKeyYBuf = pubKeyXBuf + ECC_BUF_TOTAL_LEN(params->curve.keyLen);
+
+  // Initialize ECC curve and globals.
+  ECC_initGlobals(&params->curve);
+    
+  // Set length of keys in words in the first word of each buffer.
+  *((uint32_t *)&randStrBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
+  *((uint32_t *)&pubKeyXBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
+  *((uint32_t *)&pubKeyYBuf[ECC_KEY_LEN_OFFSET]) = (uint32_t)(ECC_UINT32_BLK_LEN(params->curve.keyLen));
+  
+  // Copy in random string at key start offset.
+  memcpy(randStrBuf + ECC_KEY_OFFSET, privateKey, params->curve.keyLen);
+  
+  // Generate ECC private/public key pair.
+  // Note: the random string is an exact copy of the private key.
+  status = eccRom_genKeys((uint32_t *)randStrBuf, 
+                          (uint32_t *)randStrBuf, 
+                          (uint32_t *)pubKeyXBuf, 
+                          (uint32_t *)pubKeyYBuf);
+  
+  // Move ECC buffer values to client buffers.
+  memcpy(publicKeyX, pubKeyXBuf + ECC_KEY_OFFSET, params->curve.keyLen);
+  memcpy(publicKeyY, pubKeyYBuf + ECC_KEY_OFFSET, params->curve.keyLen);
+  
+  // Clear and release workzone and 3 buffers.
+  ECC_freeWorkzone(params, ECC_GEN_KEYS_NUM_BUFS);
+  
+  // Map success code.
+  if (((uint8_t)status) == ECCROMCC26XX_STATUS_ECDH_KEYGEN_OK)
+  {
+    status = ECCROMCC26XX_STATUS_SUCCESS;
+  }
+  
+  return status;
+}
+
+#if ECCROMCC26XX_STATIC_WORKZONE
+/*
+ *  ======== ECC_isNistP256 ========
+ *
+ *  Check that a curve is the default NIST P-256 curve from ROM, which the
+ *  static workzone and the precomputed key pair are sized for.
+ */
+static uint8_t ECC_isNistP256(ECCROMCC26XX_CurveParams *pCurve)
+{
+  return (pCurve->keyLen      == ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES      &&
+          pCurve->workzoneLen == ECCROMCC26XX_NIST_P256_WORKZONE_LEN_IN_BYTES &&
+          pCurve->windowSize  == ECC_WINDOW_SIZE                              &&
+          pCurve->param_p     == &NIST_Curve_P256_p                           &&
+          pCurve->param_r     == &NIST_Curve_P256_r                           &&
+          pCurve->param_a     == &NIST_Curve_P256_a                           &&
+          pCurve->param_b     == &NIST_Curve_P256_b                           &&
+          pCurve->param_gx    == &NIST_Curve_P256_Gx                          &&
+          pCurve->param_gy    == &NIST_Curve_P256_Gy);
+}
+
+/*
+ *  ======== ECC_clearNextKeys ========
+ */
+static void ECC_clearNextKeys(void)
+{
+  ECC_nextKeysValid = 0;
+  
+  // zero out the private key as a precautionary measure.
+  memset(ECC_nextPrivateKey, 0x00, sizeof(ECC_nextPrivateKey));
+  memset(ECC_nextPublicKeyX, 0x00, sizeof(ECC_nextPublicKeyX));
+  memset(ECC_nextPublicKeyY, 0x00, sizeof(ECC_nextPublicKeyY));
+}
+#endif // ECCROMCC26XX_STATIC_WORKZONE
@@ -181,6 +181,25 @@
  *
  *  @endcode
  *  .
+ *  ### Precomputed key pairs #
+ *  With ECCROMCC26XX_STATIC_WORKZONE set (the default), NIST P-256 operations
+ *  use a statically allocated workzone instead of the malloc callback, and a
+ *  key pair can be computed ahead of time with ECCROMCC26XX_precomputeKeys(),
+ *  for instance while advertising.  The next ECCROMCC26XX_genKeys() call for
+ *  NIST P-256 then returns that pair at once, copying its private key over the
+ *  random string passed in.  A precomputed pair is only handed out once.
+ *
+ *  @code
+ *  uint8_t randomBits[32];
+ *
+ *  if (!ECCROMCC26XX_hasPrecomputedKeys())
+ *  {
+ *      myRandomNumberGenerator(randomBits, 32);
+ *      ECCROMCC26XX_precomputeKeys(randomBits, &params);
+ *      memset(randomBits, 0, 32);
+ *  }
+ *  @endcode
+ *  .
  *  ### Supported transaction modes #
  *  - All key generation functions are blocking.
  *  .
@@ -197,6 +216,8 @@
  *  | ECCROMCC26XX_Params_init()     | Initialize parameters for Key Generation          |
  *  | ECCROMCC26XX_genKeys()         | Generate Public Key X and Y Coordinates           |
  *  | ECCROMCC26XX_genDHKey()        | Generate Diffie-Hellman Shared Secret             |
+ *  | ECCROMCC26XX_precomputeKeys()  | Generate the next NIST P-256 key pair ahead       |
+ *  | ECCROMCC26XX_hasPrecomputedKeys() | Check if a precomputed key pair is waiting     |
  *
  *  ## Unsupported functions:
  *  Functionality that currently not supported:
@@ -278,6 +299,15 @@ extern "C" {
  */
 #define ECCROMCC26XX_NIST_P256_KEY_LEN_IN_BYTES                32
 
+/*!
+ * Keep a static workzone for NIST P-256 operations and allow a key pair to be
+ * precomputed.  Costs about 960 bytes of RAM.  Set to 0 to malloc the workzone
+ * for every operation.
+ */
+#ifndef ECCROMCC26XX_STATIC_WORKZONE
+#define ECCROMCC26XX_STATIC_WORKZONE                           1
+#endif
+
 /*! 
  * @brief Compute ECC workzone length in bytes for a generic key length and window size
  *
@@ -377,6 +407,8 @@ void ECCROMCC26XX_Params_init(ECCROMCC26XX_Params *params);
  *          timeout is set to 0.
  *
  *  @param  privateKey      32 byte input buffer of randomly generated bits.
+ *                          Overwritten with the private key of the
+ *                          precomputed pair when one is used.
  *
  *  @param  publicKeyX      32 byte output buffer provided by client to store
  *                          Public Key X Coordinate.
@@ -423,6 +455,37 @@ int8_t ECCROMCC26XX_genDHKey(uint8_t *privateKey, uint8_t *publicKeyX,
                              uint8_t *publicKeyY, uint8_t *dHKeyX, 
                              uint8_t *dHKeyY, ECCROMCC26XX_Params *params);
 
+#if ECCROMCC26XX_STATIC_WORKZONE
+/*!
+ *  @brief  Generate the NIST P-256 key pair returned by the next call to
+ *          ECCROMCC26XX_genKeys().  Does nothing if a precomputed pair is
+ *          already waiting.
+ *
+ *  @pre    ECCROMCC26XX_init must be called prior to this and params must be 
+ *          intiliazed with ECCROMCC26XX_Params_init().
+ *          Calling context: Task.
+ *
+ *  @param  privateKey      32 byte input buffer of randomly generated bits.
+ *
+ *  @param  params          Pointer to a parameter block using the NIST P-256
+ *                          curve, if NULL operation will fail.  malloc and
+ *                          free are not used.
+ *
+ *  @return status
+ */
+int8_t ECCROMCC26XX_precomputeKeys(uint8_t *privateKey,
+                                   ECCROMCC26XX_Params *params);
+
+/*!
+ *  @brief  Check if a precomputed key pair is waiting to be used.
+ *
+ *  @pre    Calling context: Hwi, Swi and Task.
+ *
+ *  @return 1 if a key pair is waiting, 0 otherwise.
+ */
+uint8_t ECCROMCC26XX_hasPrecomputedKeys(void);
+#endif // ECCROMCC26XX_STATIC_WORKZONE
+
 #ifdef __cplusplus
 }
 #endif
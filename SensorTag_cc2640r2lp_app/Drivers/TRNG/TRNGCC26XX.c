@@ -50,11 +50,14 @@
  */
 #include <stdint.h>
 
+#include <string.h>
+
 #include <ti/sysbios/family/arm/m3/Hwi.h>
 
 #include <ti/drivers/Power.h>
 #include <ti/drivers/power/PowerCC26XX.h>
 
+#include <inc/hw_ints.h>
 #include <driverlib/trng.h>
 #include <TRNGCC26XX.h>
 
@@ -78,9 +81,29 @@
 #define TRNGCC26XX_IS_NOT_INITIALIZED 0
 #define TRNGCC26XX_IS_INITIALIZED     1
 
+// Entropy pool. Default requests are served from the pool, which the TRNG
+// interrupt refills once it drops below the low water mark. 0 disables the
+// pool. The number of words must be a power of two up to 128.
+#ifndef TRNGCC26XX_POOL_WORDS
+#define TRNGCC26XX_POOL_WORDS                 16
+#endif
+#define TRNGCC26XX_POOL_LOW                   (TRNGCC26XX_POOL_WORDS / 2)
+#define TRNGCC26XX_POOL_MASK                  (TRNGCC26XX_POOL_WORDS - 1)
+
 /*******************************************************************************
  * LOCAL VARIABLES
  */
+#if TRNGCC26XX_POOL_WORDS > 0
+static Hwi_Struct trngHwi;
+static uint8_t trngHwiConstructed = FALSE;
+
+// The interrupt only advances the head, takers only advance the tail. The
+// indices run freely, the difference is the number of pooled words.
+static uint32_t trngPool[TRNGCC26XX_POOL_WORDS];
+static volatile uint8_t trngPoolHead = 0;
+static volatile uint8_t trngPoolTail = 0;
+static volatile uint8_t trngRefilling = FALSE;
+#endif // TRNGCC26XX_POOL_WORDS
 
 /*******************************************************************************
  * GLOBAL VARIABLES
@@ -98,6 +121,14 @@ extern const TRNGCC26XX_Config TRNGCC26XX_config[];
 void closeTRNG(TRNGCC26XX_Handle handle);
 void openTRNG(TRNGCC26XX_Handle handle);
 
+#if TRNGCC26XX_POOL_WORDS > 0
+static uint8_t isDefaultParams(TRNGCC26XX_Params *params);
+static uint8_t takeFromPool(uint32_t *pValue);
+static void startRefill(void);
+static void stopRefill(void);
+static void trngHwiFxn(UArg arg);
+#endif // TRNGCC26XX_POOL_WORDS
+
 /*******************************************************************************
  * PUBLIC FUNCTIONS
  */
@@ -118,6 +149,17 @@ void TRNGCC26XX_init(void)
     // Intialize internal state of TRNG Peripherals to closed.
     ((TRNGCC26XX_Object *)(TRNGCC26XX_config[TRNGCC26XXX_PERIPHERAL_0_INDEX].object))->state = TRNGCC26XX_CLOSED;
 
+#if TRNGCC26XX_POOL_WORDS > 0
+    {
+      Hwi_Params hwiParams;
+
+      // Refill the pool from a lowest priority interrupt.
+      Hwi_Params_init(&hwiParams);
+      Hwi_construct(&trngHwi, INT_TRNG_IRQ, trngHwiFxn, &hwiParams, NULL);
+      trngHwiConstructed = TRUE;
+    }
+#endif // TRNGCC26XX_POOL_WORDS
+
     isInit = TRNGCC26XX_IS_INITIALIZED;
   }
 
@@ -142,6 +184,11 @@ TRNGCC26XX_Handle TRNGCC26XX_open(uint8_t index)
   // Open TRNG.
   openTRNG((TRNGCC26XX_Handle)(&(TRNGCC26XX_config[TRNGCC26XXX_PERIPHERAL_0_INDEX])));
 
+#if TRNGCC26XX_POOL_WORDS > 0
+  // Fill the pool ahead of the first request.
+  startRefill();
+#endif // TRNGCC26XX_POOL_WORDS
+
   // Enable hardware interrupts.
   Hwi_restore(hwiKey);
 
@@ -158,6 +205,11 @@ void TRNGCC26XX_close(TRNGCC26XX_Handle handle)
   // Disable hardware interrupts.
   hwiKey = (uint16_t) Hwi_disable();
 
+#if TRNGCC26XX_POOL_WORDS > 0
+  // The TRNG loses power, stop a refill.
+  stopRefill();
+#endif // TRNGCC26XX_POOL_WORDS
+
   // Close TRNG.
   closeTRNG(handle);
 
@@ -195,6 +247,32 @@ uint32_t TRNGCC26XX_getNumber(TRNGCC26XX_Handle handle, TRNGCC26XX_Params *param
   uint16_t hwiKey;
   uint32_t trngVal;
 
+#if TRNGCC26XX_POOL_WORDS > 0
+  // Serve requests with the default configuration from the pool. Interrupts
+  // are only disabled while a word is taken out.
+  if (!params || isDefaultParams(params))
+  {
+    uint8_t pooled;
+
+    hwiKey = (uint16_t) Hwi_disable();
+    pooled = takeFromPool(&trngVal);
+    Hwi_restore(hwiKey);
+
+    if (pooled)
+    {
+      if (status)
+      {
+        *status = TRNGCC26XX_STATUS_SUCCESS;
+      }
+
+      return (trngVal);
+    }
+  }
+#endif // TRNGCC26XX_POOL_WORDS
+
+  // The pool is empty or the request has its own configuration: generate a
+  // number with interrupts disabled.
+
   // Disable hardware interrupts.
   hwiKey = (uint16_t) Hwi_disable();
 
@@ -208,6 +286,11 @@ uint32_t TRNGCC26XX_getNumber(TRNGCC26XX_Handle handle, TRNGCC26XX_Params *param
   // Check for params and that they are configured legally
   if (!params)
   {
+#if TRNGCC26XX_POOL_WORDS > 0
+    // The number is polled for here, not taken by the refill interrupt.
+    stopRefill();
+#endif // TRNGCC26XX_POOL_WORDS
+
     // Configure TRNG.  This will disable TRNG.
     TRNGConfigure(TRNGCC26XX_MIN_SAMPLES_DEFAULT,
                   TRNGCC26XX_MAX_SAMPLES_DEFAULT,
@@ -230,6 +313,10 @@ uint32_t TRNGCC26XX_getNumber(TRNGCC26XX_Handle handle, TRNGCC26XX_Params *param
   }
   else
   {
+#if TRNGCC26XX_POOL_WORDS > 0
+    stopRefill();
+#endif // TRNGCC26XX_POOL_WORDS
+
     // Configure TRNG.  This will disable TRNG.
     TRNGConfigure(params->minSamplesPerCycle,
                   params->maxSamplesPerCycle,
@@ -251,12 +338,38 @@ uint32_t TRNGCC26XX_getNumber(TRNGCC26XX_Handle handle, TRNGCC26XX_Params *param
     *status = TRNGCC26XX_STATUS_SUCCESS;
   }
 
+#if TRNGCC26XX_POOL_WORDS > 0
+  // Refill the pool so that the next requests need not wait. This
+  // configures the TRNG with the default settings again.
+  startRefill();
+#endif // TRNGCC26XX_POOL_WORDS
+
   // Enable hardware interrupts.
   Hwi_restore(hwiKey);
 
   return (trngVal);
 }
 
+/*
+ *  ======== TRNGCC26XX_getBytes ========
+ */
+int8_t TRNGCC26XX_getBytes(TRNGCC26XX_Handle handle, uint8_t *pBuf, uint32_t len)
+{
+  int8_t status = TRNGCC26XX_STATUS_SUCCESS;
+
+  while (len && (status == TRNGCC26XX_STATUS_SUCCESS))
+  {
+    uint32_t trngVal = TRNGCC26XX_getNumber(handle, NULL, &status);
+    uint32_t copyLen = (len < sizeof(trngVal)) ? len : sizeof(trngVal);
+
+    memcpy(pBuf, &trngVal, copyLen);
+    pBuf += copyLen;
+    len -= copyLen;
+  }
+
+  return (status);
+}
+
  /*
   *  ======== TRNGCC26XX_isParamValid ========
   */
@@ -308,5 +421,116 @@ void closeTRNG(TRNGCC26XX_Handle handle)
   }
 }
 
+#if TRNGCC26XX_POOL_WORDS > 0
+/*
+ * Check for the configuration the pool is generated with.
+ */
+static uint8_t isDefaultParams(TRNGCC26XX_Params *params)
+{
+  return (params->minSamplesPerCycle == TRNGCC26XX_MIN_SAMPLES_DEFAULT &&
+          params->maxSamplesPerCycle == TRNGCC26XX_MAX_SAMPLES_DEFAULT &&
+          params->clocksPerSample    == TRNGCC26XX_SAMPLE_RATE_DEFAULT);
+}
+
+/*
+ * Take a word out of the pool and wipe its slot. Starts a refill below the
+ * low water mark. Call with hardware interrupts disabled.
+ */
+static uint8_t takeFromPool(uint32_t *pValue)
+{
+  uint8_t count = (uint8_t)(trngPoolHead - trngPoolTail);
+  uint8_t pooled = FALSE;
+
+  if (count > 0)
+  {
+    uint8_t index = trngPoolTail & TRNGCC26XX_POOL_MASK;
+
+    *pValue = trngPool[index];
+    trngPool[index] = 0;
+    trngPoolTail++;
+    count--;
+
+    pooled = TRUE;
+  }
+
+  if (count < TRNGCC26XX_POOL_LOW)
+  {
+    startRefill();
+  }
+
+  return (pooled);
+}
+
+/*
+ * Run the TRNG in the background until the pool is full. Standby would power
+ * the TRNG down, so it is held off for the few microseconds each number takes.
+ * Call with hardware interrupts disabled.
+ */
+static void startRefill(void)
+{
+  if (!trngHwiConstructed || trngRefilling ||
+      (uint8_t)(trngPoolHead - trngPoolTail) == TRNGCC26XX_POOL_WORDS)
+  {
+    return;
+  }
+
+  // The TRNG needs power.
+  openTRNG((TRNGCC26XX_Handle)(&(TRNGCC26XX_config[TRNGCC26XXX_PERIPHERAL_0_INDEX])));
+
+  Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+  trngRefilling = TRUE;
+
+  // Configure TRNG.  This will disable TRNG.
+  TRNGConfigure(TRNGCC26XX_MIN_SAMPLES_DEFAULT,
+                TRNGCC26XX_MAX_SAMPLES_DEFAULT,
+                TRNGCC26XX_SAMPLE_RATE_DEFAULT);
+
+  TRNGIntClear(TRNG_NUMBER_READY);
+  TRNGIntEnable(TRNG_NUMBER_READY);
+
+  // Enable TRNG.
+  TRNGEnable();
+}
+
+/*
+ * Stop running the TRNG in the background. Call with hardware interrupts
+ * disabled.
+ */
+static void stopRefill(void)
+{
+  if (trngRefilling)
+  {
+    TRNGIntDisable(TRNG_NUMBER_READY);
+    TRNGDisable();
+
+    trngRefilling = FALSE;
+    Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+  }
+}
+
+/*
+ * TRNG interrupt: move the new number into the pool, reading it starts the
+ * next one.
+ */
+static void trngHwiFxn(UArg arg)
+{
+  if (TRNGStatusGet() & TRNG_NUMBER_READY)
+  {
+    uint32_t trngVal = TRNGNumberGet(TRNG_LOW_WORD);
+
+    if ((uint8_t)(trngPoolHead - trngPoolTail) < TRNGCC26XX_POOL_WORDS)
+    {
+      trngPool[trngPoolHead & TRNGCC26XX_POOL_MASK] = trngVal;
+      trngPoolHead++;
+    }
+  }
+
+  if ((uint8_t)(trngPoolHead - trngPoolTail) == TRNGCC26XX_POOL_WORDS)
+  {
+    stopRefill();
+  }
+}
+#endif // TRNGCC26XX_POOL_WORDS
+
 /*******************************************************************************
  */
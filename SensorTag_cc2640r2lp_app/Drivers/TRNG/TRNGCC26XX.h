@@ -59,9 +59,11 @@
  *  # Overview #
  *
  *  The TRNGCC26XX driver provides reentrant access to the TRNG module within
- *  the CC26XX.  Reentrant access is controlled by creating a global critical
- *  section when requesting a random number.  This critical section disables all
- *  Hwi's from running.
+ *  the CC26XX.  Requests with the default parameters are served from an
+ *  entropy pool (TRNGCC26XX_POOL_WORDS) that the TRNG interrupt refills in the
+ *  background, so Hwi's are only disabled while a word is taken out.  When the
+ *  pool is empty, or for other parameters, a global critical section that
+ *  disables all Hwi's is held until the TRNG has produced a number.
  *
  * ## General Behavior #
  * For code examples, see [Use Cases](@ref TRNG_USE_CASES) below.
@@ -177,8 +179,8 @@
  *  @endcode
  *
  *  ### Supported transaction modes #
- *  - all calls to TRNGCC26XX_getNumber are blocking until the TRNG has a new
- *    random number available.
+ *  - calls to TRNGCC26XX_getNumber return a pooled number right away, or
+ *    block until the TRNG has a new random number available.
  *
  *  ## Error handling ##
  *  If an error occurs during a call to TRNGCC26XX_getNumber, the error status
@@ -193,6 +195,7 @@
  *  | TRNGCC26XX_Params_init()       | Initialize parameters for random number generation|
  *  | TRNGCC26XX_init()              | Generates a random number                         |
  *  | TRNGCC26XX_isParamValid        | Validate client configuration parameters          |
+ *  | TRNGCC26XX_getBytes()          | Fill a buffer with random bytes                   |
  *
  *  ============================================================================
  */
@@ -365,6 +368,23 @@ int8_t TRNGCC26XX_Params_init(TRNGCC26XX_Params *params);
 uint32_t TRNGCC26XX_getNumber(TRNGCC26XX_Handle handle,
                               TRNGCC26XX_Params *params, int8_t *status);
 
+/*!
+ * @brief       This routine fills a buffer of any length with random bytes
+ *              generated with the default parameters.
+ *
+ * @pre         Calling context: Hwi, Swi or Task.
+ *
+ * @param       handle - a TRNGCC26XX_Handle or NULL.
+ *
+ * @param       pBuf - buffer to fill. output parameter.
+ *
+ * @param       len - number of bytes.
+ *
+ * @return      TRNGCC26XX_STATUS_SUCCESS if successful.
+ */
+int8_t TRNGCC26XX_getBytes(TRNGCC26XX_Handle handle, uint8_t *pBuf,
+                           uint32_t len);
+
 /*!
  * @brief       Check that the parameters used are valid configurations.
  *
@@ -67,6 +67,14 @@
 #define HEAPMGR_FREE heapmgrFree
 #endif
 
+#ifndef HEAPMGR_REALLOC
+#define HEAPMGR_REALLOC heapmgrRealloc
+#endif
+
+#ifndef HEAPMGR_MAINTAIN
+#define HEAPMGR_MAINTAIN heapmgrMaintain
+#endif
+
 #ifndef HEAPMGR_GETMETRICS
 #define HEAPMGR_GETMETRICS heapmgrGetMetrics
 #endif
@@ -133,6 +141,75 @@
 #define HEAPMGR_REIN         'F'
 #endif
 
+/* Allocation tracer: number of records kept in the ring buffer, clock used
+ * to timestamp the records and return address of the caller. Wrappers
+ * around the heap call the _CALLER variants with their own caller, so the
+ * records name the code that used the wrapper.
+ */
+#ifdef HEAPMGR_TRACE
+#ifndef HEAPMGR_MALLOC_CALLER
+#define HEAPMGR_MALLOC_CALLER  HEAPMGR_PREFIXED(MallocCaller)
+#endif
+
+#ifndef HEAPMGR_FREE_CALLER
+#define HEAPMGR_FREE_CALLER    HEAPMGR_PREFIXED(FreeCaller)
+#endif
+
+#ifndef HEAPMGR_REALLOC_CALLER
+#define HEAPMGR_REALLOC_CALLER HEAPMGR_PREFIXED(ReallocCaller)
+#endif
+
+#ifndef HEAPMGR_TRACE_LEN
+#define HEAPMGR_TRACE_LEN    64
+#endif
+
+#ifndef HEAPMGR_TRACE_TIME
+#define HEAPMGR_TRACE_TIME() 0
+#endif
+
+#ifndef HEAPMGR_TRACE_CALLER
+#if defined __GNUC__ || defined __TI_COMPILER_VERSION__
+#define HEAPMGR_TRACE_CALLER() ((hmU32_t)(uintptr_t)__builtin_return_address(0))
+#else
+#define HEAPMGR_TRACE_CALLER() 0
+#endif
+#endif
+
+#define HEAPMGR_TRACE_MALLOC  0
+#define HEAPMGR_TRACE_FREE    1
+#define HEAPMGR_TRACE_REALLOC 2
+#endif
+
+/* Idle-time maintenance: number of blocks visited by the coalescer per call,
+ * small-block misses or large-block failures that move the end of the
+ * small-block bucket, by how many bytes, and within which bounds.
+ */
+#ifdef HEAPMGR_IDLE_MAINT
+#ifndef HEAPMGR_MAINT_STEPS
+#define HEAPMGR_MAINT_STEPS  16
+#endif
+
+#ifndef HEAPMGR_REBAL_MISSES
+#define HEAPMGR_REBAL_MISSES 8
+#endif
+
+#ifndef HEAPMGR_REBAL_FAILS
+#define HEAPMGR_REBAL_FAILS  1
+#endif
+
+#ifndef HEAPMGR_REBAL_STEP
+#define HEAPMGR_REBAL_STEP   32
+#endif
+
+#ifndef HEAPMGR_SMALL_MIN
+#define HEAPMGR_SMALL_MIN    (SMALLBLKHEAP / 2)
+#endif
+
+#ifndef HEAPMGR_SMALL_MAX
+#define HEAPMGR_SMALL_MAX    (SMALLBLKHEAP * 2)
+#endif
+#endif
+
 /* Namespace */
 #define HEAPMGR_FF1 HEAPMGR_PREFIXED(Ff1)
 #define HEAPMGR_FF2 HEAPMGR_PREFIXED(Ff2)
@@ -147,6 +224,18 @@
 #define HEAPMGR_MEMUB  HEAPMGR_PREFIXED(MemUB)
 #define HEAPMGR_MEMFAIL HEAPMGR_PREFIXED(MemFail)
 #endif
+#ifdef HEAPMGR_TRACE
+#define HEAPMGR_TRACEBUF HEAPMGR_PREFIXED(TraceBuf)
+#define HEAPMGR_TRACECNT HEAPMGR_PREFIXED(TraceCnt)
+#define HEAPMGR_TRACEADD HEAPMGR_PREFIXED(TraceAdd)
+#endif
+#ifdef HEAPMGR_IDLE_MAINT
+#define HEAPMGR_MAINTCUR HEAPMGR_PREFIXED(MaintCur)
+#define HEAPMGR_FENCEPREV HEAPMGR_PREFIXED(FencePrev)
+#define HEAPMGR_SMALLMISS HEAPMGR_PREFIXED(SmallMiss)
+#define HEAPMGR_LARGEFAIL HEAPMGR_PREFIXED(LargeFail)
+#define HEAPMGR_REBALANCE HEAPMGR_PREFIXED(Rebalance)
+#endif
 
 typedef uint8_t  hmU8_t;
 typedef uint16_t hmU16_t;
@@ -243,6 +332,13 @@ typedef uint32_t hmU32_t;
 static heapmgrHdr_t *HEAPMGR_FF1;  // First free block in the small-block bucket.
 static heapmgrHdr_t *HEAPMGR_FF2;  // First free block after the small-block bucket.
 
+#ifdef HEAPMGR_IDLE_MAINT
+static heapmgrHdr_t *HEAPMGR_MAINTCUR; // Next block visited by the coalescer.
+static heapmgrHdr_t *HEAPMGR_FENCEPREV; // Last block of the small-block bucket.
+static hmU8_t HEAPMGR_SMALLMISS;       // Small blocks allocated after the bucket.
+static hmU8_t HEAPMGR_LARGEFAIL;       // Failed allocations of large blocks.
+#endif
+
 #ifdef HEAPMGR_METRICS
 hmU16_t HEAPMGR_BLKMAX  = 0; // Max cnt of all blocks ever seen at once.
 hmU16_t HEAPMGR_BLKCNT  = 0; // Current cnt of all blocks.
@@ -269,6 +365,24 @@ static hmU16_t proTot[HEAPMGR_PROMAX] = { 0 };
 static hmU16_t proSmallBlkMiss;
 #endif
 
+#ifdef HEAPMGR_TRACE
+/** @internal allocation tracer record */
+typedef struct
+{
+  hmU32_t time;    // HEAPMGR_TRACE_TIME() at the call.
+  hmU32_t caller;  // Return address of the call, 0 if unknown.
+  hmU32_t offset;  // Offset of the returned block in the heap, ~0 on failure.
+  hmU16_t size;    // Requested size for an allocation, block size for a free.
+  hmU8_t  op;      // HEAPMGR_TRACE_MALLOC, _FREE or _REALLOC (in place).
+} heapmgrTrace_t;
+
+/* The latest records, oldest first from HEAPMGR_TRACECNT % HEAPMGR_TRACE_LEN.
+ * Global so that the buffer can be located in the map file and dumped.
+ */
+heapmgrTrace_t HEAPMGR_TRACEBUF[HEAPMGR_TRACE_LEN];
+hmU32_t HEAPMGR_TRACECNT = 0; // Total count of records ever written.
+#endif
+
 /** @intenral Memory Allocation Heap. */
 #ifdef AUTOHEAPSIZE
   static heapmgrAlign_t *HEAPMGR_HEAPSTORE;
@@ -288,6 +402,31 @@ static hmU16_t proSmallBlkMiss;
   static hmU8_t         *HEAPMGR_HEAP = (hmU8_t *)&HEAPMGR_HEAPSTORE;
 #endif // AUTOHEAPSIZE
 
+#ifdef HEAPMGR_TRACE
+void *HEAPMGR_MALLOC_CALLER( hmU16_t size, hmU32_t caller );
+void HEAPMGR_FREE_CALLER( void *ptr, hmU32_t caller );
+void *HEAPMGR_REALLOC_CALLER( void *ptr, hmU16_t size, hmU32_t caller );
+
+/**
+ * @brief   Append a record to the allocation trace. Called with the heap locked.
+ * @param   op     - HEAPMGR_TRACE_MALLOC, _FREE or _REALLOC.
+ * @param   caller - return address of the caller of the heap.
+ * @param   ptr    - block returned or freed, NULL if an allocation failed.
+ * @param   size   - requested size or block size.
+ */
+static void HEAPMGR_TRACEADD( hmU8_t op, hmU32_t caller, void *ptr, hmU16_t size )
+{
+  heapmgrTrace_t *rec = &HEAPMGR_TRACEBUF[HEAPMGR_TRACECNT % HEAPMGR_TRACE_LEN];
+
+  rec->time = HEAPMGR_TRACE_TIME();
+  rec->caller = caller;
+  rec->offset = (ptr == NULL) ? ~(hmU32_t)0 : (hmU32_t)((hmU8_t *)ptr - HEAPMGR_HEAP);
+  rec->size = size;
+  rec->op = op;
+  HEAPMGR_TRACECNT++;
+}
+#endif
+
 /**
  * @brief   Initialize the heap memory management system.
  */
@@ -349,19 +488,49 @@ void HEAPMGR_INIT( void )
   HEAPMGR_BLKCNT = HEAPMGR_BLKFREE = 2;
   HEAPMGR_MEMFAIL = 0;
 #endif
+
+#ifdef HEAPMGR_IDLE_MAINT
+  HEAPMGR_MAINTCUR = NULL;
+  HEAPMGR_FENCEPREV = (heapmgrHdr_t *)HEAPMGR_HEAP;
+  HEAPMGR_SMALLMISS = 0;
+  HEAPMGR_LARGEFAIL = 0;
+#endif
 }
 
+#ifdef HEAPMGR_TRACE
 /**
  * @brief   Implementation of the allocator functionality.
  * @param   size - number of bytes to allocate from the heap.
  * @return  void * - pointer to the heap allocation; NULL if error or failure.
  */
 void *HEAPMGR_MALLOC( hmU16_t size )
+{
+  return HEAPMGR_MALLOC_CALLER( size, HEAPMGR_TRACE_CALLER() );
+}
+
+/**
+ * @brief   HEAPMGR_MALLOC on behalf of a caller, for the allocation trace.
+ * @param   size - number of bytes to allocate from the heap.
+ * @param   caller - return address recorded for the allocation.
+ * @return  void * - pointer to the heap allocation; NULL if error or failure.
+ */
+void *HEAPMGR_MALLOC_CALLER( hmU16_t size, hmU32_t caller )
+#else
+/**
+ * @brief   Implementation of the allocator functionality.
+ * @param   size - number of bytes to allocate from the heap.
+ * @return  void * - pointer to the heap allocation; NULL if error or failure.
+ */
+void *HEAPMGR_MALLOC( hmU16_t size )
+#endif
 {
   heapmgrHdr_t *prev = NULL;
   heapmgrHdr_t *hdr;
   heapmgrHdr_t tmp;
   hmU8_t coal = 0;
+#ifdef HEAPMGR_TRACE
+  const hmU16_t reqSize = size;
+#endif
 
   HEAPMGR_ASSERT( size );
 
@@ -413,6 +582,17 @@ void *HEAPMGR_MALLOC( hmU16_t size )
 
         *prev += *hdr;
 
+#ifdef HEAPMGR_IDLE_MAINT
+        if ( HEAPMGR_MAINTCUR == hdr )
+        {
+          HEAPMGR_MAINTCUR = prev;
+        }
+        if ( HEAPMGR_FENCEPREV == hdr )
+        {
+          HEAPMGR_FENCEPREV = prev;
+        }
+#endif
+
         if ( *prev >= size )
         {
           hdr = prev;
@@ -449,10 +629,24 @@ void *HEAPMGR_MALLOC( hmU16_t size )
   {
 #ifdef HEAPMGR_METRICS
     HEAPMGR_MEMFAIL++;
+#endif
+#ifdef HEAPMGR_IDLE_MAINT
+    if ( (size > HEAPMGR_SMALL_BLKSZ) && (HEAPMGR_LARGEFAIL < HEAPMGR_REBAL_FAILS) )
+    {
+      HEAPMGR_LARGEFAIL++;
+    }
 #endif
   }
   else
   {
+#ifdef HEAPMGR_IDLE_MAINT
+    if ( (size <= HEAPMGR_SMALL_BLKSZ) && (hdr >= HEAPMGR_FF2) &&
+         (HEAPMGR_SMALLMISS < HEAPMGR_REBAL_MISSES) )
+    {
+      HEAPMGR_SMALLMISS++;
+    }
+#endif
+
     tmp -= size;
 
     // Determine whether the threshold for splitting is met.
@@ -463,6 +657,13 @@ void *HEAPMGR_MALLOC( hmU16_t size )
       *next = tmp;
       *hdr = (size | HEAPMGR_IN_USE);
 
+#ifdef HEAPMGR_IDLE_MAINT
+      if ( HEAPMGR_FENCEPREV == hdr )
+      {
+        HEAPMGR_FENCEPREV = next;
+      }
+#endif
+
 #ifdef HEAPMGR_METRICS
       HEAPMGR_BLKCNT++;
       if ( HEAPMGR_BLKMAX < HEAPMGR_BLKCNT )
@@ -544,6 +745,10 @@ void *HEAPMGR_MALLOC( hmU16_t size )
 #endif
   }
 
+#ifdef HEAPMGR_TRACE
+  HEAPMGR_TRACEADD( HEAPMGR_TRACE_MALLOC, caller, hdr, reqSize );
+#endif
+
   HEAPMGR_UNLOCK();  /* unlock the mutex */
 
   return (void *)hdr;
@@ -552,42 +757,210 @@ void *HEAPMGR_MALLOC( hmU16_t size )
 /**
  * @brief         Re-allocates a memory block of the requested
  *                size.
- *                Note that this function always re-allocates
- *                even if the requested size is lower than the
- *                original.
+ *                The block is resized in place when it shrinks,
+ *                or when the free blocks that follow it make
+ *                enough room to grow. Otherwise a new block is
+ *                allocated and the content is copied over.
  * @param ptr     pointer to the existing memory block.
  * @param size    size in bytes of the memory block to
  *                re-allocate
  *
- * @return void*  pointer to the memory block of newly
- *                re-allocation or if reallocation fails
- *                returns the pointer to the original memory
- *                block.
+ * @return void*  pointer to the re-allocated memory block or
+ *                NULL if the reallocation fails, in which case
+ *                the original memory block is left untouched.
  */
+#ifdef HEAPMGR_TRACE
 void *HEAPMGR_REALLOC( void* ptr, hmU16_t size )
+{
+  return HEAPMGR_REALLOC_CALLER( ptr, size, HEAPMGR_TRACE_CALLER() );
+}
+
+/**
+ * @brief         HEAPMGR_REALLOC on behalf of a caller, for the
+ *                allocation trace.
+ * @param ptr     pointer to the existing memory block.
+ * @param size    size in bytes of the memory block to
+ *                re-allocate
+ * @param caller  return address recorded for the reallocation.
+ *
+ * @return void*  pointer to the re-allocated memory block or
+ *                NULL if the reallocation fails.
+ */
+void *HEAPMGR_REALLOC_CALLER( void* ptr, hmU16_t size, hmU32_t caller )
+#else
+void *HEAPMGR_REALLOC( void* ptr, hmU16_t size )
+#endif
 {
   void *newPtr;
   heapmgrHdr_t *currHdr;
+  heapmgrHdr_t *next;
   hmU16_t origSize;
+  hmU16_t newSize;
+  hmU16_t avail;
+  hmU8_t merged = 0;
 
   HEAPMGR_ASSERT( size );
 
+  newSize = size + HDRSZ;
+
+  // Calculate required bytes to add to 'newSize' to align to heapmgrAlign_t.
+  if ( sizeof( heapmgrAlign_t ) == 2 )
+  {
+    newSize += (newSize & 0x01);
+  }
+  else if ( sizeof( heapmgrAlign_t ) != 1 )
+  {
+    const hmU8_t mod = newSize % sizeof( heapmgrAlign_t );
+
+    if ( mod != 0 )
+    {
+      newSize += (sizeof( heapmgrAlign_t ) - mod);
+    }
+  }
+
   currHdr = (heapmgrHdr_t *)((hmU8_t *)ptr - HDRSZ);
 
+  HEAPMGR_LOCK();
+
+  HEAPMGR_ASSERT(*currHdr & HEAPMGR_IN_USE);
+
   origSize = (hmU16_t)((*currHdr) & (~HEAPMGR_IN_USE));
 
-  if ( origSize == size )
+  // Count the free blocks that follow for as long as more room is needed.
+  avail = origSize;
+  next = (heapmgrHdr_t *)((hmU8_t *)currHdr + avail);
+  while ( (avail < newSize) && (*next != 0) && !(*next & HEAPMGR_IN_USE) )
+  {
+    avail += (hmU16_t) *next;
+    merged++;
+    next = (heapmgrHdr_t *)((hmU8_t *)currHdr + avail);
+  }
+
+  if ( avail >= newSize )
   {
+    hmU16_t rem = avail - newSize;
+
+    if ( merged != 0 )
+    {
+      // The first free block must not point into the grown block.
+      if ( (HEAPMGR_FF1 > currHdr) && (HEAPMGR_FF1 < next) )
+      {
+        HEAPMGR_FF1 = currHdr;
+      }
+#ifdef HEAPMGR_IDLE_MAINT
+      if ( (HEAPMGR_MAINTCUR > currHdr) && (HEAPMGR_MAINTCUR < next) )
+      {
+        HEAPMGR_MAINTCUR = currHdr;
+      }
+      if ( (HEAPMGR_FENCEPREV > currHdr) && (HEAPMGR_FENCEPREV < next) )
+      {
+        HEAPMGR_FENCEPREV = currHdr;
+      }
+#endif
+#ifdef HEAPMGR_METRICS
+      HEAPMGR_BLKCNT -= merged;
+      HEAPMGR_BLKFREE -= merged;
+#endif
+    }
+
+    // Split off the remainder when the threshold for splitting is met.
+    if ( rem >= HEAPMGR_MIN_BLKSZ )
+    {
+      heapmgrHdr_t *remHdr = (heapmgrHdr_t *)((hmU8_t *)currHdr + newSize);
+      *remHdr = rem;
+      avail = newSize;
+
+      if ( HEAPMGR_FF1 > remHdr )
+      {
+        HEAPMGR_FF1 = remHdr;
+      }
+#ifdef HEAPMGR_IDLE_MAINT
+      if ( HEAPMGR_FENCEPREV == currHdr )
+      {
+        HEAPMGR_FENCEPREV = remHdr;
+      }
+#endif
+
+#ifdef HEAPMGR_METRICS
+      HEAPMGR_BLKCNT++;
+      HEAPMGR_BLKFREE++;
+      if ( HEAPMGR_BLKMAX < HEAPMGR_BLKCNT )
+      {
+        HEAPMGR_BLKMAX = HEAPMGR_BLKCNT;
+      }
+#endif
+    }
+
+    *currHdr = (avail | HEAPMGR_IN_USE);
+
+#ifdef HEAPMGR_METRICS
+    HEAPMGR_MEMALO = HEAPMGR_MEMALO - origSize + avail;
+    if ( HEAPMGR_MEMMAX < HEAPMGR_MEMALO )
+    {
+      HEAPMGR_MEMMAX = HEAPMGR_MEMALO;
+    }
+    {
+      hmU16_t ub = (hmU16_t)(unsigned)(((hmU8_t *)currHdr + avail) - HEAPMGR_HEAP);
+      if (HEAPMGR_MEMUB < ub)
+      {
+        HEAPMGR_MEMUB = ub;
+      }
+    }
+#endif
+
+#ifdef HEAPMGR_PROFILER
+    {
+      hmU8_t idx;
+
+      for ( idx = 0; idx < HEAPMGR_PROMAX; idx++ )
+      {
+        if ( origSize <= proCnt[idx] )
+        {
+          break;
+        }
+      }
+      proCur[idx]--;
+
+      for ( idx = 0; idx < HEAPMGR_PROMAX; idx++ )
+      {
+        if ( avail <= proCnt[idx] )
+        {
+          break;
+        }
+      }
+      proCur[idx]++;
+      if ( proMax[idx] < proCur[idx] )
+      {
+        proMax[idx] = proCur[idx];
+      }
+    }
+#endif
+
+#ifdef HEAPMGR_TRACE
+    HEAPMGR_TRACEADD( HEAPMGR_TRACE_REALLOC, caller, ptr, size );
+#endif
+
+    HEAPMGR_UNLOCK();
     return ptr;
   }
 
+  HEAPMGR_UNLOCK();
+
+#ifdef HEAPMGR_TRACE
+  newPtr = HEAPMGR_MALLOC_CALLER( size, caller );
+#else
   newPtr = HEAPMGR_MALLOC( size );
+#endif
 
   if ( newPtr )
   {
-    hmU16_t n = origSize < size ? origSize : size;
-    memcpy( newPtr, ptr, n );
+    hmU16_t n = origSize - HDRSZ;
+    memcpy( newPtr, ptr, n < size ? n : size );
+#ifdef HEAPMGR_TRACE
+    HEAPMGR_FREE_CALLER( ptr, caller );
+#else
     HEAPMGR_FREE( ptr );
+#endif
     return newPtr;
   }
 
@@ -595,11 +968,29 @@ void *HEAPMGR_REALLOC( void* ptr, hmU16_t size )
 }
 
 
+#ifdef HEAPMGR_TRACE
 /**
  * @brief   Implementation of the de-allocator functionality.
  * @param   ptr - pointer to the memory to free.
  */
 void HEAPMGR_FREE( void *ptr )
+{
+  HEAPMGR_FREE_CALLER( ptr, HEAPMGR_TRACE_CALLER() );
+}
+
+/**
+ * @brief   HEAPMGR_FREE on behalf of a caller, for the allocation trace.
+ * @param   ptr - pointer to the memory to free.
+ * @param   caller - return address recorded for the free.
+ */
+void HEAPMGR_FREE_CALLER( void *ptr, hmU32_t caller )
+#else
+/**
+ * @brief   Implementation of the de-allocator functionality.
+ * @param   ptr - pointer to the memory to free.
+ */
+void HEAPMGR_FREE( void *ptr )
+#endif
 {
   heapmgrHdr_t *currHdr;
 
@@ -614,6 +1005,10 @@ void HEAPMGR_FREE( void *ptr )
 
   *currHdr &= ~HEAPMGR_IN_USE;
 
+#ifdef HEAPMGR_TRACE
+  HEAPMGR_TRACEADD( HEAPMGR_TRACE_FREE, caller, ptr, (hmU16_t) *currHdr );
+#endif
+
 #ifdef HEAPMGR_PROFILER
   {
     hmU16_t size = *currHdr;
@@ -648,6 +1043,166 @@ void HEAPMGR_FREE( void *ptr )
   HEAPMGR_UNLOCK();
 }
 
+#ifdef HEAPMGR_IDLE_MAINT
+/**
+ * @brief   Move the end of the small-block bucket by HEAPMGR_REBAL_STEP
+ *          bytes, when the free block on the other side has room for it.
+ *          Called with the heap locked.
+ * @param   grow - non-zero to grow the bucket, zero to shrink it.
+ * @return  non-zero when the bucket was resized.
+ */
+static hmU8_t HEAPMGR_REBALANCE( hmU8_t grow )
+{
+  // The in-use NULL block that ends the bucket.
+  heapmgrHdr_t *fence = (heapmgrHdr_t *)((hmU8_t *)HEAPMGR_FF2 - HDRSZ);
+  heapmgrHdr_t *hdr;
+
+  if ( grow )
+  {
+    // The block after the fence gives its head to the bucket.
+    hdr = HEAPMGR_FF2;
+    if ( (*hdr & HEAPMGR_IN_USE) ||
+         (*hdr < (heapmgrHdr_t)(HEAPMGR_REBAL_STEP + HEAPMGR_MIN_BLKSZ)) )
+    {
+      return 0;
+    }
+
+    HEAPMGR_FF2 = (heapmgrHdr_t *)((hmU8_t *)HEAPMGR_FF2 + HEAPMGR_REBAL_STEP);
+    *HEAPMGR_FF2 = *hdr - HEAPMGR_REBAL_STEP;
+    *((heapmgrHdr_t *)((hmU8_t *)fence + HEAPMGR_REBAL_STEP)) = (HDRSZ | HEAPMGR_IN_USE);
+    *fence = HEAPMGR_REBAL_STEP;
+
+    // The old fence is now a free block.
+    if ( HEAPMGR_FF1 > fence )
+    {
+      HEAPMGR_FF1 = fence;
+    }
+    if ( HEAPMGR_MAINTCUR == hdr )
+    {
+      HEAPMGR_MAINTCUR = fence;
+    }
+    HEAPMGR_FENCEPREV = fence;
+  }
+  else
+  {
+    // The block before the fence gives its tail to the large-block region.
+    hdr = HEAPMGR_FENCEPREV;
+    if ( (*hdr & HEAPMGR_IN_USE) ||
+         (*hdr < (heapmgrHdr_t)(HEAPMGR_REBAL_STEP + HEAPMGR_MIN_BLKSZ)) )
+    {
+      return 0;
+    }
+
+    *hdr -= HEAPMGR_REBAL_STEP;
+    *((heapmgrHdr_t *)((hmU8_t *)fence - HEAPMGR_REBAL_STEP)) = (HDRSZ | HEAPMGR_IN_USE);
+    HEAPMGR_FF2 = (heapmgrHdr_t *)((hmU8_t *)HEAPMGR_FF2 - HEAPMGR_REBAL_STEP);
+    *HEAPMGR_FF2 = HEAPMGR_REBAL_STEP;
+
+    // The old fence is now inside a free block.
+    if ( HEAPMGR_MAINTCUR == fence )
+    {
+      HEAPMGR_MAINTCUR = HEAPMGR_FF2;
+    }
+  }
+
+#ifdef HEAPMGR_METRICS
+  HEAPMGR_BLKCNT++;
+  HEAPMGR_BLKFREE++;
+  if ( HEAPMGR_BLKMAX < HEAPMGR_BLKCNT )
+  {
+    HEAPMGR_BLKMAX = HEAPMGR_BLKCNT;
+  }
+#endif
+
+  return 1;
+}
+
+/**
+ * @brief   Incremental heap maintenance, to be called when the system is
+ *          idle. Each call visits at most HEAPMGR_MAINT_STEPS blocks to
+ *          coalesce adjacent free blocks, resuming where the previous call
+ *          stopped, and moves the end of the small-block bucket by at most
+ *          one step when small blocks keep spilling out of the bucket or
+ *          large blocks fail to be allocated.
+ */
+void HEAPMGR_MAINTAIN( void )
+{
+  heapmgrHdr_t *hdr;
+  heapmgrHdr_t tmp;
+  hmU8_t n;
+
+  HEAPMGR_LOCK();
+
+  // Adapt the small-block bucket to the observed demand.
+  if ( HEAPMGR_SMALLMISS >= HEAPMGR_REBAL_MISSES )
+  {
+    if ( ((hmU8_t *)HEAPMGR_FF2 - HEAPMGR_HEAP + HEAPMGR_REBAL_STEP <= HEAPMGR_SMALL_MAX) &&
+         HEAPMGR_REBALANCE( 1 ) )
+    {
+      HEAPMGR_SMALLMISS = 0;
+      HEAPMGR_LARGEFAIL = 0;
+    }
+  }
+  else if ( HEAPMGR_LARGEFAIL >= HEAPMGR_REBAL_FAILS )
+  {
+    if ( ((hmU8_t *)HEAPMGR_FF2 - HEAPMGR_HEAP - HEAPMGR_REBAL_STEP >= HEAPMGR_SMALL_MIN) &&
+         HEAPMGR_REBALANCE( 0 ) )
+    {
+      HEAPMGR_LARGEFAIL = 0;
+    }
+  }
+
+  // Coalesce free blocks from where the previous call stopped.
+  hdr = (HEAPMGR_MAINTCUR != NULL) ? HEAPMGR_MAINTCUR : (heapmgrHdr_t *)HEAPMGR_HEAP;
+  for ( n = 0; n < HEAPMGR_MAINT_STEPS; n++ )
+  {
+    tmp = *hdr;
+    if ( tmp == 0 )
+    {
+      // End of the heap; start over on the next call.
+      hdr = (heapmgrHdr_t *)HEAPMGR_HEAP;
+      break;
+    }
+
+    if ( tmp & HEAPMGR_IN_USE )
+    {
+      hdr = (heapmgrHdr_t *)((hmU8_t *)hdr + (tmp ^ HEAPMGR_IN_USE));
+    }
+    else
+    {
+      heapmgrHdr_t *next = (heapmgrHdr_t *)((hmU8_t *)hdr + tmp);
+
+      if ( (*next != 0) && !(*next & HEAPMGR_IN_USE) )
+      {
+        // Absorb the next block and look at the one after it next.
+        *hdr += *next;
+        if ( HEAPMGR_FF1 == next )
+        {
+          HEAPMGR_FF1 = hdr;
+        }
+        if ( HEAPMGR_FENCEPREV == next )
+        {
+          HEAPMGR_FENCEPREV = hdr;
+        }
+
+#ifdef HEAPMGR_METRICS
+        HEAPMGR_BLKCNT--;
+        HEAPMGR_BLKFREE--;
+#endif
+      }
+      else
+      {
+        hdr = next;
+      }
+    }
+  }
+  HEAPMGR_MAINTCUR = hdr;
+
+  HEAPMGR_UNLOCK();
+}
+
+#endif /* HEAPMGR_IDLE_MAINT */
+
 #ifdef HEAPMGR_METRICS
 /**
  * @brief   obtain heap usage metrics
@@ -708,6 +1263,16 @@ int HEAPMGR_SANITY_CHECK(void)
     }
   }
 
+#ifdef HEAPMGR_IDLE_MAINT
+  // The last block of the small-block bucket must be the tracked one.
+  if ((result == 0) &&
+      ((hmU8_t *)HEAPMGR_FENCEPREV + (*HEAPMGR_FENCEPREV & ~HEAPMGR_IN_USE) !=
+       (hmU8_t *)HEAPMGR_FF2 - HDRSZ))
+  {
+    result = 3;
+  }
+#endif
+
   HEAPMGR_UNLOCK();
   return result;
 }
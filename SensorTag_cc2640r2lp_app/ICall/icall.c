@@ -57,6 +57,7 @@
 #include <ti/sysbios/BIOS.h>
 
 #include <stdint.h>
+#include <string.h>
 
 #include "icall.h"
 #include "icall_platform.h"
@@ -270,6 +271,32 @@ static ICall_TaskEntry ICall_tasks[ICALL_MAX_NUM_TASKS];
 /** @internal storage to track all entities using ICall module */
 static ICall_entityEntry ICall_entities[ICALL_MAX_NUM_ENTITIES];
 
+/**
+ * @internal Index of a service class in @ref ICall_serviceEntities.
+ * Service classes are multiples of 8 (see @ref ICALL_SERVICE_CLASS_MASK).
+ */
+#define ICALL_SERVICE_INDEX(_service) ((_service) >> 3)
+
+/** @internal number of service classes with a direct entity lookup */
+#define ICALL_NUM_SERVICE_INDEXES \
+  (ICALL_SERVICE_INDEX(ICALL_SERVICE_CLASS_DUMMY_BOARD) + 1)
+
+/**
+ * @internal Whether a service id has a slot in @ref ICall_serviceEntities.
+ * Only whole service classes do: a sub-service id (low bits set) would
+ * share the slot of its class, so it is looked up by the scan.
+ */
+#define ICALL_SERVICE_INDEXED(_service) \
+  ((((_service) & ~ICALL_SERVICE_CLASS_MASK) == 0) && \
+   (ICALL_SERVICE_INDEX(_service) < ICALL_NUM_SERVICE_INDEXES))
+
+/**
+ * @internal entity of each service class, or @ref ICALL_INVALID_ENTITY_ID.
+ * Entries are only ever set, once, so they are read without a critical
+ * section.
+ */
+static ICall_EntityID ICall_serviceEntities[ICALL_NUM_SERVICE_INDEXES];
+
 /**
  * @internal
  * Wakeup schedule data structure definition
@@ -315,50 +342,267 @@ ICall_LeaveCS ICall_leaveCriticalSection = ICall_leaveCSImpl;
 void *ICall_heapMalloc(uint16_t size);
 void *ICall_heapRealloc(void *blk, uint16_t size);
 void ICall_heapFree(void *blk);
+/* Called from the TI-RTOS idle loop, see Idle.addFunc() in app_ble.cfg */
+void ICall_heapMaintain(void);
 #define HEAPMGR_INIT       ICall_heapInit
 #define HEAPMGR_MALLOC     ICall_heapMalloc
 #define HEAPMGR_FREE       ICall_heapFree
 #define HEAPMGR_REALLOC    ICall_heapRealloc
 #define HEAPMGR_GETMETRICS ICall_heapGetMetrics
+#define HEAPMGR_MAINTAIN   ICall_heapMaintain
 #define HEAPMGR_LOCK()                                       \
   do { ICall_heapCSState = ICall_enterCSImpl(); } while (0)
 #define HEAPMGR_UNLOCK()                                     \
   do { ICall_leaveCSImpl(ICall_heapCSState); } while (0)
 #define HEAPMGR_IMPL_INIT()
+#define HEAPMGR_TRACE_TIME() Clock_getTicks()
+#define HEAPMGR_MALLOC_CALLER  ICall_heapMallocCaller
+#define HEAPMGR_FREE_CALLER    ICall_heapFreeCaller
+#define HEAPMGR_REALLOC_CALLER ICall_heapReallocCaller
 /* Note that a static variable can be used to contain critical section
  * state since heapmgr.h template ensures that there is no nested
  * lock call. */
 static ICall_CSState ICall_heapCSState;
 #include <heapmgr.h>
 
+#ifndef HEAPMGR_IDLE_MAINT
+/* The idle loop calls this in every build; only HEAPMGR_IDLE_MAINT gives
+ * the heap something to do there. */
+void ICall_heapMaintain(void)
+{
+}
+#endif /* HEAPMGR_IDLE_MAINT */
+
+/* The public entry points below record their own caller in the heap trace
+ * rather than letting the heap record the entry point itself. */
+#ifdef HEAPMGR_TRACE
+#define ICALL_HEAP_CALLER()                  HEAPMGR_TRACE_CALLER()
+#define ICall_heapMallocFrom(_size, _caller) \
+  ICall_heapMallocCaller(_size, _caller)
+#define ICall_heapFreeFrom(_blk, _caller)    ICall_heapFreeCaller(_blk, _caller)
+#define ICall_heapReallocFrom(_blk, _size, _caller) \
+  ICall_heapReallocCaller(_blk, _size, _caller)
+#else /* HEAPMGR_TRACE */
+#define ICALL_HEAP_CALLER()                  0
+#define ICall_heapMallocFrom(_size, _caller) ICall_heapMalloc(_size)
+#define ICall_heapFreeFrom(_blk, _caller)    ICall_heapFree(_blk)
+#define ICall_heapReallocFrom(_blk, _size, _caller) \
+  ICall_heapRealloc(_blk, _size)
+#endif /* HEAPMGR_TRACE */
+
+#ifdef ICALL_MSG_POOLS
+#define ICALL_MSG_POOL_STORE_SIZE                                   \
+  (ICALL_MSG_POOL_0_BLKSZ * ICALL_MSG_POOL_0_NUMBLKS +              \
+   ICALL_MSG_POOL_1_BLKSZ * ICALL_MSG_POOL_1_NUMBLKS +              \
+   ICALL_MSG_POOL_2_BLKSZ * ICALL_MSG_POOL_2_NUMBLKS)
+
+/* See header file for comments. */
+ICall_MsgPoolStats ICall_msgPoolStats[ICALL_MSG_POOL_NUM];
+
+/* Storage of all pools, laid out in ascending block size order */
+static uint32_t ICall_msgPoolStore[ICALL_MSG_POOL_STORE_SIZE / 4];
+
+/* Free lists of the pools, linked through the first word of each block */
+static void *ICall_msgPoolFreeList[ICALL_MSG_POOL_NUM];
+
+/* End of the storage of each pool */
+static uint8_t *ICall_msgPoolEnd[ICALL_MSG_POOL_NUM];
+
 /**
- * @internal Searches for a task entry within @ref ICall_tasks.
- * @param taskhandle  TI-RTOS task handle
- * @return Pointer to task entry when found, or NULL.
+ * @internal Builds the free lists of the block pools.
  */
-static ICall_TaskEntry *ICall_searchTask(Task_Handle taskhandle)
+static void ICall_msgPoolInit(void)
 {
-  size_t i;
+  static const uint16_t cfg[ICALL_MSG_POOL_NUM][2] =
+  {
+    { ICALL_MSG_POOL_0_BLKSZ, ICALL_MSG_POOL_0_NUMBLKS },
+    { ICALL_MSG_POOL_1_BLKSZ, ICALL_MSG_POOL_1_NUMBLKS },
+    { ICALL_MSG_POOL_2_BLKSZ, ICALL_MSG_POOL_2_NUMBLKS }
+  };
+  uint8_t *blk = (uint8_t *) ICall_msgPoolStore;
+  size_t i, j;
+
+  for (i = 0; i < ICALL_MSG_POOL_NUM; i++)
+  {
+    ICall_msgPoolStats[i].blkSize = cfg[i][0];
+    ICall_msgPoolStats[i].numBlks = cfg[i][1];
+    ICall_msgPoolStats[i].inUse = 0;
+    ICall_msgPoolStats[i].maxInUse = 0;
+    ICall_msgPoolStats[i].allocs = 0;
+    ICall_msgPoolStats[i].overflows = 0;
+    ICall_msgPoolFreeList[i] = NULL;
+    for (j = 0; j < cfg[i][1]; j++)
+    {
+      *(void **) blk = ICall_msgPoolFreeList[i];
+      ICall_msgPoolFreeList[i] = blk;
+      blk += cfg[i][0];
+    }
+    ICall_msgPoolEnd[i] = blk;
+  }
+}
+
+/**
+ * @internal Allocates a block from the smallest fitting pool, or from the
+ *           heap when the pool is exhausted or no pool fits.
+ * @param size    size of the block in bytes
+ * @param caller  return address recorded in the heap trace
+ * @return pointer to the block or NULL
+ */
+static void *ICall_blockAlloc(uint16_t size, uint32_t caller)
+{
+  ICall_MsgPoolStats *stats;
   ICall_CSState key;
+  void *blk;
+  size_t i;
 
-  key = ICall_enterCSImpl();
-  for (i = 0; i < ICALL_MAX_NUM_TASKS; i++)
+  for (i = 0; i < ICALL_MSG_POOL_NUM; i++)
   {
-    if (!ICall_tasks[i].task)
+    if (size <= ICall_msgPoolStats[i].blkSize)
     {
-      /* Empty slot */
       break;
     }
-    if (taskhandle == ICall_tasks[i].task)
+  }
+  if (i == ICALL_MSG_POOL_NUM)
+  {
+    return ICall_heapMallocFrom(size, caller);
+  }
+
+  stats = &ICall_msgPoolStats[i];
+  key = ICall_enterCSImpl();
+  blk = ICall_msgPoolFreeList[i];
+  if (blk != NULL)
+  {
+    ICall_msgPoolFreeList[i] = *(void **) blk;
+    stats->allocs++;
+    if (++stats->inUse > stats->maxInUse)
     {
-      ICall_leaveCSImpl(key);
-      return &ICall_tasks[i];
+      stats->maxInUse = stats->inUse;
     }
   }
+  else
+  {
+    stats->overflows++;
+  }
   ICall_leaveCSImpl(key);
+
+  if (blk == NULL)
+  {
+    blk = ICall_heapMallocFrom(size, caller);
+  }
+  return blk;
+}
+
+/**
+ * @internal Frees a block allocated by @ref ICall_blockAlloc.
+ * @param blk     pointer to the block
+ * @param caller  return address recorded in the heap trace
+ */
+static void ICall_blockFree(void *blk, uint32_t caller)
+{
+  ICall_CSState key;
+  size_t i;
+
+  if ((uint8_t *) blk < (uint8_t *) ICall_msgPoolStore ||
+      (uint8_t *) blk >= ICall_msgPoolEnd[ICALL_MSG_POOL_NUM - 1])
+  {
+    ICall_heapFreeFrom(blk, caller);
+    return;
+  }
+
+  for (i = 0; (uint8_t *) blk >= ICall_msgPoolEnd[i]; i++);
+
+  key = ICall_enterCSImpl();
+  *(void **) blk = ICall_msgPoolFreeList[i];
+  ICall_msgPoolFreeList[i] = blk;
+  ICall_msgPoolStats[i].inUse--;
+  ICall_leaveCSImpl(key);
+}
+
+/**
+ * @internal Resizes a block allocated by @ref ICall_blockAlloc. A pool
+ *           block is kept while the new size fits the pool, otherwise it
+ *           is moved; heap blocks are resized in place where possible.
+ * @param blk     pointer to the block
+ * @param size    new size of the block in bytes
+ * @param caller  return address recorded in the heap trace
+ * @return pointer to the block or NULL, in which case @p blk is untouched
+ */
+static void *ICall_blockRealloc(void *blk, uint16_t size, uint32_t caller)
+{
+  uint16_t blkSize;
+  void *newBlk;
+  size_t i;
+
+  if ((uint8_t *) blk < (uint8_t *) ICall_msgPoolStore ||
+      (uint8_t *) blk >= ICall_msgPoolEnd[ICALL_MSG_POOL_NUM - 1])
+  {
+    return ICall_heapReallocFrom(blk, size, caller);
+  }
+
+  for (i = 0; (uint8_t *) blk >= ICall_msgPoolEnd[i]; i++);
+
+  blkSize = ICall_msgPoolStats[i].blkSize;
+  if (size <= blkSize)
+  {
+    return blk;
+  }
+
+  newBlk = ICall_blockAlloc(size, caller);
+  if (newBlk != NULL)
+  {
+    memcpy(newBlk, blk, blkSize);
+    ICall_blockFree(blk, caller);
+  }
+  return newBlk;
+}
+#else /* ICALL_MSG_POOLS */
+#define ICall_blockAlloc(_size, _caller) ICall_heapMallocFrom(_size, _caller)
+#define ICall_blockFree(_blk, _caller)   ICall_heapFreeFrom(_blk, _caller)
+#define ICall_blockRealloc(_blk, _size, _caller) \
+  ICall_heapReallocFrom(_blk, _size, _caller)
+#endif /* ICALL_MSG_POOLS */
+
+/**
+ * @internal Searches for a task entry within @ref ICall_tasks.
+ * The entry of a task is kept in its TI-RTOS task environment by
+ * @ref ICall_newTask. Entries are never released, so the lookup needs
+ * no critical section.
+ * @param taskhandle  TI-RTOS task handle
+ * @return Pointer to task entry when found, or NULL.
+ */
+static ICall_TaskEntry *ICall_searchTask(Task_Handle taskhandle)
+{
+  ICall_TaskEntry *taskentry = (ICall_TaskEntry *) Task_getEnv(taskhandle);
+
+  /* The environment may belong to somebody else */
+  if (taskentry >= &ICall_tasks[0] &&
+      taskentry < &ICall_tasks[ICALL_MAX_NUM_TASKS] &&
+      taskentry->task == taskhandle)
+  {
+    return taskentry;
+  }
   return NULL;
 }
 
+/**
+ * @internal Records the entity of a service for
+ *           @ref ICall_searchServiceEntity.
+ *           A service enrolled twice keeps its first entity, the one the
+ *           scan of @ref ICall_entities finds.
+ * @param service  service id
+ * @param entity   entity id of the service
+ */
+static void ICall_setServiceEntity(ICall_ServiceEnum service,
+                                   ICall_EntityID entity)
+{
+  if (ICALL_SERVICE_INDEXED(service) &&
+      ICall_serviceEntities[ICALL_SERVICE_INDEX(service)] ==
+      ICALL_INVALID_ENTITY_ID)
+  {
+    ICall_serviceEntities[ICALL_SERVICE_INDEX(service)] = entity;
+  }
+}
+
 /**
  * @internal Searches for a task entry within @ref ICall_tasks or
  *           build an entry if the entry table is empty.
@@ -385,6 +629,12 @@ static ICall_TaskEntry *ICall_newTask(Task_Handle taskhandle)
         /* abort */
         ICALL_HOOK_ABORT_FUNC();
       }
+      if (Task_getEnv(taskhandle) != NULL)
+      {
+        /* The environment is somebody else's; abort */
+        ICALL_HOOK_ABORT_FUNC();
+      }
+      Task_setEnv(taskhandle, taskentry);
       ICall_leaveCSImpl(key);
       return taskentry;
     }
@@ -404,6 +654,11 @@ ICall_EntityID ICall_searchServiceEntity(ICall_ServiceEnum service)
   size_t i;
   ICall_CSState key;
 
+  if (ICALL_SERVICE_INDEXED(service))
+  {
+    return ICall_serviceEntities[ICALL_SERVICE_INDEX(service)];
+  }
+
   key = ICall_enterCSImpl();
   for (i = 0; i < ICALL_MAX_NUM_ENTITIES; i++)
   {
@@ -503,6 +758,16 @@ void ICall_init(void)
   {
     ICall_entities[i].service = ICALL_SERVICE_CLASS_INVALID_ENTRY;
   }
+  for (i = 0; i < ICALL_NUM_SERVICE_INDEXES; i++)
+  {
+    ICall_serviceEntities[i] = ICALL_INVALID_ENTITY_ID;
+  }
+#ifdef ICALL_MSG_TRACE
+  ICall_resetMsgTrace();
+#endif /* ICALL_MSG_TRACE */
+#ifdef ICALL_MSG_POOLS
+  ICall_msgPoolInit();
+#endif /* ICALL_MSG_POOLS */
 
 #ifndef ICALL_JT
   /* Initialize primitive service */
@@ -590,6 +855,7 @@ static ICall_Errno ICall_primEnroll(ICall_EnrollServiceArgs *args)
       ICall_entities[i].service = args->service;
       ICall_entities[i].task = taskentry;
       ICall_entities[i].fn = args->fn;
+      ICall_setServiceEntity(args->service, (ICall_EntityID) i);
       args->entity = (ICall_EntityID) i;
       args->msgSyncHdl = taskentry->syncHandle;
       ICall_leaveCSImpl(key);
@@ -656,7 +922,8 @@ static ICall_Errno ICall_primRegisterApp(ICall_RegisterAppArgs *args)
 static ICall_Errno ICall_primAllocMsg(ICall_AllocArgs *args)
 {
   ICall_MsgHdr *hdr =
-      (ICall_MsgHdr *) ICall_heapMalloc(sizeof(ICall_MsgHdr) + args->size);
+      (ICall_MsgHdr *) ICall_blockAlloc(sizeof(ICall_MsgHdr) + args->size,
+                                       ICALL_HEAP_CALLER());
 
   if (!hdr)
   {
@@ -665,6 +932,7 @@ static ICall_Errno ICall_primAllocMsg(ICall_AllocArgs *args)
   hdr->len = args->size;
   hdr->next = NULL;
   hdr->dest_id = ICALL_UNDEF_DEST_ID;
+  ICALL_MSG_TRACE_CLEAR(hdr + 1);
   args->ptr = (void *) (hdr + 1);
   return ICALL_ERRNO_SUCCESS;
 }
@@ -677,7 +945,8 @@ static ICall_Errno ICall_primAllocMsg(ICall_AllocArgs *args)
 static ICall_Errno ICall_primFreeMsg(ICall_FreeArgs *args)
 {
   ICall_MsgHdr *hdr = (ICall_MsgHdr *) args->ptr - 1;
-  ICall_heapFree(hdr);
+  ICALL_MSG_TRACE_HOP(args->ptr, ICALL_MSG_TRACE_HOP_DONE);
+  ICall_blockFree(hdr, ICALL_HEAP_CALLER());
   return ICALL_ERRNO_SUCCESS;
 }
 
@@ -690,7 +959,7 @@ static ICall_Errno ICall_primFreeMsg(ICall_FreeArgs *args)
  */
 void *ICall_mallocImpl(uint_fast16_t size)
 {
-  return ICall_heapMalloc(size);
+  return ICall_heapMallocFrom(size, ICALL_HEAP_CALLER());
 }
 
 /**
@@ -701,7 +970,7 @@ void *ICall_mallocImpl(uint_fast16_t size)
  */
 void ICall_freeImpl(void *ptr)
 {
-  ICall_heapFree(ptr);
+  ICall_heapFreeFrom(ptr, ICALL_HEAP_CALLER());
 }
 
 /**
@@ -713,7 +982,7 @@ void ICall_freeImpl(void *ptr)
  */
 static ICall_Errno ICall_primMalloc(ICall_AllocArgs *args)
 {
-  args->ptr = ICall_heapMalloc(args->size);
+  args->ptr = ICall_blockAlloc(args->size, ICALL_HEAP_CALLER());
   if (args->ptr == NULL)
   {
     return ICALL_ERRNO_NO_RESOURCE;
@@ -728,11 +997,187 @@ static ICall_Errno ICall_primMalloc(ICall_AllocArgs *args)
  */
 static ICall_Errno ICall_primFree(ICall_FreeArgs *args)
 {
-  ICall_heapFree(args->ptr);
+  ICall_blockFree(args->ptr, ICALL_HEAP_CALLER());
   return ICALL_ERRNO_SUCCESS;
 }
 #endif /* ICALL_JT */
 
+#ifdef ICALL_MSG_TRACE
+/* See header file for comments. */
+ICall_MsgTraceFlow ICall_msgTrace[ICALL_MSG_TRACE_MAX_FLOWS];
+
+/* Send time of a message in flight */
+typedef struct _icall_msg_trace_sent_t
+{
+  void     *msg;       /* Message pointer, NULL for an unused entry */
+  uint32_t  sendTime;  /* Clock tick of the last send */
+} ICall_MsgTraceSent;
+
+/* Send times of the messages in flight */
+static ICall_MsgTraceSent ICall_msgTraceSent[ICALL_MSG_TRACE_MAX_INFLIGHT];
+
+/* See header file for comments. */
+void ICall_resetMsgTrace(void)
+{
+  ICall_CSState key;
+  size_t i;
+
+  key = ICall_enterCSImpl();
+  memset(ICall_msgTrace, 0, sizeof(ICall_msgTrace));
+  memset(ICall_msgTraceSent, 0, sizeof(ICall_msgTraceSent));
+  for (i = 0; i < ICALL_MSG_TRACE_MAX_FLOWS; i++)
+  {
+    ICall_msgTrace[i].srcentity = ICALL_INVALID_ENTITY_ID;
+  }
+  ICall_leaveCSImpl(key);
+}
+
+/**
+ * @internal Finds the send time entry of a message.
+ *           Called within a critical section.
+ * @param msg_ptr  message pointer
+ * @return the entry or NULL if the message is not in flight
+ */
+static ICall_MsgTraceSent *ICall_msgTraceFind(void *msg_ptr)
+{
+  size_t i;
+
+  for (i = 0; i < ICALL_MSG_TRACE_MAX_INFLIGHT; i++)
+  {
+    if (ICall_msgTraceSent[i].msg == msg_ptr)
+    {
+      return &ICall_msgTraceSent[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @internal Records the send time of a message.
+ * @param msg_ptr  message pointer
+ */
+static void ICall_msgTraceSend(void *msg_ptr)
+{
+  ICall_MsgTraceSent *sent;
+  ICall_CSState key;
+  uint32_t now;
+  size_t i;
+
+  key = ICall_enterCSImpl();
+  now = Clock_getTicks();
+  sent = ICall_msgTraceFind(msg_ptr);
+  if (sent == NULL)
+  {
+    /* A free entry, or else the oldest send */
+    sent = &ICall_msgTraceSent[0];
+    for (i = 0; i < ICALL_MSG_TRACE_MAX_INFLIGHT && sent->msg != NULL; i++)
+    {
+      if (ICall_msgTraceSent[i].msg == NULL ||
+          now - ICall_msgTraceSent[i].sendTime > now - sent->sendTime)
+      {
+        sent = &ICall_msgTraceSent[i];
+      }
+    }
+    sent->msg = msg_ptr;
+  }
+  sent->sendTime = now;
+  ICall_leaveCSImpl(key);
+}
+
+/**
+ * @internal Forgets the send time of a message, e.g. once its memory is
+ *           allocated again.
+ * @param msg_ptr  message pointer
+ */
+static void ICall_msgTraceClear(void *msg_ptr)
+{
+  ICall_MsgTraceSent *sent;
+  ICall_CSState key;
+
+  key = ICall_enterCSImpl();
+  sent = ICall_msgTraceFind(msg_ptr);
+  if (sent != NULL)
+  {
+    sent->msg = NULL;
+  }
+  ICall_leaveCSImpl(key);
+}
+
+/**
+ * @internal Records the latency of a message hop, from its last send to now.
+ * @param msg_ptr  message pointer
+ * @param hop      @ref ICALL_MSG_TRACE_HOP_QUEUE or
+ *                 @ref ICALL_MSG_TRACE_HOP_DONE
+ */
+static void ICall_msgTraceHop(void *msg_ptr, uint_least8_t hop)
+{
+  ICall_MsgHdr *hdr = (ICall_MsgHdr *) msg_ptr - 1;
+  ICall_MsgTraceFlow *flow = NULL;
+  ICall_MsgTraceSent *sent;
+  uint_fast32_t us;
+  uint_fast8_t bin;
+  ICall_CSState key;
+  size_t i;
+
+  key = ICall_enterCSImpl();
+  sent = ICall_msgTraceFind(msg_ptr);
+  if (sent == NULL)
+  {
+    /* Never sent */
+    ICall_leaveCSImpl(key);
+    return;
+  }
+
+  us = (Clock_getTicks() - sent->sendTime) * Clock_tickPeriod;
+  for (bin = 0; bin < ICALL_MSG_TRACE_NUM_BINS - 1 && (us >> (bin + 4)); bin++);
+
+  if (hop == ICALL_MSG_TRACE_HOP_DONE)
+  {
+    /* Last hop of the message */
+    sent->msg = NULL;
+  }
+
+  for (i = 0; i < ICALL_MSG_TRACE_MAX_FLOWS; i++)
+  {
+    flow = &ICall_msgTrace[i];
+    if (flow->srcentity == ICALL_INVALID_ENTITY_ID)
+    {
+      /* First message of the flow */
+      flow->srcentity = hdr->srcentity;
+      flow->dstentity = hdr->dstentity;
+      flow->format = hdr->format;
+      break;
+    }
+    if (flow->srcentity == hdr->srcentity &&
+        flow->dstentity == hdr->dstentity &&
+        flow->format == hdr->format)
+    {
+      break;
+    }
+  }
+  if (i < ICALL_MSG_TRACE_MAX_FLOWS)
+  {
+    if (flow->hist[hop][bin] != UINT16_MAX)
+    {
+      flow->hist[hop][bin]++;
+    }
+    if (us > flow->maxUs[hop])
+    {
+      flow->maxUs[hop] = us;
+    }
+  }
+  ICall_leaveCSImpl(key);
+}
+
+#define ICALL_MSG_TRACE_SEND(_msg)       ICall_msgTraceSend(_msg)
+#define ICALL_MSG_TRACE_CLEAR(_msg)      ICall_msgTraceClear(_msg)
+#define ICALL_MSG_TRACE_HOP(_msg, _hop)  ICall_msgTraceHop(_msg, _hop)
+#else /* ICALL_MSG_TRACE */
+#define ICALL_MSG_TRACE_SEND(_msg)
+#define ICALL_MSG_TRACE_CLEAR(_msg)
+#define ICALL_MSG_TRACE_HOP(_msg, _hop)
+#endif /* ICALL_MSG_TRACE */
+
 /**
  * @internal Queues a message to a message queue.
  * @param q_ptr    message queue
@@ -743,6 +1188,8 @@ static void ICall_msgEnqueue( ICall_MsgQueue *q_ptr, void *msg_ptr )
   void *list;
   ICall_CSState key;
 
+  ICALL_MSG_TRACE_SEND(msg_ptr);
+
   // Hold off interrupts
   key = ICall_enterCSImpl();
 
@@ -791,36 +1238,12 @@ static void *ICall_msgDequeue( ICall_MsgQueue *q_ptr )
   // Re-enable interrupts
   ICall_leaveCSImpl(key);
 
-  return msg_ptr;
-}
-
-/**
- * @internal Prepends a list of messages to a message queue
- * @param q_ptr  message queue pointer
- * @param head   message list to prepend
- */
-static void ICall_msgPrepend( ICall_MsgQueue *q_ptr, ICall_MsgQueue head )
-{
-  void *msg_ptr = NULL;
-  ICall_CSState key;
-
-  // Hold off interrupts
-  key = ICall_enterCSImpl();
-
-  if ( head != NULL )
+  if (msg_ptr != NULL)
   {
-    /* Find the end of the queue */
-    msg_ptr = head;
-    while (ICALL_MSG_NEXT( msg_ptr ) != NULL)
-    {
-      msg_ptr = ICALL_MSG_NEXT( msg_ptr );
-    }
-    ICALL_MSG_NEXT(msg_ptr) = *q_ptr;
-    *q_ptr = head;
+    ICALL_MSG_TRACE_HOP(msg_ptr, ICALL_MSG_TRACE_HOP_QUEUE);
   }
 
-  // Re-enable interrupts
-  ICall_leaveCSImpl(key);
+  return msg_ptr;
 }
 
 #ifndef ICALL_JT
@@ -972,6 +1395,68 @@ static ICall_Errno ICall_primEntityId2ServiceId(ICall_EntityID entityId,
   return ICALL_ERRNO_SUCCESS;
 }
 
+/**
+ * @internal
+ * Searches the message queue of the calling task for a message matching
+ * a condition and removes it, leaving the other messages in place.
+ * Only the owner task removes messages from its queue while other threads
+ * only append to it, so the queue is walked without a critical section;
+ * only unlinking the match takes one.
+ *
+ * @param taskentry  task entry of the calling task
+ * @param cursor     last message already found not to match, or NULL to
+ *                   start from the head of the queue. Updated so that the
+ *                   next search only looks at messages queued since.
+ * @param matchFn    match condition
+ * @param servId     pointer to a variable to store the service id
+ *                   of the sender of the matching message
+ * @param dest       pointer to a variable to store the destination
+ *                   entity id of the matching message
+ * @return matching message, or NULL when none is queued.
+ */
+static void *ICall_msgSearchMatch(ICall_TaskEntry *taskentry, void **cursor,
+                                  ICall_MsgMatchFn matchFn,
+                                  ICall_ServiceEnum *servId,
+                                  ICall_EntityID *dest)
+{
+  void *prev = *cursor;
+  void *msg = (prev == NULL) ? taskentry->queue : ICALL_MSG_NEXT(prev);
+
+  while (msg != NULL)
+  {
+    ICall_MsgHdr *hdr = (ICall_MsgHdr *) msg - 1;
+
+    if (ICall_primEntityId2ServiceId(hdr->srcentity, servId) ==
+          ICALL_ERRNO_SUCCESS &&
+        matchFn(*servId, hdr->dstentity, msg))
+    {
+      ICall_CSState key;
+
+      key = ICall_enterCSImpl();
+      if (prev == NULL)
+      {
+        taskentry->queue = ICALL_MSG_NEXT(msg);
+      }
+      else
+      {
+        ICALL_MSG_NEXT(prev) = ICALL_MSG_NEXT(msg);
+      }
+      ICall_leaveCSImpl(key);
+
+      ICALL_MSG_NEXT(msg) = NULL;
+      ICALL_MSG_DEST_ID(msg) = ICALL_UNDEF_DEST_ID;
+      ICALL_MSG_TRACE_HOP(msg, ICALL_MSG_TRACE_HOP_QUEUE);
+      *dest = hdr->dstentity;
+      return msg;
+    }
+    prev = msg;
+    msg = ICALL_MSG_NEXT(msg);
+  }
+
+  *cursor = prev;
+  return NULL;
+}
+
 #ifndef ICALL_JT
 /**
  * @internal Transforms and entityId into a serviceId.
@@ -1449,7 +1934,7 @@ static ICall_Errno ICall_primWaitMatch(ICall_WaitMatchArgs *args)
 {
   Task_Handle taskhandle = Task_self();
   ICall_TaskEntry *taskentry = ICall_searchTask(taskhandle);
-  ICall_MsgQueue prependQueue = NULL;
+  void *cursor = NULL;
 #ifndef ICALL_EVENTS
   uint_fast16_t consumedCount = 0;
 #endif
@@ -1499,35 +1984,17 @@ static ICall_Errno ICall_primWaitMatch(ICall_WaitMatchArgs *args)
   timeoutStamp = Clock_getTicks() + timeout;
   while (ICALL_SYNC_HANDLE_PEND(taskentry->syncHandle, timeout))
   {
-    ICall_FetchMsgArgs fetchArgs;
-    ICall_ServiceEnum servId;
-    errno = ICall_primFetchMsg(&fetchArgs);
-    if (errno == ICALL_ERRNO_SUCCESS)
+    /* Look at the messages queued since the last pass only; messages
+     * that do not match stay where they are in the queue.
+     * Event are binary semaphore, so a single pass must go through all
+     * messages posted while the previous one was being processed. */
+    args->msg = ICall_msgSearchMatch(taskentry, &cursor, args->matchFn,
+                                     &args->servId, &args->dest);
+    if (args->msg != NULL)
     {
-      if (ICall_primEntityId2ServiceId(fetchArgs.src.entityId, &servId) ==
-            ICALL_ERRNO_SUCCESS)
-      {
-        if (args->matchFn(servId, fetchArgs.dest, fetchArgs.msg))
-        {
-          /* Matching message found*/
-          args->servId = servId;
-          args->dest = fetchArgs.dest;
-          args->msg = fetchArgs.msg;
-          errno = ICALL_ERRNO_SUCCESS;
-          break;
-        }
-      }
-      /* Message was received but it wasn't expected one.
-       * Add to the prepend queue */
-      ICall_msgEnqueue(&prependQueue, fetchArgs.msg);
-#ifdef ICALL_EVENTS
-    /* Event are binary semaphore, so if several messsages are posted while
-     * we are processing one, it's possible that some of them are 'missed' and
-     * not processed. Sending a event to ourself force this loop to run until
-     * all the messages in the queue are processed.
-     */
-    ICALL_SYNC_HANDLE_POST(taskentry->syncHandle);
-#endif
+      /* Matching message found*/
+      errno = ICALL_ERRNO_SUCCESS;
+      break;
     }
 
     /* Prepare for timeout exit */
@@ -1559,8 +2026,6 @@ static ICall_Errno ICall_primWaitMatch(ICall_WaitMatchArgs *args)
   ICall_primRepostSync();
 #endif //ICALL_EVENTS
 
-  /* Prepend retrieved irrelevant messages */
-  ICall_msgPrepend(&taskentry->queue, prependQueue);
 #ifndef ICALL_EVENTS
   /* Re-increment the consumed semaphores */
   for (; consumedCount > 0; consumedCount--)
@@ -2260,6 +2725,7 @@ static void ICall_initPrim(void)
 {
   ICall_entities[0].service = ICALL_SERVICE_CLASS_PRIMITIVE;
   ICall_entities[0].fn = ICall_primService;
+  ICall_setServiceEntity(ICALL_SERVICE_CLASS_PRIMITIVE, 0);
 
   /* Initialize heap */
   ICall_heapInit();
@@ -2350,7 +2816,8 @@ ICall_Errno ICall_registerApp(ICall_EntityID *entity,
 void *ICall_allocMsg(size_t size)
 {
   ICall_MsgHdr *hdr =
-      (ICall_MsgHdr *) ICall_heapMalloc(sizeof(ICall_MsgHdr) + size);
+      (ICall_MsgHdr *) ICall_blockAlloc(sizeof(ICall_MsgHdr) + size,
+                                        ICALL_HEAP_CALLER());
 
   if (!hdr)
   {
@@ -2359,6 +2826,7 @@ void *ICall_allocMsg(size_t size)
   hdr->len = size;
   hdr->next = NULL;
   hdr->dest_id = ICALL_UNDEF_DEST_ID;
+  ICALL_MSG_TRACE_CLEAR(hdr + 1);
   return ((void *) (hdr + 1));
 
 }
@@ -2371,7 +2839,8 @@ void *ICall_allocMsg(size_t size)
 void ICall_freeMsg(void *msg)
 {
   ICall_MsgHdr *hdr = (ICall_MsgHdr *) msg - 1;
-  ICall_heapFree(hdr);
+  ICALL_MSG_TRACE_HOP(msg, ICALL_MSG_TRACE_HOP_DONE);
+  ICall_blockFree(hdr, ICALL_HEAP_CALLER());
 }
 
 /**
@@ -2604,6 +3073,7 @@ ICall_enrollService(ICall_ServiceEnum service,
       ICall_entities[i].service = service;
       ICall_entities[i].task = taskentry;
       ICall_entities[i].fn = fn;
+      ICall_setServiceEntity(service, (ICall_EntityID) i);
       *entity = (ICall_EntityID) i;
       *msgSyncHdl = taskentry->syncHandle;
       ICall_leaveCSImpl(key);
@@ -2631,7 +3101,7 @@ ICall_enrollService(ICall_ServiceEnum service,
  */
 void *ICall_malloc(uint_least16_t size)
 {
-  return (ICall_heapMalloc(size));
+  return (ICall_blockAlloc(size, ICALL_HEAP_CALLER()));
 }
 
 /**
@@ -2640,7 +3110,23 @@ void *ICall_malloc(uint_least16_t size)
  */
 void ICall_free(void *msg)
 {
-  ICall_heapFree(msg);
+  ICall_blockFree(msg, ICALL_HEAP_CALLER());
+}
+
+/**
+ * Resizes a memory block allocated by ICall_malloc().
+ * @param msg   pointer to the memory block, or NULL to allocate a new one.
+ * @param size  new size of the block in bytes.
+ * @return address of the resized memory block or NULL
+ *         if resizing fails, in which case @p msg is left untouched.
+ */
+void *ICall_realloc(void *msg, uint_least16_t size)
+{
+  if (msg == NULL)
+  {
+    return (ICall_blockAlloc(size, ICALL_HEAP_CALLER()));
+  }
+  return (ICall_blockRealloc(msg, size, ICALL_HEAP_CALLER()));
 }
 
 /**
@@ -3495,7 +3981,7 @@ ICall_waitMatch(uint_least32_t milliseconds,
 {
   Task_Handle taskhandle = Task_self();
   ICall_TaskEntry *taskentry = ICall_searchTask(taskhandle);
-  ICall_MsgQueue prependQueue = NULL;
+  void *cursor = NULL;
 #ifndef ICALL_EVENTS
   uint_fast16_t consumedCount = 0;
 #endif
@@ -3545,45 +4031,30 @@ ICall_waitMatch(uint_least32_t milliseconds,
   timeoutStamp = Clock_getTicks() + timeout;
   while (ICALL_SYNC_HANDLE_PEND(taskentry->syncHandle, timeout))
   {
-    //ICall_FetchMsgArgs fetchArgs;
-    ICall_EntityID fetchSrc;
     ICall_EntityID fetchDst;
     ICall_ServiceEnum servId;
     void *fetchMsg;
-    //errno = ICall_primFetchMsg(&fetchArgs);
-    errno = ICall_fetchMsg(&fetchSrc, &fetchDst, &fetchMsg);
-    if (errno == ICALL_ERRNO_SUCCESS)
+
+    /* Look at the messages queued since the last pass only; messages
+     * that do not match stay where they are in the queue.
+     * Event are binary semaphore, so a single pass must go through all
+     * messages posted while the previous one was being processed. */
+    fetchMsg = ICall_msgSearchMatch(taskentry, &cursor, matchFn,
+                                    &servId, &fetchDst);
+    if (fetchMsg != NULL)
     {
-      if (ICall_primEntityId2ServiceId(fetchSrc, &servId) ==
-            ICALL_ERRNO_SUCCESS)
+      /* Matching message found*/
+      if (src != NULL)
       {
-        if (matchFn(servId, fetchDst, fetchMsg))
-        {
-          /* Matching message found*/
-          if (src != NULL)
-          {
-            *src = servId;
-          }
-          if (dest != NULL)
-          {
-            *dest = fetchDst;
-          }
-          *msg = fetchMsg;
-          errno = ICALL_ERRNO_SUCCESS;
-          break;
-        }
+        *src = servId;
       }
-      /* Message was received but it wasn't expected one.
-       * Add to the prepend queue */
-      ICall_msgEnqueue(&prependQueue, fetchMsg);
-#ifdef ICALL_EVENTS
-    /* Event are binary semaphore, so if several messsages are posted while
-     * we are processing one, it's possible that some of them are 'missed' and
-     * not processed. Sending a event to ourself force this loop to run until
-     * all the messages in the queue are processed.
-     */
-    ICALL_SYNC_HANDLE_POST(taskentry->syncHandle);
-#endif
+      if (dest != NULL)
+      {
+        *dest = fetchDst;
+      }
+      *msg = fetchMsg;
+      errno = ICALL_ERRNO_SUCCESS;
+      break;
     }
 
     /* Prepare for timeout exit */
@@ -3615,8 +4086,6 @@ ICall_waitMatch(uint_least32_t milliseconds,
   ICall_primRepostSync();
 #endif //ICALL_EVENTS
 
-  /* Prepend retrieved irrelevant messages */
-  ICall_msgPrepend(&taskentry->queue, prependQueue);
 #ifndef ICALL_EVENTS
   /* Re-increment the consumed semaphores */
   for (; consumedCount > 0; consumedCount--)
@@ -3755,6 +4224,9 @@ ICall_getLocalMsgEntityId(ICall_ServiceEnum service, ICall_EntityID entity)
 #endif /* ICALL_JT */
 
 #ifdef ICALL_LITE
+/* Asynchronous direct API calls that failed or could not be queued */
+static uint_least32_t icallLiteAsyncFailures = 0;
+
  /*******************************************************************************
  * @fn          matchLiteCS
  */
@@ -3766,20 +4238,20 @@ static bool matchLiteCS(ICall_ServiceEnum src,
   ICall_LiteCmdStatus *pMsg = (ICall_LiteCmdStatus *)msg;
   return (pMsg->cmdId == ICALL_LITE_DIRECT_API_DONE_CMD_ID);
 }
+
  /*******************************************************************************
- * @fn          icall_directAPI
- * see headers for details.
+ * @fn          icall_liteSendAndWait
+ *
+ * @brief       Send a direct API message to the service and block until the
+ *              stack confirms it has been executed.
+ *
+ * @param       service: service the API belongs to
+ *              pLiteMsg: message to send, header filled in here.
+ *
+ * @return      None
  */
-uint32_t icall_directAPI( uint8_t service , icall_lite_id_t id, ... )
+static void icall_liteSendAndWait(uint8_t service, icallLiteMsg_t *pLiteMsg)
 {
-  va_list argp;
-  uint32_t res;
-  icallLiteMsg_t liteMsg;
-  
-  // The following will push all parameter in the runtime stack.
-  // This need to be call before any other local declaration of variable....
-  va_start(argp, id);
-
   // Test that the API is not called in a Hwi or Swi context
   {
     BIOS_ThreadType threadtype = BIOS_getThreadType();
@@ -3792,13 +4264,11 @@ uint32_t icall_directAPI( uint8_t service , icall_lite_id_t id, ... )
   }
 
   // Create the message that will be send to the requested service..
-  liteMsg.hdr.len = sizeof(icallLiteMsg_t);
-  liteMsg.hdr.next = NULL;
-  liteMsg.hdr.dest_id = ICALL_UNDEF_DEST_ID;
-  liteMsg.msg.directAPI  = id;
-  liteMsg.msg.pointerStack = (uint32_t*)(*((uint32_t*)(&argp)));
-  ICall_sendServiceMsg(ICall_getEntityId(), service, 
-                       ICALL_MSG_FORMAT_DIRECT_API_ID, &(liteMsg.msg));
+  pLiteMsg->hdr.len = sizeof(icallLiteMsg_t);
+  pLiteMsg->hdr.next = NULL;
+  pLiteMsg->hdr.dest_id = ICALL_UNDEF_DEST_ID;
+  ICall_sendServiceMsg(ICall_getEntityId(), service,
+                       ICALL_MSG_FORMAT_DIRECT_API_ID, &(pLiteMsg->msg));
 
   // Since stack needs to always have a higher priority than the thread calling
   // the API, when we reach this point the API has been executed by the stack.
@@ -3808,29 +4278,55 @@ uint32_t icall_directAPI( uint8_t service , icall_lite_id_t id, ... )
   // It is possible that the stack is blocking on this API, in this case a
   // sync object needs to be used in order for this call to resume only when
   // the API has been process in full.
+  // The stack keeps its command status and sends the same message again on
+  // the next call: it is handed back by clearing inFlight. A status sent
+  // while that one was still queued is a fresh message, freed here.
   {
     ICall_Errno errno;
-    void *pCmdStatus = NULL;
-    
+    ICall_LiteCmdStatus *pCmdStatus = NULL;
+
     errno = ICall_waitMatch(ICALL_TIMEOUT_PREDEFINE, matchLiteCS, NULL, NULL,
                     (void **)&pCmdStatus);
     if (errno == ICALL_ERRNO_TIMEOUT)
     {
       HAL_ASSERT(HAL_ASSERT_CAUSE_ICALL_TIMEOUT);
     }
-    else if (errno == ICALL_ERRNO_SUCCESS)
+    else if (errno != ICALL_ERRNO_SUCCESS)
     {
-      if (pCmdStatus)
-      {
-        ICall_freeMsg(pCmdStatus);
-      }
+      HAL_ASSERT(HAL_ASSERT_CAUSE_ICALL_ABORT);
+    }
+    else if (pCmdStatus->inFlight)
+    {
+      pCmdStatus->inFlight = FALSE;
     }
     else
     {
-      HAL_ASSERT(HAL_ASSERT_CAUSE_ICALL_ABORT);
+      ICall_freeMsg(pCmdStatus);
     }
   }
 
+  // Round trip of the call, from send to completion
+  ICALL_MSG_TRACE_HOP(&(pLiteMsg->msg), ICALL_MSG_TRACE_HOP_DONE);
+}
+
+ /*******************************************************************************
+ * @fn          icall_directAPI
+ * see headers for details.
+ */
+uint32_t icall_directAPI( uint8_t service , icall_lite_id_t id, ... )
+{
+  va_list argp;
+  uint32_t res;
+  icallLiteMsg_t liteMsg;
+  
+  // The following will push all parameter in the runtime stack.
+  // This need to be call before any other local declaration of variable....
+  va_start(argp, id);
+
+  liteMsg.msg.directAPI  = id;
+  liteMsg.msg.pointerStack = (uint32_t*)(*((uint32_t*)(&argp)));
+  icall_liteSendAndWait(service, &liteMsg);
+
   // The return parameter is set in the runtime stack, at the location of the
   // first parameter.
   res = liteMsg.msg.pointerStack[0];
@@ -3839,4 +4335,113 @@ uint32_t icall_directAPI( uint8_t service , icall_lite_id_t id, ... )
 
   return (res);
 }
+
+ /*******************************************************************************
+ * @fn          icall_directAPIBatch
+ * see headers for details.
+ */
+void icall_directAPIBatch( uint8_t service, icall_liteCall_t *pCalls,
+                           uint_least8_t numCalls )
+{
+  icallLiteMsg_t liteMsg;
+  icall_liteBatch_t batch;
+
+  if (numCalls == 0)
+  {
+    return;
+  }
+
+  batch.pCalls = pCalls;
+  batch.numCalls = numCalls;
+
+  liteMsg.msg.directAPI = ICALL_LITE_BATCH_ID;
+  liteMsg.msg.pointerStack = (uint_least32_t *)&batch;
+  icall_liteSendAndWait(service, &liteMsg);
+}
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsync
+ * see headers for details.
+ */
+ICall_Errno icall_directAPIAsync( uint8_t service,
+                                  const icall_liteCall_t *pCall,
+                                  const void *pData, uint_least8_t dataLen,
+                                  uint_least8_t dataParam,
+                                  icall_liteAsyncCB_t pfnCB )
+{
+  icall_liteAsyncMsg_t *pAsync;
+  ICall_Errno errno;
+
+  if ((dataLen > ICALL_LITE_ASYNC_DATA_SIZE) ||
+      ((dataParam != ICALL_LITE_ASYNC_NO_DATA_PARAM) &&
+       (dataParam >= ICALL_LITE_MAX_PARAMS)))
+  {
+    return (ICALL_ERRNO_INVALID_PARAMETER);
+  }
+
+  pAsync = (icall_liteAsyncMsg_t *)ICall_allocMsg(sizeof(icall_liteAsyncMsg_t));
+  if (pAsync == NULL)
+  {
+    icallLiteAsyncFailures++;
+
+    return (ICALL_ERRNO_NO_RESOURCE);
+  }
+
+  pAsync->call = *pCall;
+  pAsync->pfnCB = pfnCB;
+
+  if (pData != NULL)
+  {
+    memcpy(pAsync->data, pData, dataLen);
+  }
+
+  if (dataParam != ICALL_LITE_ASYNC_NO_DATA_PARAM)
+  {
+    pAsync->call.param[dataParam] = (uint_least32_t)pAsync->data;
+  }
+
+  pAsync->msg.directAPI = ICALL_LITE_ASYNC_ID;
+  pAsync->msg.pointerStack = pAsync->call.param;
+
+  // No completion is awaited: the stack frees the message, or hands it back
+  // on failure or to the callback
+  errno = ICall_sendServiceMsg(ICall_getEntityId(), service,
+                               ICALL_MSG_FORMAT_DIRECT_API_ID, pAsync);
+  if (errno != ICALL_ERRNO_SUCCESS)
+  {
+    // Never queued, so it is still ours
+    ICall_freeMsg(pAsync);
+    icallLiteAsyncFailures++;
+  }
+
+  return (errno);
+}
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsyncComplete
+ * see headers for details.
+ */
+void icall_directAPIAsyncComplete( void *pMsg )
+{
+  icall_liteAsyncMsg_t *pAsync = (icall_liteAsyncMsg_t *)pMsg;
+
+  if ((uint8_t)pAsync->call.param[0] != SUCCESS)
+  {
+    icallLiteAsyncFailures++;
+  }
+
+  if (pAsync->pfnCB != NULL)
+  {
+    pAsync->pfnCB(&pAsync->call, pAsync->data);
+  }
+}
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsyncFailures
+ * see headers for details.
+ */
+uint_least32_t icall_directAPIAsyncFailures( void )
+{
+  return (icallLiteAsyncFailures);
+}
 #endif /* ICALL_LITE*/
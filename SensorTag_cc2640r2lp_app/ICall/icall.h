@@ -229,6 +229,11 @@ extern "C" {
  */
 #define ICALL_LITE_DIRECT_API_DONE_CMD_ID  0x42
 
+/**
+ * Message CMD ID returning a failed asynchronous DIRECT_API CMD to its caller
+ */
+#define ICALL_LITE_DIRECT_API_ASYNC_CMD_ID 0x43
+
 #endif   /* ICALL_LITE */
 
 /**
@@ -796,6 +801,114 @@ typedef struct _icall_msg_hdr_t
   uint8_t  dest_id;
 } ICall_MsgHdr;
 
+#ifdef ICALL_MSG_TRACE
+/*
+ * Message latency tracing. Send times are kept in a table indexed by
+ * message pointer, so ICall_MsgHdr, which the stack shares with OSAL,
+ * keeps its layout.
+ */
+
+/** Maximum number of traced (source, destination, format) flows */
+#ifndef ICALL_MSG_TRACE_MAX_FLOWS
+#define ICALL_MSG_TRACE_MAX_FLOWS          8
+#endif /* ICALL_MSG_TRACE_MAX_FLOWS */
+
+/**
+ * Maximum number of messages whose send time is tracked at once. When the
+ * table is full the oldest send is dropped, e.g. one freed by the stack
+ * without passing through ICall_freeMsg().
+ */
+#ifndef ICALL_MSG_TRACE_MAX_INFLIGHT
+#define ICALL_MSG_TRACE_MAX_INFLIGHT       16
+#endif /* ICALL_MSG_TRACE_MAX_INFLIGHT */
+
+/**
+ * Number of latency histogram bins. Bin 0 counts latencies below 16us,
+ * each following bin twice the range of the previous one, and the last
+ * bin everything above.
+ */
+#define ICALL_MSG_TRACE_NUM_BINS           12
+
+/** Hop from send to fetch by the receiving task */
+#define ICALL_MSG_TRACE_HOP_QUEUE          0
+/** Hop from send to free, or to completion for a direct API call */
+#define ICALL_MSG_TRACE_HOP_DONE           1
+#define ICALL_MSG_TRACE_NUM_HOPS           2
+
+/** Latency histograms of a flow */
+typedef struct _icall_msg_trace_flow_t
+{
+  uint8_t  srcentity;   /* Source entity, 0xFF for an unused flow */
+  uint8_t  dstentity;   /* Destination entity */
+  uint8_t  format;      /* Message format */
+  uint16_t hist[ICALL_MSG_TRACE_NUM_HOPS][ICALL_MSG_TRACE_NUM_BINS];
+  uint32_t maxUs[ICALL_MSG_TRACE_NUM_HOPS];  /* Highest latency, in us */
+} ICall_MsgTraceFlow;
+
+/**
+ * Histograms of the traced flows. Global so that it can be located in the
+ * map file and dumped, e.g. through the Register service MCU interface.
+ * Flows that did not fit are not recorded.
+ */
+extern ICall_MsgTraceFlow ICall_msgTrace[ICALL_MSG_TRACE_MAX_FLOWS];
+
+/**
+ * Clears the message latency histograms.
+ */
+extern void ICall_resetMsgTrace(void);
+#endif /* ICALL_MSG_TRACE */
+
+#ifdef ICALL_MSG_POOLS
+/*
+ * Fixed-size block pools in front of the ICall heap, for ICall_allocMsg()
+ * and ICall_malloc(). The stack image allocates its OSAL messages and
+ * buffers through ICall_malloc(), so these are served as well. A request
+ * is served by the smallest pool whose blocks fit it, or by the heap when
+ * that pool is exhausted or no pool fits. Block sizes include the message
+ * header for ICall_allocMsg() and must be multiples of 4, in ascending
+ * order. Blocks allocated once for the lifetime of the application also
+ * land in the pools, so the block counts should be tuned from
+ * @ref ICall_msgPoolStats.
+ */
+#define ICALL_MSG_POOL_NUM                 3
+
+#ifndef ICALL_MSG_POOL_0_BLKSZ
+#define ICALL_MSG_POOL_0_BLKSZ             16
+#endif /* ICALL_MSG_POOL_0_BLKSZ */
+#ifndef ICALL_MSG_POOL_0_NUMBLKS
+#define ICALL_MSG_POOL_0_NUMBLKS           12
+#endif /* ICALL_MSG_POOL_0_NUMBLKS */
+#ifndef ICALL_MSG_POOL_1_BLKSZ
+#define ICALL_MSG_POOL_1_BLKSZ             32
+#endif /* ICALL_MSG_POOL_1_BLKSZ */
+#ifndef ICALL_MSG_POOL_1_NUMBLKS
+#define ICALL_MSG_POOL_1_NUMBLKS           8
+#endif /* ICALL_MSG_POOL_1_NUMBLKS */
+#ifndef ICALL_MSG_POOL_2_BLKSZ
+#define ICALL_MSG_POOL_2_BLKSZ             64
+#endif /* ICALL_MSG_POOL_2_BLKSZ */
+#ifndef ICALL_MSG_POOL_2_NUMBLKS
+#define ICALL_MSG_POOL_2_NUMBLKS           4
+#endif /* ICALL_MSG_POOL_2_NUMBLKS */
+
+/** Usage counters of a block pool */
+typedef struct _icall_msg_pool_stats_t
+{
+  uint16_t blkSize;    /* Block size in bytes */
+  uint16_t numBlks;    /* Number of blocks */
+  uint16_t inUse;      /* Blocks currently allocated */
+  uint16_t maxInUse;   /* Highest number of blocks allocated at once */
+  uint32_t allocs;     /* Allocations served by the pool */
+  uint32_t overflows;  /* Allocations that fell back to the heap */
+} ICall_MsgPoolStats;
+
+/**
+ * Usage counters of the pools, in ascending block size order. Global so
+ * that they can be located in the map file and dumped.
+ */
+extern ICall_MsgPoolStats ICall_msgPoolStats[ICALL_MSG_POOL_NUM];
+#endif /* ICALL_MSG_POOLS */
+
 /**
  * Power state transition type of the following values:<br>
  * @ref ICALL_PWR_AWAKE_FROM_STANDBY<br>
@@ -1006,6 +1119,7 @@ typedef uint_least32_t icall_lite_id_t;
 typedef struct _ICall_LiteCmdStatus_
 {
   uint_least8_t cmdId;        //!< command id (applicable only to User Profile subgrp)
+  uint_least8_t inFlight;     //!< set while the stack's status is queued, cleared by the callee; zero on a status the callee frees
 } ICall_LiteCmdStatus;
 
 PACKED_TYPEDEF_STRUCT
@@ -1020,6 +1134,85 @@ PACKED_TYPEDEF_STRUCT
   icall_directAPIMsg_t   msg;
 } icallLiteMsg_t;
 
+/**
+ * Number of parameters passed to a stack API, as built into the stack
+ */
+#if defined(ICALL_LITE_4_PARAMS)
+#define ICALL_LITE_MAX_PARAMS              4
+#elif defined(ICALL_LITE_12_PARAMS)
+#define ICALL_LITE_MAX_PARAMS              12
+#else
+#define ICALL_LITE_MAX_PARAMS              8
+#endif
+
+/**
+ * Direct API id of a message carrying a batch of calls
+ * (see @ref icall_directAPIBatch). Never a valid jump table index nor
+ * function address.
+ */
+#define ICALL_LITE_BATCH_ID                0xFFFFFFFF
+
+/**
+ * One stack API call of a batch
+ */
+typedef struct _icall_liteCall_
+{
+  icall_lite_id_t directAPI;                    //!< Id of the stack API
+  uint_least32_t  param[ICALL_LITE_MAX_PARAMS]; //!< Parameters; param[0]
+                                                //!< returns the result
+} icall_liteCall_t;
+
+/**
+ * Batch descriptor, pointed to by pointerStack when directAPI is
+ * @ref ICALL_LITE_BATCH_ID
+ */
+typedef struct _icall_liteBatch_
+{
+  icall_liteCall_t *pCalls;    //!< Calls, executed in order
+  uint_least32_t   numCalls;   //!< Number of calls
+} icall_liteBatch_t;
+
+/**
+ * Direct API id of an asynchronous call message
+ * (see @ref icall_directAPIAsync)
+ */
+#define ICALL_LITE_ASYNC_ID                0xFFFFFFFE
+
+/**
+ * Size of the caller data copied into an asynchronous call message
+ */
+#ifndef ICALL_LITE_ASYNC_DATA_SIZE
+#define ICALL_LITE_ASYNC_DATA_SIZE         32
+#endif
+
+/**
+ * Parameter index meaning no parameter points to the caller data
+ */
+#define ICALL_LITE_ASYNC_NO_DATA_PARAM     0xFF
+
+/**
+ * Called in the caller's thread when an asynchronous call completed.
+ *
+ * @param pCall  call as executed; param[0] holds the returned status
+ * @param pData  copy of the caller data
+ */
+typedef void (*icall_liteAsyncCB_t)(icall_liteCall_t *pCall, void *pData);
+
+/**
+ * Asynchronous call message. The stack frees it once the call returned
+ * SUCCESS and pfnCB is NULL, otherwise it is sent back to the caller with
+ * its first byte replaced by @ref ICALL_LITE_DIRECT_API_ASYNC_CMD_ID.
+ */
+typedef struct _icall_liteAsyncMsg_
+{
+  icall_directAPIMsg_t msg;    //!< Must be first, directAPI is
+                               //!< @ref ICALL_LITE_ASYNC_ID
+  icall_liteCall_t     call;   //!< Call to execute
+  icall_liteAsyncCB_t  pfnCB;  //!< Completion callback, may be NULL
+  uint_least32_t       data[ICALL_LITE_ASYNC_DATA_SIZE /
+                            sizeof(uint_least32_t)];  //!< Caller data
+} icall_liteAsyncMsg_t;
+
 #endif /* ICALL_LITE */
 
 /**
@@ -1091,6 +1284,102 @@ extern ICall_EntityID ICall_searchServiceEntity(ICall_ServiceEnum service);
  * @return      register r0 will be populated with any return value fill by the Stack API.
  */
 uint32_t icall_directAPI( uint8_t service, icall_lite_id_t id, ... );
+
+ /*******************************************************************************
+ * @fn          icall_directAPIBatch
+ *
+ * @brief       Execute several stack API calls in one round trip to the stack
+ *              context. The calls run back to back in the given order and a
+ *              single completion is returned for the whole batch, instead of
+ *              one message, context switch and status per call.
+ *
+ *              Calls of a batch must not depend on each other's results.
+ *
+ * input parameters
+ *
+ * @param       service: service the APIs belong to
+ *              pCalls: calls to execute, parameters filled in by the caller.
+ *              numCalls: number of calls.
+ *
+ * output parameters
+ *
+ * @param       pCalls: param[0] of each call holds the value returned by the
+ *              stack API.
+ *
+ * @return      None
+ */
+void icall_directAPIBatch( uint8_t service, icall_liteCall_t *pCalls,
+                           uint_least8_t numCalls );
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsync
+ *
+ * @brief       Queue a stack API call and return without waiting for it.
+ *              The call and the caller data are copied into the message, so
+ *              neither needs to outlive this function. Use it for calls whose
+ *              result the caller would only log, and which return a status
+ *              (bStatus_t) that is SUCCESS when they succeed.
+ *
+ *              With pfnCB, the call is reported back through it, from the
+ *              caller's thread, once it hands the returned message to
+ *              @ref icall_directAPIAsyncComplete. Without it only a failed
+ *              call comes back.
+ *
+ * input parameters
+ *
+ * @param       service: service the API belongs to
+ *              pCall: call to execute
+ *              pData: data to copy into the message, may be NULL
+ *              dataLen: length of pData, at most ICALL_LITE_ASYNC_DATA_SIZE
+ *              dataParam: index of the parameter replaced by the address of
+ *                         the copy of pData, or
+ *                         @ref ICALL_LITE_ASYNC_NO_DATA_PARAM
+ *              pfnCB: completion callback, may be NULL
+ *
+ * output parameters
+ *
+ * @param       None
+ *
+ * @return      @ref ICALL_ERRNO_SUCCESS when queued,
+ *              @ref ICALL_ERRNO_INVALID_PARAMETER,
+ *              @ref ICALL_ERRNO_NO_RESOURCE or the error of
+ *              ICall_sendServiceMsg() otherwise. The message is freed
+ *              when it could not be queued.
+ */
+ICall_Errno icall_directAPIAsync( uint8_t service,
+                                  const icall_liteCall_t *pCall,
+                                  const void *pData, uint_least8_t dataLen,
+                                  uint_least8_t dataParam,
+                                  icall_liteAsyncCB_t pfnCB );
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsyncComplete
+ *
+ * @brief       Handle an asynchronous call returned by the stack
+ *              (@ref ICALL_LITE_DIRECT_API_ASYNC_CMD_ID) and invoke its
+ *              completion callback. The caller still frees the message.
+ *
+ * input parameters
+ *
+ * @param       pMsg: message received from the stack
+ *
+ * output parameters
+ *
+ * @param       None
+ *
+ * @return      None
+ */
+void icall_directAPIAsyncComplete( void *pMsg );
+
+ /*******************************************************************************
+ * @fn          icall_directAPIAsyncFailures
+ *
+ * @brief       Number of asynchronous calls that failed or could not be
+ *              queued.
+ *
+ * @return      Failure count, wrapping around.
+ */
+uint_least32_t icall_directAPIAsyncFailures( void );
 #endif /* ICALL_LITE */
 
 #ifdef ICALL_JT
@@ -1257,6 +1546,16 @@ void *ICall_malloc(uint_least16_t size);
  */
 void ICall_free(void *msg);
 
+/**
+ * Resizes a memory block allocated by ICall_malloc(), in place when the
+ * heap has room for it.
+ * @param msg   pointer to the memory block, or NULL to allocate a new one.
+ * @param size  new size of the block in bytes.
+ * @return address of the resized memory block or NULL
+ *         if resizing fails, in which case @p msg is left untouched.
+ */
+void *ICall_realloc(void *msg, uint_least16_t size);
+
 /**
  * Sends a message to an entity.
  * @param src     entity id of the sender
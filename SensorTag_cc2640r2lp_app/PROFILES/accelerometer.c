@@ -62,6 +62,7 @@
 #include "gatt.h"
 #include "gatt_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 
 #include "accelerometer.h"
 
@@ -430,6 +431,12 @@ bStatus_t Accel_AddService(uint32 services)
                                          GATT_NUM_ATTRS(accelAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &accelCBs);
+
+    if (status == SUCCESS)
+    {
+      // Add the service to the database hash
+      VOID GATTDbHash_addService(accelAttrTbl, GATT_NUM_ATTRS(accelAttrTbl));
+    }
   }
 
   return (status);
@@ -69,6 +69,8 @@
 #include "gatt_uuid.h"
 #include "gatt_profile_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
+#include "gatt_tx_queue.h"
 #include "hiddev.h"
 
 #include "battservice.h"
@@ -286,6 +288,12 @@ bStatus_t Batt_AddService(void)
                                        GATT_MAX_ENCRYPT_KEY_SIZE,
                                        &battCBs);
 
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(battAttrTbl, GATT_NUM_ATTRS(battAttrTbl));
+  }
+
   // Enable the Battery Monitor.
   // The batterry monitor is enable and configure at startup by the boot code, it should not be change.
 
@@ -568,21 +576,10 @@ static void battNotify(uint16_t connHandle)
                                            battLevelClientCharCfg);
   if (value & GATT_CLIENT_CFG_NOTIFY)
   {
-    attHandleValueNoti_t noti;
-
-    noti.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_NOTI,
-                                BATT_LEVEL_VALUE_LEN, NULL);
-    if (noti.pValue != NULL)
-    {
-      noti.handle = battAttrTbl[BATT_LEVEL_VALUE_IDX].handle;
-      noti.len = BATT_LEVEL_VALUE_LEN;
-      noti.pValue[0] = battLevel;
-
-      if (GATT_Notification(connHandle, &noti, FALSE) != SUCCESS)
-      {
-        GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
-      }
-    }
+    // Queued for a later connection event if no buffer is available
+    VOID GATTTxQueue_sendNotiInd(connHandle, GATT_CLIENT_CFG_NOTIFY, FALSE,
+                                 &battAttrTbl[BATT_LEVEL_VALUE_IDX], 0,
+                                 battReadAttrCB);
   }
 }
 
@@ -66,6 +66,7 @@
 #include "gatt.h"
 #include "gatt_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 #include "gapbondmgr.h"
 #include "string.h"
 
@@ -312,6 +313,8 @@ CONST gattServiceCBs_t ccServiceCBs =
 */
 bStatus_t CcService_addService(void)
 {
+  bStatus_t status;
+
   // Allocate Client Characteristic Configuration table
   ccDataConfig = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
                                                 linkDBNumConns);
@@ -324,10 +327,18 @@ bStatus_t CcService_addService(void)
   GATTServApp_InitCharCfg(INVALID_CONNHANDLE, ccDataConfig);
 
   // Register GATT attribute list and CBs with GATT Server App
-  return GATTServApp_RegisterService(ccServiceAttrTbl,
-                                     GATT_NUM_ATTRS(ccServiceAttrTbl),
-                                     GATT_MAX_ENCRYPT_KEY_SIZE,
-                                     &ccServiceCBs);
+  status = GATTServApp_RegisterService(ccServiceAttrTbl,
+                                       GATT_NUM_ATTRS(ccServiceAttrTbl),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &ccServiceCBs);
+
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(ccServiceAttrTbl, GATT_NUM_ATTRS(ccServiceAttrTbl));
+  }
+
+  return (status);
 }
 
 
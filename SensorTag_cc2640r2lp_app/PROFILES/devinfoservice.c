@@ -56,6 +56,7 @@
 #include "gatt_uuid.h"
 #include "gatt_profile_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 
 #include "devinfoservice.h"
 #include "icall_api.h"
@@ -412,11 +413,21 @@ CONST gattServiceCBs_t devInfoCBs =
  */
 bStatus_t DevInfo_AddService( void )
 {
+  bStatus_t status;
+
   // Register GATT attribute list and CBs with GATT Server App
-  return GATTServApp_RegisterService( devInfoAttrTbl,
-                                      GATT_NUM_ATTRS( devInfoAttrTbl ),
-                                      GATT_MAX_ENCRYPT_KEY_SIZE,
-                                      &devInfoCBs );
+  status = GATTServApp_RegisterService( devInfoAttrTbl,
+                                        GATT_NUM_ATTRS( devInfoAttrTbl ),
+                                        GATT_MAX_ENCRYPT_KEY_SIZE,
+                                        &devInfoCBs );
+
+  if ( status == SUCCESS )
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService( devInfoAttrTbl, GATT_NUM_ATTRS( devInfoAttrTbl ) );
+  }
+
+  return ( status );
 }
 
 /*********************************************************************
@@ -530,16 +541,21 @@ bStatus_t DevInfo_SetParameter( uint8 param, uint8 len, void *value )
 
     case DEVINFO_11073_CERT_DATA:
       {
-        // Allocate buffer for new certification
-        uint8 *pCert = ICall_malloc(len);
+        uint8 *pCert;
+
+        if (devInfo11073Cert != defaultDevInfo11073Cert)
+        {
+          // Resize existing certification buffer
+          pCert = ICall_realloc(devInfo11073Cert, len);
+        }
+        else
+        {
+          // Allocate buffer for new certification
+          pCert = ICall_malloc(len);
+        }
+
         if (pCert != NULL)
         {
-          if (devInfo11073Cert != defaultDevInfo11073Cert)
-          {
-            // Free existing certification buffer
-            ICall_free(devInfo11073Cert);
-          }
-          
           // Copy over new certification
           memcpy(pCert, value, len);
           
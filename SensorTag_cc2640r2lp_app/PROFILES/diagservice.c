@@ -0,0 +1,349 @@
+/******************************************************************************
+
+ @file  diagservice.c
+
+ @brief Diagnostic service. Exposes the boot profile: the time each
+        start-up phase was reached.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2015-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef EXCLUDE_BOOT_PROFILE
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "gatt_db_hash.h"
+#include "string.h"
+
+#include "diagservice.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Attribute names
+#ifdef USER_DESCRIPTION
+#define DIAG_BOOT_DESCR           "Boot Profile"
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Service UUID
+static CONST uint8_t diagServiceUUID[TI_UUID_SIZE] =
+{
+  TI_UUID(DIAG_SERV_UUID),
+};
+
+// Characteristic UUID: boot profile
+static CONST uint8_t diagBootUUID[TI_UUID_SIZE] =
+{
+  TI_UUID(DIAG_BOOT_UUID),
+};
+
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Length of the boot profile value
+static uint8_t diagBootProfileLen = 0;
+
+/*********************************************************************
+ * Profile Attributes - variables
+ */
+
+// Profile Service attribute
+static CONST gattAttrType_t diagService = { TI_UUID_SIZE, diagServiceUUID };
+
+// Characteristic Properties: boot profile
+static uint8_t diagBootProps = GATT_PROP_READ;
+
+// Characteristic Value: boot profile
+static uint8_t diagBootProfile[DIAG_BOOT_PROFILE_MAX_LEN];
+
+#ifdef USER_DESCRIPTION
+// Characteristic User Description: boot profile
+static uint8_t diagBootUserDescr[] = DIAG_BOOT_DESCR;
+#endif
+
+/*********************************************************************
+ * Profile Attributes - Table
+ */
+
+static gattAttribute_t diagAttrTable[] =
+{
+  {
+    { ATT_BT_UUID_SIZE, primaryServiceUUID }, /* type */
+    GATT_PERMIT_READ,                         /* permissions */
+    0,                                        /* handle */
+    (uint8_t *)&diagService                   /* pValue */
+  },
+
+    // Characteristic Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      &diagBootProps
+    },
+
+      // Characteristic Value "Boot Profile"
+      {
+        { TI_UUID_SIZE, diagBootUUID },
+        GATT_PERMIT_READ,
+        0,
+        diagBootProfile
+      },
+
+#ifdef USER_DESCRIPTION
+      // Characteristic User Description
+      {
+        { ATT_BT_UUID_SIZE, charUserDescUUID },
+        GATT_PERMIT_READ,
+        0,
+        diagBootUserDescr
+      },
+#endif
+};
+
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t diag_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                 uint8_t *pValue, uint16_t *pLen,
+                                 uint16_t offset, uint16_t maxLen,
+                                 uint8_t method);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+
+// Diagnostic Service Callbacks
+// Note: When an operation on a characteristic requires authorization and
+// pfnAuthorizeAttrCB is not defined for that characteristic's service, the
+// Stack will report a status of ATT_ERR_UNLIKELY to the client.  When an
+// operation on a characteristic requires authorization the Stack will call
+// pfnAuthorizeAttrCB to check a client's authorization prior to calling
+// pfnReadAttrCB or pfnWriteAttrCB, so no checks for authorization need to be
+// made within these functions.
+static CONST gattServiceCBs_t diagCBs =
+{
+  diag_ReadAttrCB,  // Read callback function pointer
+  NULL,             // Write callback function pointer
+  NULL              // Authorization callback function pointer
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Diag_addService
+ *
+ * @brief   Initializes the Diagnostic service by registering
+ *          GATT attributes with the GATT server.
+ *
+ * @return  Success or Failure
+ */
+bStatus_t Diag_addService(void)
+{
+  bStatus_t status;
+
+  // Register GATT attribute list and CBs with GATT Server App
+  status = GATTServApp_RegisterService(diagAttrTable,
+                                       GATT_NUM_ATTRS (diagAttrTable),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &diagCBs);
+
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(diagAttrTable, GATT_NUM_ATTRS(diagAttrTable));
+  }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      Diag_setParameter
+ *
+ * @brief   Set a Diagnostic service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   len - length of data to write
+ * @param   value - pointer to data to write.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Diag_setParameter(uint8_t param, uint8_t len, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case DIAG_BOOT_PROFILE:
+      if (len <= DIAG_BOOT_PROFILE_MAX_LEN)
+      {
+        memcpy(diagBootProfile, value, len);
+        diagBootProfileLen = len;
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+/*********************************************************************
+ * @fn      Diag_getParameter
+ *
+ * @brief   Get a Diagnostic service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   value - pointer to data to put.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Diag_getParameter(uint8_t param, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case DIAG_BOOT_PROFILE:
+      memcpy(value, diagBootProfile, diagBootProfileLen);
+      break;
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+
+/*********************************************************************
+ * @fn          diag_ReadAttrCB
+ *
+ * @brief       Read an attribute.
+ *
+ * @param       connHandle - connection message was received on
+ * @param       pAttr - pointer to attribute
+ * @param       pValue - pointer to data to be read
+ * @param       pLen - length of data to be read
+ * @param       offset - offset of the first octet to be read
+ * @param       maxLen - maximum length of data to be read
+ * @param       method - type of read message
+ *
+ * @return      SUCCESS, blePending or Failure
+ */
+static bStatus_t diag_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                 uint8_t *pValue, uint16_t *pLen,
+                                 uint16_t offset, uint16_t maxLen,
+                                 uint8_t method)
+{
+  uint16_t uuid;
+  bStatus_t status = SUCCESS;
+
+  // Make sure it's not a blob operation (no attributes in the profile are long)
+  if (offset > 0)
+  {
+    return (ATT_ERR_ATTR_NOT_LONG);
+  }
+
+  if (utilExtractUuid16(pAttr,&uuid) == FAILURE) {
+    // Invalid handle
+    *pLen = 0;
+    return ATT_ERR_INVALID_HANDLE;
+  }
+
+  switch (uuid)
+  {
+    // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
+    // gattserverapp handles those reads
+    case DIAG_BOOT_UUID:
+      *pLen = diagBootProfileLen;
+      memcpy(pValue, pAttr->pValue, diagBootProfileLen);
+      break;
+
+    default:
+      // Should never get here!
+      *pLen = 0;
+      status = ATT_ERR_ATTR_NOT_FOUND;
+      break;
+  }
+
+  return (status);
+}
+
+
+/*********************************************************************
+*********************************************************************/
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************
+
+ @file  diagservice.h
+
+ @brief Diagnostic service. Exposes the boot profile: the time each
+        start-up phase was reached.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+
+ Copyright (c) 2015-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef DIAGSERVICE_H
+#define DIAGSERVICE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "st_util.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Service UUID
+#define DIAG_SERV_UUID            0xAE00 // F000AE00-0451-4000-B000-00000000-0000
+#define DIAG_BOOT_UUID            0xAE01
+
+// Attribute Identifiers
+#define DIAG_BOOT_PROFILE         0 // Read by the client
+
+// Attribute sizes
+#define DIAG_BOOT_MAX_PHASES      10
+#define DIAG_BOOT_PROFILE_MAX_LEN (DIAG_BOOT_MAX_PHASES * 2)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+
+/*
+ * Diag_addService- Initializes the Diagnostic service by registering
+ *          GATT attributes with the GATT server.
+ */
+extern bStatus_t Diag_addService(void);
+
+/*
+ * Diag_setParameter - Set a Diagnostic service parameter.
+ *
+ *    param - Profile parameter ID
+ *    len   - length of data to write, the boot profile holds a 16 bit
+ *            value per phase, at most DIAG_BOOT_PROFILE_MAX_LEN bytes
+ *    value - pointer to data to write.
+ */
+extern bStatus_t Diag_setParameter(uint8_t param, uint8_t len, void *value);
+
+/*
+ * Diag_getParameter - Get a Diagnostic service parameter.
+ *
+ *    param - Profile parameter ID
+ *    value - pointer to data to read. At least DIAG_BOOT_PROFILE_MAX_LEN
+ *            bytes.
+ */
+extern bStatus_t Diag_getParameter(uint8_t param, void *value);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DIAGSERVICE_H */
@@ -0,0 +1,249 @@
+/******************************************************************************
+
+ @file  gatt_db_hash.c
+
+ @brief This file contains the GATT database hash. Each service is folded
+        into the hash as it is registered. The hash is compared with the
+        one stored in NV, so that bonded clients only rediscover the
+        database when it has changed.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2012-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "gapbondmgr.h"
+#include "osal_snv.h"
+
+#include "gatt_db_hash.h"
+
+#include "icall_api.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// CRC-16/CCITT parameters used for the database hash
+#define GATT_DB_HASH_POLY               0x1021
+#define GATT_DB_HASH_INIT               0xFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Hash of the services added so far
+static uint16 gattDbHashValue = GATT_DB_HASH_INIT;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 gattDbHash_crc(uint16 crc, const uint8 *pBuf, uint8 len);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GATTDbHash_addService
+ *
+ * @brief   Add a registered service to the database hash. The attribute
+ *          handles must already have been assigned by the GATT Server.
+ *          The hash covers the handle, type and permissions of every
+ *          attribute, plus the value of the service and characteristic
+ *          declarations.
+ *
+ * @param   pAttrTbl - attribute table of the service
+ * @param   numAttrs - number of attributes in the table
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t GATTDbHash_addService(gattAttribute_t *pAttrTbl, uint16 numAttrs)
+{
+  uint16 crc = gattDbHashValue;
+  uint16 i;
+
+  if ((pAttrTbl == NULL) || (numAttrs == 0) ||
+      (pAttrTbl[0].handle == GATT_INVALID_HANDLE))
+  {
+    return (INVALIDPARAMETER);
+  }
+
+  for (i = 0; i < numAttrs; i++)
+  {
+    gattAttribute_t *pAttr = &pAttrTbl[i];
+    uint8 buf[3];
+
+    buf[0] = LO_UINT16(pAttr->handle);
+    buf[1] = HI_UINT16(pAttr->handle);
+    buf[2] = pAttr->permissions;
+    crc = gattDbHash_crc(crc, buf, sizeof(buf));
+    crc = gattDbHash_crc(crc, pAttr->type.uuid, pAttr->type.len);
+
+    if (pAttr->type.len == ATT_BT_UUID_SIZE)
+    {
+      switch (BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]))
+      {
+        case GATT_PRIMARY_SERVICE_UUID:
+          {
+            gattAttrType_t *pSvcType = (gattAttrType_t *)pAttr->pValue;
+
+            crc = gattDbHash_crc(crc, pSvcType->uuid, pSvcType->len);
+          }
+          break;
+
+        case GATT_CHARACTER_UUID:
+          // Characteristic properties
+          crc = gattDbHash_crc(crc, pAttr->pValue, 1);
+          break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+  gattDbHashValue = crc;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      GATTDbHash_get
+ *
+ * @brief   Get the hash of the services added so far.
+ *
+ * @return  Database hash
+ */
+uint16 GATTDbHash_get(void)
+{
+  return (gattDbHashValue);
+}
+
+/*********************************************************************
+ * @fn      GATTDbHash_commit
+ *
+ * @brief   Compare the database hash with the one stored in NV. When
+ *          unchanged, bonded clients may keep their cached handles.
+ *          Otherwise store the new hash and flag a Service Changed
+ *          indication for all bonds.
+ *
+ * @return  TRUE if the database is unchanged, FALSE otherwise
+ */
+uint8 GATTDbHash_commit(void)
+{
+  uint16 hash = GATTDbHash_get();
+  uint16 storedHash;
+
+  if ((osal_snv_read(GATT_DB_HASH_NV_ID, sizeof(storedHash),
+                     &storedHash) == SUCCESS) && (storedHash == hash))
+  {
+    // Database unchanged: no rediscovery needed
+    return (TRUE);
+  }
+
+  VOID osal_snv_write(GATT_DB_HASH_NV_ID, sizeof(hash), &hash);
+
+#ifndef GATT_NO_SERVICE_CHANGED
+  // Bonded clients must rediscover the database
+  VOID GAPBondMgr_ServiceChangeInd(0xFFFF, TRUE);
+#endif // GATT_NO_SERVICE_CHANGED
+
+  return (FALSE);
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      gattDbHash_crc
+ *
+ * @brief   Update a CRC-16/CCITT with a buffer.
+ *
+ * @param   crc - current CRC value
+ * @param   pBuf - buffer
+ * @param   len - length of buffer
+ *
+ * @return  Updated CRC value
+ */
+static uint16 gattDbHash_crc(uint16 crc, const uint8 *pBuf, uint8 len)
+{
+  while (len--)
+  {
+    uint8 i;
+
+    crc ^= (uint16)(*pBuf++) << 8;
+
+    for (i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ GATT_DB_HASH_POLY) : (crc << 1);
+    }
+  }
+
+  return (crc);
+}
+
+/*********************************************************************
+*********************************************************************/
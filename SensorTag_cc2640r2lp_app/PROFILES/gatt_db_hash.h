@@ -0,0 +1,119 @@
+/******************************************************************************
+
+ @file  gatt_db_hash.h
+
+ @brief This file contains the GATT database hash prototypes. The hash
+        covers the registered services, so bonded clients only rediscover
+        the database when it has changed.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2012-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef GATT_DB_HASH_H
+#define GATT_DB_HASH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "gatt.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// NV ID used to store the database hash across resets
+#ifndef GATT_DB_HASH_NV_ID
+#define GATT_DB_HASH_NV_ID              BLE_NVID_CUST_START
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*
+ * GATTDbHash_addService - Add a registered service to the database
+ *          hash. Call this after GATTServApp_RegisterService succeeded,
+ *          when the attribute handles have been assigned.
+ *
+ *    pAttrTbl - attribute table of the service
+ *    numAttrs - number of attributes in the table
+ */
+extern bStatus_t GATTDbHash_addService(gattAttribute_t *pAttrTbl,
+                                       uint16 numAttrs);
+
+/*
+ * GATTDbHash_get - Get the hash of the services added so far.
+ */
+extern uint16 GATTDbHash_get(void);
+
+/*
+ * GATTDbHash_commit - Compare the database hash with the one stored in
+ *          NV. If the database is unchanged, bonded clients may keep
+ *          their cached handles and skip rediscovery. Otherwise the new
+ *          hash is stored and a Service Changed indication is flagged
+ *          for all bonds. Call once after all services are added and the
+ *          Bond Manager is registered.
+ *
+ *    Returns TRUE if the database is unchanged, FALSE otherwise.
+ */
+extern uint8 GATTDbHash_commit(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GATT_DB_HASH_H */
@@ -0,0 +1,922 @@
+/******************************************************************************
+
+ @file  gatt_tx_queue.c
+
+ @brief This file contains the GATT transmit queue. ATT responses and
+        notifications that find no buffer are queued per connection and
+        retried in order at the end of each connection event, with
+        backpressure towards the data producers and drop counters.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2012-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "linkdb.h"
+#include "hci.h"
+#include "gatt.h"
+#include "gattservapp.h"
+
+#include "gatt_tx_queue.h"
+
+#include "icall_api.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Status codes after which a transmission is worth retrying
+#define GATT_TXQ_RETRYABLE(s)           (((s) == blePending)            || \
+                                         ((s) == MSG_BUFFER_NOT_AVAIL)  || \
+                                         ((s) == bleNoResources))
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Queue entry types
+#define GATT_TXQ_TYPE_RSP               0
+#define GATT_TXQ_TYPE_NOTI_IND          1
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Queued transmission. Notifications and indications keep the attribute
+// rather than a copy of the value, which is read when the entry is sent.
+typedef struct
+{
+  uint16 connHandle;
+  uint8 type;
+  union
+  {
+    gattMsgEvent_t *pRsp;
+    struct
+    {
+      gattAttribute_t *pAttr;
+      pfnGATTReadAttrCB_t pfnReadAttrCB;
+      uint8 cccValue;
+      uint8 authenticated;
+      uint8 taskId;
+    } notiInd;
+  } data;
+} gattTxQueueEntry_t;
+
+// Caller data of an asynchronous notification. The notification comes
+// first, the stack is handed its address.
+typedef struct
+{
+  attHandleValueNoti_t noti;
+  gattTxQueueEntry_t entry;
+} gattTxQueueAsync_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Queued transmissions, oldest first
+static gattTxQueueEntry_t gattTxQueue[GATT_TXQ_MAX_ENTRIES];
+static uint8 gattTxQueueCount = 0;
+
+// Task draining the queue
+static uint8 gattTxQueueTaskId = 0;
+static uint16 gattTxQueueConnEvt = 0;
+static pfnGATTTxQueueCB_t gattTxQueueCB = NULL;
+
+// Connection whose connection event end notice stays enabled
+static uint16 gattTxQueueHoldConn = INVALID_CONNHANDLE;
+
+// Connection with a Notification handed to the stack and not yet completed
+static uint16 gattTxQueueAsyncConn = INVALID_CONNHANDLE;
+
+static uint8 gattTxQueueBackpressure = FALSE;
+static gattTxQueueStats_t gattTxQueueStats = { 0 };
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 gattTxQueue_connCount(uint16 connHandle);
+static uint8 gattTxQueue_coalesce(gattTxQueueEntry_t *pEntry);
+static bStatus_t gattTxQueue_addNotiInd(gattTxQueueEntry_t *pEntry);
+static bStatus_t gattTxQueue_add(gattTxQueueEntry_t *pEntry);
+static void gattTxQueue_moveFirst(uint8 index);
+static void gattTxQueue_remove(uint8 index);
+static void gattTxQueue_release(uint8 index, uint8 status);
+static uint8 gattTxQueue_evictNotiInd(uint16 connHandle);
+static bStatus_t gattTxQueue_send(gattTxQueueEntry_t *pEntry);
+static bStatus_t gattTxQueue_sendNotiAsync(gattTxQueueEntry_t *pEntry);
+static void gattTxQueue_asyncCB(icall_liteCall_t *pCall, void *pData);
+static bStatus_t gattTxQueue_readValue(gattTxQueueEntry_t *pEntry,
+                                       attHandleValueNoti_t *pNoti);
+static void gattTxQueue_updateBackpressure(void);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      GATTTxQueue_register
+ *
+ * @brief   Register the task that drains the queue.
+ *
+ * @param   taskId - ICall entity of the task
+ * @param   connEvtEvent - stack event flag for the connection event end
+ * @param   pfnCB - backpressure callback, may be NULL
+ *
+ * @return  none
+ */
+void GATTTxQueue_register(uint8 taskId, uint16 connEvtEvent,
+                          pfnGATTTxQueueCB_t pfnCB)
+{
+  gattTxQueueTaskId = taskId;
+  gattTxQueueConnEvt = connEvtEvent;
+  gattTxQueueCB = pfnCB;
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_enqueueRsp
+ *
+ * @brief   Take over an ATT response that the GATT Server could not
+ *          transmit. If the queue is full, the oldest notification is
+ *          given up in favour of the response, since the client would
+ *          otherwise time out and drop the connection.
+ *
+ * @param   pMsg - GATT message holding the response
+ *
+ * @return  SUCCESS if queued, bleNoResources otherwise
+ */
+bStatus_t GATTTxQueue_enqueueRsp(gattMsgEvent_t *pMsg)
+{
+  gattTxQueueEntry_t entry;
+
+  entry.connHandle = pMsg->connHandle;
+  entry.type = GATT_TXQ_TYPE_RSP;
+  entry.data.pRsp = pMsg;
+
+  if ((gattTxQueueCount >= GATT_TXQ_MAX_ENTRIES) ||
+      (gattTxQueue_connCount(pMsg->connHandle) >= GATT_TXQ_MAX_PER_CONN))
+  {
+    // Make room for the response
+    if (gattTxQueue_evictNotiInd(pMsg->connHandle) == FALSE)
+    {
+      gattTxQueueStats.rspDropped++;
+
+      return (bleNoResources);
+    }
+  }
+
+  if (gattTxQueue_add(&entry) != SUCCESS)
+  {
+    gattTxQueueStats.rspDropped++;
+
+    return (bleNoResources);
+  }
+
+  gattTxQueueStats.rspQueued++;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_sendNotiInd
+ *
+ * @brief   Send a Notification or Indication, or queue it for the next
+ *          connection event. A Notification with nothing queued or in
+ *          flight ahead of it is handed to the stack without waiting for
+ *          the result, which comes back to gattTxQueue_asyncCB. Until
+ *          then later ones of the connection are queued behind it.
+ *
+ * @param   connHandle - connection handle
+ * @param   cccValue - client characteristic configuration value
+ * @param   authenticated - whether an authenticated link is required
+ * @param   pAttr - attribute record
+ * @param   taskId - task to be notified of confirmation
+ * @param   pfnReadAttrCB - read callback function pointer
+ *
+ * @return  SUCCESS if sent or queued, failure status otherwise
+ */
+bStatus_t GATTTxQueue_sendNotiInd(uint16 connHandle, uint8 cccValue,
+                                  uint8 authenticated, gattAttribute_t *pAttr,
+                                  uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB)
+{
+  gattTxQueueEntry_t entry;
+  bStatus_t status;
+
+  entry.connHandle = connHandle;
+  entry.type = GATT_TXQ_TYPE_NOTI_IND;
+  entry.data.notiInd.pAttr = pAttr;
+  entry.data.notiInd.pfnReadAttrCB = pfnReadAttrCB;
+  entry.data.notiInd.cccValue = cccValue;
+  entry.data.notiInd.authenticated = authenticated;
+  entry.data.notiInd.taskId = taskId;
+
+  if ((gattTxQueue_connCount(connHandle) == 0) &&
+      (gattTxQueueAsyncConn != connHandle))
+  {
+    // Nothing queued ahead of it, try to send right away
+    if ((cccValue & GATT_CLIENT_CFG_NOTIFY) &&
+        (gattTxQueueAsyncConn == INVALID_CONNHANDLE))
+    {
+      // Counted as sent once the stack completed it
+      status = gattTxQueue_sendNotiAsync(&entry);
+    }
+    else
+    {
+      status = gattTxQueue_send(&entry);
+
+      if (status == SUCCESS)
+      {
+        gattTxQueueStats.notiSent++;
+      }
+    }
+
+    if (!GATT_TXQ_RETRYABLE(status))
+    {
+      return (status);
+    }
+  }
+  else if (gattTxQueue_coalesce(&entry))
+  {
+    return (SUCCESS);
+  }
+
+  return (gattTxQueue_addNotiInd(&entry));
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_process
+ *
+ * @brief   Retry queued transmissions in order. Stops at the first one
+ *          that still finds no buffer, so that later entries do not
+ *          overtake it.
+ *
+ * @return  none
+ */
+void GATTTxQueue_process(void)
+{
+  while (gattTxQueueCount > 0)
+  {
+    bStatus_t status = gattTxQueue_send(&gattTxQueue[0]);
+
+    if (GATT_TXQ_RETRYABLE(status))
+    {
+      break;
+    }
+
+    if (status == SUCCESS)
+    {
+      if (gattTxQueue[0].type == GATT_TXQ_TYPE_NOTI_IND)
+      {
+        gattTxQueueStats.notiSent++;
+      }
+    }
+    else
+    {
+      if (gattTxQueue[0].type == GATT_TXQ_TYPE_RSP)
+      {
+        gattTxQueueStats.rspDropped++;
+      }
+      else
+      {
+        gattTxQueueStats.notiDropped++;
+      }
+    }
+
+    gattTxQueue_release(0, status);
+    gattTxQueue_remove(0);
+  }
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_flush
+ *
+ * @brief   Discard the entries of a connection.
+ *
+ * @param   connHandle - connection handle (0xFFFF for all connections)
+ *
+ * @return  none
+ */
+void GATTTxQueue_flush(uint16 connHandle)
+{
+  uint8 i = 0;
+
+  // Nothing waits behind a Notification still in flight any more
+  if ((connHandle == INVALID_CONNHANDLE) || (gattTxQueueAsyncConn == connHandle))
+  {
+    gattTxQueueAsyncConn = INVALID_CONNHANDLE;
+  }
+
+  while (i < gattTxQueueCount)
+  {
+    if ((connHandle == INVALID_CONNHANDLE) ||
+        (gattTxQueue[i].connHandle == connHandle))
+    {
+      gattTxQueue_release(i, FAILURE);
+      gattTxQueue_remove(i);
+
+      gattTxQueueStats.flushed++;
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_holdConnEvt
+ *
+ * @brief   Keep the connection event end notice of a connection enabled
+ *          while nothing is queued for it. The task registered with
+ *          GATTTxQueue_register then gets the connection event end event
+ *          on every connection event.
+ *
+ * @param   connHandle - connection handle
+ * @param   hold - TRUE to hold the notice, FALSE to release it
+ *
+ * @return  SUCCESS, or FAILURE if the notice could not be enabled or
+ *          another connection holds it
+ */
+bStatus_t GATTTxQueue_holdConnEvt(uint16 connHandle, uint8 hold)
+{
+  if (hold)
+  {
+    if (gattTxQueueHoldConn == connHandle)
+    {
+      return (SUCCESS);
+    }
+
+    if ((gattTxQueueHoldConn != INVALID_CONNHANDLE) ||
+        (gattTxQueueConnEvt == 0))
+    {
+      return (FAILURE);
+    }
+
+    if (gattTxQueue_connCount(connHandle) == 0)
+    {
+      if (HCI_EXT_ConnEventNoticeCmd(connHandle, gattTxQueueTaskId,
+                                     gattTxQueueConnEvt) != SUCCESS)
+      {
+        return (FAILURE);
+      }
+    }
+
+    gattTxQueueHoldConn = connHandle;
+  }
+  else if (gattTxQueueHoldConn == connHandle)
+  {
+    gattTxQueueHoldConn = INVALID_CONNHANDLE;
+
+    if (gattTxQueue_connCount(connHandle) == 0)
+    {
+      VOID HCI_EXT_ConnEventNoticeCmd(connHandle, gattTxQueueTaskId, 0);
+    }
+  }
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_isBackpressured
+ *
+ * @brief   Whether producers should hold back data.
+ *
+ * @return  TRUE if the queue is above its high water mark and has not
+ *          yet drained to its low water mark, FALSE otherwise
+ */
+uint8 GATTTxQueue_isBackpressured(void)
+{
+  return (gattTxQueueBackpressure);
+}
+
+/*********************************************************************
+ * @fn      GATTTxQueue_getStats
+ *
+ * @brief   Get the queue statistics.
+ *
+ * @param   pStats - statistics (output)
+ *
+ * @return  none
+ */
+void GATTTxQueue_getStats(gattTxQueueStats_t *pStats)
+{
+  gattTxQueueStats.depth = gattTxQueueCount;
+
+  *pStats = gattTxQueueStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      gattTxQueue_connCount
+ *
+ * @brief   Count the queued entries of a connection.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  number of entries
+ */
+static uint8 gattTxQueue_connCount(uint16 connHandle)
+{
+  uint8 i;
+  uint8 count = 0;
+
+  for (i = 0; i < gattTxQueueCount; i++)
+  {
+    if (gattTxQueue[i].connHandle == connHandle)
+    {
+      count++;
+    }
+  }
+
+  return (count);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_coalesce
+ *
+ * @brief   Keep the order, but let a queued update of the same attribute
+ *          carry the new value.
+ *
+ * @param   pEntry - Notification or Indication to send
+ *
+ * @return  TRUE if an update of the attribute is already queued
+ */
+static uint8 gattTxQueue_coalesce(gattTxQueueEntry_t *pEntry)
+{
+  uint8 i;
+
+  for (i = 0; i < gattTxQueueCount; i++)
+  {
+    gattTxQueueEntry_t *pQueued = &gattTxQueue[i];
+
+    if ((pQueued->connHandle == pEntry->connHandle)                  &&
+        (pQueued->type == GATT_TXQ_TYPE_NOTI_IND)                    &&
+        (pQueued->data.notiInd.pAttr == pEntry->data.notiInd.pAttr)  &&
+        (pQueued->data.notiInd.cccValue == pEntry->data.notiInd.cccValue))
+    {
+      gattTxQueueStats.notiCoalesced++;
+
+      return (TRUE);
+    }
+  }
+
+  return (FALSE);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_addNotiInd
+ *
+ * @brief   Queue a Notification or Indication, within the limits.
+ *
+ * @param   pEntry - entry to copy into the queue
+ *
+ * @return  SUCCESS or bleNoResources
+ */
+static bStatus_t gattTxQueue_addNotiInd(gattTxQueueEntry_t *pEntry)
+{
+  if ((gattTxQueueCount >= GATT_TXQ_MAX_ENTRIES)                          ||
+      (gattTxQueue_connCount(pEntry->connHandle) >= GATT_TXQ_MAX_PER_CONN) ||
+      (gattTxQueue_add(pEntry) != SUCCESS))
+  {
+    gattTxQueueStats.notiDropped++;
+
+    return (bleNoResources);
+  }
+
+  gattTxQueueStats.notiQueued++;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_add
+ *
+ * @brief   Append an entry. The first entry of a connection enables the
+ *          connection event end notice that drives the retries, unless
+ *          the connection already holds it.
+ *
+ * @param   pEntry - entry to copy into the queue
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static bStatus_t gattTxQueue_add(gattTxQueueEntry_t *pEntry)
+{
+  if ((gattTxQueueConnEvt == 0) || (gattTxQueueCount >= GATT_TXQ_MAX_ENTRIES))
+  {
+    return (FAILURE);
+  }
+
+  if ((gattTxQueue_connCount(pEntry->connHandle) == 0) &&
+      (pEntry->connHandle != gattTxQueueHoldConn))
+  {
+    if (HCI_EXT_ConnEventNoticeCmd(pEntry->connHandle, gattTxQueueTaskId,
+                                   gattTxQueueConnEvt) != SUCCESS)
+    {
+      return (FAILURE);
+    }
+  }
+
+  gattTxQueue[gattTxQueueCount++] = *pEntry;
+
+  if (gattTxQueueCount > gattTxQueueStats.maxDepth)
+  {
+    gattTxQueueStats.maxDepth = gattTxQueueCount;
+  }
+
+  gattTxQueue_updateBackpressure();
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_moveFirst
+ *
+ * @brief   Move an entry ahead of the other entries of its connection.
+ *
+ * @param   index - entry index
+ *
+ * @return  none
+ */
+static void gattTxQueue_moveFirst(uint8 index)
+{
+  gattTxQueueEntry_t entry = gattTxQueue[index];
+  uint8 i;
+
+  for (i = 0; i < index; i++)
+  {
+    if (gattTxQueue[i].connHandle == entry.connHandle)
+    {
+      break;
+    }
+  }
+
+  for (; index > i; index--)
+  {
+    gattTxQueue[index] = gattTxQueue[index - 1];
+  }
+
+  gattTxQueue[i] = entry;
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_remove
+ *
+ * @brief   Remove an entry, keeping the order of the others. The last
+ *          entry of a connection disables the connection event end notice,
+ *          unless the connection holds it.
+ *
+ * @param   index - entry index
+ *
+ * @return  none
+ */
+static void gattTxQueue_remove(uint8 index)
+{
+  uint16 connHandle = gattTxQueue[index].connHandle;
+
+  for (gattTxQueueCount--; index < gattTxQueueCount; index++)
+  {
+    gattTxQueue[index] = gattTxQueue[index + 1];
+  }
+
+  if ((gattTxQueue_connCount(connHandle) == 0) &&
+      (connHandle != gattTxQueueHoldConn))
+  {
+    VOID HCI_EXT_ConnEventNoticeCmd(connHandle, gattTxQueueTaskId, 0);
+  }
+
+  gattTxQueue_updateBackpressure();
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_release
+ *
+ * @brief   Free the resources of an entry that is done with.
+ *
+ * @param   index - entry index
+ * @param   status - transmit status
+ *
+ * @return  none
+ */
+static void gattTxQueue_release(uint8 index, uint8 status)
+{
+  gattTxQueueEntry_t *pEntry = &gattTxQueue[index];
+
+  if (pEntry->type == GATT_TXQ_TYPE_RSP)
+  {
+    gattMsgEvent_t *pRsp = pEntry->data.pRsp;
+
+    if (status != SUCCESS)
+    {
+      // Response payload was not handed over to the stack
+      GATT_bm_free(&pRsp->msg, pRsp->method);
+    }
+
+    ICall_freeMsg(pRsp);
+  }
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_evictNotiInd
+ *
+ * @brief   Give up the oldest queued notification or indication, of the
+ *          given connection if it is at its limit, of any otherwise.
+ *
+ * @param   connHandle - connection that needs a slot
+ *
+ * @return  TRUE if an entry was given up, FALSE otherwise
+ */
+static uint8 gattTxQueue_evictNotiInd(uint16 connHandle)
+{
+  uint8 connFull = (gattTxQueue_connCount(connHandle) >= GATT_TXQ_MAX_PER_CONN);
+  uint8 i;
+
+  for (i = 0; i < gattTxQueueCount; i++)
+  {
+    if ((gattTxQueue[i].type == GATT_TXQ_TYPE_NOTI_IND) &&
+        (!connFull || (gattTxQueue[i].connHandle == connHandle)))
+    {
+      gattTxQueue_release(i, FAILURE);
+      gattTxQueue_remove(i);
+
+      gattTxQueueStats.notiDropped++;
+
+      return (TRUE);
+    }
+  }
+
+  return (FALSE);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_send
+ *
+ * @brief   Try to transmit an entry. For a Notification or Indication the
+ *          attribute value is read into a freshly allocated payload.
+ *
+ * @param   pEntry - entry to transmit
+ *
+ * @return  SUCCESS, a retryable status (blePending, MSG_BUFFER_NOT_AVAIL,
+ *          bleNoResources) or a failure status
+ */
+static bStatus_t gattTxQueue_send(gattTxQueueEntry_t *pEntry)
+{
+  attHandleValueNoti_t noti;
+  bStatus_t status;
+
+  if (pEntry->type == GATT_TXQ_TYPE_RSP)
+  {
+    gattMsgEvent_t *pRsp = pEntry->data.pRsp;
+
+    return (GATT_SendRsp(pRsp->connHandle, pRsp->method, &(pRsp->msg)));
+  }
+
+  status = gattTxQueue_readValue(pEntry, &noti);
+  if (status != SUCCESS)
+  {
+    return (status);
+  }
+
+  if (pEntry->data.notiInd.cccValue & GATT_CLIENT_CFG_NOTIFY)
+  {
+    status = GATT_Notification(pEntry->connHandle, &noti,
+                               pEntry->data.notiInd.authenticated);
+  }
+  else // GATT_CLIENT_CFG_INDICATE
+  {
+    status = GATT_Indication(pEntry->connHandle, (attHandleValueInd_t *)&noti,
+                             pEntry->data.notiInd.authenticated,
+                             pEntry->data.notiInd.taskId);
+  }
+
+  if (status != SUCCESS)
+  {
+    GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
+  }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_sendNotiAsync
+ *
+ * @brief   Hand a Notification to the stack without waiting for the
+ *          result. The application goes on while the stack transmits.
+ *          The connection has it in flight until gattTxQueue_asyncCB.
+ *
+ * @param   pEntry - Notification to transmit
+ *
+ * @return  SUCCESS if handed over, bleNoResources or a read failure
+ *          status otherwise
+ */
+static bStatus_t gattTxQueue_sendNotiAsync(gattTxQueueEntry_t *pEntry)
+{
+  gattTxQueueAsync_t async;
+  icall_liteCall_t call;
+  bStatus_t status;
+
+  status = gattTxQueue_readValue(pEntry, &async.noti);
+  if (status != SUCCESS)
+  {
+    return (status);
+  }
+
+  async.entry = *pEntry;
+
+  call.directAPI = IDX_GATT_Notification;
+  call.param[0] = pEntry->connHandle;
+  call.param[1] = 0; // Address of the copy of async.noti
+  call.param[2] = pEntry->data.notiInd.authenticated;
+
+  if (icall_directAPIAsync(ICALL_SERVICE_CLASS_BLE, &call, &async,
+                           sizeof(async), 1,
+                           gattTxQueue_asyncCB) != ICALL_ERRNO_SUCCESS)
+  {
+    GATT_bm_free((gattMsg_t *)&async.noti, ATT_HANDLE_VALUE_NOTI);
+
+    return (bleNoResources);
+  }
+
+  gattTxQueueAsyncConn = pEntry->connHandle;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_asyncCB
+ *
+ * @brief   A Notification handed over by gattTxQueue_sendNotiAsync was
+ *          completed by the stack. If it was turned down, free its payload
+ *          and queue it ahead of the later ones when a later connection
+ *          event may find a buffer. Once sent, the later ones go out.
+ *
+ * @param   pCall - call as executed, param[0] holds the status
+ * @param   pData - gattTxQueueAsync_t given with the call
+ *
+ * @return  none
+ */
+static void gattTxQueue_asyncCB(icall_liteCall_t *pCall, void *pData)
+{
+  gattTxQueueAsync_t *pAsync = (gattTxQueueAsync_t *)pData;
+  bStatus_t status = (bStatus_t)pCall->param[0];
+
+  if (gattTxQueueAsyncConn == pAsync->entry.connHandle)
+  {
+    gattTxQueueAsyncConn = INVALID_CONNHANDLE;
+  }
+
+  if (status == SUCCESS)
+  {
+    // The stack owns the payload now
+    gattTxQueueStats.notiSent++;
+
+    GATTTxQueue_process();
+
+    return;
+  }
+
+  GATT_bm_free((gattMsg_t *)&pAsync->noti, ATT_HANDLE_VALUE_NOTI);
+
+  if (!GATT_TXQ_RETRYABLE(status))
+  {
+    gattTxQueueStats.notiDropped++;
+  }
+  else if (!gattTxQueue_coalesce(&pAsync->entry) &&
+           (gattTxQueue_addNotiInd(&pAsync->entry) == SUCCESS))
+  {
+    gattTxQueue_moveFirst(gattTxQueueCount - 1);
+  }
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_readValue
+ *
+ * @brief   Read the attribute value of a Notification or Indication into
+ *          a freshly allocated payload.
+ *
+ * @param   pEntry - Notification or Indication
+ * @param   pNoti - payload (output). On SUCCESS the caller frees it,
+ *                  unless the stack accepts it.
+ *
+ * @return  SUCCESS, bleNoResources or the read callback status
+ */
+static bStatus_t gattTxQueue_readValue(gattTxQueueEntry_t *pEntry,
+                                       attHandleValueNoti_t *pNoti)
+{
+  uint16 len;
+  bStatus_t status;
+
+  // If the attribute value is longer than (ATT_MTU - 3) octets, then
+  // only the first (ATT_MTU - 3) octets of this attributes value can
+  // be sent in a notification.
+  pNoti->pValue = (uint8 *)GATT_bm_alloc(pEntry->connHandle,
+                                         ATT_HANDLE_VALUE_NOTI,
+                                         GATT_MAX_MTU, &len);
+  if (pNoti->pValue == NULL)
+  {
+    return (bleNoResources);
+  }
+
+  status = (*pEntry->data.notiInd.pfnReadAttrCB)(pEntry->connHandle,
+                                                 pEntry->data.notiInd.pAttr,
+                                                 pNoti->pValue, &pNoti->len,
+                                                 0, len, GATT_LOCAL_READ);
+  if (status != SUCCESS)
+  {
+    GATT_bm_free((gattMsg_t *)pNoti, ATT_HANDLE_VALUE_NOTI);
+
+    return (status);
+  }
+
+  pNoti->handle = pEntry->data.notiInd.pAttr->handle;
+
+  return (SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      gattTxQueue_updateBackpressure
+ *
+ * @brief   Assert or release backpressure on the water marks and notify
+ *          the registered task of a change.
+ *
+ * @return  none
+ */
+static void gattTxQueue_updateBackpressure(void)
+{
+  uint8 backpressure = gattTxQueueBackpressure;
+
+  if (gattTxQueueCount >= GATT_TXQ_HIGH_WATER)
+  {
+    backpressure = TRUE;
+  }
+  else if (gattTxQueueCount <= GATT_TXQ_LOW_WATER)
+  {
+    backpressure = FALSE;
+  }
+
+  if (backpressure != gattTxQueueBackpressure)
+  {
+    gattTxQueueBackpressure = backpressure;
+
+    if (gattTxQueueCB != NULL)
+    {
+      (*gattTxQueueCB)(backpressure);
+    }
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
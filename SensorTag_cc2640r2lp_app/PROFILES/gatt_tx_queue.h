@@ -0,0 +1,210 @@
+/******************************************************************************
+
+ @file  gatt_tx_queue.h
+
+ @brief This file contains the GATT transmit queue prototypes. The queue
+        holds ATT responses and notifications that could not be sent for
+        lack of buffers and retries them on later connection events.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2012-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef GATT_TX_QUEUE_H
+#define GATT_TX_QUEUE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "gatt.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Maximum number of queued transmissions, all connections combined
+#ifndef GATT_TXQ_MAX_ENTRIES
+#define GATT_TXQ_MAX_ENTRIES            8
+#endif
+
+// Maximum number of queued transmissions per connection
+#ifndef GATT_TXQ_MAX_PER_CONN
+#define GATT_TXQ_MAX_PER_CONN           6
+#endif
+
+// Queue depth at which backpressure is asserted and released again
+#ifndef GATT_TXQ_HIGH_WATER
+#define GATT_TXQ_HIGH_WATER             (GATT_TXQ_MAX_ENTRIES - 2)
+#endif
+
+#ifndef GATT_TXQ_LOW_WATER
+#define GATT_TXQ_LOW_WATER              (GATT_TXQ_MAX_ENTRIES / 4)
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Queue statistics
+typedef struct
+{
+  uint16 notiSent;        // Notifications/indications handed to the stack
+  uint16 rspQueued;       // ATT responses deferred to a later connection event
+  uint16 notiQueued;      // Notifications/indications deferred
+  uint16 notiCoalesced;   // Updates merged into an already queued entry
+  uint16 rspDropped;      // ATT responses given up
+  uint16 notiDropped;     // Notifications/indications given up
+  uint16 flushed;         // Entries discarded on disconnect
+  uint8  depth;           // Current number of queued entries
+  uint8  maxDepth;        // Highest number of queued entries seen
+} gattTxQueueStats_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * Profile Callbacks
+ */
+
+// Called when backpressure is asserted (TRUE) or released (FALSE)
+typedef void (*pfnGATTTxQueueCB_t)(uint8 backpressure);
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*
+ * GATTTxQueue_register - Register the task that drains the queue. The
+ *          task is sent the given stack event at the end of every
+ *          connection event while a connection has queued entries, and
+ *          must then call GATTTxQueue_process.
+ *
+ *    taskId - ICall entity of the task
+ *    connEvtEvent - stack event flag for the connection event end
+ *    pfnCB - backpressure callback, may be NULL
+ */
+extern void GATTTxQueue_register(uint8 taskId, uint16 connEvtEvent,
+                                 pfnGATTTxQueueCB_t pfnCB);
+
+/*
+ * GATTTxQueue_enqueueRsp - Take over an ATT response that the GATT Server
+ *          could not transmit (GATT_MSG_EVENT with status blePending).
+ *
+ *    pMsg - GATT message holding the response
+ *
+ *    Returns SUCCESS if queued; the queue then owns the message.
+ *    Otherwise the caller must free it.
+ */
+extern bStatus_t GATTTxQueue_enqueueRsp(gattMsgEvent_t *pMsg);
+
+/*
+ * GATTTxQueue_sendNotiInd - Send a Notification or Indication, or queue it
+ *          for the next connection event if no buffer is available or
+ *          earlier transmissions are still queued for the connection. A
+ *          queued entry reads the attribute value when it is sent, so
+ *          repeated updates of one attribute take a single slot.
+ *
+ *    connHandle - connection handle
+ *    cccValue - GATT_CLIENT_CFG_NOTIFY or GATT_CLIENT_CFG_INDICATE
+ *    authenticated - whether an authenticated link is required
+ *    pAttr - attribute record
+ *    taskId - task to be notified of confirmation
+ *    pfnReadAttrCB - read callback function pointer
+ *
+ *    Returns SUCCESS if sent or queued.
+ */
+extern bStatus_t GATTTxQueue_sendNotiInd(uint16 connHandle, uint8 cccValue,
+                                         uint8 authenticated,
+                                         gattAttribute_t *pAttr, uint8 taskId,
+                                         pfnGATTReadAttrCB_t pfnReadAttrCB);
+
+/*
+ * GATTTxQueue_process - Retry queued transmissions in order. Call on the
+ *          connection event end event.
+ */
+extern void GATTTxQueue_process(void);
+
+/*
+ * GATTTxQueue_flush - Discard the entries of a connection.
+ *
+ *    connHandle - connection handle (0xFFFF for all connections)
+ */
+extern void GATTTxQueue_flush(uint16 connHandle);
+
+/*
+ * GATTTxQueue_holdConnEvt - Keep the connection event end notice of a
+ *          connection enabled while nothing is queued for it, for a
+ *          task that streams data and tops up the stack's buffers on
+ *          every connection event. One connection can be held at a time.
+ *
+ *    connHandle - connection handle
+ *    hold - TRUE to hold the notice, FALSE to release it
+ *
+ *    Returns SUCCESS, or FAILURE if the notice could not be enabled or
+ *    another connection holds it.
+ */
+extern bStatus_t GATTTxQueue_holdConnEvt(uint16 connHandle, uint8 hold);
+
+/*
+ * GATTTxQueue_isBackpressured - Whether producers should hold back data.
+ */
+extern uint8 GATTTxQueue_isBackpressured(void);
+
+/*
+ * GATTTxQueue_getStats - Get the queue statistics.
+ *
+ *    pStats - statistics (output)
+ */
+extern void GATTTxQueue_getStats(gattTxQueueStats_t *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GATT_TX_QUEUE_H */
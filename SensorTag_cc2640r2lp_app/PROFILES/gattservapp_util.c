@@ -53,6 +53,7 @@
 
 #include "gatt.h"
 #include "gattservapp.h"
+#include "gatt_tx_queue.h"
 
 #include "icall_api.h"
 /*********************************************************************
@@ -89,9 +90,6 @@
 
 static gattCharCfg_t *gattServApp_FindCharCfgItem( uint16 connHandle,
                                                    gattCharCfg_t *charCfgTbl );
-static bStatus_t gattServApp_SendNotiInd( uint16 connHandle, uint8 cccValue,
-                                          uint8 authenticated, gattAttribute_t *pAttr,
-                                          uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB );
 
 /*********************************************************************
  * API FUNCTIONS
@@ -180,13 +178,13 @@ bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
       {
         if ( pItem->value & GATT_CLIENT_CFG_NOTIFY )
         {
-           status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_NOTIFY,
+           status |= GATTTxQueue_sendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_NOTIFY,
                                               authenticated, pAttr, taskId, pfnReadAttrCB );
         }
 
         if ( pItem->value & GATT_CLIENT_CFG_INDICATE )
         {
-           status |= gattServApp_SendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_INDICATE,
+           status |= GATTTxQueue_sendNotiInd( pItem->connHandle, GATT_CLIENT_CFG_INDICATE,
                                               authenticated, pAttr, taskId, pfnReadAttrCB );
         }
       }
@@ -379,65 +377,6 @@ static gattCharCfg_t *gattServApp_FindCharCfgItem( uint16 connHandle,
   return ( (gattCharCfg_t *)NULL );
 }
 
- /*********************************************************************
- * @fn      gattServApp_SendNotiInd
- *
- * @brief   Send an ATT Notification/Indication.
- *
- * @param   connHandle - connection handle to use.
- * @param   cccValue - client characteristic configuration value.
- * @param   authenticated - whether an authenticated link is required.
- * @param   pAttr - pointer to attribute record.
- * @param   taskId - task to be notified of confirmation.
- * @param   pfnReadAttrCB - read callback function pointer.
- *
- * @return  Success or Failure
- */
-static bStatus_t gattServApp_SendNotiInd( uint16 connHandle, uint8 cccValue,
-                                          uint8 authenticated, gattAttribute_t *pAttr,
-                                          uint8 taskId, pfnGATTReadAttrCB_t pfnReadAttrCB )
-{
-  attHandleValueNoti_t noti;
-  uint16 len;
-  bStatus_t status;
-
-  // If the attribute value is longer than (ATT_MTU - 3) octets, then
-  // only the first (ATT_MTU - 3) octets of this attributes value can
-  // be sent in a notification.
-  noti.pValue = (uint8 *)GATT_bm_alloc( connHandle, ATT_HANDLE_VALUE_NOTI,
-                                        GATT_MAX_MTU, &len );
-  if ( noti.pValue != NULL )
-  {
-    status = (*pfnReadAttrCB)( connHandle, pAttr, noti.pValue, &noti.len,
-                               0, len, GATT_LOCAL_READ );
-    if ( status == SUCCESS )
-    {
-      noti.handle = pAttr->handle;
-
-      if ( cccValue & GATT_CLIENT_CFG_NOTIFY )
-      {
-        status = GATT_Notification( connHandle, &noti, authenticated );
-      }
-      else // GATT_CLIENT_CFG_INDICATE
-      {
-        status = GATT_Indication( connHandle, (attHandleValueInd_t *)&noti,
-                                  authenticated, taskId );
-      }
-    }
-
-    if ( status != SUCCESS )
-    {
-      GATT_bm_free( (gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI );
-    }
-  }
-  else
-  {
-    status = bleNoResources;
-  }
-
-  return ( status );
-}
-
 
 /****************************************************************************
 ****************************************************************************/
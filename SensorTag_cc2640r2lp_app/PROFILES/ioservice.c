@@ -62,6 +62,7 @@
 #include "gatt.h"
 #include "gatt_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 #include "string.h"
 
 #include "ioservice.h"
@@ -253,6 +254,8 @@ CONST gattServiceCBs_t ioCBs =
  */
 bStatus_t Io_addService(void)
 {
+  bStatus_t status;
+
   // Allocate Client Characteristic Configuration table
   ioDataConfig = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
                                                 linkDBNumConns);
@@ -265,10 +268,18 @@ bStatus_t Io_addService(void)
   GATTServApp_InitCharCfg(INVALID_CONNHANDLE, ioDataConfig);
 
   // Register GATT attribute list and CBs with GATT Server App
-  return GATTServApp_RegisterService(ioAttrTbl,
-                                      GATT_NUM_ATTRS(ioAttrTbl),
-                                      GATT_MAX_ENCRYPT_KEY_SIZE,
-                                      &ioCBs);
+  status = GATTServApp_RegisterService(ioAttrTbl,
+                                       GATT_NUM_ATTRS(ioAttrTbl),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &ioCBs);
+
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(ioAttrTbl, GATT_NUM_ATTRS(ioAttrTbl));
+  }
+
+  return (status);
 }
 
 /*********************************************************************
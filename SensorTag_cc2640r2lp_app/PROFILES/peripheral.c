@@ -58,6 +58,7 @@
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
+#include <ti/sysbios/family/arm/m3/Hwi.h>
 
 #include <driverlib/ioc.h>
 
@@ -76,6 +77,7 @@
 #include "icall.h"
 
 #include "icall_api.h"
+#include "ble_user_config.h"
 
 /*********************************************************************
  * MACROS
@@ -89,11 +91,13 @@
 #define START_ADVERTISING_EVT         Event_Id_00
 #define START_CONN_UPDATE_EVT         Event_Id_01
 #define CONN_PARAM_TIMEOUT_EVT        Event_Id_02
+#define LINK_SIZE_UPDATE_EVT          Event_Id_03
 
-#define GAPROLE_ALL_EVENTS            (GAPROLE_ICALL_EVT     | \
-                                       START_ADVERTISING_EVT | \
-                                       START_CONN_UPDATE_EVT | \
-                                       CONN_PARAM_TIMEOUT_EVT)
+#define GAPROLE_ALL_EVENTS            (GAPROLE_ICALL_EVT      | \
+                                       START_ADVERTISING_EVT  | \
+                                       START_CONN_UPDATE_EVT  | \
+                                       CONN_PARAM_TIMEOUT_EVT | \
+                                       LINK_SIZE_UPDATE_EVT)
 
 #define DEFAULT_ADVERT_OFF_TIME       30000   // 30 seconds
 
@@ -115,6 +119,22 @@
 
 #define MAX_TIMEOUT_VALUE             0xFFFF
 
+// Link size requested after connection. The stack caps the ATT_MTU at
+// MAX_PDU_SIZE - 4 (ble_user_config.h), so one ATT PDU plus the L2CAP
+// header fits a single LL packet.
+#ifndef GAPROLE_LINK_ATT_MTU
+#define GAPROLE_LINK_ATT_MTU          (MAX_PDU_SIZE - L2CAP_HDR_SIZE)
+#endif
+
+// Longest LL payload (LE Data Length Extension)
+#define GAPROLE_LINK_MAX_TX_OCTETS    251
+
+#define GAPROLE_LINK_TX_OCTETS        MIN(GAPROLE_LINK_ATT_MTU + L2CAP_HDR_SIZE, \
+                                          GAPROLE_LINK_MAX_TX_OCTETS)
+#define GAPROLE_LINK_TX_TIME          ((GAPROLE_LINK_TX_OCTETS + 14) * 8) // 1M PHY, in us
+
+#define DEFAULT_DATA_LEN_OCTETS       27
+
 // Task configuration
 #define GAPROLE_TASK_PRIORITY         3
 
@@ -135,6 +155,15 @@ typedef struct
   uint16_t timeoutMultiplier;
 } gapRole_updateConnParams_t;
 
+// Link size update passed on by the application, 0 if not changed
+typedef struct
+{
+  uint16_t connHandle;
+  uint16_t attMtu;
+  uint16_t txOctets;
+  uint16_t rxOctets;
+} gapRole_linkSizeUpdate_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -229,10 +258,21 @@ static uint8_t  gapRole_ConnectedDevAddrType = 0;
 static uint8_t  gapRole_ConnTermReason = 0;
 
 static uint8_t paramUpdateNoSuccessOption = GAPROLE_NO_ACTION;
+static uint8_t paramUpdateFailures = 0;
+
+// Negotiated link size
+static uint8_t  gapRole_LinkSizeUpdate = TRUE;
+static uint16_t gapRole_AttMtu = ATT_MTU_SIZE;
+static uint16_t gapRole_TxOctets = DEFAULT_DATA_LEN_OCTETS;
+static uint16_t gapRole_RxOctets = DEFAULT_DATA_LEN_OCTETS;
+
+// Link size updates from the application task, applied by the GAPRole task
+static gapRole_linkSizeUpdate_t gapRole_PendingLinkSize = { 0 };
 
 // Application callbacks
 static gapRolesCBs_t *pGapRoles_AppCGs = NULL;
 static gapRolesParamUpdateCB_t *pGapRoles_ParamUpdateCB = NULL;
+static gapRolesLinkSizeCB_t *pGapRoles_LinkSizeCB = NULL;
 
 /*********************************************************************
  * Profile Attributes - variables
@@ -257,6 +297,13 @@ static bStatus_t gapRole_startConnUpdate(uint8_t handleFailure,
 
 static void gapRole_setEvent(uint32_t event);
 
+static void gapRole_startLinkSizeUpdate(uint16_t connHandle);
+static void gapRole_setLinkSize(uint16_t attMtu, uint16_t txOctets,
+                                uint16_t rxOctets);
+static void gapRole_postLinkSize(uint16_t connHandle, uint16_t attMtu,
+                                 uint16_t txOctets, uint16_t rxOctets);
+static void gapRole_processLinkSize(void);
+
 /*********************************************************************
  * CALLBACKS
  */
@@ -502,6 +549,17 @@ bStatus_t GAPRole_SetParameter(uint16_t param, uint8_t len, void *pValue)
       }
       break;
 
+    case GAPROLE_LINK_SIZE_UPDATE:
+      if (len == sizeof (uint8_t))
+      {
+        gapRole_LinkSizeUpdate = *((uint8_t*)pValue);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
     case GAPROLE_MIN_CONN_INTERVAL:
       {
         uint16_t newInterval = *((uint16_t*)pValue);
@@ -731,6 +789,26 @@ bStatus_t GAPRole_GetParameter(uint16_t param, void *pValue)
       *((uint8_t*)pValue) = gapRole_ConnTermReason;
       break;
 
+    case GAPROLE_LINK_SIZE_UPDATE:
+      *((uint8_t*)pValue) = gapRole_LinkSizeUpdate;
+      break;
+
+    case GAPROLE_ATT_MTU:
+      *((uint16_t*)pValue) = gapRole_AttMtu;
+      break;
+
+    case GAPROLE_DATA_LEN_TX_OCTETS:
+      *((uint16_t*)pValue) = gapRole_TxOctets;
+      break;
+
+    case GAPROLE_DATA_LEN_RX_OCTETS:
+      *((uint16_t*)pValue) = gapRole_RxOctets;
+      break;
+
+    case GAPROLE_PARAM_UPDATE_FAILURES:
+      *((uint8_t*)pValue) = paramUpdateFailures;
+      break;
+
     default:
       // The param value isn't part of this profile, try the GAP.
       if (param < TGAP_PARAMID_MAX)
@@ -786,6 +864,40 @@ void GAPRole_RegisterAppCBs(gapRolesParamUpdateCB_t *pParamUpdateCB)
   }
 }
 
+/*********************************************************************
+ * @brief   Register application's link size callback.
+ *
+ * Public function defined in peripheral.h.
+ */
+void GAPRole_RegisterLinkSizeCB(gapRolesLinkSizeCB_t *pLinkSizeCB)
+{
+  if (pLinkSizeCB != NULL)
+  {
+    pGapRoles_LinkSizeCB = pLinkSizeCB;
+  }
+}
+
+/*********************************************************************
+ * @brief   Pass on an ATT_MTU update.
+ *
+ * Public function defined in peripheral.h.
+ */
+void GAPRole_MtuUpdated(uint16_t connHandle, uint16_t attMtu)
+{
+  gapRole_postLinkSize(connHandle, attMtu, 0, 0);
+}
+
+/*********************************************************************
+ * @brief   Pass on an LE data length update.
+ *
+ * Public function defined in peripheral.h.
+ */
+void GAPRole_DataLenUpdated(uint16_t connHandle, uint16_t txOctets,
+                            uint16_t rxOctets)
+{
+  gapRole_postLinkSize(connHandle, 0, txOctets, rxOctets);
+}
+
 /*********************************************************************
  * @brief   Terminates the existing connection.
  *
@@ -854,6 +966,9 @@ static void gapRole_init(void)
   linkDBNumConns = linkDB_NumConns();
 #endif /* STACK_LIBRARY */
 
+  // The ATT_MTU exchange is a GATT Client procedure
+  VOID GATT_InitClient();
+
   // Setup timers as one-shot timers
   Util_constructClock(&startAdvClock, gapRole_clockHandler,
                       0, 0, false, START_ADVERTISING_EVT);
@@ -985,6 +1100,12 @@ static void gapRole_taskFxn(UArg a0, UArg a1)
         // Unsuccessful in updating connection parameters
         gapRole_HandleParamUpdateNoSuccess();
       }
+
+      if (events & LINK_SIZE_UPDATE_EVT)
+      {
+        // Link size update passed on by the application
+        gapRole_processLinkSize();
+      }
     }
   } // for
 }
@@ -1006,6 +1127,25 @@ static void gapRole_processStackMsg(ICall_Hdr *pMsg)
       gapRole_processGAPMsg((gapEventHdr_t *)pMsg);
       break;
 
+    case GATT_MSG_EVENT:
+      {
+        gattMsgEvent_t *pPkt = (gattMsgEvent_t *)pMsg;
+
+        // Response to the ATT_MTU exchange started on connection
+        if ((pPkt->method == ATT_EXCHANGE_MTU_RSP) &&
+            (pPkt->connHandle == gapRole_ConnectionHandle))
+        {
+          uint16_t mtu = pPkt->msg.exchangeMTURsp.serverRxMTU;
+
+          gapRole_setLinkSize(MIN(mtu, GAPROLE_LINK_ATT_MTU), gapRole_TxOctets,
+                              gapRole_RxOctets);
+        }
+
+        // Free message payload. Needed only for ATT Protocol messages
+        GATT_bm_free(&pPkt->msg, pPkt->method);
+      }
+      break;
+
     case L2CAP_SIGNAL_EVENT:
       {
         l2capSignalEvent_t *pPkt = (l2capSignalEvent_t *)pMsg;
@@ -1221,6 +1361,12 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
           // Notify the Bond Manager to the connection
           VOID GAPBondMgr_LinkEst(pPkt->devAddrType, pPkt->devAddr,
                                   pPkt->connectionHandle, GAP_PROFILE_PERIPHERAL);
+
+          // Ask for longer packets, so notifications can fill a larger PDU
+          if (gapRole_LinkSizeUpdate)
+          {
+            gapRole_startLinkSizeUpdate(pPkt->connectionHandle);
+          }
         }
         else if (pPkt->hdr.status == bleGAPConnNotAcceptable)
         {
@@ -1252,6 +1398,9 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
         gapRole_ConnSlaveLatency = 0;
         gapRole_ConnTimeout = 0;
         gapRole_ConnTermReason = pPkt->reason;
+        gapRole_AttMtu = ATT_MTU_SIZE;
+        gapRole_TxOctets = DEFAULT_DATA_LEN_OCTETS;
+        gapRole_RxOctets = DEFAULT_DATA_LEN_OCTETS;
 
         // Cancel all connection parameter update timers (if any active)
         Util_stopClock(&startUpdateClock);
@@ -1454,6 +1603,9 @@ static void gapRole_SetupGAP(void)
  */
 static void gapRole_HandleParamUpdateNoSuccess(void)
 {
+  // Let the application see that its request did not go through
+  paramUpdateFailures++;
+
   // See which option was chosen for unsuccessful updates
   switch (paramUpdateNoSuccessOption)
   {
@@ -1611,6 +1763,132 @@ static void gapRole_setEvent(uint32_t event)
   Event_post(syncEvent, event);
 }
 
+/*********************************************************************
+ * @fn      gapRole_startLinkSizeUpdate
+ *
+ * @brief   Request the LE data length and ATT_MTU of GAPROLE_LINK_ATT_MTU.
+ *          The results arrive as the LE Data Length Change event and the
+ *          ATT_MTU exchange response.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  none
+ */
+static void gapRole_startLinkSizeUpdate(uint16_t connHandle)
+{
+  attExchangeMTUReq_t req;
+
+  // Longer LL packets first, so the larger ATT PDUs are not fragmented
+  VOID HCI_LE_SetDataLenCmd(connHandle, GAPROLE_LINK_TX_OCTETS,
+                            GAPROLE_LINK_TX_TIME);
+
+  req.clientRxMTU = GAPROLE_LINK_ATT_MTU;
+  VOID GATT_ExchangeMTU(connHandle, &req, selfEntity);
+}
+
+/*********************************************************************
+ * @fn      gapRole_setLinkSize
+ *
+ * @brief   Store the negotiated link size and notify the application
+ *          if it changed.
+ *
+ * @param   attMtu - ATT_MTU
+ * @param   txOctets - maximum LL transmit payload
+ * @param   rxOctets - maximum LL receive payload
+ *
+ * @return  none
+ */
+static void gapRole_setLinkSize(uint16_t attMtu, uint16_t txOctets,
+                                uint16_t rxOctets)
+{
+  if ((attMtu != gapRole_AttMtu) || (txOctets != gapRole_TxOctets) ||
+      (rxOctets != gapRole_RxOctets))
+  {
+    gapRole_AttMtu = attMtu;
+    gapRole_TxOctets = txOctets;
+    gapRole_RxOctets = rxOctets;
+
+    if (pGapRoles_LinkSizeCB != NULL)
+    {
+      (*pGapRoles_LinkSizeCB)(gapRole_ConnectionHandle, gapRole_AttMtu,
+                              gapRole_TxOctets);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_postLinkSize
+ *
+ * @brief   Hand a link size update from the application task over to the
+ *          GAPRole task, which owns the link size and calls the link size
+ *          callback. Updates posted before the GAPRole task runs are
+ *          merged.
+ *
+ * @param   connHandle - connection handle
+ * @param   attMtu - new ATT_MTU, 0 if not changed
+ * @param   txOctets - new maximum LL transmit payload, 0 if not changed
+ * @param   rxOctets - new maximum LL receive payload, 0 if not changed
+ *
+ * @return  none
+ */
+static void gapRole_postLinkSize(uint16_t connHandle, uint16_t attMtu,
+                                 uint16_t txOctets, uint16_t rxOctets)
+{
+  uint16_t hwiKey = (uint16_t) Hwi_disable();
+
+  if (gapRole_PendingLinkSize.connHandle != connHandle)
+  {
+    // Drop what is left of an update for a previous connection
+    VOID memset(&gapRole_PendingLinkSize, 0, sizeof(gapRole_PendingLinkSize));
+    gapRole_PendingLinkSize.connHandle = connHandle;
+  }
+
+  if (attMtu != 0)
+  {
+    gapRole_PendingLinkSize.attMtu = attMtu;
+  }
+
+  if (txOctets != 0)
+  {
+    gapRole_PendingLinkSize.txOctets = txOctets;
+    gapRole_PendingLinkSize.rxOctets = rxOctets;
+  }
+
+  Hwi_restore(hwiKey);
+
+  gapRole_setEvent(LINK_SIZE_UPDATE_EVT);
+}
+
+/*********************************************************************
+ * @fn      gapRole_processLinkSize
+ *
+ * @brief   Apply the link size update posted by the application, if it
+ *          is for the current connection.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapRole_processLinkSize(void)
+{
+  gapRole_linkSizeUpdate_t update;
+  uint16_t hwiKey = (uint16_t) Hwi_disable();
+
+  update = gapRole_PendingLinkSize;
+  gapRole_PendingLinkSize.attMtu = 0;
+  gapRole_PendingLinkSize.txOctets = 0;
+  gapRole_PendingLinkSize.rxOctets = 0;
+
+  Hwi_restore(hwiKey);
+
+  if (update.connHandle == gapRole_ConnectionHandle)
+  {
+    gapRole_setLinkSize((update.attMtu != 0) ? update.attMtu : gapRole_AttMtu,
+                        (update.txOctets != 0) ? update.txOctets : gapRole_TxOctets,
+                        (update.txOctets != 0) ? update.rxOctets : gapRole_RxOctets);
+  }
+}
+
 /*********************************************************************
  * @fn      gapRole_clockHandler
  *
@@ -95,6 +95,11 @@ extern "C"
 #define GAPROLE_ADV_NONCONN_ENABLED 0x31B  //!< Enable/Disable Non-Connectable Advertising.  Read/Write.  Size is uint8_t.  Default is FALSE=Disabled.
 #define GAPROLE_BD_ADDR_TYPE        0x31C  //!< Address type of connected device. Read only. Size is uint8_t.
 #define GAPROLE_CONN_TERM_REASON    0x31D  //!< Reason of the last connection terminated event. Size is uint8_t.
+#define GAPROLE_LINK_SIZE_UPDATE    0x31E  //!< Request a larger ATT_MTU and LE data length after connection. Read/Write. Size is uint8_t. Default is TRUE=Enabled.
+#define GAPROLE_ATT_MTU             0x31F  //!< Negotiated ATT_MTU of the current connection. Read only. Size is uint16_t. Default is ATT_MTU_SIZE (23).
+#define GAPROLE_DATA_LEN_TX_OCTETS  0x320  //!< Negotiated maximum LL transmit payload of the current connection. Read only. Size is uint16_t. Default is 27.
+#define GAPROLE_DATA_LEN_RX_OCTETS  0x321  //!< Negotiated maximum LL receive payload of the current connection. Read only. Size is uint16_t. Default is 27.
+#define GAPROLE_PARAM_UPDATE_FAILURES 0x322 //!< Number of connection parameter updates that were rejected or timed out. Read only. Size is uint8_t. Wraps around.
 
 /** @} End GAPROLE_PROFILE_PARAMETERS */
 
@@ -158,6 +163,13 @@ typedef void (*gapRolesParamUpdateCB_t)(uint16_t connInterval,
                                         uint16_t connSlaveLatency,
                                         uint16_t connTimeout);
 
+/**
+ * Callback when the ATT_MTU or the LE data length of the connection changes.
+ */
+typedef void (*gapRolesLinkSizeCB_t)(uint16_t connHandle,
+                                     uint16_t attMtu,
+                                     uint16_t txOctets);
+
 /**
  * Callback when the device has been started.  Callback event to
  * the Notify of a state change.
@@ -268,6 +280,45 @@ extern bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
  */
 extern void GAPRole_RegisterAppCBs(gapRolesParamUpdateCB_t *pParamUpdateCB);
 
+/**
+ * @brief       Register application's link size callback.
+ *
+ * @param       pLinkSizeCB - pointer to link size callback.
+ *
+ * @return      none
+ */
+extern void GAPRole_RegisterLinkSizeCB(gapRolesLinkSizeCB_t *pLinkSizeCB);
+
+/**
+ * @brief       Pass on an ATT_MTU update. The application is the one
+ *              registered for GATT messages, so it calls this on
+ *              ATT_MTU_UPDATED_EVENT.
+ *              The update is applied, and the link size callback
+ *              called, from the GAPRole task.
+ *
+ * @param       connHandle - connection handle
+ * @param       attMtu - new ATT_MTU
+ *
+ * @return      none
+ */
+extern void GAPRole_MtuUpdated(uint16_t connHandle, uint16_t attMtu);
+
+/**
+ * @brief       Pass on an LE data length update. The application is the one
+ *              registered for HCI messages, so it calls this on the LE Data
+ *              Length Change event.
+ *              The update is applied, and the link size callback
+ *              called, from the GAPRole task.
+ *
+ * @param       connHandle - connection handle
+ * @param       txOctets - maximum LL transmit payload
+ * @param       rxOctets - maximum LL receive payload
+ *
+ * @return      none
+ */
+extern void GAPRole_DataLenUpdated(uint16_t connHandle, uint16_t txOctets,
+                                   uint16_t rxOctets);
+
 /**
  * @} End GAPROLES_PERIPHERAL_API
  */
@@ -63,6 +63,7 @@
 #include "gatt_uuid.h"
 #include "gatt_profile_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 #include "gapbondmgr.h"
 
 #include "proxreporter.h"
@@ -330,6 +331,12 @@ bStatus_t ProxReporter_AddService(uint32 services)
                                          GATT_NUM_ATTRS(linkLossAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &proxReporterCBs);
+
+    if (status == SUCCESS)
+    {
+      // Add the service to the database hash
+      VOID GATTDbHash_addService(linkLossAttrTbl, GATT_NUM_ATTRS(linkLossAttrTbl));
+    }
   }
 
   if ((status == SUCCESS) && (services & PP_IM_ALETR_SERVICE))
@@ -339,6 +346,12 @@ bStatus_t ProxReporter_AddService(uint32 services)
                                          GATT_NUM_ATTRS(imAlertAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &proxReporterCBs);
+
+    if (status == SUCCESS)
+    {
+      // Add the service to the database hash
+      VOID GATTDbHash_addService(imAlertAttrTbl, GATT_NUM_ATTRS(imAlertAttrTbl));
+    }
   }
   
   if ((status == SUCCESS)  && (services & PP_TX_PWR_LEVEL_SERVICE))
@@ -356,6 +369,12 @@ bStatus_t ProxReporter_AddService(uint32 services)
                                            GATT_NUM_ATTRS(txPwrLevelAttrTbl),
                                            GATT_MAX_ENCRYPT_KEY_SIZE,
                                            &proxReporterCBs);
+
+      if (status == SUCCESS)
+      {
+        // Add the service to the database hash
+        VOID GATTDbHash_addService(txPwrLevelAttrTbl, GATT_NUM_ATTRS(txPwrLevelAttrTbl));
+      }
     }
     else
     {
@@ -0,0 +1,630 @@
+/******************************************************************************
+
+ @file  recorderservice.c
+
+ @brief Sample recorder service. Downloads the flash sample log in
+        notifications and resumes from a log offset.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+ 
+ Copyright (c) 2015-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef EXCLUDE_RECORDER
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "linkdb.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "gatt_db_hash.h"
+#include "string.h"
+
+#include "recorderservice.h"
+
+#include "icall_api.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Attribute names
+#ifdef USER_DESCRIPTION
+#define RECORDER_DATA_DESCR       "Recorder Data"
+#define RECORDER_CTRL_DESCR       "Recorder Control"
+#endif
+
+// Position of the data value in the attribute table
+#define RECORDER_DATA_VALUE_IDX   2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Service UUID
+static CONST uint8_t recorderServiceUUID[TI_UUID_SIZE] =
+{
+  TI_UUID(RECORDER_SERV_UUID),
+};
+
+// Characteristic UUID: data
+static CONST uint8_t recorderDataUUID[TI_UUID_SIZE] =
+{
+  TI_UUID(RECORDER_DATA_UUID),
+};
+
+// Characteristic UUID: control
+static CONST uint8_t recorderCtrlUUID[TI_UUID_SIZE] =
+{
+  TI_UUID(RECORDER_CTRL_UUID),
+};
+
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static sensorCBs_t *recorder_AppCBs = NULL;
+
+// Connection that issued the last command, the download goes there
+static uint16_t recorderConnHandle = INVALID_CONNHANDLE;
+
+// Last command written by the client
+static uint8_t recorderCommand[RECORDER_COMMAND_LEN];
+
+/*********************************************************************
+ * Profile Attributes - variables
+ */
+
+// Profile Service attribute
+static CONST gattAttrType_t recorderService = { TI_UUID_SIZE,
+                                                recorderServiceUUID };
+
+// Characteristic Properties: data
+static uint8_t recorderDataProps = GATT_PROP_NOTIFY;
+
+// Characteristic Value: data (only ever notified)
+static uint8_t recorderData = 0;
+
+// Characteristic Configuration: data
+static gattCharCfg_t *recorderDataConfig;
+
+#ifdef USER_DESCRIPTION
+// Characteristic User Description: data
+static uint8_t recorderDataUserDescr[] = RECORDER_DATA_DESCR;
+#endif
+
+// Characteristic Properties: control
+static uint8_t recorderCtrlProps = GATT_PROP_READ | GATT_PROP_WRITE;
+
+// Characteristic Value: control (reads return the status)
+static uint8_t recorderStatus[RECORDER_STATUS_LEN];
+
+#ifdef USER_DESCRIPTION
+// Characteristic User Description: control
+static uint8_t recorderCtrlUserDescr[] = RECORDER_CTRL_DESCR;
+#endif
+
+/*********************************************************************
+ * Profile Attributes - Table
+ */
+
+static gattAttribute_t recorderAttrTable[] =
+{
+  {
+    { ATT_BT_UUID_SIZE, primaryServiceUUID }, /* type */
+    GATT_PERMIT_READ,                         /* permissions */
+    0,                                        /* handle */
+    (uint8_t *)&recorderService               /* pValue */
+  },
+
+    // Characteristic Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      &recorderDataProps
+    },
+
+      // Characteristic Value "Data"
+      {
+        { TI_UUID_SIZE, recorderDataUUID },
+        0,
+        0,
+        &recorderData
+      },
+
+      // Characteristic configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+        0,
+        (uint8_t *)&recorderDataConfig
+      },
+#ifdef USER_DESCRIPTION
+      // Characteristic User Description
+      {
+        { ATT_BT_UUID_SIZE, charUserDescUUID },
+        GATT_PERMIT_READ,
+        0,
+        recorderDataUserDescr
+      },
+#endif
+    // Characteristic Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      &recorderCtrlProps
+    },
+
+      // Characteristic Value "Control"
+      {
+        { TI_UUID_SIZE, recorderCtrlUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+        0,
+        recorderStatus
+      },
+
+#ifdef USER_DESCRIPTION
+      // Characteristic User Description
+      {
+        { ATT_BT_UUID_SIZE, charUserDescUUID },
+        GATT_PERMIT_READ,
+        0,
+        recorderCtrlUserDescr
+      },
+#endif
+};
+
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t recorder_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t *pLen,
+                                     uint16_t offset, uint16_t maxLen,
+                                     uint8_t method);
+static bStatus_t recorder_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                      uint8_t *pValue, uint16_t len,
+                                      uint16_t offset, uint8_t method);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+
+// Recorder Service Callbacks
+// Note: When an operation on a characteristic requires authorization and
+// pfnAuthorizeAttrCB is not defined for that characteristic's service, the
+// Stack will report a status of ATT_ERR_UNLIKELY to the client.  When an
+// operation on a characteristic requires authorization the Stack will call
+// pfnAuthorizeAttrCB to check a client's authorization prior to calling
+// pfnReadAttrCB or pfnWriteAttrCB, so no checks for authorization need to be
+// made within these functions.
+static CONST gattServiceCBs_t recorderCBs =
+{
+  recorder_ReadAttrCB,  // Read callback function pointer
+  recorder_WriteAttrCB, // Write callback function pointer
+  NULL                  // Authorization callback function pointer
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Recorder_addService
+ *
+ * @brief   Initializes the Recorder service by registering
+ *          GATT attributes with the GATT server.
+ *
+ * @return  Success or Failure
+ */
+bStatus_t Recorder_addService(void)
+{
+  bStatus_t status;
+
+  // Allocate Client Characteristic Configuration table
+  recorderDataConfig = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
+                                                     linkDBNumConns);
+  if (recorderDataConfig == NULL)
+  {
+    return (bleMemAllocError);
+  }
+
+  // Initialize Client Characteristic Configuration attributes
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, recorderDataConfig);
+
+  // Register GATT attribute list and CBs with GATT Server App
+  status = GATTServApp_RegisterService(recorderAttrTable,
+                                       GATT_NUM_ATTRS (recorderAttrTable),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &recorderCBs);
+
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(recorderAttrTable,
+                                GATT_NUM_ATTRS(recorderAttrTable));
+  }
+
+  return (status);
+}
+
+
+/*********************************************************************
+ * @fn      Recorder_registerAppCBs
+ *
+ * @brief   Registers the application callback function. Only call
+ *          this function once.
+ *
+ * @param   callbacks - pointer to application callbacks.
+ *
+ * @return  SUCCESS or bleAlreadyInRequestedMode
+ */
+bStatus_t Recorder_registerAppCBs(sensorCBs_t *appCallbacks)
+{
+  if (recorder_AppCBs == NULL)
+  {
+    if (appCallbacks != NULL)
+    {
+      recorder_AppCBs = appCallbacks;
+    }
+
+    return (SUCCESS);
+  }
+
+  return (bleAlreadyInRequestedMode);
+}
+
+/*********************************************************************
+ * @fn      Recorder_setParameter
+ *
+ * @brief   Set a Recorder service parameter.
+ *
+ * @param   param - Profile parameter ID (only the status is applicable)
+ * @param   len - length of data to write
+ * @param   value - pointer to data to write.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Recorder_setParameter(uint8_t param, uint8_t len, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case RECORDER_STATUS:
+      if (len == RECORDER_STATUS_LEN)
+      {
+        memcpy(recorderStatus, value, len);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+/*********************************************************************
+ * @fn      Recorder_getParameter
+ *
+ * @brief   Get a Recorder service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   value - pointer to data to put.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Recorder_getParameter(uint8_t param, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case RECORDER_COMMAND:
+      memcpy(value, recorderCommand, RECORDER_COMMAND_LEN);
+      break;
+
+    case RECORDER_STATUS:
+      memcpy(value, recorderStatus, RECORDER_STATUS_LEN);
+      break;
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+/*********************************************************************
+ * @fn      Recorder_getConnHandle
+ *
+ * @brief   Connection of the client that issued the last command.
+ *
+ * @return  connection handle, INVALID_CONNHANDLE if there is none
+ */
+uint16_t Recorder_getConnHandle(void)
+{
+  return (recorderConnHandle);
+}
+
+/*********************************************************************
+ * @fn      Recorder_sendData
+ *
+ * @brief   Notify a piece of the log to the client that issued the
+ *          last command. The notification holds the log offset
+ *          followed by as much of the data as the ATT_MTU allows.
+ *          Unlike the other services this bypasses the GATT transmit
+ *          queue, which keeps one value per attribute: the caller
+ *          tries again later when the stack is out of buffers.
+ *
+ * @param   offset - log offset of the first byte
+ * @param   pData - log data, NULL with len 0 marks the end of the log
+ * @param   len - length of the log data
+ * @param   pSent - number of data bytes sent (output)
+ *
+ * @return  SUCCESS, bleNoResources or failure
+ */
+bStatus_t Recorder_sendData(uint32_t offset, const uint8_t *pData,
+                            uint16_t len, uint16_t *pSent)
+{
+  attHandleValueNoti_t noti;
+  uint16_t allocLen;
+  bStatus_t status;
+
+  *pSent = 0;
+
+  if ((recorderConnHandle == INVALID_CONNHANDLE) ||
+      !(GATTServApp_ReadCharCfg(recorderConnHandle, recorderDataConfig) &
+        GATT_CLIENT_CFG_NOTIFY))
+  {
+    return (bleIncorrectMode);
+  }
+
+  // Allocate as much as the ATT_MTU of the connection allows
+  noti.pValue = (uint8 *)GATT_bm_alloc(recorderConnHandle,
+                                       ATT_HANDLE_VALUE_NOTI,
+                                       GATT_MAX_MTU, &allocLen);
+  if (noti.pValue == NULL)
+  {
+    return (bleNoResources);
+  }
+
+  if (len > allocLen - RECORDER_OFFSET_LEN)
+  {
+    len = allocLen - RECORDER_OFFSET_LEN;
+  }
+
+  noti.pValue[0] = BREAK_UINT32(offset, 0);
+  noti.pValue[1] = BREAK_UINT32(offset, 1);
+  noti.pValue[2] = BREAK_UINT32(offset, 2);
+  noti.pValue[3] = BREAK_UINT32(offset, 3);
+  if (len > 0)
+  {
+    memcpy(&noti.pValue[RECORDER_OFFSET_LEN], pData, len);
+  }
+
+  noti.handle = recorderAttrTable[RECORDER_DATA_VALUE_IDX].handle;
+  noti.len = RECORDER_OFFSET_LEN + len;
+
+  status = GATT_Notification(recorderConnHandle, &noti, FALSE);
+  if (status == SUCCESS)
+  {
+    *pSent = len;
+  }
+  else
+  {
+    GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
+
+    if ((status == blePending) || (status == MSG_BUFFER_NOT_AVAIL))
+    {
+      status = bleNoResources;
+    }
+  }
+
+  return (status);
+}
+
+
+/*********************************************************************
+ * @fn          recorder_ReadAttrCB
+ *
+ * @brief       Read an attribute.
+ *
+ * @param       connHandle - connection message was received on
+ * @param       pAttr - pointer to attribute
+ * @param       pValue - pointer to data to be read
+ * @param       pLen - length of data to be read
+ * @param       offset - offset of the first octet to be read
+ * @param       maxLen - maximum length of data to be read
+ * @param       method - type of read message
+ *
+ * @return      SUCCESS, blePending or Failure
+ */
+static bStatus_t recorder_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t *pLen,
+                                     uint16_t offset, uint16_t maxLen,
+                                     uint8_t method)
+{
+  uint16_t uuid;
+  bStatus_t status = SUCCESS;
+
+  // Make sure it's not a blob operation (no attributes in the profile are long)
+  if (offset > 0)
+  {
+    return (ATT_ERR_ATTR_NOT_LONG);
+  }
+
+  if (utilExtractUuid16(pAttr,&uuid) == FAILURE) {
+    // Invalid handle
+    *pLen = 0;
+    return ATT_ERR_INVALID_HANDLE;
+  }
+
+  switch (uuid)
+  {
+    // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
+    // gattserverapp handles those reads
+    case RECORDER_CTRL_UUID:
+      *pLen = RECORDER_STATUS_LEN;
+      memcpy(pValue, pAttr->pValue, RECORDER_STATUS_LEN);
+      break;
+
+    default:
+      *pLen = 0;
+      status = ATT_ERR_ATTR_NOT_FOUND;
+      break;
+    }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      recorder_WriteAttrCB
+ *
+ * @brief   Validate attribute data prior to a write operation
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS, blePending or Failure
+ */
+static bStatus_t recorder_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                      uint8_t *pValue, uint16_t len,
+                                      uint16_t offset, uint8_t method)
+{
+    bStatus_t status = SUCCESS;
+    uint8_t notifyApp = 0xFF;
+    uint16_t uuid;
+
+    if (utilExtractUuid16(pAttr,&uuid) == FAILURE)
+    {
+        // Invalid handle
+        return ATT_ERR_INVALID_HANDLE;
+    }
+
+    switch (uuid)
+    {
+    case RECORDER_CTRL_UUID:
+        // Validate the value
+        // Make sure it's not a blob oper
+        if (offset == 0)
+        {
+            // Only the start command carries an offset
+            if ((len == 0) ||
+                (len != ((pValue[0] == RECORDER_CMD_START) ?
+                         RECORDER_COMMAND_LEN : 1)))
+            {
+                status = ATT_ERR_INVALID_VALUE_SIZE;
+            }
+            else if (pValue[0] > RECORDER_CMD_ERASE)
+            {
+                status = ATT_ERR_INVALID_VALUE;
+            }
+        }
+        else
+        {
+            status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        // Write the value
+        if (status == SUCCESS)
+        {
+            memset(recorderCommand, 0, RECORDER_COMMAND_LEN);
+            memcpy(recorderCommand, pValue, len);
+            recorderConnHandle = connHandle;
+            notifyApp = RECORDER_COMMAND;
+        }
+        break;
+
+    case GATT_CLIENT_CHAR_CFG_UUID:
+        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                                offset, GATT_CLIENT_CFG_NOTIFY);
+        break;
+
+    default:
+        // Should never get here!
+        status = ATT_ERR_ATTR_NOT_FOUND;
+        break;
+    }
+
+    // If a characteristic value changed then callback function
+    // to notify application of change
+    if ((notifyApp != 0xFF) && recorder_AppCBs &&
+        recorder_AppCBs->pfnSensorChange)
+    {
+        recorder_AppCBs->pfnSensorChange(notifyApp);
+    }
+
+    return (status);
+}
+
+
+/*********************************************************************
+*********************************************************************/
+#endif
@@ -0,0 +1,165 @@
+/******************************************************************************
+
+ @file  recorderservice.h
+
+ @brief Sample recorder service. Downloads the flash sample log in
+        notifications and resumes from a log offset.
+
+ Group: WCS, BTS
+ Target Device: CC2650, CC2640, CC1350
+
+ ******************************************************************************
+
+ Copyright (c) 2015-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: ble_sdk_2_02_01_18
+ Release Date: 2016-10-26 15:20:04
+ *****************************************************************************/
+
+#ifndef RECORDERSERVICE_H
+#define RECORDERSERVICE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "st_util.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Service UUID
+#define RECORDER_SERV_UUID        0xAD00 // F000AD00-0451-4000-B000-00000000-0000
+#define RECORDER_DATA_UUID        0xAD01
+#define RECORDER_CTRL_UUID        0xAD02
+
+// Attribute Identifiers
+#define RECORDER_COMMAND          0 // Written by the client
+#define RECORDER_STATUS           1 // Read by the client
+
+// Attribute sizes
+#define RECORDER_COMMAND_LEN      5 // Byte 0: command, byte 1-4: log offset
+#define RECORDER_STATUS_LEN       9 // Byte 0: state, 1-4: oldest, 5-8: end
+#define RECORDER_OFFSET_LEN       4 // Log offset leading each notification
+
+// Commands
+#define RECORDER_CMD_STOP         0x00 // Stop a download
+#define RECORDER_CMD_START        0x01 // Download from the given log offset
+#define RECORDER_CMD_ERASE        0x02 // Discard the recorded log
+
+// States
+#define RECORDER_STATE_IDLE       0x00
+#define RECORDER_STATE_RECORDING  0x01
+#define RECORDER_STATE_DOWNLOAD   0x02
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+
+/*
+ * Recorder_addService- Initializes the Recorder service by registering
+ *          GATT attributes with the GATT server.
+ */
+extern bStatus_t Recorder_addService(void);
+
+/*
+ * Recorder_registerAppCBs - Registers the application callback function.
+ *                    Only call this function once.
+ *
+ *    appCallbacks - pointer to application callbacks.
+ */
+extern bStatus_t Recorder_registerAppCBs(sensorCBs_t *appCallbacks);
+
+/*
+ * Recorder_setParameter - Set a Recorder service parameter.
+ *
+ *    param - Profile parameter ID (only the status is applicable)
+ *    len   - length of data to write
+ *    value - pointer to data to write.
+ */
+extern bStatus_t Recorder_setParameter(uint8_t param, uint8_t len, void *value);
+
+/*
+ * Recorder_getParameter - Get a Recorder service parameter.
+ *
+ *    param - Profile parameter ID
+ *    value - pointer to data to read. The command is always returned
+ *            as RECORDER_COMMAND_LEN bytes, missing bytes read as 0.
+ */
+extern bStatus_t Recorder_getParameter(uint8_t param, void *value);
+
+/*
+ * Recorder_sendData - Notify a piece of the log to the client that
+ *          issued the last command. As much of the data as fits in
+ *          one notification (ATT_MTU - 3 - RECORDER_OFFSET_LEN) is sent.
+ *
+ *    offset - log offset of the first byte
+ *    pData  - log data, NULL with len 0 marks the end of the log
+ *    len    - length of the log data
+ *    pSent  - number of data bytes sent (output)
+ *
+ *    Returns SUCCESS, bleNoResources if the stack is out of buffers
+ *    for now, or a failure status if the client is gone or has
+ *    notifications turned off.
+ */
+extern bStatus_t Recorder_sendData(uint32_t offset, const uint8_t *pData,
+                                   uint16_t len, uint16_t *pSent);
+
+/*
+ * Recorder_getConnHandle - Connection of the client that issued the
+ *          last command, INVALID_CONNHANDLE if there is none.
+ */
+extern uint16_t Recorder_getConnHandle(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORDERSERVICE_H */
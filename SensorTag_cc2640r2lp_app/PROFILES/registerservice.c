@@ -53,6 +53,7 @@
 #include "gatt.h"
 #include "gatt_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 #include "string.h"
 
 #include "registerservice.h"
@@ -297,11 +298,21 @@ static CONST gattServiceCBs_t sensorCBs =
  */
 bStatus_t Register_addService(void)
 {
+  bStatus_t status;
+
   // Register GATT attribute list and CBs with GATT Server App
-  return GATTServApp_RegisterService(sensorAttrTable,
-                                      GATT_NUM_ATTRS (sensorAttrTable),
-                                      GATT_MAX_ENCRYPT_KEY_SIZE,
-                                      &sensorCBs);
+  status = GATTServApp_RegisterService(sensorAttrTable,
+                                       GATT_NUM_ATTRS (sensorAttrTable),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &sensorCBs);
+
+  if (status == SUCCESS)
+  {
+    // Add the service to the database hash
+    VOID GATTDbHash_addService(sensorAttrTable, GATT_NUM_ATTRS(sensorAttrTable));
+  }
+
+  return (status);
 }
 
 
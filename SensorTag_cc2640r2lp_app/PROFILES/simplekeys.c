@@ -62,6 +62,7 @@
 #include "gatt.h"
 #include "gatt_uuid.h"
 #include "gattservapp.h"
+#include "gatt_db_hash.h"
 #include "gapbondmgr.h"
 
 #include "simplekeys.h"
@@ -243,6 +244,12 @@ bStatus_t SK_AddService(uint32 services)
                                          GATT_NUM_ATTRS(simplekeysAttrTbl),
                                          GATT_MAX_ENCRYPT_KEY_SIZE,
                                          &skCBs);
+
+    if (status == SUCCESS)
+    {
+      // Add the service to the database hash
+      VOID GATTDbHash_addService(simplekeysAttrTbl, GATT_NUM_ATTRS(simplekeysAttrTbl));
+    }
   }
 
   return (status);
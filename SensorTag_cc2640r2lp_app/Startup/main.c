@@ -61,6 +61,7 @@
 
 // Application
 #include "sensortag.h"
+#include "sensortag_boot.h"
 
 /* Header files required to enable instruction fetch cache */
 #include <inc/hw_memmap.h>
@@ -161,6 +162,8 @@ extern void AssertHandler(uint8 assertCause, uint8 assertSubcause);
  */
 int main()
 {
+  SensorTagBoot_mark(ST_BOOT_MAIN);
+
 #if defined( USE_FPGA )
   HWREG(PRCM_BASE + PRCM_O_PDCTL0) &= ~PRCM_PDCTL0_RFC_ON;
   HWREG(PRCM_BASE + PRCM_O_PDCTL1) &= ~PRCM_PDCTL1_RFC_ON;
@@ -208,12 +211,14 @@ int main()
 #endif  /* ICALL_JT */
   /* Initialize ICall module */
   ICall_init();
+  SensorTagBoot_mark(ST_BOOT_ICALL_INIT);
 
   /* Start tasks of external images - Priority 5 */
   ICall_createRemoteTasks();
 
   /* Kick off profile - Priority 3 */
   GAPRole_createTask();
+  SensorTagBoot_mark(ST_BOOT_GAPROLE_TASK);
 
   /* Kick off application - Priority 1 */
   SensorTag_createTask();
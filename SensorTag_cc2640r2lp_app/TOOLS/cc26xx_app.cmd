@@ -154,6 +154,9 @@ SECTIONS
     .emb_text       :   >> FLASH | FLASH_LAST_PAGE
     .ccfg           :   >  FLASH_LAST_PAGE (HIGH)
 
+    /* Whole pages for the sample recorder log, not part of the image */
+    .recorder       :   >  FLASH (HIGH), type = NOLOAD, align = FLASH_PAGE_LEN
+
 	GROUP > SRAM
 	{
 	    .data
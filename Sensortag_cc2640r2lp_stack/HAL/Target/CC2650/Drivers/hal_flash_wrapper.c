@@ -55,6 +55,7 @@
 #include <inc/hw_memmap.h>
    
 uint8* HalFlashGetAddress( uint8 pg, uint16 offset );
+void HalFlashEraseSector( uint32 addr );
 /**************************************************************************************************
  * @fn          HalFlashRead
  *
@@ -138,6 +139,29 @@ void HalFlashErase(uint8 pg)
   FlashSectorErase( (uint32)HalFlashGetAddress(pg, 0));
 }
 
+/**************************************************************************************************
+ * @fn          HalFlashEraseSector
+ *
+ * @brief       This function erases the flash sector at an absolute address. Unlike
+ *              HalFlashErase it is not limited to the NV pages, so the application
+ *              can erase its own flash areas on the stack thread (ICall direct API).
+ *
+ * input parameters
+ *
+ * @param       addr - Address of the sector, aligned to the sector size.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashEraseSector(uint32 addr)
+{
+  FlashSectorErase( addr );
+}
+
 /**************************************************************************************************
  * @fn          HalFlashGetAddress
  *
@@ -60,14 +60,62 @@
  * MACROS
  */
 
+// Number of entries in a UUID lookup table
+#define UUID_TBL_SIZE(tbl)          ( sizeof( tbl ) / sizeof( tbl[0] ) )
+
 /*********************************************************************
  * CONSTANTS
  */
 
+// Offset of the 16-bit alias within a 128-bit base UUID (bytes 12 and 13)
+#define UUID_ALIAS_OFFSET           12
+
+#ifdef GATT_TI_UUID_128_BIT
+/*
+ * 16-bit aliases of the TI 128-bit UUIDs resolved by GATT_FindUUIDRec.
+ * This list is generated from the service headers by
+ * tests/host/gatt_uuid_gen.c and MUST be kept sorted by ascending alias
+ * value.
+ */
+#define GATT_TI_UUID_ALIASES( X ) \
+  X( 0xAA64 ) /* IO_SERV_UUID */ \
+  X( 0xAA65 ) /* IO_DATA_UUID */ \
+  X( 0xAA66 ) /* IO_CONF_UUID */ \
+  X( 0xAC00 ) /* REGISTER_SERV_UUID */ \
+  X( 0xAC01 ) /* REGISTER_DATA_UUID */ \
+  X( 0xAC02 ) /* REGISTER_ADDR_UUID */ \
+  X( 0xAC03 ) /* REGISTER_DEV_UUID */ \
+  X( 0xAD00 ) /* RECORDER_SERV_UUID */ \
+  X( 0xAD01 ) /* RECORDER_DATA_UUID */ \
+  X( 0xAD02 ) /* RECORDER_CTRL_UUID */ \
+  X( 0xAE00 ) /* DIAG_SERV_UUID */ \
+  X( 0xAE01 ) /* DIAG_BOOT_UUID */ \
+  X( 0xCCC0 ) /* CCSERVICE_SERV_UUID */ \
+  X( 0xCCC1 ) /* CCSERVICE_CHAR1_UUID */ \
+  X( 0xCCC2 ) /* CCSERVICE_CHAR2_UUID */ \
+  X( 0xCCC3 ) /* CCSERVICE_CHAR3_UUID */
+
+#define TI_UUID_ALIAS( uuid )       uuid,
+#endif // GATT_TI_UUID_128_BIT
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// UUID lookup table entry: 16-bit UUID (or alias) and its record
+typedef struct
+{
+  uint16 uuid;         // 16-bit UUID or 16-bit alias within a base UUID
+  const uint8 *pRec;   // UUID record
+} gattUUIDTblEntry_t;
+
+// 128-bit UUID record built from a base UUID and a 16-bit alias
+typedef struct gattUUIDRec
+{
+  struct gattUUIDRec *pNext;  // next record built
+  uint8 uuid[ATT_UUID_SIZE];  // 128-bit UUID
+} gattUUIDRec_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -224,9 +272,73 @@ CONST uint8 reportRefUUID[ATT_BT_UUID_SIZE] =
  * LOCAL VARIABLES
  */
 
+/*
+ * 16-bit UUID records. This table is searched with a binary search and
+ * therefore MUST be kept sorted by ascending UUID value.
+ */
+static CONST gattUUIDTblEntry_t gattUUIDTbl[] =
+{
+  /*** GATT Services ***/
+  { GAP_SERVICE_UUID,                 gapServiceUUID },      // 0x1800
+  { GATT_SERVICE_UUID,                gattServiceUUID },     // 0x1801
+
+  /*** GATT Declarations ***/
+  { GATT_PRIMARY_SERVICE_UUID,        primaryServiceUUID },  // 0x2800
+  { GATT_SECONDARY_SERVICE_UUID,      secondaryServiceUUID },// 0x2801
+  { GATT_INCLUDE_UUID,                includeUUID },         // 0x2802
+  { GATT_CHARACTER_UUID,              characterUUID },       // 0x2803
+
+  /*** GATT Descriptors ***/
+  { GATT_CHAR_EXT_PROPS_UUID,         charExtPropsUUID },    // 0x2900
+  { GATT_CHAR_USER_DESC_UUID,         charUserDescUUID },    // 0x2901
+  { GATT_CLIENT_CHAR_CFG_UUID,        clientCharCfgUUID },   // 0x2902
+  { GATT_SERV_CHAR_CFG_UUID,          servCharCfgUUID },     // 0x2903
+  { GATT_CHAR_FORMAT_UUID,            charFormatUUID },      // 0x2904
+  { GATT_CHAR_AGG_FORMAT_UUID,        charAggFormatUUID },   // 0x2905
+  { GATT_VALID_RANGE_UUID,            validRangeUUID },      // 0x2906
+  { GATT_EXT_REPORT_REF_UUID,         extReportRefUUID },    // 0x2907
+  { GATT_REPORT_REF_UUID,             reportRefUUID },       // 0x2908
+
+  /*** GATT Characteristics ***/
+  { DEVICE_NAME_UUID,                 deviceNameUUID },      // 0x2A00
+  { APPEARANCE_UUID,                  appearanceUUID },      // 0x2A01
+  { PERI_PRIVACY_FLAG_UUID,           periPrivacyFlagUUID }, // 0x2A02
+  { RECONNECT_ADDR_UUID,              reconnectAddrUUID },   // 0x2A03
+  { PERI_CONN_PARAM_UUID,             periConnParamUUID },   // 0x2A04
+  { SERVICE_CHANGED_UUID,             serviceChangedUUID },  // 0x2A05
+  { CENTRAL_ADDRESS_RESOLUTION_UUID,  centAddrResUUID }      // 0x2AA6
+};
+
+#ifdef GATT_TI_UUID_128_BIT
+// TI Base 128-bit UUID F000XXXX-0451-4000-B000-000000000000, stored
+// without the 16-bit alias (bytes 12 and 13)
+static CONST uint8 tiBaseUUID[ATT_UUID_SIZE-2] =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB0,
+  0x00, 0x40, 0x51, 0x04, 0x00, 0xF0
+};
+
+// Lookup keys: the 16-bit aliases within tiBaseUUID
+static CONST uint16 tiUUIDTbl[] =
+{
+  GATT_TI_UUID_ALIASES( TI_UUID_ALIAS )
+};
+#endif // GATT_TI_UUID_128_BIT
+
+// 128-bit UUID records built so far. Callers keep the record pointer, so
+// records are built on first use and never freed.
+static gattUUIDRec_t *gattUUIDRecList = NULL;
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
+static const uint8 *gattFindUUID16Rec( uint16 uuid );
+static const uint8 *gattBuildUUIDRec( const uint8 *pUUID );
+static uint8 gattIsBaseUUID( const uint8 *pUUID, const uint8 *pBaseLo,
+                             const uint8 *pBaseHi );
+#ifdef GATT_TI_UUID_128_BIT
+static uint8 gattIsTIAlias( uint16 uuid );
+#endif
 
 /*********************************************************************
  * API FUNCTIONS
@@ -237,6 +349,13 @@ CONST uint8 reportRefUUID[ATT_BT_UUID_SIZE] =
  *
  * @brief   Find the UUID record for a given UUID.
  *
+ *          16-bit UUIDs are resolved through the sorted 16-bit record
+ *          table. 128-bit UUIDs built on the Bluetooth Base UUID are
+ *          checked against the same table, and 128-bit UUIDs built on
+ *          the TI Base UUID against the TI alias table. The record
+ *          returned always has the length asked for: 128-bit records are
+ *          built from the base and the alias on first use.
+ *
  * @param   pUUID - UUID to look for.
  * @param   len - length of UUID.
  *
@@ -249,113 +368,163 @@ const uint8 *GATT_FindUUIDRec( const uint8 *pUUID, uint8 len )
   if ( len == ATT_BT_UUID_SIZE )
   {
     // 16-bit UUID
-    uint16 uuid = BUILD_UINT16( pUUID[0], pUUID[1] );
-    switch ( uuid )
-    {
-      /*** GATT Services ***/
-
-      case GAP_SERVICE_UUID:
-        pRec = gapServiceUUID;
-        break;
-
-      case GATT_SERVICE_UUID:
-        pRec = gattServiceUUID;
-        break;
-
-      /*** GATT Declarations ***/
-
-      case GATT_PRIMARY_SERVICE_UUID:
-        pRec = primaryServiceUUID;
-        break;
-
-      case GATT_SECONDARY_SERVICE_UUID:
-        pRec = secondaryServiceUUID;
-        break;
-
-      case GATT_INCLUDE_UUID:
-        pRec = includeUUID;
-        break;
-
-      case GATT_CHARACTER_UUID:
-        pRec = characterUUID;
-        break;
-
-      /*** GATT Descriptors ***/
-
-      case GATT_CHAR_EXT_PROPS_UUID:
-        pRec = charExtPropsUUID;
-        break;
-
-      case GATT_CHAR_USER_DESC_UUID:
-        pRec = charUserDescUUID;
-        break;
-
-      case GATT_CLIENT_CHAR_CFG_UUID:
-        pRec = clientCharCfgUUID;
-        break;
-
-      case GATT_SERV_CHAR_CFG_UUID:
-        pRec = servCharCfgUUID;
-        break;
-
-      case GATT_CHAR_FORMAT_UUID:
-        pRec = charFormatUUID;
-        break;
-
-      case GATT_CHAR_AGG_FORMAT_UUID:
-        pRec = charAggFormatUUID;
-        break;
+    pRec = gattFindUUID16Rec( BUILD_UINT16( pUUID[0], pUUID[1] ) );
+  }
+  else if ( len == ATT_UUID_SIZE )
+  {
+    // 128-bit UUID
+    uint16 uuid = BUILD_UINT16( pUUID[UUID_ALIAS_OFFSET],
+                                pUUID[UUID_ALIAS_OFFSET+1] );
 
-      case GATT_VALID_RANGE_UUID:
-        pRec = validRangeUUID;
-        break;
+    // Bluetooth Base UUID (btBaseUUID): 0000XXXX-0000-1000-8000-00805F9B34FB
+    if ( gattIsBaseUUID( pUUID, btBaseUUID, &btBaseUUID[UUID_ALIAS_OFFSET+2] ) )
+    {
+      if ( gattFindUUID16Rec( uuid ) != NULL )
+      {
+        pRec = gattBuildUUIDRec( pUUID );
+      }
+    }
+#ifdef GATT_TI_UUID_128_BIT
+    else if ( gattIsBaseUUID( pUUID, tiBaseUUID, &tiBaseUUID[UUID_ALIAS_OFFSET] ) )
+    {
+      if ( gattIsTIAlias( uuid ) )
+      {
+        pRec = gattBuildUUIDRec( pUUID );
+      }
+    }
+#endif
+  }
 
-      case GATT_EXT_REPORT_REF_UUID:
-        pRec = extReportRefUUID;
-        break;
+  return ( pRec );
+}
 
-      case GATT_REPORT_REF_UUID:
-        pRec = reportRefUUID;
-        break;
+/*********************************************************************
+ * @fn      gattFindUUID16Rec
+ *
+ * @brief   Binary search the 16-bit UUID record table.
+ *
+ * @param   uuid - 16-bit UUID to look for.
+ *
+ * @return  Pointer to UUID record. NULL, otherwise.
+ */
+static const uint8 *gattFindUUID16Rec( uint16 uuid )
+{
+  uint8 lo = 0;
+  uint8 hi = UUID_TBL_SIZE( gattUUIDTbl );
 
-      /*** GATT Characteristics ***/
+  while ( lo < hi )
+  {
+    uint8 mid = lo + ( ( hi - lo ) >> 1 );
 
-      case DEVICE_NAME_UUID:
-        pRec = deviceNameUUID;
-        break;
+    if ( gattUUIDTbl[mid].uuid == uuid )
+    {
+      return ( gattUUIDTbl[mid].pRec );
+    }
+    else if ( gattUUIDTbl[mid].uuid < uuid )
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
 
-      case APPEARANCE_UUID:
-        pRec = appearanceUUID;
-        break;
+  return ( NULL );
+}
 
-      case RECONNECT_ADDR_UUID:
-        pRec = reconnectAddrUUID;
-        break;
+#ifdef GATT_TI_UUID_128_BIT
+/*********************************************************************
+ * @fn      gattIsTIAlias
+ *
+ * @brief   Binary search the TI 128-bit UUID alias table.
+ *
+ * @param   uuid - 16-bit alias to look for.
+ *
+ * @return  TRUE if the alias is in the table. FALSE, otherwise.
+ */
+static uint8 gattIsTIAlias( uint16 uuid )
+{
+  uint8 lo = 0;
+  uint8 hi = UUID_TBL_SIZE( tiUUIDTbl );
 
-      case PERI_PRIVACY_FLAG_UUID:
-        pRec = periPrivacyFlagUUID;
-        break;
+  while ( lo < hi )
+  {
+    uint8 mid = lo + ( ( hi - lo ) >> 1 );
 
-      case PERI_CONN_PARAM_UUID:
-        pRec = periConnParamUUID;
-        break;
+    if ( tiUUIDTbl[mid] == uuid )
+    {
+      return ( TRUE );
+    }
+    else if ( tiUUIDTbl[mid] < uuid )
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
 
-      case SERVICE_CHANGED_UUID:
-        pRec = serviceChangedUUID;
-        break;
+  return ( FALSE );
+}
+#endif // GATT_TI_UUID_128_BIT
 
-      /*** GATT Units ***/
+/*********************************************************************
+ * @fn      gattBuildUUIDRec
+ *
+ * @brief   Find the 128-bit record for a UUID, or build it on first use.
+ *
+ * @param   pUUID - 128-bit UUID.
+ *
+ * @return  Pointer to UUID record. NULL if out of memory.
+ */
+static const uint8 *gattBuildUUIDRec( const uint8 *pUUID )
+{
+  gattUUIDRec_t *pRec;
 
-      default:
-        break;
+  for ( pRec = gattUUIDRecList; pRec != NULL; pRec = pRec->pNext )
+  {
+    // The bases were checked already, so compare the alias first
+    if ( ( pRec->uuid[UUID_ALIAS_OFFSET] == pUUID[UUID_ALIAS_OFFSET] )     &&
+         ( pRec->uuid[UUID_ALIAS_OFFSET+1] == pUUID[UUID_ALIAS_OFFSET+1] ) &&
+         osal_memcmp( pRec->uuid, pUUID, ATT_UUID_SIZE ) )
+    {
+      return ( pRec->uuid );
     }
   }
-  else if ( len == ATT_UUID_SIZE )
+
+  pRec = (gattUUIDRec_t *)osal_mem_alloc( sizeof( gattUUIDRec_t ) );
+  if ( pRec == NULL )
   {
-    // 128-bit UUID
+    return ( NULL );
   }
 
-  return ( pRec );
+  VOID osal_memcpy( pRec->uuid, pUUID, ATT_UUID_SIZE );
+  pRec->pNext = gattUUIDRecList;
+  gattUUIDRecList = pRec;
+
+  return ( pRec->uuid );
+}
+
+/*********************************************************************
+ * @fn      gattIsBaseUUID
+ *
+ * @brief   Check whether a 128-bit UUID is built on a given base UUID,
+ *          i.e. matches the base everywhere except for the 16-bit alias.
+ *
+ * @param   pUUID - 128-bit UUID to check.
+ * @param   pBaseLo - base bytes before the alias (bytes 0 to 11).
+ * @param   pBaseHi - base bytes after the alias (bytes 14 and 15).
+ *
+ * @return  TRUE if the UUID is built on the base. FALSE, otherwise.
+ */
+static uint8 gattIsBaseUUID( const uint8 *pUUID, const uint8 *pBaseLo,
+                             const uint8 *pBaseHi )
+{
+  return ( osal_memcmp( pUUID, pBaseLo, UUID_ALIAS_OFFSET ) &&
+           osal_memcmp( &pUUID[UUID_ALIAS_OFFSET+2], pBaseHi,
+                        ATT_UUID_SIZE - UUID_ALIAS_OFFSET - 2 ) );
 }
 
 /****************************************************************************
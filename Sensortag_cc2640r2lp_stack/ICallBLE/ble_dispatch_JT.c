@@ -96,6 +96,10 @@
  * LOCAL FUNCTIONS
  */
 
+/* hal_flash_wrapper.c */
+extern void HalFlashWrite( uint32 addr, uint8 *buf, uint16 cnt );
+extern void HalFlashEraseSector( uint32 addr );
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -728,6 +732,11 @@ defined(CTRL_CONFIG) && (CTRL_CONFIG & (ADV_CONN_CFG | INIT_CFG))
 the revision needs to be read. this enable quick detection of bad alignement 
 in the table */
   (uint32)buildRevision,                                     // JT_INDEX[239]
+  /* Flash wrapper, for application flash areas (sensortag_recorder.c).
+   * Appended after buildRevision so that its index, which the application
+   * checks, does not move. */
+  (uint32)HalFlashWrite,                                     // JT_INDEX[240]
+  (uint32)HalFlashEraseSector,                               // JT_INDEX[241]
 };
 #endif /* STACK_LIBRARY */
 /*********************************************************************
@@ -97,10 +97,17 @@ typedef uint32_t (*directAPIFctPtr_t)(uint32_t param1, uint32_t param2,
 static uint32_t * icallLiteJT = NULL;
 #endif /* STACK_LIBRARY */
 
+// Command status of each proxy task, allocated on its first call and sent
+// again for every later one. Its inFlight flag is set while it is queued and
+// cleared by the callee once consumed; a callee that timed out leaves it set,
+// and a fresh status is sent instead so the message is never queued twice.
+static ICall_LiteCmdStatus *liteCmdStatus[OSAL_MAX_NUM_PROXY_TASKS] = { NULL };
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 static void sendLiteCmdStatus(uint8 taskId);
+static uint32_t icall_liteCall(icall_lite_id_t directAPI, uint32_t *param);
 
 /*********************************************************************
  * NETWORK LAYER CALLBACKS
@@ -117,7 +124,12 @@ static void sendLiteCmdStatus(uint8 taskId);
 /*********************************************************************
  * @fn      sendLiteCmdStatus
  *
- * @brief   Send command status message to the API callee.
+ * @brief   Send command status message to the API callee. The message
+ *          belongs to the callee's proxy task and is not freed by the
+ *          callee, so no heap is used past its first call. While it is
+ *          still queued, a fresh message is sent that the callee frees. A
+ *          message that could not be delivered has been freed by
+ *          osal_msg_send and is dropped from the cache.
  *
  * @param   taskId -task Id of the API callee.
  *
@@ -125,16 +137,81 @@ static void sendLiteCmdStatus(uint8 taskId);
  */
 static void sendLiteCmdStatus(uint8 taskId)
 {
-  ICall_LiteCmdStatus *pMsg =
-    (ICall_LiteCmdStatus *)osal_msg_allocate(sizeof(ICall_LiteCmdStatus));
+  uint8 proxyIdx = taskId & ~OSAL_PROXY_ID_FLAG;
+  ICall_LiteCmdStatus *pMsg;
+
+  if (proxyIdx >= OSAL_MAX_NUM_PROXY_TASKS)
+  {
+    HAL_ASSERT(HAL_ASSERT_CAUSE_INTERNAL_ERROR);
+    return;
+  }
 
-  if (pMsg)
+  pMsg = liteCmdStatus[proxyIdx];
+  if ((pMsg == NULL) || pMsg->inFlight)
   {
+    pMsg = (ICall_LiteCmdStatus *)osal_msg_allocate(sizeof(ICall_LiteCmdStatus));
+    if (pMsg == NULL)
+    {
+      // The callee would wait for the status until it times out
+      HAL_ASSERT(HAL_ASSERT_CAUSE_OUT_OF_MEMORY);
+      return;
+    }
+
     pMsg->cmdId = ICALL_LITE_DIRECT_API_DONE_CMD_ID;
-    osal_msg_send(taskId, (uint8 *)pMsg);
+    pMsg->inFlight = FALSE;
+
+    // Keep it unless the kept one is still queued: that one is reused once
+    // the callee has consumed it, and this one is freed by the callee.
+    if (liteCmdStatus[proxyIdx] == NULL)
+    {
+      liteCmdStatus[proxyIdx] = pMsg;
+    }
+  }
+
+  if (pMsg == liteCmdStatus[proxyIdx])
+  {
+    pMsg->inFlight = TRUE;
+  }
+
+  // osal_msg_send deallocates the message when it cannot be delivered. It
+  // must not be sent again then: allocate a new one on the next call.
+  if ((osal_msg_send(taskId, (uint8 *)pMsg) != SUCCESS) &&
+      (pMsg == liteCmdStatus[proxyIdx]))
+  {
+    liteCmdStatus[proxyIdx] = NULL;
   }
 }
 
+/*********************************************************************
+ * @fn      icall_liteCall
+ *
+ * @brief   Call a stack API.
+ *
+ * @param   directAPI - id of the stack API.
+ * @param   param - parameters of the call.
+ *
+ * @return  Value returned by the stack API.
+ */
+static uint32_t icall_liteCall(icall_lite_id_t directAPI, uint32_t *param)
+{
+#ifdef STACK_LIBRARY
+  return ((directAPIFctPtr_t)(directAPI))
+#else
+  return ((directAPIFctPtr_t)(icallLiteJT[directAPI]))
+#endif  /* STACK_LIBRARY */
+#if defined(ICALL_LITE_4_PARAMS)
+                                       (param[0], param[1], param[2], param[3]);
+#elif defined(ICALL_LITE_12_PARAMS)
+                                       (param[0], param[1], param[2], param[3],
+                                        param[4], param[5], param[6], param[7],
+                                        param[8], param[9], param[10],
+                                        param[11]);
+#else
+                                       (param[0], param[1], param[2], param[3],
+                                        param[4], param[5], param[6], param[7]);
+#endif
+}
+
 /*********************************************************************
  * @fn      icall_LiteTranslationInit
  *
@@ -160,7 +237,11 @@ void icall_liteTranslationInit(uint32_t *JT)
 /*********************************************************************
  * @fn      icall_liteTranslation
  *
- * @brief   Translate the icall direct API Message to a stack API call.
+ * @brief   Translate the icall direct API Message to a stack API call, or
+ *          to each call of a batch (ICALL_LITE_BATCH_ID). Asynchronous
+ *          calls (ICALL_LITE_ASYNC_ID) get no completion status; the
+ *          message itself goes back when the call failed or has a
+ *          callback.
  *
  * @param   pMsg - pointer to the received message.
  *
@@ -171,43 +252,51 @@ void icall_liteTranslation(icall_directAPIMsg_t *pMsg)
   osal_msg_hdr_t *hdr;
   uint8 taskId;  //msg_ptr->hciExtCmd.srctaskid;
 
-#ifdef STACK_LIBRARY
-  pMsg->pointerStack[0] = ((directAPIFctPtr_t)(pMsg->directAPI))
-#else
-  pMsg->pointerStack[0] = ((directAPIFctPtr_t)(icallLiteJT[pMsg->directAPI]))
-#endif  /* STACK_LIBRARY */
-#if defined(ICALL_LITE_4_PARAMS)
-                                                   (pMsg->pointerStack[0],
-                                                    pMsg->pointerStack[1],
-                                                    pMsg->pointerStack[2],
-                                                    pMsg->pointerStack[3]);
-#elif defined(ICALL_LITE_12_PARAMS)
-                                                   (pMsg->pointerStack[0],
-                                                    pMsg->pointerStack[1],
-                                                    pMsg->pointerStack[2],
-                                                    pMsg->pointerStack[3],
-                                                    pMsg->pointerStack[4],
-                                                    pMsg->pointerStack[5],
-                                                    pMsg->pointerStack[6],
-                                                    pMsg->pointerStack[7],
-                                                    pMsg->pointerStack[8],
-                                                    pMsg->pointerStack[9],
-                                                    pMsg->pointerStack[10],
-                                                    pMsg->pointerStack[11]);
-#else
-                                                   (pMsg->pointerStack[0],
-                                                    pMsg->pointerStack[1],
-                                                    pMsg->pointerStack[2],
-                                                    pMsg->pointerStack[3],
-                                                    pMsg->pointerStack[4],
-                                                    pMsg->pointerStack[5],
-                                                    pMsg->pointerStack[6],
-                                                    pMsg->pointerStack[7]);
-#endif
-
   hdr = (osal_msg_hdr_t *) pMsg - 1;
   taskId = osal_alien2proxy(hdr->srcentity);
 
+  if (pMsg->directAPI == ICALL_LITE_ASYNC_ID)
+  {
+    // Nobody waits for the call. The message is ours to free, unless the
+    // call failed or the caller has a callback, and it goes back.
+    icall_liteAsyncMsg_t *pAsync = (icall_liteAsyncMsg_t *)pMsg;
+
+    pAsync->call.param[0] = icall_liteCall(pAsync->call.directAPI,
+                                           (uint32_t *)pAsync->call.param);
+
+    if (((uint8)pAsync->call.param[0] == SUCCESS) && (pAsync->pfnCB == NULL))
+    {
+      osal_msg_deallocate((uint8 *)pAsync);
+    }
+    else
+    {
+      ((ICall_LiteCmdStatus *)pAsync)->cmdId = ICALL_LITE_DIRECT_API_ASYNC_CMD_ID;
+      osal_msg_send(taskId, (uint8 *)pAsync);
+    }
+
+    return;
+  }
+
+  if (pMsg->directAPI == ICALL_LITE_BATCH_ID)
+  {
+    // Run the whole batch before answering the callee once
+    icall_liteBatch_t *pBatch = (icall_liteBatch_t *)pMsg->pointerStack;
+    uint_least32_t i;
+
+    for (i = 0; i < pBatch->numCalls; i++)
+    {
+      icall_liteCall_t *pCall = &pBatch->pCalls[i];
+
+      pCall->param[0] = icall_liteCall(pCall->directAPI,
+                                       (uint32_t *)pCall->param);
+    }
+  }
+  else
+  {
+    pMsg->pointerStack[0] = icall_liteCall(pMsg->directAPI,
+                                           (uint32_t *)pMsg->pointerStack);
+  }
+
   // post Message confirming the end of the API call.
   sendLiteCmdStatus(taskId);
 }
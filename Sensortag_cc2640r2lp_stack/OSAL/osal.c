@@ -86,11 +86,6 @@
 /*********************************************************************
  * CONSTANTS
  */
-#ifdef USE_ICALL
-// A bit mask to use to indicate a proxy OSAL task ID.
-#define OSAL_PROXY_ID_FLAG       0x80
-#endif // USE_ICALL
-
 /*********************************************************************
  * TYPEDEFS
  */
@@ -127,11 +122,6 @@ osal_icallMsg_hook_t osal_icallMsg_hook = NULL;
 static uint8 activeTaskID = TASK_NO_TASK;
 
 #ifdef USE_ICALL
-// Maximum number of proxy tasks
-#ifndef OSAL_MAX_NUM_PROXY_TASKS
-#define OSAL_MAX_NUM_PROXY_TASKS 2
-#endif // OSAL_MAX_NUM_PROXY_TASKS
-
 // ICall entity ID value used to indicate invalid value
 #define OSAL_INVALID_DISPATCH_ID 0xffu
 
@@ -1734,10 +1724,15 @@ void osal_run_system( void )
     tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
     HAL_EXIT_CRITICAL_SECTION(intState);
   }
-#if defined( POWER_SAVING ) && !defined(USE_ICALL)
+#if ( defined( POWER_SAVING ) && !defined(USE_ICALL) ) || defined( OSAL_SNV_CACHE )
   else  // Complete pass through all task events with no activity?
   {
+#if defined( OSAL_SNV_CACHE )
+    VOID osal_snv_flush();  // Write the NV items cached while busy
+#endif
+#if defined( POWER_SAVING ) && !defined(USE_ICALL)
     osal_pwrmgr_powerconserve();  // Put the processor/system into sleep
+#endif
   }
 #endif
 
@@ -97,6 +97,16 @@ extern "C"
 /*** Interrupts ***/
 #define INTS_ALL    0xFF
 
+#ifdef USE_ICALL
+// A bit mask to use to indicate a proxy OSAL task ID.
+#define OSAL_PROXY_ID_FLAG       0x80
+
+// Maximum number of proxy tasks
+#ifndef OSAL_MAX_NUM_PROXY_TASKS
+#define OSAL_MAX_NUM_PROXY_TASKS 2
+#endif // OSAL_MAX_NUM_PROXY_TASKS
+#endif // USE_ICALL
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -150,6 +150,19 @@ extern uint8 osal_snv_ext_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf);
  */
 extern uint8 osal_snv_compact( uint8 threshold );
 
+#if defined(OSAL_SNV_CACHE)
+/*********************************************************************
+ * @fn      osal_snv_flush
+ *
+ * @brief   Write to NV all cached items not yet written.
+ *
+ * @param   none
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+extern uint8 osal_snv_flush( void );
+#endif // OSAL_SNV_CACHE
+
 /*********************************************************************
 *********************************************************************/
 
@@ -57,6 +57,9 @@
 #include "osal_snv.c"
 #elif OSAL_SNV == 1 // This is the 1 page SNV
 #include "osal_snv.h"
+#if defined(OSAL_SNV_CACHE)
+#include "osal.h"
+#endif // OSAL_SNV_CACHE
 #include "./../../../../services/src/nv/cc26xx/nvocop.c"
 
 #ifndef SYSTEM_ID
@@ -66,6 +69,205 @@
 // Convert a threshold percentage to bytes.
 #define THRESHOLD2BYTES(x) ((FLASH_PAGE_SIZE) - (((FLASH_PAGE_SIZE) * (x)) / 100))
 
+#if defined(OSAL_SNV_CACHE)
+// Number of NV items kept in RAM
+#ifndef OSAL_SNV_CACHE_ENTRIES
+#define OSAL_SNV_CACHE_ENTRIES 8
+#endif // OSAL_SNV_CACHE_ENTRIES
+
+// Largest NV item kept in RAM; larger ones are read and written directly
+#ifndef OSAL_SNV_CACHE_ITEM_LEN
+#define OSAL_SNV_CACHE_ITEM_LEN 32
+#endif // OSAL_SNV_CACHE_ITEM_LEN
+
+// RAM copy of an NV item
+typedef struct
+{
+  osalSnvId_t  id;
+  osalSnvLen_t len;                            // 0 if entry unused
+  uint8        dirty;                          // TRUE if not yet written to NV
+  uint8        whole;                          // TRUE if len is the NV item length
+  uint8        used;                           // Access tick, for eviction
+  uint8        data[OSAL_SNV_CACHE_ITEM_LEN];
+} osalSnvCacheEntry_t;
+
+static osalSnvCacheEntry_t osalSnvCache[OSAL_SNV_CACHE_ENTRIES];
+static uint8 osalSnvCacheTick = 0;
+#endif // OSAL_SNV_CACHE
+
+/*********************************************************************
+ * @fn      osal_snv_readItem
+ *
+ * @brief   Read data from NV, bypassing any cache.
+ *
+ * @param   id   - Valid NV item Id.
+ * @param   len  - Length of data to read.
+ * @param   *pBuf - Data is read into this buffer.
+ *
+ * @return  SUCCESS if successful.
+ *          Otherwise, NV_OPER_FAILED for failure.
+ */
+static uint8 osal_snv_readItem( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
+{
+  NVINTF_itemID_t nv_id;
+  
+  nv_id.itemID = id;
+  nv_id.subID = 0;
+  nv_id.systemID = SYSTEM_ID;
+  
+  return NVOCOP_readItem(nv_id, 0, len, pBuf);
+}
+
+/*********************************************************************
+ * @fn      osal_snv_writeItem
+ *
+ * @brief   Write a data item to NV, bypassing any cache.
+ *
+ * @param   id   - Valid NV item Id.
+ * @param   len  - Length of data to write.
+ * @param   *pBuf - Data to write.
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+static uint8 osal_snv_writeItem( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
+{
+  NVINTF_itemID_t nv_id;
+  
+  nv_id.itemID = id;
+  nv_id.subID = 0;
+  nv_id.systemID = SYSTEM_ID;
+
+  return NVOCOP_writeItem(nv_id, len, pBuf);
+}
+
+#if defined(OSAL_SNV_CACHE)
+/*********************************************************************
+ * @fn      osal_snv_cacheFind
+ *
+ * @brief   Find the RAM copy of an NV item.
+ *
+ * @param   id - Valid NV item Id.
+ *
+ * @return  pointer to the entry, NULL if the item is not cached.
+ */
+static osalSnvCacheEntry_t *osal_snv_cacheFind( osalSnvId_t id )
+{
+  uint8 i;
+
+  for ( i = 0; i < OSAL_SNV_CACHE_ENTRIES; i++ )
+  {
+    if ( osalSnvCache[i].len && ( osalSnvCache[i].id == id ) )
+    {
+      osalSnvCache[i].used = ++osalSnvCacheTick;
+
+      return &osalSnvCache[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      osal_snv_cacheFlushEntry
+ *
+ * @brief   Write a cached item to NV if it was not yet written.
+ *
+ * @param   pEntry - cache entry
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+static uint8 osal_snv_cacheFlushEntry( osalSnvCacheEntry_t *pEntry )
+{
+  if ( pEntry->dirty )
+  {
+    uint8 status = osal_snv_writeItem( pEntry->id, pEntry->len, pEntry->data );
+
+    if ( status != SUCCESS )
+    {
+      return status;
+    }
+
+    pEntry->dirty = FALSE;
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      osal_snv_cacheAdd
+ *
+ * @brief   Keep a copy of an NV item in RAM, reusing an unused entry or
+ *          else the least recently used one, which is written to NV
+ *          first if needed.
+ *
+ * @param   id   - Valid NV item Id.
+ * @param   len  - Length of data.
+ * @param   *pBuf - Data of the item.
+ *
+ * @return  pointer to the entry, NULL if none could be freed.
+ */
+static osalSnvCacheEntry_t *osal_snv_cacheAdd( osalSnvId_t id, osalSnvLen_t len,
+                                               void *pBuf )
+{
+  osalSnvCacheEntry_t *pEntry = &osalSnvCache[0];
+  uint8 i;
+
+  for ( i = 0; i < OSAL_SNV_CACHE_ENTRIES; i++ )
+  {
+    if ( osalSnvCache[i].len == 0 )
+    {
+      pEntry = &osalSnvCache[i];
+      break;
+    }
+
+    if ( (uint8)( osalSnvCacheTick - osalSnvCache[i].used ) >
+         (uint8)( osalSnvCacheTick - pEntry->used ) )
+    {
+      pEntry = &osalSnvCache[i];
+    }
+  }
+
+  if ( pEntry->len && ( osal_snv_cacheFlushEntry( pEntry ) != SUCCESS ) )
+  {
+    return NULL;
+  }
+
+  pEntry->id = id;
+  pEntry->len = len;
+  pEntry->dirty = FALSE;
+  pEntry->whole = FALSE;
+  pEntry->used = ++osalSnvCacheTick;
+  osal_memcpy( pEntry->data, pBuf, len );
+
+  return pEntry;
+}
+
+/*********************************************************************
+ * @fn      osal_snv_flush
+ *
+ * @brief   Write to NV all cached items not yet written.
+ *
+ * @param   none
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+uint8 osal_snv_flush( void )
+{
+  uint8 status = SUCCESS;
+  uint8 i;
+
+  for ( i = 0; i < OSAL_SNV_CACHE_ENTRIES; i++ )
+  {
+    if ( osalSnvCache[i].len && ( osal_snv_cacheFlushEntry( &osalSnvCache[i] ) != SUCCESS ) )
+    {
+      status = NV_OPER_FAILED;
+    }
+  }
+
+  return status;
+}
+#endif // OSAL_SNV_CACHE
+
 /*********************************************************************
  * @fn      osal_snv_init
  *
@@ -94,13 +296,40 @@ uint8 osal_snv_init( void )
  */
 uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
 {
-  NVINTF_itemID_t nv_id;
-  
-  nv_id.itemID = id;
-  nv_id.subID = 0;
-  nv_id.systemID = SYSTEM_ID;
-  
-  return NVOCOP_readItem(nv_id, 0, len, pBuf);
+#if defined(OSAL_SNV_CACHE)
+  osalSnvCacheEntry_t *pEntry = osal_snv_cacheFind( id );
+  uint8 status;
+
+  if ( pEntry )
+  {
+    if ( len <= pEntry->len )
+    {
+      osal_memcpy( pBuf, pEntry->data, len );
+
+      return SUCCESS;
+    }
+
+    // Longer than cached; NV must be up to date before reading it
+    status = osal_snv_cacheFlushEntry( pEntry );
+    if ( status != SUCCESS )
+    {
+      return status;
+    }
+
+    pEntry->len = 0;
+  }
+
+  status = osal_snv_readItem( id, len, pBuf );
+
+  if ( ( status == SUCCESS ) && ( len <= OSAL_SNV_CACHE_ITEM_LEN ) )
+  {
+    VOID osal_snv_cacheAdd( id, len, pBuf );
+  }
+
+  return status;
+#else // !OSAL_SNV_CACHE
+  return osal_snv_readItem( id, len, pBuf );
+#endif // OSAL_SNV_CACHE
 }
 
 /*********************************************************************
@@ -116,14 +345,46 @@ uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
  */
 uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
 {
-  NVINTF_itemID_t nv_id;
-  
-  nv_id.itemID = id;
-  nv_id.subID = 0;
-  nv_id.systemID = SYSTEM_ID;
+#if defined(OSAL_SNV_CACHE)
+  osalSnvCacheEntry_t *pEntry = osal_snv_cacheFind( id );
+
+  if ( len <= OSAL_SNV_CACHE_ITEM_LEN )
+  {
+    if ( pEntry )
+    {
+      // Nothing to write if the contents did not change. A read may have
+      // cached only the start of the item, which a write would truncate.
+      if ( pEntry->whole && ( len == pEntry->len ) &&
+           osal_memcmp( pEntry->data, pBuf, len ) )
+      {
+        return SUCCESS;
+      }
 
+      pEntry->len = len;
+      osal_memcpy( pEntry->data, pBuf, len );
+    }
+    else
+    {
+      pEntry = osal_snv_cacheAdd( id, len, pBuf );
+    }
 
-  return NVOCOP_writeItem(nv_id, len, pBuf);
+    // Written to NV when idle, on eviction, flush or compaction
+    if ( pEntry )
+    {
+      pEntry->dirty = TRUE;
+      pEntry->whole = TRUE;
+
+      return SUCCESS;
+    }
+  }
+  else if ( pEntry )
+  {
+    // Replaced by a larger item, so the cached one need not be written
+    pEntry->len = 0;
+  }
+#endif // OSAL_SNV_CACHE
+
+  return osal_snv_writeItem( id, len, pBuf );
 }
 
 /*********************************************************************
@@ -139,6 +400,11 @@ uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf)
  */
 uint8 osal_snv_compact( uint8 threshold )
 {
+#if defined(OSAL_SNV_CACHE)
+  // Compact with all items up to date
+  VOID osal_snv_flush();
+#endif // OSAL_SNV_CACHE
+
   // convert percentage to approximate byte threshold.
   if (threshold <= 100)
   {
@@ -92,6 +92,8 @@
 #define GAP_BOND_SAVE_REC_EVT                           0x0002 // Save bond record in NV
 #define GAP_BOND_SAVE_RCA_EVT                           0x0004 // Save reconnection address in NV
 #define GAP_BOND_POP_PAIR_QUEUE_EVT                     0x0008 // Begin pairing with the next queued device
+#define GAP_BOND_FLUSH_CC_EVT                           0x0010 // Save modified char configs in NV
+#define GAP_BOND_SAVE_LRU_EVT                           0x0020 // Save LRU bond list in NV
 
 
 // Once NV usage reaches this percentage threshold, NV compaction gets triggered.
@@ -107,6 +109,47 @@
 // should be 3 total octets: 2 octets for attribute handle and 1 octet for value
 #define CENT_ADDR_RES_RSP_LEN                           3
 
+// Number of connected bonds whose characteristic configuration is kept in RAM
+#ifndef GAP_BOND_CHAR_CFG_SHADOWS
+#define GAP_BOND_CHAR_CFG_SHADOWS                       1
+#endif // GAP_BOND_CHAR_CFG_SHADOWS
+
+// Time without characteristic configuration change before it is saved in NV (ms)
+#ifndef GAP_BOND_CHAR_CFG_FLUSH_DELAY
+#define GAP_BOND_CHAR_CFG_FLUSH_DELAY                   2000
+#endif // GAP_BOND_CHAR_CFG_FLUSH_DELAY
+
+// Number of LRU bond list changes kept in RAM before the list is saved in NV
+#ifndef GAP_BOND_LRU_SAVE_UPDATES
+#define GAP_BOND_LRU_SAVE_UPDATES                       4
+#endif // GAP_BOND_LRU_SAVE_UPDATES
+
+// Time without LRU bond list change before it is saved in NV (ms)
+#ifndef GAP_BOND_LRU_SAVE_DELAY
+#define GAP_BOND_LRU_SAVE_DELAY                         10000
+#endif // GAP_BOND_LRU_SAVE_DELAY
+
+// Number of slots in each bond address hash index (power of 2 above GAP_BONDINGS_MAX)
+#ifndef GAP_BOND_HASH_SIZE
+#if GAP_BONDINGS_MAX < 8
+#define GAP_BOND_HASH_SIZE                              16
+#elif GAP_BONDINGS_MAX < 16
+#define GAP_BOND_HASH_SIZE                              32
+#elif GAP_BONDINGS_MAX < 32
+#define GAP_BOND_HASH_SIZE                              64
+#else
+#define GAP_BOND_HASH_SIZE                              128
+#endif
+#endif // GAP_BOND_HASH_SIZE
+
+// Unused bond address hash index slot
+#define GAP_BOND_HASH_EMPTY                             0xFF
+
+// Number of recently resolved private addresses remembered
+#ifndef GAP_BOND_RPA_CACHE_SIZE
+#define GAP_BOND_RPA_CACHE_SIZE                         4
+#endif // GAP_BOND_RPA_CACHE_SIZE
+
 /**
  * GAP Bond Manager NV layout
  *
@@ -199,6 +242,31 @@ typedef struct
   uint8  value;       // attribute value for this device
 } gapBondCharCfg_t;
 
+#if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
+// Structure of a RAM copy of a bonded device's IRK
+typedef struct
+{
+  uint8   bondIdx;                    // Bond record index
+  uint8   IRK[KEYLEN];                // Device IRK
+} gapBondIrk_t;
+
+// Structure of a recently resolved private address
+typedef struct
+{
+  uint8   addr[B_ADDR_LEN];           // Resolvable private address
+  uint8   bondIdx;                    // Bond record index, GAP_BONDINGS_MAX if unused
+} gapBondRpa_t;
+#endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
+
+// Structure of a RAM copy of a connected bond's characteristic configuration
+typedef struct
+{
+  uint16           connHandle;                 // Connection handle
+  uint8            bondIdx;                    // Bond record index, GAP_BONDINGS_MAX if unused
+  uint8            dirty;                      // TRUE if charCfg differs from NV
+  gapBondCharCfg_t charCfg[GAP_CHAR_CFG_MAX];  // Not inverted
+} gapBondCharCfgShadow_t;
+
 typedef struct pairQueue
 {
   uint16           connHandle;
@@ -305,6 +373,12 @@ static const gapBondCBs_t *pGapBondCB = NULL;
 // Local RAM shadowed bond records
 static gapBondRec_t bonds[GAP_BONDINGS_MAX] = {0};
 
+// Open addressing indexes of bonds[] by public and reconnection address,
+// and bitmap of empty bond records. Rebuilt whenever bonds[] changes.
+static uint8 gapBond_addrHash[GAP_BOND_HASH_SIZE];
+static uint8 gapBond_reconnectHash[GAP_BOND_HASH_SIZE];
+static uint8 gapBond_emptyBonds[(GAP_BONDINGS_MAX + 7) / 8];
+
 static uint8 autoSyncWhiteList = FALSE;
 
 static uint8 eraseAllBonds = FALSE;
@@ -331,6 +405,23 @@ gapBondPairQueueNode_t *pPairingQ = NULL;
 uint8 gapBond_removeLRUBond = FALSE;
 uint8 gapBond_lruBondList[GAP_BONDINGS_MAX] = {0};
 
+// Generation of the LRU bond list in RAM, and of the one last saved in NV
+static uint8 gapBond_lruGen = 0;
+static uint8 gapBond_lruSavedGen = 0;
+
+// Characteristic configuration of connected bonds, saved in NV after a
+// while without change, at disconnection or once bonding completes.
+static gapBondCharCfgShadow_t gapBond_charCfgShadows[GAP_BOND_CHAR_CFG_SHADOWS];
+
+#if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
+// RAM copy of the valid device IRKs, so that resolving an address does not
+// read NV, and the private addresses they most recently resolved.
+static gapBondIrk_t gapBond_irkTbl[GAP_BONDINGS_MAX];
+static uint8 gapBond_numIrks = 0;
+static gapBondRpa_t gapBond_rpaCache[GAP_BOND_RPA_CACHE_SIZE];
+static uint8 gapBond_rpaCacheNext = 0;
+#endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
+
 #if defined (BLE_V42_FEATURES) && (BLE_V42_FEATURES & PRIVACY_1_2_CFG)
 // Global used to indicate whether Resolving List must be resynched with
 // bond records once controller is no longer adv/init/scanning
@@ -344,6 +435,12 @@ static uint8 gapBondMgrUpdateCharCfg( uint8 idx, uint16 attrHandle, uint16 value
 static gapBondCharCfg_t *gapBondMgrFindCharCfgItem( uint16 attrHandle,
                                                     gapBondCharCfg_t *charCfgTbl );
 static void gapBondMgrInvertCharCfgItem( gapBondCharCfg_t *charCfgTbl );
+static uint8 gapBondMgrSetCharCfgItem( gapBondCharCfg_t *charCfgTbl, uint16 attrHandle,
+                                       uint16 value, uint8 *pUpdate );
+static gapBondCharCfgShadow_t *gapBondMgrFindCharCfgShadow( uint8 idx );
+static void gapBondMgrOpenCharCfgShadow( uint8 idx, uint16 connHandle,
+                                         gapBondCharCfg_t *charCfgTbl );
+static void gapBondMgrFlushCharCfgShadows( uint16 connHandle, uint8 release );
 static uint8 gapBondMgrAddBond( gapBondRec_t *pBondRec, gapAuthCompleteEvent_t *pPkt );
 static uint8 gapBondMgrGetStateFlags( uint8 idx );
 static bStatus_t gapBondMgrGetPublicAddr( uint8 idx, uint8 *pAddr );
@@ -351,6 +448,10 @@ static uint8 gapBondMgrFindReconnectAddr( uint8 *pReconnectAddr );
 static uint8 gapBondMgrFindAddr( uint8 *pDevAddr );
 static void gapBondMgrReadBonds( void );
 static uint8 gapBondMgrFindEmpty( void );
+static uint8 gapBondMgrHashAddr( uint8 *pAddr );
+static uint8 gapBondMgrFindHashedAddr( uint8 *pHash, uint8 *pAddr, uint8 reconnect );
+static void gapBondMgrHashInsert( uint8 *pHash, uint8 *pAddr, uint8 idx );
+static void gapBondMgrIndexBonds( void );
 static uint8 gapBondMgrBondTotal( void );
 static bStatus_t gapBondMgrEraseAllBondings( void );
 static bStatus_t gapBondMgrEraseBonding( uint8 idx );
@@ -370,6 +471,7 @@ static uint8 gapBondGetRandomAddrSubType( uint8 *pAddr );
 static void gapBondMgrReadLruBondList(void);
 static uint8 gapBondMgrGetLruBondIndex(void);
 static void gapBondMgrUpdateLruBondList(uint8 bondIndex);
+static void gapBondMgrSaveLruBondList(void);
 
 #ifndef GBM_GATT_NO_CLIENT
 #if !defined (GATT_NO_SERVICE_CHANGED) || \
@@ -395,6 +497,8 @@ static void gapBondMgrSendServiceChange( linkDBItem_t *pLinkItem );
 
 #if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
 static uint8 gapBondMgrResolvePrivateAddr( uint8 *pAddr );
+static void gapBondMgrReadIrks( void );
+static void gapBondMgrSetIrk( uint8 idx, uint8 *pIRK );
 #endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
 
 #if defined (BLE_V42_FEATURES) && (BLE_V42_FEATURES & PRIVACY_1_2_CFG)
@@ -968,6 +1072,12 @@ bStatus_t GAPBondMgr_LinkEst( uint8 addrType, uint8 *pDevAddr, uint16 connHandle
     }
 #endif //SNP_SECURITY
 
+    // Save any RAM copy left from an earlier link before reloading from NV
+    if ( gapBondMgrFindCharCfgShadow( idx ) != NULL )
+    {
+      gapBondMgrFlushCharCfgShadows( gapBondMgrFindCharCfgShadow( idx )->connHandle, FALSE );
+    }
+
     // Load the characteristic configuration
     if ( osal_snv_read( gattCfgNvID(idx), sizeof ( charCfg ), charCfg ) == SUCCESS )
     {
@@ -975,6 +1085,9 @@ bStatus_t GAPBondMgr_LinkEst( uint8 addrType, uint8 *pDevAddr, uint16 connHandle
 
       gapBondMgrInvertCharCfgItem( charCfg );
 
+      // Keep a RAM copy for the CCC writes of this connection
+      gapBondMgrOpenCharCfgShadow( idx, connHandle, charCfg );
+
       for ( i = 0; i < GAP_CHAR_CFG_MAX; i++ )
       {
         gapBondCharCfg_t *pItem = &(charCfg[i]);
@@ -1035,7 +1148,11 @@ bStatus_t GAPBondMgr_LinkEst( uint8 addrType, uint8 *pDevAddr, uint16 connHandle
  */
 void GAPBondMgr_LinkTerm(uint16 connHandle)
 {
-  (void)connHandle;
+  // Save the characteristic configuration of this connection
+  gapBondMgrFlushCharCfgShadows( connHandle, TRUE );
+
+  // Save the LRU bond list changed since the last save
+  gapBondMgrSaveLruBondList();
 
   if ( GAP_NumActiveConnections() == 0 )
   {
@@ -1741,6 +1858,27 @@ static uint8 gapBondMgrChangeState( uint8 idx, uint16 state, uint8 set )
 static uint8 gapBondMgrUpdateCharCfg( uint8 idx, uint16 attrHandle, uint16 value )
 {
   gapBondRec_t bondRec;   // Space to read a Bond record from NV
+  gapBondCharCfgShadow_t *pShadow = gapBondMgrFindCharCfgShadow( idx );
+
+  // A connected bond is updated in RAM, and saved in NV later
+  if ( pShadow != NULL )
+  {
+    uint8 update = FALSE;
+
+    if ( gapBondMgrSetCharCfgItem( pShadow->charCfg, attrHandle, value, &update ) == FALSE )
+    {
+      return ( FALSE ); // No empty entry found
+    }
+
+    if ( update )
+    {
+      pShadow->dirty = TRUE;
+      VOID osal_start_timerEx( gapBondMgr_TaskID, GAP_BOND_FLUSH_CC_EVT,
+                               GAP_BOND_CHAR_CFG_FLUSH_DELAY );
+    }
+
+    return ( TRUE );
+  }
 
   // Look for public address that is used (not all 0xFF's)
   if ( ( osal_snv_read( mainRecordNvID(idx), sizeof ( gapBondRec_t ), &bondRec ) == SUCCESS )
@@ -1754,42 +1892,9 @@ static uint8 gapBondMgrUpdateCharCfg( uint8 idx, uint16 attrHandle, uint16 value
 
       gapBondMgrInvertCharCfgItem( charCfg );
 
-      if ( attrHandle == GATT_INVALID_HANDLE )
+      if ( gapBondMgrSetCharCfgItem( charCfg, attrHandle, value, &update ) == FALSE )
       {
-        if ( osal_isbufset( (uint8 *)charCfg, 0x00, sizeof ( charCfg ) ) == FALSE )
-        {
-          // Clear all characteristic configuration for this device
-          VOID osal_memset( (void *)charCfg, 0x00, sizeof ( charCfg ) );
-          update = TRUE;
-        }
-      }
-      else
-      {
-        gapBondCharCfg_t *pItem = gapBondMgrFindCharCfgItem( attrHandle, charCfg );
-        if ( pItem == NULL )
-        {
-          // Must be a new item; ignore if the value is no operation (default)
-          if ( ( value == GATT_CFG_NO_OPERATION ) ||
-               ( ( pItem = gapBondMgrFindCharCfgItem( GATT_INVALID_HANDLE, charCfg ) ) == NULL ) )
-          {
-            return ( FALSE ); // No empty entry found
-          }
-
-          pItem->attrHandle = attrHandle;
-        }
-
-        if ( pItem->value != value )
-        {
-          // Update characteristic configuration
-          pItem->value = (uint8)value;
-          if ( value == GATT_CFG_NO_OPERATION )
-          {
-            // Erase the item
-            pItem->attrHandle = GATT_INVALID_HANDLE;
-          }
-
-          update = TRUE;
-        }
+        return ( FALSE ); // No empty entry found
       }
 
       // Update the characteristic configuration of the bonded device.
@@ -1806,6 +1911,161 @@ static uint8 gapBondMgrUpdateCharCfg( uint8 idx, uint16 attrHandle, uint16 value
   return ( FALSE );
 }
 
+/*********************************************************************
+ * @fn      gapBondMgrSetCharCfgItem
+ *
+ * @brief   Set the Characteristic Configuration for a given attribute
+ *          in a characteristic configuration table that is not inverted.
+ *
+ * @param   charCfgTbl - characteristic configuration table.
+ * @param   attrHandle - attribute handle (0 means all handles)
+ * @param   value - characteristic configuration value
+ * @param   pUpdate - set to TRUE if the table was changed
+ *
+ * @return  FALSE if no empty entry was found for a new item, TRUE otherwise.
+ */
+static uint8 gapBondMgrSetCharCfgItem( gapBondCharCfg_t *charCfgTbl, uint16 attrHandle,
+                                       uint16 value, uint8 *pUpdate )
+{
+  if ( attrHandle == GATT_INVALID_HANDLE )
+  {
+    if ( osal_isbufset( (uint8 *)charCfgTbl, 0x00,
+                        sizeof ( gapBondCharCfg_t ) * GAP_CHAR_CFG_MAX ) == FALSE )
+    {
+      // Clear all characteristic configuration for this device
+      VOID osal_memset( (void *)charCfgTbl, 0x00,
+                        sizeof ( gapBondCharCfg_t ) * GAP_CHAR_CFG_MAX );
+      *pUpdate = TRUE;
+    }
+  }
+  else
+  {
+    gapBondCharCfg_t *pItem = gapBondMgrFindCharCfgItem( attrHandle, charCfgTbl );
+    if ( pItem == NULL )
+    {
+      // Must be a new item; ignore if the value is no operation (default)
+      if ( ( value == GATT_CFG_NO_OPERATION ) ||
+           ( ( pItem = gapBondMgrFindCharCfgItem( GATT_INVALID_HANDLE, charCfgTbl ) ) == NULL ) )
+      {
+        return ( FALSE ); // No empty entry found
+      }
+
+      pItem->attrHandle = attrHandle;
+    }
+
+    if ( pItem->value != value )
+    {
+      // Update characteristic configuration
+      pItem->value = (uint8)value;
+      if ( value == GATT_CFG_NO_OPERATION )
+      {
+        // Erase the item
+        pItem->attrHandle = GATT_INVALID_HANDLE;
+      }
+
+      *pUpdate = TRUE;
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrFindCharCfgShadow
+ *
+ * @brief   Find the RAM copy of a bond's Characteristic Configuration.
+ *
+ * @param   idx - Bond NV index
+ *
+ * @return  pointer to the found copy. NULL, otherwise.
+ */
+static gapBondCharCfgShadow_t *gapBondMgrFindCharCfgShadow( uint8 idx )
+{
+  uint8 i;
+  for ( i = 0; i < GAP_BOND_CHAR_CFG_SHADOWS; i++ )
+  {
+    if ( gapBond_charCfgShadows[i].bondIdx == idx )
+    {
+      return ( &(gapBond_charCfgShadows[i]) );
+    }
+  }
+
+  return ( (gapBondCharCfgShadow_t *)NULL );
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrOpenCharCfgShadow
+ *
+ * @brief   Keep a RAM copy of a connected bond's Characteristic
+ *          Configuration, if one is free. Otherwise, its updates are
+ *          written to NV right away.
+ *
+ * @param   idx - Bond NV index
+ * @param   connHandle - connection handle
+ * @param   charCfgTbl - characteristic configuration table as in NV,
+ *                       but not inverted.
+ *
+ * @return  none.
+ */
+static void gapBondMgrOpenCharCfgShadow( uint8 idx, uint16 connHandle,
+                                         gapBondCharCfg_t *charCfgTbl )
+{
+  gapBondCharCfgShadow_t *pShadow = gapBondMgrFindCharCfgShadow( idx );
+
+  if ( pShadow == NULL )
+  {
+    pShadow = gapBondMgrFindCharCfgShadow( GAP_BONDINGS_MAX );
+  }
+
+  if ( pShadow != NULL )
+  {
+    pShadow->connHandle = connHandle;
+    pShadow->bondIdx = idx;
+    pShadow->dirty = FALSE;
+    VOID osal_memcpy( pShadow->charCfg, charCfgTbl, sizeof ( pShadow->charCfg ) );
+  }
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrFlushCharCfgShadows
+ *
+ * @brief   Save the modified RAM copies of Characteristic Configuration
+ *          in NV.
+ *
+ * @param   connHandle - connection handle, or INVALID_CONNHANDLE for all
+ * @param   release - TRUE to stop keeping the copies in RAM
+ *
+ * @return  none.
+ */
+static void gapBondMgrFlushCharCfgShadows( uint16 connHandle, uint8 release )
+{
+  uint8 i;
+  for ( i = 0; i < GAP_BOND_CHAR_CFG_SHADOWS; i++ )
+  {
+    gapBondCharCfgShadow_t *pShadow = &(gapBond_charCfgShadows[i]);
+
+    if ( ( pShadow->bondIdx < GAP_BONDINGS_MAX ) &&
+         ( ( connHandle == INVALID_CONNHANDLE ) || ( pShadow->connHandle == connHandle ) ) )
+    {
+      if ( pShadow->dirty )
+      {
+        gapBondCharCfg_t charCfg[GAP_CHAR_CFG_MAX];
+
+        VOID osal_memcpy( charCfg, pShadow->charCfg, sizeof ( charCfg ) );
+        gapBondMgrInvertCharCfgItem( charCfg );
+        VOID osal_snv_write( gattCfgNvID(pShadow->bondIdx), sizeof ( charCfg ), charCfg );
+
+        pShadow->dirty = FALSE;
+      }
+
+      if ( release )
+      {
+        pShadow->bondIdx = GAP_BONDINGS_MAX;
+      }
+    }
+  }
+}
+
 /*********************************************************************
  * @fn      gapBondMgrFindCharCfgItem
  *
@@ -1932,8 +2192,14 @@ static uint8 gapBondMgrAddBond( gapBondRec_t *pBondRec, gapAuthCompleteEvent_t *
 
       VOID osal_snv_write( gattCfgNvID(bondIdx), sizeof ( charCfg ), charCfg );
 
+      // The CCC values about to be synced from the GATT database are kept
+      // in RAM until bonding completes
+      gapBondMgrInvertCharCfgItem( charCfg );
+      gapBondMgrOpenCharCfgShadow( bondIdx, pPkt->connectionHandle, charCfg );
+
       // Update Bond RAM Shadow just with the newly added bond entry
       VOID osal_memcpy( &(bonds[bondIdx]), pBondRec, sizeof ( gapBondRec_t ) );
+      gapBondMgrIndexBonds();
 
 #if defined (BLE_V42_FEATURES) && (BLE_V42_FEATURES & PRIVACY_1_2_CFG)
       if ( pPkt->pIdentityInfo )
@@ -1979,6 +2245,9 @@ static uint8 gapBondMgrAddBond( gapBondRec_t *pBondRec, gapAuthCompleteEvent_t *
       else if ( pAuthEvt->pIdentityInfo )
       {
         VOID osal_snv_write( devIRKNvID(bondIdx), KEYLEN, pAuthEvt->pIdentityInfo->irk );
+#if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
+        gapBondMgrSetIrk( bondIdx, pAuthEvt->pIdentityInfo->irk );
+#endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
         pAuthEvt->pIdentityInfo = NULL;
       }
       // If available, save the connected device's Signature information
@@ -2077,18 +2346,7 @@ static bStatus_t gapBondMgrGetPublicAddr( uint8 idx, uint8 *pAddr )
  */
 static uint8 gapBondMgrFindReconnectAddr( uint8 *pReconnectAddr )
 {
-  // Item doesn't exist, so create all the items
-  uint8 idx;
-  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
-  {
-    // compare reconnection address
-    if ( osal_memcmp( bonds[idx].reconnectAddr, pReconnectAddr, B_ADDR_LEN ) )
-    {
-      return ( idx ); // Found it
-    }
-  }
-
-  return ( GAP_BONDINGS_MAX );
+  return ( gapBondMgrFindHashedAddr( gapBond_reconnectHash, pReconnectAddr, TRUE ) );
 }
 
 /*********************************************************************
@@ -2103,20 +2361,138 @@ static uint8 gapBondMgrFindReconnectAddr( uint8 *pReconnectAddr )
  */
 static uint8 gapBondMgrFindAddr( uint8 *pDevAddr )
 {
-  // Item doesn't exist, so create all the items
-  uint8 idx;
-  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  return ( gapBondMgrFindHashedAddr( gapBond_addrHash, pDevAddr, FALSE ) );
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrHashAddr
+ *
+ * @brief   Hash a device address into a bond address index slot.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  slot (0 - (GAP_BOND_HASH_SIZE-1))
+ */
+static uint8 gapBondMgrHashAddr( uint8 *pAddr )
+{
+  uint16 hash = 0;
+  uint8 i;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    hash = ( hash * 31 ) + pAddr[i];
+  }
+
+  return ( (uint8)( ( hash ^ ( hash >> 8 ) ) & ( GAP_BOND_HASH_SIZE - 1 ) ) );
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrFindHashedAddr
+ *
+ * @brief   Look up an address in a bond address index. Records sharing
+ *          an address are probed in index order, so the lowest one is
+ *          found first, as a scan of bonds[] would.
+ *
+ * @param   pHash - gapBond_addrHash or gapBond_reconnectHash
+ * @param   pAddr - device address to look for
+ * @param   reconnect - TRUE to compare reconnection addresses
+ *
+ * @return  index to found bonding (0 - (GAP_BONDINGS_MAX-1),
+ *          GAP_BONDINGS_MAX if not found
+ */
+static uint8 gapBondMgrFindHashedAddr( uint8 *pHash, uint8 *pAddr, uint8 reconnect )
+{
+  uint8 slot;
+
+  // Unused addresses are never indexed
+  if ( osal_isbufset( pAddr, 0xFF, B_ADDR_LEN ) )
   {
-    // Read in NV Main Bond Record and compare public address
-    if ( osal_memcmp( bonds[idx].publicAddr, pDevAddr, B_ADDR_LEN ) )
+    return ( GAP_BONDINGS_MAX );
+  }
+
+  slot = gapBondMgrHashAddr( pAddr );
+
+  // Never more than GAP_BONDINGS_MAX slots used, so an empty one ends the probe
+  while ( pHash[slot] != GAP_BOND_HASH_EMPTY )
+  {
+    uint8 idx = pHash[slot];
+    uint8 *pBondAddr = reconnect ? bonds[idx].reconnectAddr : bonds[idx].publicAddr;
+
+    if ( osal_memcmp( pBondAddr, pAddr, B_ADDR_LEN ) )
     {
       return ( idx ); // Found it
     }
+
+    slot = ( slot + 1 ) & ( GAP_BOND_HASH_SIZE - 1 );
   }
 
   return ( GAP_BONDINGS_MAX );
 }
 
+/*********************************************************************
+ * @fn      gapBondMgrHashInsert
+ *
+ * @brief   Add a bond record to a bond address index. Unused (all 0xFF)
+ *          addresses are left out so empty records do not form one long
+ *          probe run; empty records are tracked in gapBond_emptyBonds.
+ *
+ * @param   pHash - gapBond_addrHash or gapBond_reconnectHash
+ * @param   pAddr - device address of the bond record
+ * @param   idx - bond record index
+ *
+ * @return  none
+ */
+static void gapBondMgrHashInsert( uint8 *pHash, uint8 *pAddr, uint8 idx )
+{
+  uint8 slot;
+
+  if ( osal_isbufset( pAddr, 0xFF, B_ADDR_LEN ) )
+  {
+    return;
+  }
+
+  slot = gapBondMgrHashAddr( pAddr );
+  while ( pHash[slot] != GAP_BOND_HASH_EMPTY )
+  {
+    slot = ( slot + 1 ) & ( GAP_BOND_HASH_SIZE - 1 );
+  }
+  pHash[slot] = idx;
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrIndexBonds
+ *
+ * @brief   Rebuild the bond address indexes and the empty bond bitmap
+ *          from the Bond RAM Shadow.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapBondMgrIndexBonds( void )
+{
+  uint8 idx;
+
+  VOID osal_memset( gapBond_addrHash, GAP_BOND_HASH_EMPTY, sizeof ( gapBond_addrHash ) );
+  VOID osal_memset( gapBond_reconnectHash, GAP_BOND_HASH_EMPTY, sizeof ( gapBond_reconnectHash ) );
+  VOID osal_memset( gapBond_emptyBonds, 0, sizeof ( gapBond_emptyBonds ) );
+
+  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  {
+    // Look for public address of all 0xFF's
+    if ( osal_isbufset( bonds[idx].publicAddr, 0xFF, B_ADDR_LEN ) )
+    {
+      gapBond_emptyBonds[idx >> 3] |= ( 1 << ( idx & 0x07 ) );
+    }
+    else
+    {
+      gapBondMgrHashInsert( gapBond_addrHash, bonds[idx].publicAddr, idx );
+    }
+
+    gapBondMgrHashInsert( gapBond_reconnectHash, bonds[idx].reconnectAddr, idx );
+  }
+}
+
 #if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
 /*********************************************************************
  * @fn      gapBondMgrResolvePrivateAddr
@@ -2131,24 +2507,124 @@ static uint8 gapBondMgrFindAddr( uint8 *pDevAddr )
  */
 static uint8 gapBondMgrResolvePrivateAddr( uint8 *pDevAddr )
 {
-  uint8 idx;
-  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  gapBondRpa_t *pRpa;
+  uint8 i;
+
+  // An address resolved recently needs no AES
+  for ( i = 0; i < GAP_BOND_RPA_CACHE_SIZE; i++ )
   {
-    uint8 IRK[KEYLEN];
+    if ( ( gapBond_rpaCache[i].bondIdx < GAP_BONDINGS_MAX ) &&
+         osal_memcmp( gapBond_rpaCache[i].addr, pDevAddr, B_ADDR_LEN ) )
+    {
+      return ( gapBond_rpaCache[i].bondIdx ); // Found it
+    }
+  }
 
-    // Read in NV IRK Record and compare resolvable address
-    if ( osal_snv_read( devIRKNvID(idx), KEYLEN, IRK ) == SUCCESS )
+  // Compare resolvable address against the RAM copy of the IRKs
+  for ( i = 0; i < gapBond_numIrks; i++ )
+  {
+    if ( GAP_ResolvePrivateAddr( gapBond_irkTbl[i].IRK, pDevAddr ) == SUCCESS )
     {
-      if ( ( osal_isbufset( IRK, 0xFF, KEYLEN ) == FALSE ) &&
-           ( GAP_ResolvePrivateAddr( IRK, pDevAddr ) == SUCCESS ) )
+      // Remember it, replacing the oldest entry
+      pRpa = &gapBond_rpaCache[gapBond_rpaCacheNext];
+      VOID osal_memcpy( pRpa->addr, pDevAddr, B_ADDR_LEN );
+      pRpa->bondIdx = gapBond_irkTbl[i].bondIdx;
+
+      if ( ++gapBond_rpaCacheNext == GAP_BOND_RPA_CACHE_SIZE )
       {
-        return ( idx ); // Found it
+        gapBond_rpaCacheNext = 0;
       }
+
+      return ( pRpa->bondIdx ); // Found it
     }
   }
 
   return ( GAP_BONDINGS_MAX );
 }
+
+/*********************************************************************
+ * @fn      gapBondMgrReadIrks
+ *
+ * @brief   Read the valid device IRKs from NV into RAM and forget the
+ *          recently resolved addresses.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapBondMgrReadIrks( void )
+{
+  uint8 idx;
+
+  gapBond_numIrks = 0;
+  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  {
+    gapBondIrk_t *pIrk = &gapBond_irkTbl[gapBond_numIrks];
+
+    if ( ( osal_snv_read( devIRKNvID(idx), KEYLEN, pIrk->IRK ) == SUCCESS ) &&
+         ( osal_isbufset( pIrk->IRK, 0xFF, KEYLEN ) == FALSE ) )
+    {
+      pIrk->bondIdx = idx;
+      gapBond_numIrks++;
+    }
+  }
+
+  for ( idx = 0; idx < GAP_BOND_RPA_CACHE_SIZE; idx++ )
+  {
+    gapBond_rpaCache[idx].bondIdx = GAP_BONDINGS_MAX;
+  }
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrSetIrk
+ *
+ * @brief   Update the RAM copy of a device IRK after it was written to NV,
+ *          and forget the addresses it resolved.
+ *
+ * @param   idx - bond record index
+ * @param   pIRK - new IRK, all 0xFF's or NULL if removed
+ *
+ * @return  none
+ */
+static void gapBondMgrSetIrk( uint8 idx, uint8 *pIRK )
+{
+  uint8 i;
+
+  for ( i = 0; i < GAP_BOND_RPA_CACHE_SIZE; i++ )
+  {
+    if ( gapBond_rpaCache[i].bondIdx == idx )
+    {
+      gapBond_rpaCache[i].bondIdx = GAP_BONDINGS_MAX;
+    }
+  }
+
+  for ( i = 0; i < gapBond_numIrks; i++ )
+  {
+    if ( gapBond_irkTbl[i].bondIdx == idx )
+    {
+      break;
+    }
+  }
+
+  if ( ( pIRK == NULL ) || osal_isbufset( pIRK, 0xFF, KEYLEN ) )
+  {
+    // Keep the table compact by moving the last entry into the hole
+    if ( i < gapBond_numIrks )
+    {
+      gapBond_irkTbl[i] = gapBond_irkTbl[--gapBond_numIrks];
+    }
+  }
+  else
+  {
+    if ( i == gapBond_numIrks )
+    {
+      gapBond_numIrks++;
+    }
+
+    gapBond_irkTbl[i].bondIdx = idx;
+    VOID osal_memcpy( gapBond_irkTbl[i].IRK, pIRK, KEYLEN );
+  }
+}
 #endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
 
 #if defined (BLE_V42_FEATURES) && (BLE_V42_FEATURES & PRIVACY_1_2_CFG)
@@ -2199,6 +2675,12 @@ static void gapBondMgrReadBonds( void )
     }
   }
 
+  gapBondMgrIndexBonds();
+
+#if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
+  gapBondMgrReadIrks();
+#endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
+
   if ( autoSyncWhiteList )
   {
     gapBondMgr_SyncWhiteList();
@@ -2219,17 +2701,54 @@ static void gapBondMgrReadBonds( void )
  */
 static void gapBondMgrReadLruBondList(void)
 {
+  uint8 seen[GAP_BONDINGS_MAX];
+  uint8 numSeen = 0;
+
   // See if the LRU list exists in NV
   if ( osal_snv_read( BLE_LRU_BOND_LIST, sizeof( uint8 ) * GAP_BONDINGS_MAX,
-                      gapBond_lruBondList ) != SUCCESS )
+                      gapBond_lruBondList ) == SUCCESS )
   {
-    // If it doesn't, add the list using the LRU values
+    VOID osal_memset( seen, FALSE, sizeof ( seen ) );
+
+    // It must hold each bond record index exactly once
     for ( uint8 idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
     {
-      // Store in reverse order (bond record 0 will automatically be most recently used)
-      gapBond_lruBondList[idx] = GAP_BONDINGS_MAX - idx - 1;
+      if ( ( gapBond_lruBondList[idx] >= GAP_BONDINGS_MAX ) ||
+           ( seen[gapBond_lruBondList[idx]] ) )
+      {
+        break;
+      }
+
+      seen[gapBond_lruBondList[idx]] = TRUE;
+      numSeen++;
+    }
+  }
+
+  if ( numSeen != GAP_BONDINGS_MAX )
+  {
+    uint8 pos = 0;
+
+    // If it doesn't, add the list using the LRU values. Empty records go
+    // first so they are reused before any bond, then bonds by record index
+    // (bond record 0 will be most recently used).
+    for ( uint8 idx = GAP_BONDINGS_MAX; idx > 0; idx-- )
+    {
+      if ( osal_isbufset( bonds[idx - 1].publicAddr, 0xFF, B_ADDR_LEN ) )
+      {
+        gapBond_lruBondList[pos++] = idx - 1;
+      }
+    }
+
+    for ( uint8 idx = GAP_BONDINGS_MAX; idx > 0; idx-- )
+    {
+      if ( osal_isbufset( bonds[idx - 1].publicAddr, 0xFF, B_ADDR_LEN ) == FALSE )
+      {
+        gapBond_lruBondList[pos++] = idx - 1;
+      }
     }
   }
+
+  gapBond_lruGen = gapBond_lruSavedGen = 0;
 }
 
 /*********************************************************************
@@ -2285,10 +2804,44 @@ static void gapBondMgrUpdateLruBondList(uint8 bondIndex)
   // If there was any change to the list
   if ( updateIdx < GAP_BONDINGS_MAX - 1)
   {
-    // Store updated list in NV
-    osal_snv_write( BLE_LRU_BOND_LIST, sizeof(uint8) * GAP_BONDINGS_MAX,
-                    gapBond_lruBondList );
+    gapBond_lruGen++;
+
+    // Store updated list in NV once enough changes are pending, or after a
+    // while without change
+    if ( (uint8)( gapBond_lruGen - gapBond_lruSavedGen ) >= GAP_BOND_LRU_SAVE_UPDATES )
+    {
+      gapBondMgrSaveLruBondList();
+    }
+    else
+    {
+      VOID osal_start_timerEx( gapBondMgr_TaskID, GAP_BOND_SAVE_LRU_EVT,
+                               GAP_BOND_LRU_SAVE_DELAY );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      gapBondMgrSaveLruBondList
+ *
+ * @brief   Store the LRU bond list in NV if it changed since last stored.
+ *          A list lost on reset only misorders the bonds used since then.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapBondMgrSaveLruBondList(void)
+{
+  if ( gapBond_lruGen != gapBond_lruSavedGen )
+  {
+    if ( osal_snv_write( BLE_LRU_BOND_LIST, sizeof(uint8) * GAP_BONDINGS_MAX,
+                         gapBond_lruBondList ) == SUCCESS )
+    {
+      gapBond_lruSavedGen = gapBond_lruGen;
+    }
   }
+
+  VOID osal_stop_timerEx( gapBondMgr_TaskID, GAP_BOND_SAVE_LRU_EVT );
 }
 
 /*********************************************************************
@@ -2303,13 +2856,21 @@ static void gapBondMgrUpdateLruBondList(uint8 bondIndex)
  */
 static uint8 gapBondMgrFindEmpty( void )
 {
-  // Item doesn't exist, so create all the items
-  uint8 idx;
-  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  uint8 i;
+  for ( i = 0; i < sizeof ( gapBond_emptyBonds ); i++ )
   {
-    // Look for public address of all 0xFF's
-    if ( osal_isbufset( bonds[idx].publicAddr, 0xFF, B_ADDR_LEN ) )
+    if ( gapBond_emptyBonds[i] )
     {
+      uint8 idx = i << 3;
+      uint8 bits = gapBond_emptyBonds[i];
+
+      // Lowest empty bond record in this byte
+      while ( ( bits & 0x01 ) == 0 )
+      {
+        bits >>= 1;
+        idx++;
+      }
+
       return ( idx ); // Found one
     }
   }
@@ -2461,6 +3022,9 @@ static bStatus_t gapBondMgrEraseBonding( uint8 idx )
     ret |= osal_snv_write( devLTKNvID(idx), sizeof ( gapBondLTK_t ), &ltk );
 #endif //SNP_SECURITY
     ret |= osal_snv_write( devIRKNvID(idx), KEYLEN, ltk.LTK );
+#if !defined (BLE_V42_FEATURES) || !(BLE_V42_FEATURES & PRIVACY_1_2_CFG)
+    gapBondMgrSetIrk( idx, NULL );
+#endif // ! BLE_V42_FEATURES | ! PRIVACY_1_2_CFG
 #ifndef SNP_SECURITY
     ret |= osal_snv_write( devCSRKNvID(idx), KEYLEN, ltk.LTK );
     ret |= osal_snv_write( devSignCounterNvID(idx), sizeof ( uint32 ), ltk.LTK );
@@ -2468,6 +3032,15 @@ static bStatus_t gapBondMgrEraseBonding( uint8 idx )
 
     // Write out FF's over the characteristic configuration entry.
     ret |= osal_snv_write( gattCfgNvID(idx), sizeof ( charCfg ), charCfg );
+
+    // Drop any RAM copy so it is not written back over the erased entry
+    {
+      gapBondCharCfgShadow_t *pShadow = gapBondMgrFindCharCfgShadow( idx );
+      if ( pShadow != NULL )
+      {
+        pShadow->bondIdx = GAP_BONDINGS_MAX;
+      }
+    }
   }
   else
   {
@@ -2492,6 +3065,9 @@ void GAPBondMgr_Init( uint8 task_id )
   // Setup Bond RAM Shadow
   gapBondMgrReadBonds();
 
+  // No characteristic configuration is kept in RAM until a bond connects
+  gapBondMgrFlushCharCfgShadows( INVALID_CONNHANDLE, TRUE );
+
   // Setup LRU Bond List
   gapBondMgrReadLruBondList();
 
@@ -2550,6 +3126,9 @@ uint16 GAPBondMgr_ProcessEvent( uint8 task_id, uint16 events )
     // Note: pAuthEvt is a global variable used for deferring the storage
     if ( gapBondMgr_SyncCharCfg( pAuthEvt->connectionHandle ) )
     {
+      // Save the synced CCC values before reporting the bond as saved
+      gapBondMgrFlushCharCfgShadows( pAuthEvt->connectionHandle, FALSE );
+
       if ( pGapBondCB && pGapBondCB->pairStateCB )
       {
         // Assume SUCCESS since we got this far.
@@ -2593,6 +3172,22 @@ uint16 GAPBondMgr_ProcessEvent( uint8 task_id, uint16 events )
     return (events ^ GAP_BOND_SYNC_CC_EVT);
   }
 
+  if ( events & GAP_BOND_SAVE_LRU_EVT )
+  {
+    // LRU bond list has not changed for a while
+    gapBondMgrSaveLruBondList();
+
+    return (events ^ GAP_BOND_SAVE_LRU_EVT);
+  }
+
+  if ( events & GAP_BOND_FLUSH_CC_EVT )
+  {
+    // Characteristic configuration has not changed for a while
+    gapBondMgrFlushCharCfgShadows( INVALID_CONNHANDLE, FALSE );
+
+    return (events ^ GAP_BOND_FLUSH_CC_EVT);
+  }
+
   if ( events & GAP_BOND_SAVE_RCA_EVT )
   {
 #if ( HOST_CONFIG & PERIPHERAL_CFG )
@@ -3293,6 +3888,7 @@ static void gapBondMgrAttrValueChangeCB( uint16 connHandle, uint8 attrId )
           {
             // Reverse bytes before saving the new reconnection address
             VOID osal_revmemcpy( bonds[idx].reconnectAddr, reconnectAddr, B_ADDR_LEN );
+            gapBondMgrIndexBonds();
 
             // Remember bond index for the reconnection address
             reconnectAddrIdx = idx;
@@ -54,6 +54,9 @@
 #include "hal_mcu.h"
 #include "hal_sleep.h"
 #include "osal.h"
+#if defined( OSAL_SNV_CACHE )
+#include "osal_snv.h"
+#endif // OSAL_SNV_CACHE
 
 /*********************************************************************
  */
@@ -91,10 +94,16 @@ extern void _itoa(uint16 num, uint8 *buf, uint8 radix);
 /* system restart and boot loader used from MTEL.c */
 // Only needed until BLESTACK-250 is resolved.
 #ifdef USE_FPGA
-#define SystemReset()        SysCtrlSystemReset() //HAL_SYSTEM_RESET();
+#define SystemResetNow()     SysCtrlSystemReset() //HAL_SYSTEM_RESET();
 #else // !USE_FPGA
-#define SystemReset()        HAL_SYSTEM_RESET();
+#define SystemResetNow()     HAL_SYSTEM_RESET();
 #endif // USE_FPGA
+#if defined( OSAL_SNV_CACHE )
+// Write cached NV items before they are lost
+#define SystemReset()        st( VOID osal_snv_flush(); SystemResetNow(); )
+#else // !OSAL_SNV_CACHE
+#define SystemReset()        SystemResetNow()
+#endif // OSAL_SNV_CACHE
 #define SystemResetSoft()    Onboard_soft_reset();
 #define BootLoader()         // Not yet implemented for MSP430
 
@@ -0,0 +1,173 @@
+/*
+ * Host test for fast_crc16 in Sensortag_cc2640r2lp_stack/Startup/icall_startup.c.
+ *
+ * Checks that the table driven fast_crc16 matches the bitwise slow_crc16 on
+ * random buffers and seeds, and that validChecksum accepts an image with its
+ * CRC appended and rejects a corrupted one. Then times both over an image
+ * of the size of the stack's flash.
+ *
+ * Build and run from the repository root, once per table placement:
+ *   gcc -std=gnu99 -Wall -Wno-pointer-to-int-cast -O2 -Itests/host/stubs \
+ *       -o crc16_test tests/host/crc16_test.c && ./crc16_test
+ *   gcc -std=gnu99 -Wall -Wno-pointer-to-int-cast -O2 -Itests/host/stubs \
+ *       -DCRC16_TABLE_IN_RAM -o crc16_test tests/host/crc16_test.c && ./crc16_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// icall_startup.c only builds with the TI or IAR compiler; STACK_LIBRARY
+// leaves out the entry section pragma and the C runtime init.
+#define __TI_COMPILER_VERSION__ 1
+#define STACK_LIBRARY
+#include "../../Sensortag_cc2640r2lp_stack/Startup/icall_startup.c"
+#undef __TI_COMPILER_VERSION__
+
+ICall_Dispatcher ICall_dispatcher;
+ICall_EnterCS    ICall_enterCriticalSection;
+ICall_LeaveCS    ICall_leaveCriticalSection;
+
+int stack_main( void *arg )
+{
+  (void) arg;
+  return 0;
+}
+
+#define NUM_RUNS   2000
+#define MAX_LEN    4096
+
+// Timed image: 128 KB, checksummed TIMED_RUNS times by each version
+#define IMAGE_LEN  ( 128 * 1024 )
+#define TIMED_RUNS 20
+
+static uint8 buf[MAX_LEN + 3];
+static uint8 image[IMAGE_LEN];
+
+static double nowUs( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+
+  return ( ts.tv_sec * 1e6 + ts.tv_nsec / 1e3 );
+}
+
+// slow_crc16 takes a pointer to non-const data
+static uint16 slowCrc( uint16 crc, const uint8 *pAddr, uint32 len )
+{
+  return ( slow_crc16( crc, (uint8 *) pAddr, len ) );
+}
+
+// Microseconds per pass over the image, after a pass to warm up
+static double timeCrc( uint16 (*crcFn)( uint16, const uint8 *, uint32 ),
+                       uint16 *pCrc )
+{
+  double t0;
+  int r;
+
+  *pCrc = crcFn( 0, image, IMAGE_LEN );
+
+  t0 = nowUs();
+  for ( r = 0; r < TIMED_RUNS; r++ )
+  {
+    *pCrc = crcFn( *pCrc, image, IMAGE_LEN );
+  }
+
+  return ( ( nowUs() - t0 ) / TIMED_RUNS );
+}
+
+int main( void )
+{
+  uint8 zeros[2] = { 0, 0 };
+  int failures = 0;
+  int n;
+
+  srand( 1 );
+
+  for ( n = 0; n < NUM_RUNS; n++ )
+  {
+    uint32 len = rand() % MAX_LEN;
+    uint16 seed = (uint16) rand();
+    uint16 slow, fast;
+    uint32 i;
+
+    for ( i = 0; i < len; i++ )
+    {
+      buf[i] = (uint8) rand();
+    }
+
+    slow = slow_crc16( seed, buf, len );
+    fast = fast_crc16( seed, buf, len );
+    if ( slow != fast )
+    {
+      printf( "run %d: len %u seed 0x%04X slow 0x%04X fast 0x%04X\n",
+              n, (unsigned) len, seed, slow, fast );
+      failures++;
+    }
+
+    // The two trailing zero bytes must rotate out the same answer
+    if ( slow_crc16( slow, zeros, 2 ) != fast_crc16( fast, zeros, 2 ) )
+    {
+      printf( "run %d: final rotation differs\n", n );
+      failures++;
+    }
+  }
+
+  // An image of whole words followed by its CRC, as the linker lays it out
+  {
+    uint32 len = 1024;
+    uint16 crc;
+    uint32 i;
+
+    for ( i = 0; i < len; i++ )
+    {
+      buf[i] = (uint8) rand();
+    }
+
+    crc = slow_crc16( 0, buf, len );
+    crc = slow_crc16( crc, zeros, 2 );
+    memcpy( &buf[len], &crc, sizeof ( crc ) );
+
+    if ( validChecksum( (const uint32 *) buf,
+                        (const uint32 *) &buf[len - 1] ) != TRUE )
+    {
+      printf( "validChecksum rejected a valid image\n" );
+      failures++;
+    }
+
+    buf[len / 2] ^= 0x01;
+    if ( validChecksum( (const uint32 *) buf,
+                        (const uint32 *) &buf[len - 1] ) != FALSE )
+    {
+      printf( "validChecksum accepted a corrupted image\n" );
+      failures++;
+    }
+  }
+
+  // Timing over a whole image
+  {
+    uint16 slow, fast;
+    double slowUs, fastUs;
+    uint32 i;
+
+    for ( i = 0; i < IMAGE_LEN; i++ )
+    {
+      image[i] = (uint8) rand();
+    }
+
+    slowUs = timeCrc( slowCrc, &slow );
+    fastUs = timeCrc( fast_crc16, &fast );
+    if ( slow != fast )
+    {
+      printf( "timed runs: slow 0x%04X fast 0x%04X\n", slow, fast );
+      failures++;
+    }
+
+    printf( "crc16 over %u KB: slow_crc16 %.0f us, fast_crc16 %.0f us (%.1fx)\n",
+            IMAGE_LEN / 1024, slowUs, fastUs, slowUs / fastUs );
+  }
+
+  printf( "crc16_test: %s\n", failures ? "FAILED" : "ok" );
+  return ( failures ? 1 : 0 );
+}
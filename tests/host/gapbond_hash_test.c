@@ -0,0 +1,263 @@
+/*
+ * Host test for the bond address indexes in
+ * Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c.
+ *
+ * gapbondmgr.c needs SDK headers the tree does not ship, so the hash index
+ * code (GAP_BOND_HASH_SIZE, gapBondMgrHashAddr, gapBondMgrFindHashedAddr,
+ * gapBondMgrHashInsert, gapBondMgrIndexBonds and gapBondMgrFindEmpty) is
+ * extracted from it unchanged first: the hash size into
+ * gapbondmgr_hash_size.inc and the functions into gapbondmgr_hash.inc.
+ *
+ * Build and run from the repository root, here with 64 bonds:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#ifndef GAP_BOND_HASH_SIZE$/,/^#define GAP_BOND_HASH_EMPTY/p' \
+ *       Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c > _host_tests/gapbondmgr_hash_size.inc
+ *   sed -n '/^static [a-z0-9]* gapBondMgr\(HashAddr\|FindHashedAddr\|HashInsert\|IndexBonds\|FindEmpty\)(.*)$/,/^}$/p' \
+ *       Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c > _host_tests/gapbondmgr_hash.inc
+ *   gcc -std=gnu99 -Wall -Itests/host/stubs -I_host_tests -DGAP_BONDINGS_MAX=64 \
+ *       -o _host_tests/gapbond_hash_test tests/host/gapbond_hash_test.c
+ *   _host_tests/gapbond_hash_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+
+#ifndef GAP_BONDINGS_MAX
+#define GAP_BONDINGS_MAX  64
+#endif
+
+#define B_ADDR_LEN        6
+
+#define NUM_TRIALS        100
+
+// The fields of the bond record used by the indexes
+typedef struct
+{
+  uint8   publicAddr[B_ADDR_LEN];
+  uint8   publicAddrType;
+  uint8   reconnectAddr[B_ADDR_LEN];
+  uint8   stateFlags;
+} gapBondRec_t;
+
+static uint8 osal_isbufset( uint8 *buf, uint8 val, uint8 len )
+{
+  while ( len-- )
+  {
+    if ( *buf++ != val )
+    {
+      return ( FALSE );
+    }
+  }
+  return ( TRUE );
+}
+
+static uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+
+#define osal_memset memset
+
+static uint8 gapBond_removeLRUBond = FALSE;
+
+static uint8 gapBondMgrGetLruBondIndex( void )
+{
+  return ( 0 );
+}
+
+#include "gapbondmgr_hash_size.inc"
+
+static gapBondRec_t bonds[GAP_BONDINGS_MAX];
+static uint8 gapBond_addrHash[GAP_BOND_HASH_SIZE];
+static uint8 gapBond_reconnectHash[GAP_BOND_HASH_SIZE];
+static uint8 gapBond_emptyBonds[(GAP_BONDINGS_MAX + 7) / 8];
+
+#include "gapbondmgr_hash.inc"
+
+static int failures = 0;
+
+#define CHECK( _cond, ... )                 \
+  do                                        \
+  {                                         \
+    if ( !( _cond ) )                       \
+    {                                       \
+      printf( __VA_ARGS__ );                \
+      printf( "\n" );                       \
+      failures++;                           \
+    }                                       \
+  } while ( 0 )
+
+static void randomAddr( uint8 *pAddr )
+{
+  uint8 i;
+
+  do
+  {
+    for ( i = 0; i < B_ADDR_LEN; i++ )
+    {
+      pAddr[i] = (uint8) rand();
+    }
+  } while ( osal_isbufset( pAddr, 0xFF, B_ADDR_LEN ) );
+}
+
+// Number of index slots probed to reach the record stored in a slot
+static unsigned probeLen( uint8 slot, uint8 *pAddr )
+{
+  uint8 home = gapBondMgrHashAddr( pAddr );
+
+  return ( ( ( slot - home ) & ( GAP_BOND_HASH_SIZE - 1 ) ) + 1 );
+}
+
+static unsigned usedSlots( uint8 *pHash )
+{
+  unsigned n = 0;
+  unsigned slot;
+
+  for ( slot = 0; slot < GAP_BOND_HASH_SIZE; slot++ )
+  {
+    if ( pHash[slot] != GAP_BOND_HASH_EMPTY )
+    {
+      n++;
+    }
+  }
+  return ( n );
+}
+
+int main( void )
+{
+  unsigned long probes = 0, hits = 0;
+  unsigned maxProbe = 0;
+  uint8 unused[B_ADDR_LEN];
+  int trial;
+
+  srand( 1 );
+  memset( unused, 0xFF, B_ADDR_LEN );
+
+  // The index needs a free slot to end each probe run
+  CHECK( GAP_BOND_HASH_SIZE > GAP_BONDINGS_MAX, "hash size %d too small",
+         GAP_BOND_HASH_SIZE );
+
+  for ( trial = 0; trial < NUM_TRIALS; trial++ )
+  {
+    uint8 numEmpty = 0;
+    uint8 firstEmpty = GAP_BONDINGS_MAX;
+    uint8 numReconnect = 0;
+    uint8 idx;
+    int n;
+
+    // A full table, then some records left empty from the second trial on
+    memset( bonds, 0xFF, sizeof ( bonds ) );
+    for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+    {
+      if ( trial > 0 && ( rand() % 4 ) == 0 )
+      {
+        if ( firstEmpty == GAP_BONDINGS_MAX )
+        {
+          firstEmpty = idx;
+        }
+        numEmpty++;
+        continue;
+      }
+
+      randomAddr( bonds[idx].publicAddr );
+      if ( rand() % 2 )
+      {
+        randomAddr( bonds[idx].reconnectAddr );
+        numReconnect++;
+      }
+    }
+
+    gapBondMgrIndexBonds();
+
+    // Every used record is found by its addresses
+    for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+    {
+      if ( osal_isbufset( bonds[idx].publicAddr, 0xFF, B_ADDR_LEN ) )
+      {
+        continue;
+      }
+
+      CHECK( gapBondMgrFindHashedAddr( gapBond_addrHash, bonds[idx].publicAddr,
+                                       FALSE ) == idx,
+             "trial %d: bond %d not found by address", trial, idx );
+
+      if ( !osal_isbufset( bonds[idx].reconnectAddr, 0xFF, B_ADDR_LEN ) )
+      {
+        CHECK( gapBondMgrFindHashedAddr( gapBond_reconnectHash,
+                                         bonds[idx].reconnectAddr,
+                                         TRUE ) == idx,
+               "trial %d: bond %d not found by reconnection address",
+               trial, idx );
+      }
+    }
+
+    // Empty records and unused addresses stay out of the indexes
+    CHECK( usedSlots( gapBond_addrHash ) == GAP_BONDINGS_MAX - numEmpty,
+           "trial %d: %u address slots used, %d expected", trial,
+           usedSlots( gapBond_addrHash ), GAP_BONDINGS_MAX - numEmpty );
+    CHECK( usedSlots( gapBond_reconnectHash ) == numReconnect,
+           "trial %d: %u reconnection slots used, %d expected", trial,
+           usedSlots( gapBond_reconnectHash ), numReconnect );
+    CHECK( gapBondMgrFindHashedAddr( gapBond_addrHash, unused,
+                                     FALSE ) == GAP_BONDINGS_MAX,
+           "trial %d: unused address found", trial );
+
+    // Addresses that are not bonded are not found
+    for ( n = 0; n < 100; n++ )
+    {
+      uint8 addr[B_ADDR_LEN];
+
+      randomAddr( addr );
+      idx = gapBondMgrFindHashedAddr( gapBond_addrHash, addr, FALSE );
+      CHECK( idx == GAP_BONDINGS_MAX ||
+             osal_memcmp( bonds[idx].publicAddr, addr, B_ADDR_LEN ),
+             "trial %d: wrong bond %d found", trial, idx );
+    }
+
+    // The lowest empty record is handed out first
+    CHECK( gapBondMgrFindEmpty() == firstEmpty,
+           "trial %d: empty record %d, %d expected", trial,
+           gapBondMgrFindEmpty(), firstEmpty );
+
+    // Probe run lengths of the address index
+    for ( n = 0; n < GAP_BOND_HASH_SIZE; n++ )
+    {
+      uint8 bondIdx = gapBond_addrHash[n];
+
+      if ( bondIdx != GAP_BOND_HASH_EMPTY )
+      {
+        unsigned len = probeLen( (uint8) n, bonds[bondIdx].publicAddr );
+
+        probes += len;
+        hits++;
+        if ( len > maxProbe )
+        {
+          maxProbe = len;
+        }
+      }
+    }
+  }
+
+  // Two records sharing an address resolve to the lower one
+  memset( bonds, 0xFF, sizeof ( bonds ) );
+  randomAddr( bonds[GAP_BONDINGS_MAX - 1].publicAddr );
+  memcpy( bonds[1].publicAddr, bonds[GAP_BONDINGS_MAX - 1].publicAddr,
+          B_ADDR_LEN );
+  gapBondMgrIndexBonds();
+  CHECK( gapBondMgrFindHashedAddr( gapBond_addrHash, bonds[1].publicAddr,
+                                   FALSE ) == 1,
+         "duplicate address did not resolve to the lower record" );
+  CHECK( gapBondMgrFindEmpty() == 0, "record 0 not reported empty" );
+
+  // At most half the slots are used, so lookups stay short
+  CHECK( probes <= 2 * hits, "average probe run %.2f too long",
+         (double) probes / hits );
+
+  printf( "gapbond_hash_test: %s (%d bonds, %d slots, "
+          "average probe %.2f, longest %u)\n",
+          failures ? "FAILED" : "ok", GAP_BONDINGS_MAX, GAP_BOND_HASH_SIZE,
+          (double) probes / hits, maxProbe );
+  return ( failures ? 1 : 0 );
+}
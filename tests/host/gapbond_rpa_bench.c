@@ -0,0 +1,388 @@
+/*
+ * Host test and benchmark for private address resolution in
+ * Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c.
+ *
+ * gapbondmgr.c needs SDK headers the tree does not ship, so the RAM IRK
+ * table and the resolved address cache (GAP_BOND_RPA_CACHE_SIZE, their
+ * types and variables, gapBondMgrResolvePrivateAddr, gapBondMgrReadIrks
+ * and gapBondMgrSetIrk) are extracted from it unchanged into
+ * gapbondmgr_rpa.inc. The SNV layer and the AES based GAP_ResolvePrivateAddr
+ * are stubbed and count their calls; the stub hash stands in for ah().
+ *
+ * Bonded devices reconnect with a resolvable private address that they
+ * change every few connections, mixed with devices that are not bonded.
+ * Bonds are erased and replaced on the way. Every lookup must find the
+ * bond the lookup before the RAM table found, i.e. the NV scan kept below
+ * as oldResolvePrivateAddr. The SNV reads and AES runs per lookup of both
+ * are printed.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#ifndef GAP_BOND_RPA_CACHE_SIZE$/,/^#endif \/\/ GAP_BOND_RPA_CACHE_SIZE$/p; /^\/\/ Structure of a RAM copy of a bonded device.s IRK$/,/^} gapBondRpa_t;$/p; /^static gapBondIrk_t gapBond_irkTbl/,/^static uint8 gapBond_rpaCacheNext/p; /^static [a-z0-9]* gapBondMgr\(ResolvePrivateAddr\|ReadIrks\|SetIrk\)( .*)$/,/^}$/p' \
+ *       Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c > _host_tests/gapbondmgr_rpa.inc
+ *   gcc -std=gnu99 -Wall -Itests/host/stubs -I_host_tests \
+ *       -o _host_tests/gapbond_rpa_bench tests/host/gapbond_rpa_bench.c
+ *   _host_tests/gapbond_rpa_bench
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+
+#ifndef GAP_BONDINGS_MAX
+#define GAP_BONDINGS_MAX  10
+#endif
+
+#define B_ADDR_LEN        6
+#define KEYLEN            16
+#define SUCCESS           0x00
+#define FAILURE           0x01
+#define NV_OPER_FAILED    0x0A
+
+// Devices that connect, bonded or not, and lookups made
+#define NUM_DEVICES       ( 3 * GAP_BONDINGS_MAX )
+#define NUM_LOOKUPS       100000
+
+static unsigned long snvReads;
+static unsigned long aesRuns;
+
+static uint8 osal_isbufset( uint8 *buf, uint8 val, uint8 len )
+{
+  while ( len-- )
+  {
+    if ( *buf++ != val )
+    {
+      return ( FALSE );
+    }
+  }
+  return ( TRUE );
+}
+
+static uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+
+#define osal_memcpy memcpy
+
+/*
+ * SNV: the device IRK items of the bonds, all 0xFF's when erased
+ */
+static uint8 nvIrk[GAP_BONDINGS_MAX][KEYLEN];
+
+#define devIRKNvID(bondIdx)  (bondIdx)
+
+static uint8 osal_snv_read( uint8 id, uint8 len, void *pBuf )
+{
+  snvReads++;
+  if ( id >= GAP_BONDINGS_MAX || len != KEYLEN )
+  {
+    return ( NV_OPER_FAILED );
+  }
+  memcpy( pBuf, nvIrk[id], KEYLEN );
+  return ( SUCCESS );
+}
+
+/*
+ * Stand-in for the AES based address hash ah(): a 24-bit hash of the IRK
+ * and the random part of the address.
+ */
+static uint32 stubAh( const uint8 *pIRK, const uint8 *pPrand )
+{
+  uint32 h = 2166136261u;
+  uint8 i;
+
+  for ( i = 0; i < KEYLEN; i++ )
+  {
+    h = ( h ^ pIRK[i] ) * 16777619u;
+  }
+  for ( i = 0; i < 3; i++ )
+  {
+    h = ( h ^ pPrand[i] ) * 16777619u;
+  }
+  return ( h & 0xFFFFFF );
+}
+
+// The address is LSB first: hash in bytes 0 to 2, prand in bytes 3 to 5
+static uint8 GAP_ResolvePrivateAddr( uint8 *pIRK, uint8 *pAddr )
+{
+  uint32 hash = pAddr[0] | ( pAddr[1] << 8 ) | ( (uint32) pAddr[2] << 16 );
+
+  aesRuns++;
+  return ( ( stubAh( pIRK, &pAddr[3] ) == hash ) ? SUCCESS : FAILURE );
+}
+
+#include "gapbondmgr_rpa.inc"
+
+/*
+ * The lookup before the RAM table: read each IRK from NV and try it.
+ */
+static uint8 oldResolvePrivateAddr( uint8 *pDevAddr )
+{
+  uint8 idx;
+  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  {
+    uint8 IRK[KEYLEN];
+
+    // Read in NV IRK Record and compare resolvable address
+    if ( osal_snv_read( devIRKNvID(idx), KEYLEN, IRK ) == SUCCESS )
+    {
+      if ( ( osal_isbufset( IRK, 0xFF, KEYLEN ) == FALSE ) &&
+           ( GAP_ResolvePrivateAddr( IRK, pDevAddr ) == SUCCESS ) )
+      {
+        return ( idx ); // Found it
+      }
+    }
+  }
+
+  return ( GAP_BONDINGS_MAX );
+}
+
+static int failures = 0;
+
+#define CHECK( _cond, ... )                 \
+  do                                        \
+  {                                         \
+    if ( !( _cond ) && failures++ < 10 )    \
+    {                                       \
+      printf( "FAIL: " );                   \
+      printf( __VA_ARGS__ );                \
+      printf( "\n" );                       \
+    }                                       \
+  } while ( 0 )
+
+// A device: its IRK and its current resolvable private address
+typedef struct
+{
+  uint8 IRK[KEYLEN];
+  uint8 addr[B_ADDR_LEN];
+} device_t;
+
+static device_t devices[NUM_DEVICES];
+
+static void newIrk( device_t *pDev )
+{
+  uint8 i;
+
+  do
+  {
+    for ( i = 0; i < KEYLEN; i++ )
+    {
+      pDev->IRK[i] = (uint8) rand();
+    }
+  } while ( osal_isbufset( pDev->IRK, 0xFF, KEYLEN ) );
+}
+
+static void newRpa( device_t *pDev )
+{
+  uint32 hash;
+
+  pDev->addr[3] = (uint8) rand();
+  pDev->addr[4] = (uint8) rand();
+  pDev->addr[5] = ( (uint8) rand() & 0x3F ) | 0x40;
+  hash = stubAh( pDev->IRK, &pDev->addr[3] );
+  pDev->addr[0] = (uint8) hash;
+  pDev->addr[1] = (uint8) ( hash >> 8 );
+  pDev->addr[2] = (uint8) ( hash >> 16 );
+}
+
+/*
+ * Stores the IRK of a device in a bond slot, NULL to erase it, as
+ * gapBondMgrAddBond and gapBondMgrEraseBonding do.
+ */
+static void storeIrk( uint8 idx, device_t *pDev )
+{
+  if ( pDev != NULL )
+  {
+    memcpy( nvIrk[idx], pDev->IRK, KEYLEN );
+    gapBondMgrSetIrk( idx, pDev->IRK );
+  }
+  else
+  {
+    memset( nvIrk[idx], 0xFF, KEYLEN );
+    gapBondMgrSetIrk( idx, NULL );
+  }
+}
+
+// Lookups with the old and the new code, each with its SNV and AES counts
+typedef struct
+{
+  unsigned long lookups;
+  unsigned long snvReads[2];
+  unsigned long aesRuns[2];
+} stats_t;
+
+static uint8 lookup( uint8 *pAddr, stats_t *pStats )
+{
+  uint8 oldIdx, newIdx;
+
+  snvReads = aesRuns = 0;
+  oldIdx = oldResolvePrivateAddr( pAddr );
+  pStats->snvReads[0] += snvReads;
+  pStats->aesRuns[0] += aesRuns;
+
+  snvReads = aesRuns = 0;
+  newIdx = gapBondMgrResolvePrivateAddr( pAddr );
+  pStats->snvReads[1] += snvReads;
+  pStats->aesRuns[1] += aesRuns;
+
+  pStats->lookups++;
+  CHECK( newIdx == oldIdx, "lookup %lu: bond %u, the NV scan found %u",
+         pStats->lookups, newIdx, oldIdx );
+
+  return ( newIdx );
+}
+
+static void printStats( const char *pName, const stats_t *pStats )
+{
+  printf( "  %-16s %6lu %7.2f %7.2f %7.2f %7.2f\n", pName, pStats->lookups,
+          (double) pStats->snvReads[0] / pStats->lookups,
+          (double) pStats->aesRuns[0] / pStats->lookups,
+          (double) pStats->snvReads[1] / pStats->lookups,
+          (double) pStats->aesRuns[1] / pStats->lookups );
+}
+
+int main( void )
+{
+  stats_t bonded = { 0 };
+  stats_t unknown = { 0 };
+  uint8 slotDev[GAP_BONDINGS_MAX];   // Device bonded in each slot
+  unsigned long n;
+  uint8 idx;
+  int d, i;
+
+  srand( 1 );
+
+  for ( d = 0; d < NUM_DEVICES; d++ )
+  {
+    newIrk( &devices[d] );
+    newRpa( &devices[d] );
+  }
+
+  // Every other slot bonded at power up, the others empty or bonded
+  // without an IRK
+  memset( nvIrk, 0xFF, sizeof( nvIrk ) );
+  for ( idx = 0; idx < GAP_BONDINGS_MAX; idx++ )
+  {
+    slotDev[idx] = NUM_DEVICES;
+    if ( idx % 2 == 0 )
+    {
+      slotDev[idx] = idx;
+      memcpy( nvIrk[idx], devices[idx].IRK, KEYLEN );
+    }
+  }
+  gapBondMgrReadIrks();
+  CHECK( gapBond_numIrks == ( GAP_BONDINGS_MAX + 1 ) / 2,
+         "%u IRKs read from NV", gapBond_numIrks );
+
+  for ( n = 0; n < NUM_LOOKUPS; n++ )
+  {
+    int event = rand() % 1000;
+
+    if ( event == 0 )
+    {
+      // A bond is erased
+      idx = rand() % GAP_BONDINGS_MAX;
+      storeIrk( idx, NULL );
+      slotDev[idx] = NUM_DEVICES;
+    }
+    else if ( event < 3 )
+    {
+      // A device bonds, in a free slot or replacing a bond; the IRK of a
+      // device that bonds again may change
+      idx = rand() % GAP_BONDINGS_MAX;
+      d = rand() % NUM_DEVICES;
+      for ( i = 0; i < GAP_BONDINGS_MAX; i++ )
+      {
+        if ( slotDev[i] == d )
+        {
+          storeIrk( i, NULL );
+          slotDev[i] = NUM_DEVICES;
+        }
+      }
+      if ( rand() % 2 )
+      {
+        newIrk( &devices[d] );
+        newRpa( &devices[d] );
+      }
+      storeIrk( idx, &devices[d] );
+      slotDev[idx] = d;
+    }
+    else
+    {
+      // A device connects, most of the time a bonded one; it changes its
+      // address every 8th time or so
+      d = rand() % NUM_DEVICES;
+      if ( rand() % 5 != 0 )
+      {
+        idx = rand() % GAP_BONDINGS_MAX;
+        for ( i = 0; i < GAP_BONDINGS_MAX && slotDev[idx] == NUM_DEVICES; i++ )
+        {
+          idx = ( idx + 1 ) % GAP_BONDINGS_MAX;
+        }
+        if ( slotDev[idx] < NUM_DEVICES )
+        {
+          d = slotDev[idx];
+        }
+      }
+      if ( rand() % 8 == 0 )
+      {
+        newRpa( &devices[d] );
+      }
+
+      idx = GAP_BONDINGS_MAX;
+      for ( i = 0; i < GAP_BONDINGS_MAX; i++ )
+      {
+        if ( slotDev[i] == d )
+        {
+          idx = i;
+        }
+      }
+
+      CHECK( lookup( devices[d].addr, ( idx < GAP_BONDINGS_MAX ) ?
+                     &bonded : &unknown ) == idx,
+             "device %d found in the wrong slot", d );
+    }
+  }
+
+  // A power cycle reads back the same table
+  {
+    gapBondIrk_t irks[GAP_BONDINGS_MAX];
+    uint8 numIrks = gapBond_numIrks;
+
+    memcpy( irks, gapBond_irkTbl, sizeof( irks ) );
+    gapBondMgrReadIrks();
+    CHECK( gapBond_numIrks == numIrks, "%u IRKs after a power cycle, %u before",
+           gapBond_numIrks, numIrks );
+    for ( idx = 0; idx < gapBond_numIrks; idx++ )
+    {
+      for ( i = 0; i < numIrks; i++ )
+      {
+        if ( irks[i].bondIdx == gapBond_irkTbl[idx].bondIdx &&
+             memcmp( irks[i].IRK, gapBond_irkTbl[idx].IRK, KEYLEN ) == 0 )
+        {
+          break;
+        }
+      }
+      CHECK( i < numIrks, "IRK of bond %u differs after a power cycle",
+             gapBond_irkTbl[idx].bondIdx );
+    }
+  }
+
+  printf( "%d bonds, %d resolved addresses cached; per lookup:\n",
+          GAP_BONDINGS_MAX, GAP_BOND_RPA_CACHE_SIZE );
+  printf( "                            NV scan         RAM table\n" );
+  printf( "  device           count   reads     AES   reads     AES\n" );
+  printStats( "bonded", &bonded );
+  printStats( "not bonded", &unknown );
+
+  if ( failures )
+  {
+    return ( 1 );
+  }
+
+  printf( "gapbond_rpa_bench: OK\n" );
+
+  return ( 0 );
+}
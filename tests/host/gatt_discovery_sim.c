@@ -0,0 +1,721 @@
+/*
+ * Host discovery simulator for the GATT database hash in
+ * SensorTag_cc2640r2lp_app/PROFILES/gatt_db_hash.c.
+ *
+ * Builds an attribute database with the SensorTag service layout and runs
+ * the full discovery a central does on first connection: Read By Group Type
+ * for the primary services, Read By Type for the characteristics of each
+ * service and Find Information for the descriptors of each characteristic.
+ * The server side walks the attribute list for every request, as the ATT
+ * server in the stack does. It reports requests, attributes visited and
+ * microseconds per full discovery, and the estimated link time at one ATT
+ * transaction per connection interval.
+ *
+ * It then checks the database unchanged fast path with the hash code
+ * extracted unchanged from gatt_db_hash.c: a bonded client reconnecting to
+ * an unchanged database skips discovery, and any change to the database
+ * flags a Service Changed indication.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#define GATT_DB_HASH_\(POLY\|INIT\) /p; /^static uint16 gattDbHashValue /p; /^[a-zA-Z0-9_ ]*\(GATTDbHash_[a-zA-Z]*\|gattDbHash_crc\)(.*)$/,/^}$/p' \
+ *       SensorTag_cc2640r2lp_app/PROFILES/gatt_db_hash.c > _host_tests/gatt_db_hash.inc
+ *   gcc -std=gnu99 -Wall -Itests/host/stubs -I_host_tests \
+ *       -o _host_tests/gatt_discovery_sim tests/host/gatt_discovery_sim.c
+ *   _host_tests/gatt_discovery_sim [ATT_MTU] [connection interval in ms]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_types.h"
+
+#define NUM_TRIALS                  2000
+
+#define MAX_ATTRS                   256
+#define MAX_SERVICES                20
+
+#define ATT_BT_UUID_SIZE            2
+#define ATT_UUID_SIZE               16
+
+#define GATT_INVALID_HANDLE         0x0000
+#define GATT_PRIMARY_SERVICE_UUID   0x2800
+#define GATT_CHARACTER_UUID         0x2803
+#define GATT_CLIENT_CHAR_CFG_UUID   0x2902
+#define GATT_CHAR_USER_DESC_UUID    0x2901
+
+#define GATT_PERMIT_READ            0x01
+#define GATT_PERMIT_WRITE           0x02
+
+#define GATT_PROP_READ              0x02
+#define GATT_PROP_WRITE             0x08
+#define GATT_PROP_NOTIFY            0x10
+#define GATT_PROP_INDICATE          0x20
+
+#define SUCCESS                     0x00
+#define INVALIDPARAMETER            0x02
+
+#define LO_UINT16(a)                ((a) & 0xFF)
+#define HI_UINT16(a)                (((a) >> 8) & 0xFF)
+#define BUILD_UINT16(lo, hi)        ((uint16)(((lo) & 0xFF) + (((hi) & 0xFF) << 8)))
+
+typedef uint8 bStatus_t;
+
+typedef struct
+{
+  uint8 len;
+  const uint8 *uuid;
+} gattAttrType_t;
+
+typedef struct
+{
+  gattAttrType_t type;
+  uint8 permissions;
+  uint16 handle;
+  uint8 *pValue;
+} gattAttribute_t;
+
+// Stand-ins for the NV and Bond Manager calls of GATTDbHash_commit
+#define BLE_NVID_CUST_START         0x80
+#define GATT_DB_HASH_NV_ID          BLE_NVID_CUST_START
+
+static uint8 nvValid;
+static uint16 nvHash;
+static int serviceChangedCount;
+
+static uint8 osal_snv_read(uint8 id, uint8 len, void *pBuf)
+{
+  if (!nvValid || (id != GATT_DB_HASH_NV_ID) || (len != sizeof(nvHash)))
+  {
+    return (0x0A);
+  }
+
+  memcpy(pBuf, &nvHash, len);
+
+  return (SUCCESS);
+}
+
+static uint8 osal_snv_write(uint8 id, uint8 len, void *pBuf)
+{
+  memcpy(&nvHash, pBuf, len);
+  nvValid = TRUE;
+
+  return (SUCCESS);
+}
+
+static bStatus_t GAPBondMgr_ServiceChangeInd(uint16 connHandle, uint8 setParam)
+{
+  serviceChangedCount++;
+
+  return (SUCCESS);
+}
+
+static uint16 gattDbHash_crc(uint16 crc, const uint8 *pBuf, uint8 len);
+
+#include "gatt_db_hash.inc"
+
+/*
+ * Service layout
+ */
+
+// Characteristic flags
+#define CHAR_CCC      0x01  // has a Client Characteristic Configuration
+#define CHAR_DESC     0x02  // has a Characteristic User Description
+
+typedef struct
+{
+  uint16 uuid;
+  uint8 props;
+  uint8 flags;
+} charSpec_t;
+
+typedef struct
+{
+  const char *name;
+  uint16 uuid;
+  uint8 ti128;            // 128-bit UUIDs on the TI base
+  uint8 numChars;
+  charSpec_t chars[10];
+} serviceSpec_t;
+
+#define SENSOR_SERVICE(name, uuid)                                      \
+  { name, uuid, TRUE, 3,                                                \
+    { { uuid + 1, GATT_PROP_READ | GATT_PROP_NOTIFY, CHAR_CCC | CHAR_DESC }, \
+      { uuid + 2, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC },        \
+      { uuid + 3, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC } } }
+
+static const serviceSpec_t sensorTagDb[] =
+{
+  { "GAP", 0x1800, FALSE, 3,
+    { { 0x2A00, GATT_PROP_READ, 0 },
+      { 0x2A01, GATT_PROP_READ, 0 },
+      { 0x2A04, GATT_PROP_READ, 0 } } },
+  { "GATT", 0x1801, FALSE, 1,
+    { { 0x2A05, GATT_PROP_INDICATE, CHAR_CCC } } },
+  { "Device Information", 0x180A, FALSE, 9,
+    { { 0x2A23, GATT_PROP_READ, 0 }, { 0x2A24, GATT_PROP_READ, 0 },
+      { 0x2A25, GATT_PROP_READ, 0 }, { 0x2A26, GATT_PROP_READ, 0 },
+      { 0x2A27, GATT_PROP_READ, 0 }, { 0x2A28, GATT_PROP_READ, 0 },
+      { 0x2A29, GATT_PROP_READ, 0 }, { 0x2A2A, GATT_PROP_READ, 0 },
+      { 0x2A50, GATT_PROP_READ, 0 } } },
+  { "Battery", 0x180F, FALSE, 1,
+    { { 0x2A19, GATT_PROP_READ | GATT_PROP_NOTIFY, CHAR_CCC } } },
+  SENSOR_SERVICE("IR Temperature", 0xAA00),
+  SENSOR_SERVICE("Humidity", 0xAA20),
+  SENSOR_SERVICE("Barometer", 0xAA40),
+  SENSOR_SERVICE("Optical", 0xAA70),
+  SENSOR_SERVICE("Movement", 0xAA80),
+  { "Simple Keys", 0xFFE0, FALSE, 1,
+    { { 0xFFE1, GATT_PROP_NOTIFY, CHAR_CCC | CHAR_DESC } } },
+  { "IO", 0xAA64, TRUE, 2,
+    { { 0xAA65, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC },
+      { 0xAA66, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC } } },
+  { "Register", 0xAC00, TRUE, 3,
+    { { 0xAC01, GATT_PROP_READ | GATT_PROP_WRITE | GATT_PROP_NOTIFY, CHAR_CCC | CHAR_DESC },
+      { 0xAC02, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC },
+      { 0xAC03, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC } } },
+  { "Connection Control", 0xCCC0, TRUE, 3,
+    { { 0xCCC1, GATT_PROP_READ | GATT_PROP_NOTIFY, CHAR_CCC | CHAR_DESC },
+      { 0xCCC2, GATT_PROP_WRITE, CHAR_DESC },
+      { 0xCCC3, GATT_PROP_WRITE, CHAR_DESC } } },
+  { "Recorder", 0xAD00, TRUE, 2,
+    { { 0xAD01, GATT_PROP_READ | GATT_PROP_NOTIFY, CHAR_CCC | CHAR_DESC },
+      { 0xAD02, GATT_PROP_READ | GATT_PROP_WRITE, CHAR_DESC } } },
+  { "Diagnostics", 0xAE00, TRUE, 1,
+    { { 0xAE01, GATT_PROP_READ, CHAR_DESC } } },
+};
+
+#define NUM_SERVICES  (sizeof(sensorTagDb) / sizeof(sensorTagDb[0]))
+
+/*
+ * Attribute database
+ */
+
+static const uint8 primaryServiceUUID[2] = { LO_UINT16(GATT_PRIMARY_SERVICE_UUID), HI_UINT16(GATT_PRIMARY_SERVICE_UUID) };
+static const uint8 characterUUID[2] = { LO_UINT16(GATT_CHARACTER_UUID), HI_UINT16(GATT_CHARACTER_UUID) };
+static const uint8 clientCharCfgUUID[2] = { LO_UINT16(GATT_CLIENT_CHAR_CFG_UUID), HI_UINT16(GATT_CLIENT_CHAR_CFG_UUID) };
+static const uint8 charUserDescUUID[2] = { LO_UINT16(GATT_CHAR_USER_DESC_UUID), HI_UINT16(GATT_CHAR_USER_DESC_UUID) };
+
+typedef struct
+{
+  gattAttribute_t attrs[MAX_ATTRS];
+  uint16 numAttrs;
+
+  // Per service: first attribute, number of attributes, service UUID
+  uint16 svcStart[MAX_SERVICES];
+  uint16 svcNumAttrs[MAX_SERVICES];
+  gattAttrType_t svcType[MAX_SERVICES];
+  uint8 svcUuid[MAX_SERVICES][ATT_UUID_SIZE];
+  uint16 numServices;
+
+  // Characteristic declaration values and value UUIDs
+  uint8 charDecl[MAX_ATTRS][3 + ATT_UUID_SIZE];
+  uint8 charUuid[MAX_ATTRS][ATT_UUID_SIZE];
+} gattDb_t;
+
+static gattDb_t db;
+
+// Total characteristics and descriptors in the database
+static int expectChars;
+static int expectDescs;
+
+static void setUuid(uint8 *pUuid, uint16 uuid, uint8 ti128)
+{
+  // TI base UUID: F000XXXX-0451-4000-B000-000000000000
+  static const uint8 tiBase[ATT_UUID_SIZE] =
+  {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB0,
+    0x00, 0x40, 0x51, 0x04, 0x00, 0x00, 0x00, 0xF0
+  };
+
+  if (ti128)
+  {
+    memcpy(pUuid, tiBase, ATT_UUID_SIZE);
+    pUuid[12] = LO_UINT16(uuid);
+    pUuid[13] = HI_UINT16(uuid);
+  }
+  else
+  {
+    pUuid[0] = LO_UINT16(uuid);
+    pUuid[1] = HI_UINT16(uuid);
+  }
+}
+
+static gattAttribute_t *addAttr(const uint8 *pType, uint8 typeLen,
+                                uint8 permissions, uint8 *pValue)
+{
+  gattAttribute_t *pAttr = &db.attrs[db.numAttrs++];
+
+  pAttr->type.len = typeLen;
+  pAttr->type.uuid = pType;
+  pAttr->permissions = permissions;
+  pAttr->handle = db.numAttrs;
+  pAttr->pValue = pValue;
+
+  return (pAttr);
+}
+
+// Build the database from the layout, skipping service 'skip' (or none)
+static void buildDb(int skip)
+{
+  int s, c;
+
+  memset(&db, 0, sizeof(db));
+  expectChars = 0;
+  expectDescs = 0;
+
+  for (s = 0; s < NUM_SERVICES; s++)
+  {
+    const serviceSpec_t *pSpec = &sensorTagDb[s];
+    uint16 svc = db.numServices;
+    uint8 uuidLen = pSpec->ti128 ? ATT_UUID_SIZE : ATT_BT_UUID_SIZE;
+
+    if (s == skip)
+    {
+      continue;
+    }
+
+    setUuid(db.svcUuid[svc], pSpec->uuid, pSpec->ti128);
+    db.svcType[svc].len = uuidLen;
+    db.svcType[svc].uuid = db.svcUuid[svc];
+    db.svcStart[svc] = db.numAttrs;
+
+    addAttr(primaryServiceUUID, ATT_BT_UUID_SIZE, GATT_PERMIT_READ,
+            (uint8 *)&db.svcType[svc]);
+
+    for (c = 0; c < pSpec->numChars; c++)
+    {
+      const charSpec_t *pChar = &pSpec->chars[c];
+      uint16 decl = db.numAttrs;
+
+      // Declaration value: properties, value handle, value UUID
+      db.charDecl[decl][0] = pChar->props;
+      db.charDecl[decl][1] = LO_UINT16(decl + 2);
+      db.charDecl[decl][2] = HI_UINT16(decl + 2);
+      setUuid(&db.charDecl[decl][3], pChar->uuid, pSpec->ti128);
+      setUuid(db.charUuid[decl], pChar->uuid, pSpec->ti128);
+
+      addAttr(characterUUID, ATT_BT_UUID_SIZE, GATT_PERMIT_READ,
+              db.charDecl[decl]);
+      addAttr(db.charUuid[decl], uuidLen, GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+              NULL);
+      expectChars++;
+
+      if (pChar->flags & CHAR_CCC)
+      {
+        addAttr(clientCharCfgUUID, ATT_BT_UUID_SIZE,
+                GATT_PERMIT_READ | GATT_PERMIT_WRITE, NULL);
+        expectDescs++;
+      }
+
+      if (pChar->flags & CHAR_DESC)
+      {
+        addAttr(charUserDescUUID, ATT_BT_UUID_SIZE, GATT_PERMIT_READ, NULL);
+        expectDescs++;
+      }
+    }
+
+    db.svcNumAttrs[svc] = db.numAttrs - db.svcStart[svc];
+    db.numServices++;
+  }
+}
+
+// Register the services with the hash, as the profiles do
+static void hashDb(void)
+{
+  uint16 s;
+
+  gattDbHashValue = GATT_DB_HASH_INIT;
+
+  for (s = 0; s < db.numServices; s++)
+  {
+    VOID GATTDbHash_addService(&db.attrs[db.svcStart[s]], db.svcNumAttrs[s]);
+  }
+}
+
+/*
+ * ATT server: every request walks the attribute list from the start
+ */
+
+static unsigned long visits;
+
+static uint16 attrType(const gattAttribute_t *pAttr)
+{
+  if (pAttr->type.len != ATT_BT_UUID_SIZE)
+  {
+    return (0);
+  }
+
+  return (BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]));
+}
+
+// Find the first attribute at or after handle 'start'
+static int findAttr(uint16 start)
+{
+  int i;
+
+  for (i = 0; i < db.numAttrs; i++)
+  {
+    visits++;
+
+    if (db.attrs[i].handle >= start)
+    {
+      return (i);
+    }
+  }
+
+  return (-1);
+}
+
+// End handle of the group that starts at attribute 'i'
+static uint16 groupEnd(int i)
+{
+  for (i++; i < db.numAttrs; i++)
+  {
+    visits++;
+
+    if (attrType(&db.attrs[i]) == GATT_PRIMARY_SERVICE_UUID)
+    {
+      return (db.attrs[i].handle - 1);
+    }
+  }
+
+  return (0xFFFF);
+}
+
+// Read By Group Type Request for primary services; returns the number of
+// services in the response and sets the next start handle
+static int readByGroupType(uint16 start, uint16 mtu, uint16 *pNext,
+                           uint16 *pStart, uint16 *pEnd)
+{
+  int i = findAttr(start);
+  int found = 0;
+  uint16 used = 2;
+  uint8 entryLen = 0;
+
+  for (; (i >= 0) && (i < db.numAttrs); i++)
+  {
+    gattAttribute_t *pAttr = &db.attrs[i];
+    gattAttrType_t *pSvc;
+    uint16 end;
+
+    visits++;
+
+    if (attrType(pAttr) != GATT_PRIMARY_SERVICE_UUID)
+    {
+      continue;
+    }
+
+    pSvc = (gattAttrType_t *)pAttr->pValue;
+
+    // All entries in a response have the same length
+    if ((entryLen != 0) && (entryLen != 4 + pSvc->len))
+    {
+      break;
+    }
+
+    if (used + 4 + pSvc->len > mtu)
+    {
+      break;
+    }
+
+    entryLen = 4 + pSvc->len;
+    used += entryLen;
+    end = groupEnd(i);
+    *pNext = (end == 0xFFFF) ? 0 : end + 1;
+    pStart[found] = pAttr->handle;
+    pEnd[found] = end;
+    found++;
+  }
+
+  return (found);
+}
+
+// Read By Type Request for characteristic declarations in [start, end]
+static int readByTypeChar(uint16 start, uint16 end, uint16 mtu,
+                          uint16 *pNext, uint16 *pDecls)
+{
+  int i = findAttr(start);
+  int found = 0;
+  uint16 used = 2;
+  uint8 entryLen = 0;
+
+  for (; (i >= 0) && (i < db.numAttrs) && (db.attrs[i].handle <= end); i++)
+  {
+    gattAttribute_t *pAttr = &db.attrs[i];
+    uint8 uuidLen;
+
+    visits++;
+
+    if (attrType(pAttr) != GATT_CHARACTER_UUID)
+    {
+      continue;
+    }
+
+    uuidLen = db.attrs[i + 1].type.len;
+
+    if ((entryLen != 0) && (entryLen != 5 + uuidLen))
+    {
+      break;
+    }
+
+    if (used + 5 + uuidLen > mtu)
+    {
+      break;
+    }
+
+    entryLen = 5 + uuidLen;
+    used += entryLen;
+    pDecls[found++] = pAttr->handle;
+    *pNext = pAttr->handle + 1;
+  }
+
+  return (found);
+}
+
+// Find Information Request in [start, end]
+static int findInfo(uint16 start, uint16 end, uint16 mtu, uint16 *pNext)
+{
+  int i = findAttr(start);
+  int found = 0;
+  uint16 used = 2;
+  uint8 uuidLen = 0;
+
+  for (; (i >= 0) && (i < db.numAttrs) && (db.attrs[i].handle <= end); i++)
+  {
+    gattAttribute_t *pAttr = &db.attrs[i];
+
+    visits++;
+
+    // One UUID format per response
+    if ((uuidLen != 0) && (uuidLen != pAttr->type.len))
+    {
+      break;
+    }
+
+    if (used + 2 + pAttr->type.len > mtu)
+    {
+      break;
+    }
+
+    uuidLen = pAttr->type.len;
+    used += 2 + uuidLen;
+    *pNext = pAttr->handle + 1;
+    found++;
+  }
+
+  return (found);
+}
+
+/*
+ * Central: full primary service, characteristic and descriptor discovery
+ */
+
+typedef struct
+{
+  int requests;
+  int services;
+  int chars;
+  int descs;
+} discovery_t;
+
+static void discover(uint16 mtu, discovery_t *pResult)
+{
+  uint16 svcStart[MAX_SERVICES];
+  uint16 svcEnd[MAX_SERVICES];
+  int numSvcs = 0;
+  uint16 next = 1;
+  int s;
+
+  memset(pResult, 0, sizeof(*pResult));
+
+  // Primary services
+  while (next != 0)
+  {
+    int n;
+
+    pResult->requests++;
+    n = readByGroupType(next, mtu, &next, &svcStart[numSvcs],
+                        &svcEnd[numSvcs]);
+
+    if (n == 0)
+    {
+      break;
+    }
+
+    numSvcs += n;
+  }
+
+  pResult->services = numSvcs;
+
+  for (s = 0; s < numSvcs; s++)
+  {
+    uint16 decls[MAX_ATTRS];
+    int numDecls = 0;
+    int c;
+
+    // Characteristics of the service
+    next = svcStart[s];
+
+    for (;;)
+    {
+      int n;
+
+      pResult->requests++;
+      n = readByTypeChar(next, svcEnd[s], mtu, &next, &decls[numDecls]);
+
+      if (n == 0)
+      {
+        break;
+      }
+
+      numDecls += n;
+    }
+
+    pResult->chars += numDecls;
+
+    // Descriptors of each characteristic
+    for (c = 0; c < numDecls; c++)
+    {
+      uint16 end = (c + 1 < numDecls) ? decls[c + 1] - 1 :
+                   (svcEnd[s] == 0xFFFF ? db.numAttrs : svcEnd[s]);
+
+      next = decls[c] + 2;
+
+      while (next <= end)
+      {
+        int n;
+
+        pResult->requests++;
+        n = findInfo(next, end, mtu, &next);
+
+        if (n == 0)
+        {
+          break;
+        }
+
+        pResult->descs += n;
+      }
+    }
+  }
+}
+
+static double nowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e6 + ts.tv_nsec / 1e3);
+}
+
+int main(int argc, char **argv)
+{
+  uint16 mtu = (argc > 1) ? (uint16)atoi(argv[1]) : 23;
+  int connIntervalMs = (argc > 2) ? atoi(argv[2]) : 30;
+  discovery_t result;
+  double t0, us;
+  uint16 hash;
+  int failures = 0;
+  int i;
+
+  if ((mtu < 23) || (connIntervalMs <= 0))
+  {
+    fprintf(stderr, "usage: %s [ATT_MTU >= 23] [connection interval ms]\n",
+            argv[0]);
+    return (2);
+  }
+
+  buildDb(-1);
+
+  // Full discovery
+  visits = 0;
+  discover(mtu, &result);
+
+  printf("database: %d services, %d attributes, ATT_MTU %d\n",
+         (int)db.numServices, (int)db.numAttrs, mtu);
+  printf("full discovery: %d requests (%lu attributes visited), "
+         "%d services, %d characteristics, %d descriptors\n",
+         result.requests, visits, result.services, result.chars, result.descs);
+
+  if ((result.services != db.numServices) || (result.chars != expectChars) ||
+      (result.descs != expectDescs))
+  {
+    printf("FAIL: discovery found %d/%d/%d, expected %d/%d/%d\n",
+           result.services, result.chars, result.descs,
+           (int)db.numServices, expectChars, expectDescs);
+    failures++;
+  }
+
+  t0 = nowUs();
+  for (i = 0; i < NUM_TRIALS; i++)
+  {
+    discover(mtu, &result);
+  }
+  us = (nowUs() - t0) / NUM_TRIALS;
+
+  printf("server work: %.2f us per full discovery on this host\n", us);
+  printf("link time: about %d ms at one ATT transaction per %d ms interval\n",
+         result.requests * connIntervalMs, connIntervalMs);
+
+  // Database unchanged fast path
+  nvValid = FALSE;
+  serviceChangedCount = 0;
+
+  hashDb();
+  hash = GATTDbHash_get();
+  if (GATTDbHash_commit() != FALSE || serviceChangedCount != 1)
+  {
+    printf("FAIL: first boot must store the hash and flag Service Changed\n");
+    failures++;
+  }
+
+  hashDb();
+  if (GATTDbHash_commit() != TRUE || serviceChangedCount != 1)
+  {
+    printf("FAIL: unchanged database must not flag Service Changed\n");
+    failures++;
+  }
+  else
+  {
+    printf("reconnect, database unchanged (hash 0x%04X): 0 requests, 0 ms\n",
+           hash);
+  }
+
+  // Drop a service: the hash must change and clients must rediscover
+  buildDb(NUM_SERVICES - 1);
+  hashDb();
+  if ((GATTDbHash_get() == hash) || (GATTDbHash_commit() != FALSE) ||
+      (serviceChangedCount != 2))
+  {
+    printf("FAIL: changed database must flag Service Changed\n");
+    failures++;
+  }
+  else
+  {
+    discover(mtu, &result);
+    printf("reconnect, database changed (hash 0x%04X): %d requests, "
+           "about %d ms\n", GATTDbHash_get(), result.requests,
+           result.requests * connIntervalMs);
+  }
+
+  // Same services, different permissions: still a change
+  buildDb(-1);
+  db.attrs[db.numAttrs - 1].permissions |= GATT_PERMIT_WRITE;
+  hashDb();
+  if (GATTDbHash_get() == hash)
+  {
+    printf("FAIL: permission change not covered by the hash\n");
+    failures++;
+  }
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("gatt_discovery_sim: OK\n");
+
+  return (0);
+}
@@ -0,0 +1,296 @@
+/*
+ * Host test and benchmark for GATT_FindUUIDRec in
+ * Sensortag_cc2640r2lp_stack/Host/gatt_uuid.c (the application copy is
+ * identical).
+ *
+ * gatt_uuid.c only includes SDK headers for types and osal helpers, so it
+ * is compiled here with its #include lines removed and the stand-ins
+ * below. The checks cover:
+ * - every 16-bit UUID returns its own 2-byte record;
+ * - every 128-bit UUID on the Bluetooth or the TI base returns a 16-byte
+ *   record equal to the query, built once and then handed out again;
+ * - unknown UUIDs and other bases return NULL.
+ * The benchmark times the lookups against the switch the table replaced
+ * and prints the flash used by the TI alias list.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed '/^#include /d' Sensortag_cc2640r2lp_stack/Host/gatt_uuid.c > _host_tests/gatt_uuid_body.inc
+ *   gcc -std=gnu99 -Wall -O2 -Itests/host/stubs -I_host_tests \
+ *       -ISensortag_cc2640r2lp_stack/Host \
+ *       -o _host_tests/gatt_uuid_bench tests/host/gatt_uuid_bench.c
+ *   _host_tests/gatt_uuid_bench
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_types.h"
+
+#define NUM_ROUNDS            20000
+
+#define GATT_TI_UUID_128_BIT
+
+#define CONST                 const
+#define GENERIC
+
+#define ATT_BT_UUID_SIZE      2
+#define ATT_UUID_SIZE         16
+
+#define LO_UINT16(a)          ((a) & 0xFF)
+#define HI_UINT16(a)          (((a) >> 8) & 0xFF)
+#define BUILD_UINT16(lo, hi)  ((uint16)(((lo) & 0xFF) + (((hi) & 0xFF) << 8)))
+
+// Bluetooth Base UUID: 00000000-0000-1000-8000-00805F9B34FB
+static CONST uint8 btBaseUUID[ATT_UUID_SIZE] =
+{
+  0xFB, 0x34, 0x9B, 0x5F, 0x80, 0x00, 0x00, 0x80,
+  0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static int numAllocs;
+
+static uint8 osal_memcmp(const void *src1, const void *src2, unsigned int len)
+{
+  return (memcmp(src1, src2, len) == 0);
+}
+
+static void *osal_memcpy(void *dst, const void *src, unsigned int len)
+{
+  return ((uint8 *)memcpy(dst, src, len) + len);
+}
+
+static void *osal_mem_alloc(uint16 size)
+{
+  numAllocs++;
+
+  return (malloc(size));
+}
+
+#include "gatt_uuid.h"
+#include "gatt_uuid_body.inc"
+
+/*
+ * The switch GATT_FindUUIDRec used before the tables, for comparison.
+ * It did not resolve 128-bit UUIDs.
+ */
+static const uint8 *switchFindUUIDRec(const uint8 *pUUID, uint8 len)
+{
+  const uint8 *pRec = NULL;
+
+  if (len == ATT_BT_UUID_SIZE)
+  {
+    switch (BUILD_UINT16(pUUID[0], pUUID[1]))
+    {
+      case GAP_SERVICE_UUID:            pRec = gapServiceUUID;        break;
+      case GATT_SERVICE_UUID:           pRec = gattServiceUUID;       break;
+      case GATT_PRIMARY_SERVICE_UUID:   pRec = primaryServiceUUID;    break;
+      case GATT_SECONDARY_SERVICE_UUID: pRec = secondaryServiceUUID;  break;
+      case GATT_INCLUDE_UUID:           pRec = includeUUID;           break;
+      case GATT_CHARACTER_UUID:         pRec = characterUUID;         break;
+      case GATT_CHAR_EXT_PROPS_UUID:    pRec = charExtPropsUUID;      break;
+      case GATT_CHAR_USER_DESC_UUID:    pRec = charUserDescUUID;      break;
+      case GATT_CLIENT_CHAR_CFG_UUID:   pRec = clientCharCfgUUID;     break;
+      case GATT_SERV_CHAR_CFG_UUID:     pRec = servCharCfgUUID;       break;
+      case GATT_CHAR_FORMAT_UUID:       pRec = charFormatUUID;        break;
+      case GATT_CHAR_AGG_FORMAT_UUID:   pRec = charAggFormatUUID;     break;
+      case GATT_VALID_RANGE_UUID:       pRec = validRangeUUID;        break;
+      case GATT_EXT_REPORT_REF_UUID:    pRec = extReportRefUUID;      break;
+      case GATT_REPORT_REF_UUID:        pRec = reportRefUUID;         break;
+      case DEVICE_NAME_UUID:            pRec = deviceNameUUID;        break;
+      case APPEARANCE_UUID:             pRec = appearanceUUID;        break;
+      case RECONNECT_ADDR_UUID:         pRec = reconnectAddrUUID;     break;
+      case PERI_PRIVACY_FLAG_UUID:      pRec = periPrivacyFlagUUID;   break;
+      case PERI_CONN_PARAM_UUID:        pRec = periConnParamUUID;     break;
+      case SERVICE_CHANGED_UUID:        pRec = serviceChangedUUID;    break;
+      default:                                                        break;
+    }
+  }
+
+  return (pRec);
+}
+
+// A query as it arrives in an ATT request
+typedef struct
+{
+  uint8 uuid[ATT_UUID_SIZE];
+  uint8 len;
+} query_t;
+
+static void make16(query_t *pQuery, uint16 uuid)
+{
+  pQuery->uuid[0] = LO_UINT16(uuid);
+  pQuery->uuid[1] = HI_UINT16(uuid);
+  pQuery->len = ATT_BT_UUID_SIZE;
+}
+
+static void makeBt128(query_t *pQuery, uint16 uuid)
+{
+  memcpy(pQuery->uuid, btBaseUUID, ATT_UUID_SIZE);
+  pQuery->uuid[UUID_ALIAS_OFFSET] = LO_UINT16(uuid);
+  pQuery->uuid[UUID_ALIAS_OFFSET + 1] = HI_UINT16(uuid);
+  pQuery->len = ATT_UUID_SIZE;
+}
+
+static void makeTi128(query_t *pQuery, uint16 uuid)
+{
+  memcpy(pQuery->uuid, tiBaseUUID, UUID_ALIAS_OFFSET);
+  pQuery->uuid[UUID_ALIAS_OFFSET] = LO_UINT16(uuid);
+  pQuery->uuid[UUID_ALIAS_OFFSET + 1] = HI_UINT16(uuid);
+  memcpy(&pQuery->uuid[UUID_ALIAS_OFFSET + 2], &tiBaseUUID[UUID_ALIAS_OFFSET],
+         ATT_UUID_SIZE - UUID_ALIAS_OFFSET - 2);
+  pQuery->len = ATT_UUID_SIZE;
+}
+
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+typedef const uint8 *(*findFn_t)(const uint8 *pUUID, uint8 len);
+
+static double timeLookups(findFn_t find, const query_t *pQueries, int num)
+{
+  volatile uintptr_t sink = 0;
+  double t0 = nowNs();
+  int r, i;
+
+  for (r = 0; r < NUM_ROUNDS; r++)
+  {
+    for (i = 0; i < num; i++)
+    {
+      sink += (uintptr_t)find(pQueries[i].uuid, pQueries[i].len);
+    }
+  }
+
+  (void)sink;
+
+  return ((nowNs() - t0) / ((double)NUM_ROUNDS * num));
+}
+
+#define NUM_STD     UUID_TBL_SIZE(gattUUIDTbl)
+#define NUM_TI      UUID_TBL_SIZE(tiUUIDTbl)
+
+int main(void)
+{
+  query_t std16[NUM_STD], std128[NUM_STD], ti128[NUM_TI], unknown[4];
+  const uint8 *pRec, *pAgain;
+  int failures = 0;
+  int i;
+
+  // Both tables are binary searched
+  for (i = 1; i < NUM_STD; i++)
+  {
+    if (gattUUIDTbl[i - 1].uuid >= gattUUIDTbl[i].uuid)
+    {
+      printf("FAIL: gattUUIDTbl not sorted at 0x%04X\n", gattUUIDTbl[i].uuid);
+      failures++;
+    }
+  }
+  for (i = 1; i < NUM_TI; i++)
+  {
+    if (tiUUIDTbl[i - 1] >= tiUUIDTbl[i])
+    {
+      printf("FAIL: tiUUIDTbl not sorted at 0x%04X\n", tiUUIDTbl[i]);
+      failures++;
+    }
+  }
+
+  // 16-bit UUIDs: their own 2-byte record
+  for (i = 0; i < NUM_STD; i++)
+  {
+    make16(&std16[i], gattUUIDTbl[i].uuid);
+    pRec = GATT_FindUUIDRec(std16[i].uuid, std16[i].len);
+
+    if ((pRec != gattUUIDTbl[i].pRec) ||
+        memcmp(pRec, std16[i].uuid, ATT_BT_UUID_SIZE) != 0)
+    {
+      printf("FAIL: 16-bit 0x%04X\n", gattUUIDTbl[i].uuid);
+      failures++;
+    }
+  }
+
+  // 128-bit UUIDs: a 16-byte record equal to the query, built only once
+  for (i = 0; i < NUM_STD + NUM_TI; i++)
+  {
+    query_t *pQuery = (i < NUM_STD) ? &std128[i] : &ti128[i - NUM_STD];
+    uint16 uuid;
+
+    if (i < NUM_STD)
+    {
+      uuid = gattUUIDTbl[i].uuid;
+      makeBt128(pQuery, uuid);
+    }
+    else
+    {
+      uuid = tiUUIDTbl[i - NUM_STD];
+      makeTi128(pQuery, uuid);
+    }
+
+    pRec = GATT_FindUUIDRec(pQuery->uuid, pQuery->len);
+    pAgain = GATT_FindUUIDRec(pQuery->uuid, pQuery->len);
+
+    if ((pRec == NULL) || (pRec != pAgain) ||
+        memcmp(pRec, pQuery->uuid, ATT_UUID_SIZE) != 0)
+    {
+      printf("FAIL: 128-bit %s 0x%04X\n", (i < NUM_STD) ? "BT" : "TI", uuid);
+      failures++;
+    }
+  }
+
+  if (numAllocs != NUM_STD + NUM_TI)
+  {
+    printf("FAIL: %d records built for %d 128-bit UUIDs\n", numAllocs,
+           (int)(NUM_STD + NUM_TI));
+    failures++;
+  }
+
+  // Not resolved: TI alias as 16-bit, unknown alias, unknown base, bad length
+  make16(&unknown[0], tiUUIDTbl[0]);
+  makeTi128(&unknown[1], 0xAA00);
+  makeBt128(&unknown[2], GAP_SERVICE_UUID);
+  unknown[2].uuid[0] ^= 0x01;
+  make16(&unknown[3], GAP_SERVICE_UUID);
+  unknown[3].len = 4;
+
+  for (i = 0; i < 4; i++)
+  {
+    if (GATT_FindUUIDRec(unknown[i].uuid, unknown[i].len) != NULL)
+    {
+      printf("FAIL: unknown UUID %d resolved\n", i);
+      failures++;
+    }
+  }
+
+  printf("lookup, ns per call:   switch   table\n");
+  printf("  16-bit standard     %7.1f %7.1f\n",
+         timeLookups(switchFindUUIDRec, std16, NUM_STD),
+         timeLookups(GATT_FindUUIDRec, std16, NUM_STD));
+  printf("  128-bit BT base           - %7.1f\n",
+         timeLookups(GATT_FindUUIDRec, std128, NUM_STD));
+  printf("  128-bit TI base           - %7.1f\n",
+         timeLookups(GATT_FindUUIDRec, ti128, NUM_TI));
+  printf("  unknown           %7.1f %7.1f\n",
+         timeLookups(switchFindUUIDRec, unknown, 4),
+         timeLookups(GATT_FindUUIDRec, unknown, 4));
+
+  printf("TI aliases: %d, flash %d bytes (base %d + aliases %d); "
+         "a 16-byte record per alias would take %d\n",
+         (int)NUM_TI, (int)(sizeof(tiBaseUUID) + sizeof(tiUUIDTbl)),
+         (int)sizeof(tiBaseUUID), (int)sizeof(tiUUIDTbl),
+         (int)(NUM_TI * ATT_UUID_SIZE + sizeof(tiUUIDTbl)));
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("gatt_uuid_bench: OK\n");
+
+  return (0);
+}
@@ -0,0 +1,122 @@
+/*
+ * Generator for the TI 128-bit UUID alias list (GATT_TI_UUID_ALIASES) in
+ * gatt_uuid.c.
+ *
+ * Reads the service headers given on the command line, collects every
+ * "#define <NAME>_UUID 0x<alias>" and prints the alias list sorted by
+ * alias value, ready to paste into gatt_uuid.c. Fails on an alias that
+ * is defined twice.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   gcc -std=gnu99 -Wall -o _host_tests/gatt_uuid_gen tests/host/gatt_uuid_gen.c
+ *   P=SensorTag_cc2640r2lp_app/PROFILES
+ *   _host_tests/gatt_uuid_gen $P/ioservice.h $P/registerservice.h \
+ *       $P/recorderservice.h $P/diagservice.h $P/ccservice.h
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ALIASES   256
+#define MAX_NAME      64
+
+typedef struct
+{
+  unsigned alias;
+  char name[MAX_NAME];
+} alias_t;
+
+static alias_t aliases[MAX_ALIASES];
+static int numAliases;
+
+static int cmpAlias(const void *a, const void *b)
+{
+  return ((int)((const alias_t *)a)->alias - (int)((const alias_t *)b)->alias);
+}
+
+static int readHeader(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[256];
+
+  if (f == NULL)
+  {
+    perror(path);
+    return (-1);
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    char name[MAX_NAME];
+    unsigned alias;
+    size_t len;
+
+    if (sscanf(line, "#define %63s 0x%x", name, &alias) != 2)
+    {
+      continue;
+    }
+
+    len = strlen(name);
+    if ((len < 5) || (strcmp(&name[len - 5], "_UUID") != 0) ||
+        (alias > 0xFFFF))
+    {
+      continue;
+    }
+
+    if (numAliases == MAX_ALIASES)
+    {
+      fprintf(stderr, "%s: too many aliases\n", path);
+      fclose(f);
+      return (-1);
+    }
+
+    aliases[numAliases].alias = alias;
+    strcpy(aliases[numAliases].name, name);
+    numAliases++;
+  }
+
+  fclose(f);
+
+  return (0);
+}
+
+int main(int argc, char **argv)
+{
+  int i;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s service.h...\n", argv[0]);
+    return (2);
+  }
+
+  for (i = 1; i < argc; i++)
+  {
+    if (readHeader(argv[i]) != 0)
+    {
+      return (1);
+    }
+  }
+
+  qsort(aliases, numAliases, sizeof(aliases[0]), cmpAlias);
+
+  for (i = 1; i < numAliases; i++)
+  {
+    if (aliases[i].alias == aliases[i - 1].alias)
+    {
+      fprintf(stderr, "alias 0x%04X defined as %s and %s\n", aliases[i].alias,
+              aliases[i - 1].name, aliases[i].name);
+      return (1);
+    }
+  }
+
+  printf("#define GATT_TI_UUID_ALIASES( X ) \\\n");
+  for (i = 0; i < numAliases; i++)
+  {
+    printf("  X( 0x%04X ) /* %s */%s\n", aliases[i].alias, aliases[i].name,
+           (i + 1 < numAliases) ? " \\" : "");
+  }
+
+  return (0);
+}
@@ -0,0 +1,187 @@
+/*
+ * Host test for HEAPMGR_REALLOC in SensorTag_cc2640r2lp_app/ICall/heapmgr.h.
+ *
+ * Runs random malloc, realloc and free steps over a small heap. After each
+ * step it checks that every live block kept its content, that a failed
+ * realloc left the block untouched, that HEAPMGR_SANITY_CHECK passes and that
+ * the allocated byte count matches the live blocks. With HEAPMGR_IDLE_MAINT
+ * it also runs the idle maintenance every few steps and checks that the
+ * small-block bucket was both grown and shrunk.
+ *
+ * Build and run from the repository root, with and without the tracer or
+ * the idle maintenance:
+ *   gcc -std=gnu99 -Wall -ISensorTag_cc2640r2lp_app/ICall \
+ *       -o heapmgr_realloc_test tests/host/heapmgr_realloc_test.c && ./heapmgr_realloc_test
+ *   gcc -std=gnu99 -Wall -ISensorTag_cc2640r2lp_app/ICall -DHEAPMGR_TRACE \
+ *       -o heapmgr_realloc_test tests/host/heapmgr_realloc_test.c && ./heapmgr_realloc_test
+ *   gcc -std=gnu99 -Wall -ISensorTag_cc2640r2lp_app/ICall -DHEAPMGR_IDLE_MAINT \
+ *       -o heapmgr_realloc_test tests/host/heapmgr_realloc_test.c && ./heapmgr_realloc_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define HEAPMGR_SIZE    4000
+#define HEAPMGR_METRICS
+
+// heapmgr.h picks its header alignment per target; use the 32-bit one.
+#ifndef i386
+#define i386 1
+#endif
+
+// heapmgr.h expects its includer to declare the entry points, as icall.c does
+void *heapmgrMalloc(uint16_t size);
+void heapmgrFree(void *ptr);
+#include <heapmgr.h>
+
+#define NUM_BLOCKS  40
+#define NUM_STEPS   200000
+#define MAX_SIZE    120
+#define MAINT_STEPS 8
+
+static void *blk[NUM_BLOCKS];
+static uint16_t blkSize[NUM_BLOCKS];
+
+static int checkFill(const void *ptr, uint16_t size, int i)
+{
+  const uint8_t *p = ptr;
+  uint16_t k;
+
+  for (k = 0; k < size; k++)
+  {
+    if (p[k] != (uint8_t) i)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(void)
+{
+  long inPlace = 0, moved = 0, failed = 0;
+#ifdef HEAPMGR_IDLE_MAINT
+  long grown = 0, shrunk = 0;
+#endif
+  int step;
+
+  heapmgrInit();
+  srand(1);
+
+  for (step = 0; step < NUM_STEPS; step++)
+  {
+    int i = rand() % NUM_BLOCKS;
+    uint16_t size = (uint16_t) (1 + rand() % MAX_SIZE);
+    hmU16_t blkMax, blkCnt, blkFree, memAlo, memMax, memUB;
+    unsigned live = 0;
+    int k;
+
+    if (blk[i] == NULL)
+    {
+      blk[i] = heapmgrMalloc(size);
+      if (blk[i] != NULL)
+      {
+        blkSize[i] = size;
+        memset(blk[i], i, size);
+      }
+    }
+    else if (rand() % 3 == 0)
+    {
+      if (!checkFill(blk[i], blkSize[i], i))
+      {
+        printf("step %d: block %d corrupted before free\n", step, i);
+        return 1;
+      }
+      heapmgrFree(blk[i]);
+      blk[i] = NULL;
+    }
+    else
+    {
+      void *newBlk = heapmgrRealloc(blk[i], size);
+
+      if (newBlk == NULL)
+      {
+        failed++;
+        if (!checkFill(blk[i], blkSize[i], i))
+        {
+          printf("step %d: failed realloc changed block %d\n", step, i);
+          return 1;
+        }
+      }
+      else
+      {
+        if (!checkFill(newBlk, size < blkSize[i] ? size : blkSize[i], i))
+        {
+          printf("step %d: realloc lost the content of block %d\n", step, i);
+          return 1;
+        }
+        if (newBlk == blk[i])
+        {
+          inPlace++;
+        }
+        else
+        {
+          moved++;
+        }
+        blk[i] = newBlk;
+        blkSize[i] = size;
+        memset(newBlk, i, size);
+      }
+    }
+
+#ifdef HEAPMGR_IDLE_MAINT
+    if (step % MAINT_STEPS == 0)
+    {
+      heapmgrHdr_t *ff2 = HEAPMGR_FF2;
+
+      heapmgrMaintain();
+      grown += (HEAPMGR_FF2 > ff2);
+      shrunk += (HEAPMGR_FF2 < ff2);
+    }
+#endif
+
+    if (HEAPMGR_SANITY_CHECK() != 0)
+    {
+      printf("step %d: heap sanity check failed\n", step);
+      return 1;
+    }
+
+    // The allocated bytes are the live blocks plus the end of heap marker
+    heapmgrGetMetrics(&blkMax, &blkCnt, &blkFree, &memAlo, &memMax, &memUB);
+    for (k = 0; k < NUM_BLOCKS; k++)
+    {
+      if (blk[k] != NULL)
+      {
+        live += *(heapmgrHdr_t *) ((uint8_t *) blk[k] - HDRSZ) & ~HEAPMGR_IN_USE;
+      }
+    }
+    if (memAlo != live + HDRSZ)
+    {
+      printf("step %d: %u bytes allocated, %u expected\n",
+             step, (unsigned) memAlo, live + HDRSZ);
+      return 1;
+    }
+  }
+
+  if (inPlace == 0 || moved == 0)
+  {
+    printf("realloc paths not covered: %ld in place, %ld moved\n",
+           inPlace, moved);
+    return 1;
+  }
+
+#ifdef HEAPMGR_IDLE_MAINT
+  if (grown == 0 || shrunk == 0)
+  {
+    printf("bucket not rebalanced: %ld grown, %ld shrunk\n", grown, shrunk);
+    return 1;
+  }
+  printf("bucket grown %ld and shrunk %ld times, %d bytes now\n", grown,
+         shrunk, (int) ((uint8_t *) HEAPMGR_FF2 - HEAPMGR_HEAP));
+#endif
+
+  printf("heapmgr_realloc_test: ok (%ld in place, %ld moved, %ld failed)\n",
+         inPlace, moved, failed);
+  return 0;
+}
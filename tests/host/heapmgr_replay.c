@@ -0,0 +1,687 @@
+/*
+ * Replays a heap trace recorded with HEAPMGR_TRACE against the real
+ * heapmgr.h at a range of heap sizes, and against a best-fit allocator with
+ * the same block header, to size HEAPMGR_SIZE.
+ *
+ * For each heap size it reports the peak memory in use, the fragmentation
+ * (share of the free space outside the largest free block) and the first
+ * record that fails to allocate, with its caller.
+ *
+ * The trace is a dump of heapmgrTraceBuf, oldest record first, i.e. starting
+ * at index heapmgrTraceCnt % HEAPMGR_TRACE_LEN. One record per line, fields
+ * in the order of heapmgrTrace_t, numbers in C notation:
+ *
+ *   time caller offset size op
+ *
+ * op is 0 (malloc), 1 (free) or 2 (realloc in place); a realloc that moved
+ * the block is recorded as a malloc and a free. Lines starting with # are
+ * comments. Blocks freed in the trace but allocated before it are skipped.
+ *
+ * Build and run from the repository root:
+ *   gcc -std=gnu11 -Wall -ISensorTag_cc2640r2lp_app/ICall \
+ *       -o heapmgr_replay tests/host/heapmgr_replay.c
+ *   ./heapmgr_replay tests/host/data/heapmgr_trace.txt
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define HEAPMGR_METRICS
+
+// heapmgr.h picks its header alignment per target; use the 32-bit one.
+#ifndef i386
+#define i386 1
+#endif
+
+typedef struct
+{
+  unsigned size;
+  void (*init)(void);
+  void *(*malloc)(uint16_t size);
+  void (*free)(void *ptr);
+  void *(*realloc)(void *ptr, uint16_t size);
+  void (*freeStats)(unsigned *pFree, unsigned *pLargest);
+  unsigned (*peakUse)(void);
+  int (*sanityCheck)(void);
+} ReplayHeap;
+
+#define REPLAY_HEAP_SIZE 1024
+#define REPLAY_HEAP_NAME heap1024_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 1536
+#define REPLAY_HEAP_NAME heap1536_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 2048
+#define REPLAY_HEAP_NAME heap2048_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 3072
+#define REPLAY_HEAP_NAME heap3072_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 4096
+#define REPLAY_HEAP_NAME heap4096_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 6144
+#define REPLAY_HEAP_NAME heap6144_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 8192
+#define REPLAY_HEAP_NAME heap8192_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 12288
+#define REPLAY_HEAP_NAME heap12288_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 16384
+#define REPLAY_HEAP_NAME heap16384_
+#include "heapmgr_replay_heap.h"
+
+static const ReplayHeap *replayHeaps[] =
+{
+  &heap1024_Entry, &heap1536_Entry, &heap2048_Entry, &heap3072_Entry,
+  &heap4096_Entry, &heap6144_Entry, &heap8192_Entry, &heap12288_Entry,
+  &heap16384_Entry
+};
+
+#define NUM_HEAPS  (sizeof(replayHeaps) / sizeof(replayHeaps[0]))
+
+/*********************************************************************
+ * Trace
+ */
+
+// heapmgrTrace_t ops: HEAPMGR_TRACE_MALLOC, _FREE and _REALLOC
+#define OP_MALLOC   0
+#define OP_FREE     1
+#define OP_REALLOC  2
+
+#define NO_OFFSET   0xFFFFFFFFu
+
+typedef struct
+{
+  uint32_t time;
+  uint32_t caller;
+  uint32_t offset;
+  uint16_t size;
+  uint8_t  op;
+} Record;
+
+static Record *trace;
+static unsigned numRecords;
+
+static int loadTrace(const char *path)
+{
+  char line[256];
+  unsigned cap = 0;
+  unsigned lineNo = 0;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    return 0;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    unsigned long v[5];
+    char *p = line;
+    int i;
+
+    lineNo++;
+    while (*p == ' ' || *p == '\t')
+    {
+      p++;
+    }
+    if (*p == '#' || *p == '\n' || *p == '\0')
+    {
+      continue;
+    }
+
+    for (i = 0; i < 5; i++)
+    {
+      char *end;
+
+      v[i] = strtoul(p, &end, 0);
+      if (end == p)
+      {
+        fprintf(stderr, "%s:%u: expected 5 fields\n", path, lineNo);
+        fclose(f);
+        return 0;
+      }
+      p = end;
+    }
+    if (v[4] > OP_REALLOC)
+    {
+      fprintf(stderr, "%s:%u: unknown op %lu\n", path, lineNo, v[4]);
+      fclose(f);
+      return 0;
+    }
+
+    if (numRecords == cap)
+    {
+      cap = cap ? cap * 2 : 1024;
+      trace = realloc(trace, cap * sizeof(Record));
+      if (trace == NULL)
+      {
+        fclose(f);
+        return 0;
+      }
+    }
+    trace[numRecords].time = (uint32_t) v[0];
+    trace[numRecords].caller = (uint32_t) v[1];
+    trace[numRecords].offset = (uint32_t) v[2];
+    trace[numRecords].size = (uint16_t) v[3];
+    trace[numRecords].op = (uint8_t) v[4];
+    numRecords++;
+  }
+
+  fclose(f);
+  return 1;
+}
+
+/*********************************************************************
+ * Blocks live in the replay, by their offset in the traced heap
+ */
+
+typedef struct
+{
+  uint32_t offset;
+  void *ptr;       // Replayed block, NULL if its allocation failed
+  uint16_t size;
+} Live;
+
+static Live *live;
+static unsigned numLive;
+
+static Live *findLive(uint32_t offset)
+{
+  unsigned i;
+
+  for (i = 0; i < numLive; i++)
+  {
+    if (live[i].offset == offset)
+    {
+      return &live[i];
+    }
+  }
+  return NULL;
+}
+
+static void addLive(uint32_t offset, void *ptr, uint16_t size)
+{
+  Live *l = findLive(offset);
+
+  if (l == NULL)
+  {
+    live = realloc(live, (numLive + 1) * sizeof(Live));
+    l = &live[numLive++];
+  }
+  l->offset = offset;
+  l->ptr = ptr;
+  l->size = size;
+}
+
+static void removeLive(Live *l)
+{
+  *l = live[--numLive];
+}
+
+/*********************************************************************
+ * Best-fit allocator with the heapmgr block header, for comparison
+ */
+
+#define ALT_HDRSZ  4
+#define ALT_MAX    65536
+
+typedef struct
+{
+  uint32_t start;
+  uint32_t size;  // Including the header
+  uint8_t  used;
+} AltBlock;
+
+static AltBlock altBlocks[ALT_MAX / 8];
+static unsigned altNum;
+static unsigned altCap;
+static unsigned altUse;
+static unsigned altPeak;
+static uint8_t altMem[ALT_MAX];
+
+static void altInit(unsigned size)
+{
+  // The end of heap marker takes a header, as in heapmgr
+  altCap = (size / ALT_HDRSZ) * ALT_HDRSZ - ALT_HDRSZ;
+  altBlocks[0].start = 0;
+  altBlocks[0].size = altCap;
+  altBlocks[0].used = 0;
+  altNum = 1;
+  altUse = ALT_HDRSZ;
+  altPeak = altUse;
+}
+
+static void *altMalloc(uint16_t size)
+{
+  uint32_t need = (size + ALT_HDRSZ + 3) & ~3u;
+  unsigned best = altNum;
+  unsigned i;
+
+  for (i = 0; i < altNum; i++)
+  {
+    if (!altBlocks[i].used && altBlocks[i].size >= need &&
+        (best == altNum || altBlocks[i].size < altBlocks[best].size))
+    {
+      best = i;
+    }
+  }
+  if (best == altNum)
+  {
+    return NULL;
+  }
+
+  if (altBlocks[best].size - need >= ALT_HDRSZ + 4)
+  {
+    memmove(&altBlocks[best + 2], &altBlocks[best + 1],
+            (altNum - best - 1) * sizeof(AltBlock));
+    altBlocks[best + 1].start = altBlocks[best].start + need;
+    altBlocks[best + 1].size = altBlocks[best].size - need;
+    altBlocks[best + 1].used = 0;
+    altBlocks[best].size = need;
+    altNum++;
+  }
+  altBlocks[best].used = 1;
+  altUse += altBlocks[best].size;
+  if (altUse > altPeak)
+  {
+    altPeak = altUse;
+  }
+  return &altMem[altBlocks[best].start + ALT_HDRSZ];
+}
+
+static unsigned altIndex(void *ptr)
+{
+  uint32_t start = (uint32_t) ((uint8_t *) ptr - altMem) - ALT_HDRSZ;
+  unsigned lo = 0, hi = altNum;
+
+  while (lo < hi)
+  {
+    unsigned mid = (lo + hi) / 2;
+
+    if (altBlocks[mid].start < start)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void altFree(void *ptr)
+{
+  unsigned i = altIndex(ptr);
+
+  altBlocks[i].used = 0;
+  altUse -= altBlocks[i].size;
+
+  // Merge with the free neighbours
+  if (i + 1 < altNum && !altBlocks[i + 1].used)
+  {
+    altBlocks[i].size += altBlocks[i + 1].size;
+    memmove(&altBlocks[i + 1], &altBlocks[i + 2],
+            (altNum - i - 2) * sizeof(AltBlock));
+    altNum--;
+  }
+  if (i > 0 && !altBlocks[i - 1].used)
+  {
+    altBlocks[i - 1].size += altBlocks[i].size;
+    memmove(&altBlocks[i], &altBlocks[i + 1],
+            (altNum - i - 1) * sizeof(AltBlock));
+    altNum--;
+  }
+}
+
+static void *altRealloc(void *ptr, uint16_t size)
+{
+  unsigned i = altIndex(ptr);
+  uint16_t old = (uint16_t) (altBlocks[i].size - ALT_HDRSZ);
+  void *newPtr;
+
+  if (size <= old)
+  {
+    return ptr;
+  }
+
+  newPtr = altMalloc(size);
+  if (newPtr != NULL)
+  {
+    memcpy(newPtr, ptr, old);
+    altFree(ptr);
+  }
+  return newPtr;
+}
+
+static void altFreeStats(unsigned *pFree, unsigned *pLargest)
+{
+  unsigned i;
+
+  *pFree = 0;
+  *pLargest = 0;
+  for (i = 0; i < altNum; i++)
+  {
+    if (!altBlocks[i].used)
+    {
+      *pFree += altBlocks[i].size - ALT_HDRSZ;
+      if (altBlocks[i].size - ALT_HDRSZ > *pLargest)
+      {
+        *pLargest = altBlocks[i].size - ALT_HDRSZ;
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * Replay
+ */
+
+typedef struct
+{
+  unsigned size;
+  void (*init)(unsigned size);
+  void *(*malloc)(uint16_t size);
+  void (*free)(void *ptr);
+  void *(*realloc)(void *ptr, uint16_t size);
+  void (*freeStats)(unsigned *pFree, unsigned *pLargest);
+  unsigned (*peakUse)(void);
+  int (*sanityCheck)(void);
+} Allocator;
+
+typedef struct
+{
+  unsigned failures;
+  unsigned firstFail;     // Record index, numRecords if none
+  unsigned peak;          // Peak bytes in use, headers included
+  unsigned fragPct;       // At the first failure, else at the peak
+  int broken;             // Sanity check failed
+} Result;
+
+static unsigned fragPct(const Allocator *a)
+{
+  unsigned freeBytes, largest;
+
+  a->freeStats(&freeBytes, &largest);
+  return freeBytes ? (freeBytes - largest) * 100 / freeBytes : 0;
+}
+
+static void replay(const Allocator *a, Result *r)
+{
+  unsigned peakSeen = 0;
+  unsigned i;
+
+  memset(r, 0, sizeof(*r));
+  r->firstFail = numRecords;
+  numLive = 0;
+  a->init(a->size);
+
+  for (i = 0; i < numRecords; i++)
+  {
+    const Record *rec = &trace[i];
+    Live *l = findLive(rec->offset);
+    int failed = 0;
+
+    switch (rec->op)
+    {
+      case OP_MALLOC:
+        if (rec->offset == NO_OFFSET)
+        {
+          // Failed on the target as well; nothing to free later
+          break;
+        }
+        {
+          void *ptr = a->malloc(rec->size);
+
+          addLive(rec->offset, ptr, rec->size);
+          failed = (ptr == NULL);
+        }
+        break;
+
+      case OP_FREE:
+        if (l != NULL)
+        {
+          if (l->ptr != NULL)
+          {
+            a->free(l->ptr);
+          }
+          removeLive(l);
+        }
+        break;
+
+      case OP_REALLOC:
+        if (l != NULL && l->ptr != NULL)
+        {
+          void *ptr = a->realloc(l->ptr, rec->size);
+
+          if (ptr != NULL)
+          {
+            l->ptr = ptr;
+            l->size = rec->size;
+          }
+          failed = (ptr == NULL);
+        }
+        break;
+    }
+
+    if (a->sanityCheck != NULL && a->sanityCheck() != 0)
+    {
+      r->broken = 1;
+      return;
+    }
+
+    if (failed)
+    {
+      if (r->failures++ == 0)
+      {
+        r->firstFail = i;
+        r->fragPct = fragPct(a);
+      }
+    }
+    else if (r->failures == 0 && a->peakUse() > peakSeen)
+    {
+      peakSeen = a->peakUse();
+      r->fragPct = fragPct(a);
+    }
+  }
+  r->peak = a->peakUse();
+}
+
+/* Adapters from the heapmgr instances to Allocator */
+static const ReplayHeap *curHeap;
+
+static void heapInit(unsigned size)
+{
+  unsigned i;
+
+  for (i = 0; i < NUM_HEAPS; i++)
+  {
+    if (replayHeaps[i]->size == size)
+    {
+      curHeap = replayHeaps[i];
+    }
+  }
+  curHeap->init();
+}
+
+static void *heapMalloc(uint16_t size)
+{
+  return curHeap->malloc(size);
+}
+
+static void heapFree(void *ptr)
+{
+  curHeap->free(ptr);
+}
+
+static void *heapRealloc(void *ptr, uint16_t size)
+{
+  return curHeap->realloc(ptr, size);
+}
+
+static void heapFreeStats(unsigned *pFree, unsigned *pLargest)
+{
+  curHeap->freeStats(pFree, pLargest);
+}
+
+static unsigned heapPeakUse(void)
+{
+  return curHeap->peakUse();
+}
+
+static int heapSanityCheck(void)
+{
+  return curHeap->sanityCheck();
+}
+
+static unsigned altPeakUse(void)
+{
+  return altPeak;
+}
+
+/* Peak of the bytes held by live blocks, headers included: a lower bound
+ * for any allocator with this header. */
+static unsigned livePeak(void)
+{
+  unsigned use = ALT_HDRSZ, peak = ALT_HDRSZ;
+  unsigned i;
+
+  numLive = 0;
+  for (i = 0; i < numRecords; i++)
+  {
+    const Record *rec = &trace[i];
+    Live *l = findLive(rec->offset);
+    unsigned size = (rec->size + ALT_HDRSZ + 3) & ~3u;
+
+    if (rec->op == OP_MALLOC && rec->offset != NO_OFFSET)
+    {
+      addLive(rec->offset, NULL, rec->size);
+      use += size;
+    }
+    else if (l != NULL)
+    {
+      use -= (l->size + ALT_HDRSZ + 3) & ~3u;
+      if (rec->op == OP_FREE)
+      {
+        removeLive(l);
+      }
+      else
+      {
+        l->size = rec->size;
+        use += size;
+      }
+    }
+    if (use > peak)
+    {
+      peak = use;
+    }
+  }
+  return peak;
+}
+
+/* Peak use, fragmentation and first failure, as "  peak frag  first fails" */
+static void printResult(const Result *r)
+{
+  if (r->broken)
+  {
+    printf(" | %-25s", "SANITY CHECK FAILED");
+  }
+  else if (r->failures == 0)
+  {
+    printf(" | %5u %3u%% %6s %5s", r->peak, r->fragPct, "-", "-");
+  }
+  else
+  {
+    printf(" | %5u %3u%% %6u %5u", r->peak, r->fragPct, r->firstFail,
+           r->failures);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned lateFrees = 0, targetFails = 0;
+  int broken = 0;
+  unsigned i;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <trace>\n", argv[0]);
+    return 2;
+  }
+  if (!loadTrace(argv[1]) || numRecords == 0)
+  {
+    fprintf(stderr, "%s: no trace records\n", argv[1]);
+    return 2;
+  }
+
+  // Records about blocks that the trace does not show being allocated
+  numLive = 0;
+  for (i = 0; i < numRecords; i++)
+  {
+    Live *l = findLive(trace[i].offset);
+
+    if (trace[i].op == OP_MALLOC)
+    {
+      if (trace[i].offset == NO_OFFSET)
+      {
+        targetFails++;
+      }
+      else
+      {
+        addLive(trace[i].offset, NULL, trace[i].size);
+      }
+    }
+    else if (l == NULL)
+    {
+      lateFrees++;
+    }
+    else if (trace[i].op == OP_FREE)
+    {
+      removeLive(l);
+    }
+  }
+
+  printf("%u records, %u about blocks allocated before the trace, "
+         "%u failed on the target\n", numRecords, lateFrees, targetFails);
+  printf("live data peak: %u bytes, headers included\n\n", livePeak());
+  printf("        heapmgr                     best-fit\n");
+  printf("  heap |  peak frag  first fails |  peak frag  first fails"
+         " | heapmgr fail caller\n");
+
+  for (i = 0; i < NUM_HEAPS; i++)
+  {
+    Allocator heap =
+    {
+      replayHeaps[i]->size, heapInit, heapMalloc, heapFree,
+      heapRealloc, heapFreeStats, heapPeakUse, heapSanityCheck
+    };
+    Allocator alt =
+    {
+      replayHeaps[i]->size, altInit, altMalloc, altFree,
+      altRealloc, altFreeStats, altPeakUse, NULL
+    };
+    uint32_t caller;
+    Result r;
+
+    printf("%6u", replayHeaps[i]->size);
+    replay(&heap, &r);
+    broken |= r.broken;
+    printResult(&r);
+    caller = (r.failures != 0 && !r.broken) ? trace[r.firstFail].caller : 0;
+    replay(&alt, &r);
+    printResult(&r);
+    if (caller != 0)
+    {
+      printf(" | 0x%08X", (unsigned) caller);
+    }
+    printf("\n");
+  }
+
+  return broken ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * One instance of the real heapmgr.h for heapmgr_replay.c, of
+ * REPLAY_HEAP_SIZE bytes, with its functions prefixed by REPLAY_HEAP_NAME.
+ * Include once per heap size; each inclusion defines the ReplayHeap
+ * <REPLAY_HEAP_NAME>Entry.
+ */
+#define REPLAY_CAT_(_a, _b)      _a ## _b
+#define REPLAY_CAT(_a, _b)       REPLAY_CAT_(_a, _b)
+#define REPLAY_FN(_name)         REPLAY_CAT(REPLAY_HEAP_NAME, _name)
+
+#define HEAPMGR_SIZE             REPLAY_HEAP_SIZE
+#define HEAPMGR_PREFIXED(_name)  REPLAY_FN(_name)
+#define HEAPMGR_INIT             REPLAY_FN(Init)
+#define HEAPMGR_MALLOC           REPLAY_FN(Malloc)
+#define HEAPMGR_FREE             REPLAY_FN(Free)
+#define HEAPMGR_REALLOC          REPLAY_FN(Realloc)
+#define HEAPMGR_MAINTAIN         REPLAY_FN(Maintain)
+#define HEAPMGR_GETMETRICS       REPLAY_FN(GetMetrics)
+#define HEAPMGR_SANITY_CHECK     REPLAY_FN(SanityCheck)
+
+void *HEAPMGR_MALLOC(uint16_t size);
+void HEAPMGR_FREE(void *ptr);
+
+#include <heapmgr.h>
+
+/* Sizes of the free space and of the largest free block */
+static void REPLAY_FN(FreeStats)(unsigned *pFree, unsigned *pLargest)
+{
+  heapmgrHdr_t *hdr = (heapmgrHdr_t *) HEAPMGR_HEAP;
+
+  *pFree = 0;
+  *pLargest = 0;
+  while (*hdr != 0)
+  {
+    unsigned size = *hdr & ~HEAPMGR_IN_USE;
+
+    if (!(*hdr & HEAPMGR_IN_USE))
+    {
+      unsigned run = size;
+      heapmgrHdr_t *next = (heapmgrHdr_t *) ((hmU8_t *) hdr + size);
+
+      // Adjacent free blocks are merged on the next allocation
+      while (*next != 0 && !(*next & HEAPMGR_IN_USE))
+      {
+        run += *next;
+        next = (heapmgrHdr_t *) ((hmU8_t *) next + *next);
+      }
+      *pFree += run - HDRSZ;
+      if (run - HDRSZ > *pLargest)
+      {
+        *pLargest = run - HDRSZ;
+      }
+      hdr = next;
+    }
+    else
+    {
+      hdr = (heapmgrHdr_t *) ((hmU8_t *) hdr + size);
+    }
+  }
+}
+
+static unsigned REPLAY_FN(PeakUse)(void)
+{
+  return HEAPMGR_MEMMAX;
+}
+
+static const ReplayHeap REPLAY_FN(Entry) =
+{
+  REPLAY_HEAP_SIZE, REPLAY_FN(Init), REPLAY_FN(Malloc), REPLAY_FN(Free),
+  REPLAY_FN(Realloc), REPLAY_FN(FreeStats), REPLAY_FN(PeakUse),
+  REPLAY_FN(SanityCheck)
+};
+
+#undef HEAPMGR_SIZE
+#undef HEAPMGR_PREFIXED
+#undef HEAPMGR_INIT
+#undef HEAPMGR_MALLOC
+#undef HEAPMGR_FREE
+#undef HEAPMGR_REALLOC
+#undef HEAPMGR_MAINTAIN
+#undef HEAPMGR_GETMETRICS
+#undef HEAPMGR_SANITY_CHECK
+#undef REPLAY_HEAP_SIZE
+#undef REPLAY_HEAP_NAME
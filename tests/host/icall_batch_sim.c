@@ -0,0 +1,474 @@
+/*
+ * Host emulation of the two-thread ICall-Lite direct API path, timing
+ * icall_directAPIBatch against one icall_directAPI round trip per call.
+ *
+ * The caller side (matchLiteCS, icall_liteSendAndWait and
+ * icall_directAPIBatch) is extracted from
+ * SensorTag_cc2640r2lp_app/ICall/icall.c, and the stack side
+ * (Sensortag_cc2640r2lp_stack/ICallBLE/icall_lite_translation.c) is built
+ * with its #include lines removed. Both run unchanged, each in its own
+ * thread, joined by an emulated ICall message queue per thread: every
+ * message handed over wakes the other thread, as the higher priority
+ * stack task preempts the application on the target. The stack is built
+ * as a library (STACK_LIBRARY), so a call id is the address of the API.
+ *
+ * icall_directAPI passes its parameters by pointing at its va_list, which
+ * only works with the ARM calling convention; the single calls here send
+ * the same message from a parameter array instead.
+ *
+ * The checks cover:
+ * - every call of a batch runs on the stack thread, in order, and returns
+ *   its result in param[0];
+ * - a batch costs one message and one completion status, and the stack
+ *   allocates its status only once.
+ * The benchmark prints the time per call and the messages per call for
+ * batches of 1 to 16 calls.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^static bool matchLiteCS(/,/^}$/p; /^static void icall_liteSendAndWait(/,/^}$/p; /^void icall_directAPIBatch(/,/^}$/p' \
+ *       SensorTag_cc2640r2lp_app/ICall/icall.c > _host_tests/icall_lite_caller.inc
+ *   sed '/^#include /d' Sensortag_cc2640r2lp_stack/ICallBLE/icall_lite_translation.c \
+ *       > _host_tests/icall_lite_translation_body.inc
+ *   gcc -std=gnu99 -Wall -O2 -pthread -I_host_tests \
+ *       -o _host_tests/icall_batch_sim tests/host/icall_batch_sim.c
+ *   _host_tests/icall_batch_sim
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_CALLS                       20000
+
+#define ICALL_LITE
+#define STACK_LIBRARY
+
+#ifndef TRUE
+#define TRUE                            1
+#define FALSE                           0
+#endif
+
+#define SUCCESS                         0
+
+static int failures = 0;
+
+#define CHECK(_cond, _msg)                                              \
+  do                                                                    \
+  {                                                                     \
+    if (!(_cond) && failures++ < 10)                                    \
+    {                                                                   \
+      printf("FAIL: %s\n", _msg);                                       \
+    }                                                                   \
+  } while (0)
+
+/*
+ * icall.h, with icall_lite_id_t wide enough for a host address. The packed
+ * structures have no padding on the host, so they are not packed here.
+ */
+typedef uint_least16_t ICall_ServiceEnum;
+typedef uint_least8_t ICall_EntityID;
+typedef int_least8_t ICall_Errno;
+typedef bool (*ICall_MsgMatchFn)(ICall_ServiceEnum src, ICall_EntityID dest,
+                                 const void *msg);
+
+#define ICALL_SERVICE_CLASS_BLE            0x0010
+#define ICALL_UNDEF_DEST_ID                0xffu
+#define ICALL_MSG_FORMAT_DIRECT_API_ID     3
+#define ICALL_LITE_DIRECT_API_DONE_CMD_ID  0x42
+#define ICALL_LITE_DIRECT_API_ASYNC_CMD_ID 0x43
+#define ICALL_TIMEOUT_PREDEFINE            5000
+#define ICALL_ERRNO_SUCCESS                0
+#define ICALL_ERRNO_TIMEOUT                1
+
+typedef struct _icall_msg_hdr_t
+{
+  void    *next;
+  uint8_t  srcentity;
+  uint8_t  dstentity;
+  uint8_t  format;
+  uint16_t len;
+  uint8_t  dest_id;
+} ICall_MsgHdr;
+
+typedef uintptr_t icall_lite_id_t;
+
+typedef struct _ICall_LiteCmdStatus_
+{
+  uint_least8_t cmdId;
+  uint_least8_t inFlight;
+} ICall_LiteCmdStatus;
+
+typedef struct
+{
+  uint_least32_t    *pointerStack;
+  icall_lite_id_t   directAPI;
+} icall_directAPIMsg_t;
+
+typedef struct
+{
+  ICall_MsgHdr hdr;
+  icall_directAPIMsg_t   msg;
+} icallLiteMsg_t;
+
+#define ICALL_LITE_MAX_PARAMS              8
+#define ICALL_LITE_BATCH_ID                0xFFFFFFFF
+#define ICALL_LITE_ASYNC_ID                0xFFFFFFFE
+#define ICALL_LITE_ASYNC_DATA_SIZE         32
+
+typedef struct _icall_liteCall_
+{
+  icall_lite_id_t directAPI;
+  uint_least32_t  param[ICALL_LITE_MAX_PARAMS];
+} icall_liteCall_t;
+
+typedef struct _icall_liteBatch_
+{
+  icall_liteCall_t *pCalls;
+  uint_least32_t   numCalls;
+} icall_liteBatch_t;
+
+typedef void (*icall_liteAsyncCB_t)(icall_liteCall_t *pCall, void *pData);
+
+typedef struct _icall_liteAsyncMsg_
+{
+  icall_directAPIMsg_t msg;
+  icall_liteCall_t     call;
+  icall_liteAsyncCB_t  pfnCB;
+  uint_least32_t       data[ICALL_LITE_ASYNC_DATA_SIZE /
+                            sizeof(uint_least32_t)];
+} icall_liteAsyncMsg_t;
+
+/*
+ * hal_assert.h and TI-RTOS
+ */
+#define HAL_ASSERT_CAUSE_INTERNAL_ERROR 1
+#define HAL_ASSERT_CAUSE_OUT_OF_MEMORY  2
+#define HAL_ASSERT_CAUSE_ICALL_ABORT    3
+#define HAL_ASSERT_CAUSE_ICALL_TIMEOUT  4
+
+#define HAL_ASSERT(_cause)                                              \
+  do                                                                    \
+  {                                                                     \
+    printf("FAIL: assert %d at line %d\n", _cause, __LINE__);           \
+    exit(1);                                                            \
+  } while (0)
+#define HAL_ASSERT_FORCED()             HAL_ASSERT(0)
+
+typedef enum
+{
+  BIOS_ThreadType_Hwi,
+  BIOS_ThreadType_Swi,
+  BIOS_ThreadType_Task,
+  BIOS_ThreadType_Main
+} BIOS_ThreadType;
+
+static BIOS_ThreadType BIOS_getThreadType(void)
+{
+  return (BIOS_ThreadType_Task);
+}
+
+#define ICALL_MSG_TRACE_HOP(_msg, _hop)
+#define ICALL_MSG_TRACE_HOP_DONE        0
+
+/*
+ * Emulated message queues: one per thread, handed over under one lock
+ */
+typedef struct
+{
+  ICall_MsgHdr *pHead;
+  ICall_MsgHdr *pTail;
+  pthread_cond_t cond;
+} queue_t;
+
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static queue_t appQueue = { NULL, NULL, PTHREAD_COND_INITIALIZER };
+static queue_t stackQueue = { NULL, NULL, PTHREAD_COND_INITIALIZER };
+
+#define APP_ENTITY              1
+
+// Counted while the benchmark runs
+static unsigned long numMessages;
+static unsigned long numStatusAllocs;
+
+static void queuePut(queue_t *pQueue, ICall_MsgHdr *pHdr)
+{
+  pthread_mutex_lock(&queueLock);
+  pHdr->next = NULL;
+  if (pQueue->pTail != NULL)
+  {
+    pQueue->pTail->next = pHdr;
+  }
+  else
+  {
+    pQueue->pHead = pHdr;
+  }
+  pQueue->pTail = pHdr;
+  numMessages++;
+  pthread_cond_signal(&pQueue->cond);
+  pthread_mutex_unlock(&queueLock);
+}
+
+static ICall_MsgHdr *queueGet(queue_t *pQueue)
+{
+  ICall_MsgHdr *pHdr;
+
+  pthread_mutex_lock(&queueLock);
+  while (pQueue->pHead == NULL)
+  {
+    pthread_cond_wait(&pQueue->cond, &queueLock);
+  }
+  pHdr = pQueue->pHead;
+  pQueue->pHead = pHdr->next;
+  if (pQueue->pHead == NULL)
+  {
+    pQueue->pTail = NULL;
+  }
+  pthread_mutex_unlock(&queueLock);
+
+  return (pHdr);
+}
+
+/*
+ * ICall, on the application side
+ */
+static ICall_EntityID ICall_getEntityId(void)
+{
+  return (APP_ENTITY);
+}
+
+static ICall_Errno ICall_sendServiceMsg(ICall_EntityID src,
+                                        ICall_ServiceEnum dest,
+                                        uint_least8_t format, void *msg)
+{
+  ICall_MsgHdr *pHdr = (ICall_MsgHdr *)msg - 1;
+
+  pHdr->srcentity = src;
+  pHdr->format = format;
+  queuePut(&stackQueue, pHdr);
+
+  return (ICALL_ERRNO_SUCCESS);
+}
+
+// Only the completion status is ever queued to the application here
+static ICall_Errno ICall_waitMatch(uint_least32_t milliseconds,
+                                   ICall_MsgMatchFn matchFn,
+                                   ICall_ServiceEnum *srcServiceId,
+                                   ICall_EntityID *dest, void **msg)
+{
+  ICall_MsgHdr *pHdr = queueGet(&appQueue);
+
+  CHECK(matchFn(0, 0, pHdr + 1), "unexpected message to the application");
+  *msg = pHdr + 1;
+
+  return (ICALL_ERRNO_SUCCESS);
+}
+
+static void ICall_freeMsg(void *msg)
+{
+  free((ICall_MsgHdr *)msg - 1);
+}
+
+/*
+ * OSAL, on the stack side
+ */
+typedef uint8_t uint8;
+typedef ICall_MsgHdr osal_msg_hdr_t;
+
+#define OSAL_PROXY_ID_FLAG              0x80
+#define OSAL_MAX_NUM_PROXY_TASKS        2
+
+static uint8 osal_alien2proxy(uint8 entity)
+{
+  return (OSAL_PROXY_ID_FLAG | (entity - APP_ENTITY));
+}
+
+static uint8 *osal_msg_allocate(uint16_t len)
+{
+  ICall_MsgHdr *pHdr = malloc(sizeof(ICall_MsgHdr) + len);
+
+  numStatusAllocs++;
+  pHdr->len = len;
+
+  return ((uint8 *)(pHdr + 1));
+}
+
+static void osal_msg_deallocate(uint8 *pMsg)
+{
+  free((ICall_MsgHdr *)pMsg - 1);
+}
+
+static uint8 osal_msg_send(uint8 taskId, uint8 *pMsg)
+{
+  CHECK(taskId == (OSAL_PROXY_ID_FLAG | 0), "status sent to the wrong task");
+  queuePut(&appQueue, (ICall_MsgHdr *)pMsg - 1);
+
+  return (SUCCESS);
+}
+
+#include "icall_lite_caller.inc"
+#include "icall_lite_translation_body.inc"
+
+/*
+ * The stack thread and its APIs
+ */
+static pthread_t stackThread;
+static uint32_t lastSeq;
+
+#define API_PARAMS  uint32_t p1, uint32_t p2, uint32_t p3, uint32_t p4, \
+                    uint32_t p5, uint32_t p6, uint32_t p7, uint32_t p8
+
+// Returns a function of its parameters; p1 is a sequence number
+static uint32_t apiMix(API_PARAMS)
+{
+  CHECK(pthread_equal(pthread_self(), stackThread), "API run by the caller");
+  CHECK(p1 == lastSeq + 1, "calls of a batch out of order");
+  lastSeq = p1;
+
+  return (p1 * 3 + p2 + p8);
+}
+
+static void *stackMain(void *arg)
+{
+  for (;;)
+  {
+    ICall_MsgHdr *pHdr = queueGet(&stackQueue);
+
+    // A message without a call stops the thread
+    if (pHdr->len == 0)
+    {
+      break;
+    }
+
+    icall_liteTranslation((icall_directAPIMsg_t *)(pHdr + 1));
+  }
+
+  return (NULL);
+}
+
+/*
+ * The single call path of icall_directAPI, from a parameter array
+ */
+static uint32_t directAPI(icall_lite_id_t id, uint_least32_t *pParams)
+{
+  icallLiteMsg_t liteMsg;
+
+  liteMsg.msg.directAPI = id;
+  liteMsg.msg.pointerStack = pParams;
+  icall_liteSendAndWait(ICALL_SERVICE_CLASS_BLE, &liteMsg);
+
+  return (pParams[0]);
+}
+
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+static uint32_t seq;
+
+static void fillCall(icall_liteCall_t *pCall)
+{
+  memset(pCall, 0, sizeof(*pCall));
+  pCall->directAPI = (icall_lite_id_t)apiMix;
+  pCall->param[0] = ++seq;
+  pCall->param[1] = seq ^ 0x5A5A;
+  pCall->param[7] = 7;
+}
+
+static void checkResult(const icall_liteCall_t *pCall, uint32_t s)
+{
+  CHECK(pCall->param[0] == s * 3 + (s ^ 0x5A5A) + 7, "wrong result");
+}
+
+int main(void)
+{
+  static const int batchSizes[] = { 1, 4, 16 };
+  icall_liteCall_t calls[16];
+  ICall_MsgHdr stopMsg;
+  int b, n, i;
+
+  pthread_create(&stackThread, NULL, stackMain, NULL);
+
+  printf("%d calls, ns per call   messages per call\n", NUM_CALLS);
+
+  // One round trip per call
+  {
+    unsigned long msgs0 = numMessages;
+    double t0 = nowNs();
+
+    for (n = 0; n < NUM_CALLS; n++)
+    {
+      fillCall(&calls[0]);
+      directAPI(calls[0].directAPI, calls[0].param);
+      checkResult(&calls[0], seq);
+    }
+
+    printf("  icall_directAPI      %8.0f   %4.2f\n",
+           (nowNs() - t0) / NUM_CALLS,
+           (double)(numMessages - msgs0) / NUM_CALLS);
+  }
+
+  // One round trip per batch
+  for (b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); b++)
+  {
+    int size = batchSizes[b];
+    unsigned long msgs0 = numMessages;
+    double t0 = nowNs();
+
+    for (n = 0; n < NUM_CALLS; n += size)
+    {
+      uint32_t first = seq + 1;
+
+      for (i = 0; i < size; i++)
+      {
+        fillCall(&calls[i]);
+      }
+
+      icall_directAPIBatch(ICALL_SERVICE_CLASS_BLE, calls, size);
+
+      for (i = 0; i < size; i++)
+      {
+        checkResult(&calls[i], first + i);
+      }
+    }
+
+    CHECK(numMessages - msgs0 == 2 * (NUM_CALLS / size),
+          "not one message and one status per batch");
+
+    printf("  batch of %-2d          %8.0f   %4.2f\n", size,
+           (nowNs() - t0) / NUM_CALLS,
+           (double)(numMessages - msgs0) / NUM_CALLS);
+  }
+
+  // An empty batch is not sent
+  {
+    unsigned long msgs0 = numMessages;
+
+    icall_directAPIBatch(ICALL_SERVICE_CLASS_BLE, calls, 0);
+    CHECK(numMessages == msgs0, "empty batch sent");
+  }
+
+  CHECK(lastSeq == seq, "calls lost");
+  CHECK(numStatusAllocs == 1, "completion status allocated more than once");
+
+  stopMsg.len = 0;
+  queuePut(&stackQueue, &stopMsg);
+  pthread_join(stackThread, NULL);
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("icall_batch_sim: OK\n");
+
+  return (0);
+}
@@ -0,0 +1,379 @@
+/*
+ * Host test and benchmark for the ICall task and service lookups in
+ * SensorTag_cc2640r2lp_app/ICall/icall.c.
+ *
+ * icall.c needs TI-RTOS, so the lookup code (ICALL_SERVICE_INDEX and the
+ * service entity table, ICall_searchTask, ICall_setServiceEntity,
+ * ICall_newTask and ICall_searchServiceEntity) is extracted from it
+ * unchanged into icall_lookup.inc. The TI-RTOS task environment is
+ * emulated, and the critical section only counts its use. The checks
+ * cover:
+ * - every task and every service, sub-services included, is found as the
+ *   scans it replaced found it, and a service enrolled twice keeps its
+ *   first entity;
+ * - a task environment that is not an ICall entry is not taken for one,
+ *   and ICall_newTask aborts rather than overwrite it.
+ * The benchmark times the lookups against the scans, in TSC cycles where
+ * the host has one (nanoseconds otherwise), for the last task and service
+ * of full tables.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#define ICALL_SERVICE_INDEX(/,/^static ICall_EntityID ICall_serviceEntities/p; /^static ICall_TaskEntry \*ICall_\(searchTask\|newTask\)(.*)$/,/^}$/p; /^static void ICall_setServiceEntity(/,/^}$/p; /^ICall_EntityID ICall_searchServiceEntity(.*)$/,/^}$/p' \
+ *       SensorTag_cc2640r2lp_app/ICall/icall.c > _host_tests/icall_lookup.inc
+ *   gcc -std=gnu99 -Wall -O2 -I_host_tests \
+ *       -o _host_tests/icall_lookup_bench tests/host/icall_lookup_bench.c
+ *   _host_tests/icall_lookup_bench
+ */
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ROUNDS                      2000000
+
+#ifndef ICALL_MAX_NUM_ENTITIES
+#define ICALL_MAX_NUM_ENTITIES          6
+#endif
+
+#ifndef ICALL_MAX_NUM_TASKS
+#define ICALL_MAX_NUM_TASKS             2
+#endif
+
+// icall.h
+typedef uint_least16_t ICall_ServiceEnum;
+typedef uint_least8_t ICall_EntityID;
+typedef uint_least32_t ICall_CSState;
+typedef void *ICall_SyncHandle;
+typedef void *ICall_MsgQueue;
+typedef int (*ICall_ServiceFunc)(void *args);
+
+#define ICALL_INVALID_ENTITY_ID         0xffu
+#define ICALL_SERVICE_CLASS_MASK        0xFFF8
+#define ICALL_SERVICE_CLASS_PRIMITIVE   0x0008
+#define ICALL_SERVICE_CLASS_BLE         0x0010
+#define ICALL_SERVICE_CLASS_NPI         0x0038
+#define ICALL_SERVICE_CLASS_BLE_MSG     0x0050
+#define ICALL_SERVICE_CLASS_CRYPTO      0x0080
+#define ICALL_SERVICE_CLASS_DUMMY_BOARD 0x0200
+
+// icall.c
+#define ICALL_SERVICE_CLASS_INVALID_ENTRY  0x0000
+#define ICALL_SERVICE_CLASS_APPLICATION    ICALL_SERVICE_CLASS_MASK
+
+// TI-RTOS task, with its environment pointer
+typedef struct
+{
+  void *env;
+} Task_Object;
+
+typedef Task_Object *Task_Handle;
+
+static void *Task_getEnv(Task_Handle task)
+{
+  return (task->env);
+}
+
+static void Task_setEnv(Task_Handle task, void *env)
+{
+  task->env = env;
+}
+
+static int syncObject;
+static jmp_buf abortJump;
+static int numCriticalSections;
+
+#define ICALL_SYNC_HANDLE_CREATE()      ((ICall_SyncHandle) &syncObject)
+#define ICALL_HOOK_ABORT_FUNC()         longjmp(abortJump, 1)
+
+// On target a Task_disable and Hwi_disable pair and their restores
+static __attribute__((noinline)) ICall_CSState ICall_enterCSImpl(void)
+{
+  numCriticalSections++;
+  __asm__ volatile("" ::: "memory");
+
+  return (0);
+}
+
+static __attribute__((noinline)) void ICall_leaveCSImpl(ICall_CSState key)
+{
+  __asm__ volatile("" ::: "memory");
+}
+
+typedef struct _icall_task_entry_t
+{
+  Task_Handle task;
+  ICall_SyncHandle syncHandle;
+  ICall_MsgQueue queue;
+} ICall_TaskEntry;
+
+typedef struct _icall_entity_entry_t
+{
+  ICall_ServiceEnum service;
+  ICall_TaskEntry *task;
+  ICall_ServiceFunc fn;
+} ICall_entityEntry;
+
+static ICall_TaskEntry ICall_tasks[ICALL_MAX_NUM_TASKS];
+static ICall_entityEntry ICall_entities[ICALL_MAX_NUM_ENTITIES];
+
+#include "icall_lookup.inc"
+
+/*
+ * The scans the lookups replaced, for comparison.
+ */
+static ICall_TaskEntry *scanSearchTask(Task_Handle taskhandle)
+{
+  size_t i;
+  ICall_CSState key;
+
+  key = ICall_enterCSImpl();
+  for (i = 0; i < ICALL_MAX_NUM_TASKS; i++)
+  {
+    if (!ICall_tasks[i].task)
+    {
+      break;
+    }
+    if (taskhandle == ICall_tasks[i].task)
+    {
+      ICall_leaveCSImpl(key);
+      return &ICall_tasks[i];
+    }
+  }
+  ICall_leaveCSImpl(key);
+  return NULL;
+}
+
+static ICall_EntityID scanSearchServiceEntity(ICall_ServiceEnum service)
+{
+  size_t i;
+  ICall_CSState key;
+
+  key = ICall_enterCSImpl();
+  for (i = 0; i < ICALL_MAX_NUM_ENTITIES; i++)
+  {
+    if (ICall_entities[i].service == ICALL_SERVICE_CLASS_INVALID_ENTRY)
+    {
+      break;
+    }
+    if (service == ICall_entities[i].service)
+    {
+      ICall_leaveCSImpl(key);
+      return (ICall_EntityID) i;
+    }
+  }
+  ICall_leaveCSImpl(key);
+  return ICALL_INVALID_ENTITY_ID;
+}
+
+static int failures = 0;
+
+static Task_Object tasks[ICALL_MAX_NUM_TASKS + 1];
+
+// Environment another module set on its task
+static ICall_TaskEntry foreignEnv;
+
+// Services enrolled in order, the last entries are applications
+static const ICall_ServiceEnum services[] =
+{
+  ICALL_SERVICE_CLASS_PRIMITIVE,
+  ICALL_SERVICE_CLASS_BLE,
+  ICALL_SERVICE_CLASS_BLE | 1,        // Sub-service of BLE
+  ICALL_SERVICE_CLASS_BLE_MSG,
+  ICALL_SERVICE_CLASS_BLE,            // Enrolled twice
+  ICALL_SERVICE_CLASS_CRYPTO,
+  ICALL_SERVICE_CLASS_NPI,
+  ICALL_SERVICE_CLASS_BLE_MSG | 2,
+};
+
+#define NUM_SERVICES    (sizeof(services) / sizeof(services[0]))
+
+// Enroll like ICall_enrollService and ICall_registerApp do
+static void enroll(void)
+{
+  size_t i;
+
+  memset(ICall_tasks, 0, sizeof(ICall_tasks));
+  for (i = 0; i < ICALL_NUM_SERVICE_INDEXES; i++)
+  {
+    ICall_serviceEntities[i] = ICALL_INVALID_ENTITY_ID;
+  }
+
+  for (i = 0; i < ICALL_MAX_NUM_TASKS; i++)
+  {
+    if (ICall_newTask(&tasks[i]) != &ICall_tasks[i])
+    {
+      printf("FAIL: no entry for task %d\n", (int)i);
+      failures++;
+    }
+  }
+
+  for (i = 0; i < ICALL_MAX_NUM_ENTITIES; i++)
+  {
+    ICall_ServiceEnum service = (i < NUM_SERVICES) ?
+      services[i] : ICALL_SERVICE_CLASS_APPLICATION;
+
+    ICall_entities[i].service = service;
+    ICall_entities[i].task = &ICall_tasks[i % ICALL_MAX_NUM_TASKS];
+    ICall_setServiceEntity(service, (ICall_EntityID) i);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TIME_UNIT       "cycles"
+
+static double timeNow(void)
+{
+  return ((double)__builtin_ia32_rdtsc());
+}
+#else
+#define TIME_UNIT       "ns"
+
+static double timeNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+#endif
+
+typedef ICall_TaskEntry *(*taskFn_t)(Task_Handle taskhandle);
+typedef ICall_EntityID (*serviceFn_t)(ICall_ServiceEnum service);
+
+static double timeTask(taskFn_t find, Task_Handle task, double *pCS)
+{
+  volatile uintptr_t sink = 0;
+  int cs = numCriticalSections;
+  double t0 = timeNow();
+  int r;
+
+  for (r = 0; r < NUM_ROUNDS; r++)
+  {
+    sink += (uintptr_t)find(task);
+  }
+
+  (void)sink;
+  *pCS = (double)(numCriticalSections - cs) / NUM_ROUNDS;
+
+  return ((timeNow() - t0) / NUM_ROUNDS);
+}
+
+static double timeService(serviceFn_t find, ICall_ServiceEnum service,
+                          double *pCS)
+{
+  volatile uintptr_t sink = 0;
+  int cs = numCriticalSections;
+  double t0 = timeNow();
+  int r;
+
+  for (r = 0; r < NUM_ROUNDS; r++)
+  {
+    sink += find(service);
+  }
+
+  (void)sink;
+  *pCS = (double)(numCriticalSections - cs) / NUM_ROUNDS;
+
+  return ((timeNow() - t0) / NUM_ROUNDS);
+}
+
+int main(void)
+{
+  static const ICall_ServiceEnum queries[] =
+  {
+    ICALL_SERVICE_CLASS_PRIMITIVE, ICALL_SERVICE_CLASS_BLE,
+    ICALL_SERVICE_CLASS_BLE | 1, ICALL_SERVICE_CLASS_BLE | 2,
+    ICALL_SERVICE_CLASS_BLE_MSG, ICALL_SERVICE_CLASS_BLE_MSG | 2,
+    ICALL_SERVICE_CLASS_CRYPTO, ICALL_SERVICE_CLASS_NPI,
+    ICALL_SERVICE_CLASS_DUMMY_BOARD, ICALL_SERVICE_CLASS_APPLICATION
+  };
+  Task_Handle lastTask = &tasks[ICALL_MAX_NUM_TASKS - 1];
+  ICall_ServiceEnum lastService;
+  double oldCycles, newCycles, oldCS, newCS;
+  size_t i;
+
+  if (setjmp(abortJump) != 0)
+  {
+    printf("FAIL: aborted while enrolling\n");
+    return (1);
+  }
+  enroll();
+
+  // Tasks: the entry the scan finds, or none for a task without one
+  for (i = 0; i <= ICALL_MAX_NUM_TASKS; i++)
+  {
+    if (ICall_searchTask(&tasks[i]) != scanSearchTask(&tasks[i]))
+    {
+      printf("FAIL: task %d\n", (int)i);
+      failures++;
+    }
+  }
+
+  // Services: the entity the scan finds, sub-services included
+  for (i = 0; i < sizeof(queries) / sizeof(queries[0]); i++)
+  {
+    if (ICall_searchServiceEntity(queries[i]) !=
+        scanSearchServiceEntity(queries[i]))
+    {
+      printf("FAIL: service 0x%04X: entity %u, scan finds %u\n", queries[i],
+             ICall_searchServiceEntity(queries[i]),
+             scanSearchServiceEntity(queries[i]));
+      failures++;
+    }
+  }
+
+  // An environment that is not an ICall entry
+  tasks[ICALL_MAX_NUM_TASKS].env = &foreignEnv;
+  if (ICall_searchTask(&tasks[ICALL_MAX_NUM_TASKS]) != NULL)
+  {
+    printf("FAIL: foreign task environment taken for an entry\n");
+    failures++;
+  }
+
+  memset(ICall_tasks, 0, sizeof(ICall_tasks));
+  if (setjmp(abortJump) == 0)
+  {
+    ICall_newTask(&tasks[ICALL_MAX_NUM_TASKS]);
+    printf("FAIL: foreign task environment overwritten\n");
+    failures++;
+  }
+  tasks[ICALL_MAX_NUM_TASKS].env = NULL;
+
+  // Time the worst case: last task, last enrolled service
+  for (i = 0; i <= ICALL_MAX_NUM_TASKS; i++)
+  {
+    tasks[i].env = NULL;
+  }
+  enroll();
+  lastService = (ICALL_MAX_NUM_ENTITIES <= NUM_SERVICES) ?
+    services[ICALL_MAX_NUM_ENTITIES - 1] : services[NUM_SERVICES - 1];
+  if (!ICALL_SERVICE_INDEXED(lastService))
+  {
+    lastService &= ICALL_SERVICE_CLASS_MASK;
+  }
+
+  printf("%d tasks, %d entities; %s per lookup (critical sections)\n",
+         ICALL_MAX_NUM_TASKS, ICALL_MAX_NUM_ENTITIES, TIME_UNIT);
+
+  oldCycles = timeTask(scanSearchTask, lastTask, &oldCS);
+  newCycles = timeTask(ICall_searchTask, lastTask, &newCS);
+  printf("  ICall_searchTask           scan %6.1f (%.0f)  now %6.1f (%.0f)\n",
+         oldCycles, oldCS, newCycles, newCS);
+
+  oldCycles = timeService(scanSearchServiceEntity, lastService, &oldCS);
+  newCycles = timeService(ICall_searchServiceEntity, lastService, &newCS);
+  printf("  ICall_searchServiceEntity  scan %6.1f (%.0f)  now %6.1f (%.0f)"
+         "  service 0x%04X\n", oldCycles, oldCS, newCycles, newCS, lastService);
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("icall_lookup_bench: OK\n");
+
+  return (0);
+}
@@ -0,0 +1,518 @@
+/*
+ * Host stress test and benchmark for ICall_msgSearchMatch in
+ * SensorTag_cc2640r2lp_app/ICall/icall.c, the in-place search behind
+ * ICall_waitMatch.
+ *
+ * icall.c needs TI-RTOS, so the message queue code (ICALL_MSG_NEXT,
+ * ICALL_MSG_DEST_ID, ICall_msgEnqueue, ICall_msgDequeue,
+ * ICall_primEntityId2ServiceId and ICall_msgSearchMatch) is extracted from
+ * it unchanged into icall_match.inc. The wait loop of ICall_waitMatch is
+ * replayed around it. Other threads append to the queue while the owner
+ * walks it: the stress test models them as interrupts taken inside the
+ * match function, outside any critical section, and between passes.
+ * The checks cover:
+ * - every wait returns the matching message, and all other messages stay
+ *   queued in their order, appended ones included;
+ * - no message is looked at twice in one wait;
+ * - messages from an application entity are never matched.
+ * The benchmark times a wait for a reply queued behind a backlog of stack
+ * events against the fetch and prepend loop ICall_waitMatch used before,
+ * and counts the loop passes and messages moved.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#define ICALL_MSG_\(NEXT\|DEST_ID\)(/p; /^static void ICall_msgEnqueue(/,/^}$/p; /^static void \*ICall_msgDequeue(/,/^}$/p; /^static ICall_Errno ICall_primEntityId2ServiceId(/,/^}$/p; /^static void \*ICall_msgSearchMatch(/,/^}$/p' \
+ *       SensorTag_cc2640r2lp_app/ICall/icall.c > _host_tests/icall_match.inc
+ *   gcc -std=gnu99 -Wall -O2 -I_host_tests \
+ *       -o _host_tests/icall_match_stress tests/host/icall_match_stress.c
+ *   _host_tests/icall_match_stress
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_WAITS                       100000
+#define NUM_BENCH_WAITS                 2000
+#define POOL_SIZE                       1024
+
+#define ICALL_MAX_NUM_ENTITIES          6
+
+static int failures = 0;
+
+#define CHECK(_cond, _msg)                                              \
+  do                                                                    \
+  {                                                                     \
+    if (!(_cond) && failures++ < 10)                                    \
+    {                                                                   \
+      printf("FAIL: %s\n", _msg);                                       \
+    }                                                                   \
+  } while (0)
+
+// icall.h
+typedef uint_least16_t ICall_ServiceEnum;
+typedef uint_least8_t ICall_EntityID;
+typedef int_least8_t ICall_Errno;
+typedef uint_least32_t ICall_CSState;
+typedef int (*ICall_ServiceFunc)(void *args);
+typedef bool (*ICall_MsgMatchFn)(ICall_ServiceEnum src, ICall_EntityID dest,
+                                 const void *msg);
+
+#define ICALL_UNDEF_DEST_ID             0xffu
+#define ICALL_ERRNO_SUCCESS             0
+#define ICALL_ERRNO_INVALID_SERVICE     (-4)
+#define ICALL_SERVICE_CLASS_MASK        0xFFF8
+#define ICALL_SERVICE_CLASS_BLE         0x0010
+
+typedef struct _icall_msg_hdr_t
+{
+  void    *next;
+  uint8_t  srcentity;
+  uint8_t  dstentity;
+  uint8_t  format;
+  uint16_t len;
+  uint8_t  dest_id;
+} ICall_MsgHdr;
+
+// icall.c
+#define ICALL_SERVICE_CLASS_INVALID_ENTRY  0x0000
+#define ICALL_SERVICE_CLASS_APPLICATION    ICALL_SERVICE_CLASS_MASK
+
+typedef void *ICall_MsgQueue;
+
+typedef struct _icall_task_entry_t
+{
+  void *task;
+  void *syncHandle;
+  ICall_MsgQueue queue;
+} ICall_TaskEntry;
+
+typedef struct _icall_entity_entry_t
+{
+  ICall_ServiceEnum service;
+  ICall_TaskEntry *task;
+  ICall_ServiceFunc fn;
+} ICall_entityEntry;
+
+static ICall_entityEntry ICall_entities[ICALL_MAX_NUM_ENTITIES];
+
+#define ICALL_MSG_TRACE_SEND(_msg)
+#define ICALL_MSG_TRACE_HOP(_msg, _hop)
+
+// Critical sections only nest; interrupts are not taken inside one
+static int csDepth;
+
+static ICall_CSState ICall_enterCSImpl(void)
+{
+  csDepth++;
+
+  return (0);
+}
+
+static void ICall_leaveCSImpl(ICall_CSState key)
+{
+  csDepth--;
+}
+
+#include "icall_match.inc"
+
+/*
+ * The ICall_msgPrepend ICall_waitMatch used before, for comparison
+ */
+static void oldMsgPrepend(ICall_MsgQueue *q_ptr, ICall_MsgQueue head)
+{
+  void *msg_ptr = NULL;
+  ICall_CSState key;
+
+  key = ICall_enterCSImpl();
+
+  if (head != NULL)
+  {
+    msg_ptr = head;
+    while (ICALL_MSG_NEXT(msg_ptr) != NULL)
+    {
+      msg_ptr = ICALL_MSG_NEXT(msg_ptr);
+    }
+    ICALL_MSG_NEXT(msg_ptr) = *q_ptr;
+    *q_ptr = head;
+  }
+
+  ICall_leaveCSImpl(key);
+}
+
+/*
+ * Messages: a header and a sequence number. The waiter looks for the one
+ * numbered matchSeq.
+ */
+#define APP_ENTITY      0
+#define STACK_ENTITY    1
+
+typedef struct
+{
+  ICall_MsgHdr hdr;
+  uint32_t seq;
+  uint32_t seenInWait;
+} testMsg_t;
+
+static testMsg_t pool[POOL_SIZE];
+static int poolFree[POOL_SIZE];
+static int numPoolFree;
+
+static ICall_TaskEntry waiter;
+static uint32_t nextSeq = 1;
+static uint32_t matchSeq;
+static uint32_t waitId;
+
+// The expected queue content, in order
+static uint32_t model[POOL_SIZE];
+static int modelLen;
+
+// Stress counters
+static unsigned long numExamined;
+static unsigned long numInterrupts;
+static int interruptChance;
+
+static void *newMsg(uint8_t src)
+{
+  testMsg_t *pMsg = &pool[poolFree[--numPoolFree]];
+
+  pMsg->hdr.srcentity = src;
+  pMsg->hdr.dstentity = APP_ENTITY;
+  pMsg->hdr.dest_id = 0;
+  pMsg->seq = nextSeq++;
+  pMsg->seenInWait = 0;
+
+  return (&pMsg->seq);
+}
+
+static void freeMsg(void *msg)
+{
+  poolFree[numPoolFree++] = (testMsg_t *)((ICall_MsgHdr *)msg - 1) - pool;
+}
+
+static uint32_t msgSeq(const void *msg)
+{
+  return (*(const uint32_t *)msg);
+}
+
+// Another thread appends a message, as ICall_primSend does
+static void post(uint8_t src)
+{
+  void *msg = newMsg(src);
+
+  CHECK(csDepth == 0, "queue appended to inside a critical section");
+  ICall_msgEnqueue(&waiter.queue, msg);
+  model[modelLen++] = msgSeq(msg);
+}
+
+// A burst of stack events, a few sent by an application entity
+static void postBurst(int count)
+{
+  while ((count-- > 0) && (numPoolFree > 2))
+  {
+    post((rand() % 8 == 0) ? APP_ENTITY : STACK_ENTITY);
+  }
+}
+
+// The reply waited for, sent by the stack as a message of its own
+static void postMatch(void)
+{
+  matchSeq = nextSeq;
+  post(STACK_ENTITY);
+}
+
+static bool matchReply(ICall_ServiceEnum src, ICall_EntityID dest,
+                       const void *msg)
+{
+  testMsg_t *pMsg = (testMsg_t *)((ICall_MsgHdr *)msg - 1);
+
+  numExamined++;
+  CHECK(src == ICALL_SERVICE_CLASS_BLE, "message of an application matched");
+  CHECK(pMsg->seenInWait != waitId, "message examined twice in a wait");
+  pMsg->seenInWait = waitId;
+
+  // An interrupt between reading this message and the next one
+  if ((interruptChance != 0) && (rand() % interruptChance == 0))
+  {
+    numInterrupts++;
+    if ((matchSeq == 0) && (rand() % 4 == 0))
+    {
+      postMatch();
+    }
+    else
+    {
+      postBurst(1 + rand() % 3);
+    }
+  }
+
+  return ((matchSeq != 0) && (msgSeq(msg) == matchSeq));
+}
+
+/*
+ * The wait loop of ICall_waitMatch: a pass for every wake-up of the task
+ */
+static void *waitMatch(int *pPasses)
+{
+  void *cursor = NULL;
+  ICall_ServiceEnum servId;
+  ICall_EntityID dest;
+  void *msg;
+
+  waitId++;
+  *pPasses = 0;
+
+  for (;;)
+  {
+    (*pPasses)++;
+    msg = ICall_msgSearchMatch(&waiter, &cursor, matchReply, &servId, &dest);
+    if (msg != NULL)
+    {
+      CHECK(ICALL_MSG_DEST_ID(msg) == ICALL_UNDEF_DEST_ID,
+            "destination left on the match");
+      return (msg);
+    }
+
+    // Woken up by the next burst, with the reply or not
+    if ((matchSeq == 0) && (rand() % 3 == 0))
+    {
+      postMatch();
+    }
+    postBurst(rand() % 4);
+  }
+}
+
+/*
+ * The fetch and prepend loop ICall_waitMatch used before: every message
+ * that does not match is moved to a prepend queue and the task posts
+ * itself a wake-up for the next one.
+ */
+static void *oldWaitMatch(int *pPasses, int *pMoved)
+{
+  ICall_MsgQueue prependQueue = NULL;
+  void *msg;
+
+  *pPasses = 0;
+  *pMoved = 0;
+
+  for (;;)
+  {
+    ICall_ServiceEnum servId;
+    ICall_MsgHdr *hdr;
+
+    (*pPasses)++;
+    msg = ICall_msgDequeue(&waiter.queue);
+    if (msg == NULL)
+    {
+      break;
+    }
+
+    hdr = (ICall_MsgHdr *)msg - 1;
+    if ((ICall_primEntityId2ServiceId(hdr->srcentity, &servId) ==
+           ICALL_ERRNO_SUCCESS) &&
+        matchReply(servId, hdr->dstentity, msg))
+    {
+      break;
+    }
+
+    ICall_msgEnqueue(&prependQueue, msg);
+    (*pMoved)++;
+  }
+
+  oldMsgPrepend(&waiter.queue, prependQueue);
+
+  return (msg);
+}
+
+static void checkQueue(void)
+{
+  void *msg = waiter.queue;
+  int i;
+
+  for (i = 0; (i < modelLen) && (msg != NULL); i++)
+  {
+    if (msgSeq(msg) != model[i])
+    {
+      break;
+    }
+    msg = ICALL_MSG_NEXT(msg);
+  }
+
+  CHECK((i == modelLen) && (msg == NULL), "queue order changed");
+}
+
+static void modelRemove(uint32_t seq)
+{
+  int i;
+
+  for (i = 0; (i < modelLen) && (model[i] != seq); i++)
+  {
+  }
+
+  CHECK(i < modelLen, "match not in the model");
+  if (i < modelLen)
+  {
+    memmove(&model[i], &model[i + 1], (modelLen - i - 1) * sizeof(model[0]));
+    modelLen--;
+  }
+}
+
+// The owner task processes part of its backlog, as ICall_fetchMsg does
+static void drain(int count)
+{
+  while ((count-- > 0) && (modelLen > 0))
+  {
+    void *msg = ICall_msgDequeue(&waiter.queue);
+
+    CHECK((msg != NULL) && (msgSeq(msg) == model[0]), "dequeue out of order");
+    memmove(&model[0], &model[1], (modelLen - 1) * sizeof(model[0]));
+    modelLen--;
+    if (msg != NULL)
+    {
+      freeMsg(msg);
+    }
+  }
+}
+
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+/*
+ * Time waits for a reply queued behind a backlog of stack events
+ */
+static void bench(int backlog)
+{
+  void *(*const fns[2])(int *pPasses, int *pMoved) = { NULL, oldWaitMatch };
+  double ns[2];
+  int passes[2], moved[2];
+  int r, f, n;
+
+  drain(modelLen);
+  while (modelLen < backlog)
+  {
+    post(STACK_ENTITY);
+  }
+
+  // Each twice, the first run warms up
+  for (r = 0; r < 4; r++)
+  {
+    double t0 = nowNs();
+
+    f = r % 2;
+
+    for (n = 0; n < NUM_BENCH_WAITS; n++)
+    {
+      void *msg;
+
+      postMatch();
+      if (fns[f] == NULL)
+      {
+        msg = waitMatch(&passes[f]);
+        moved[f] = 0;
+      }
+      else
+      {
+        waitId++;
+        msg = fns[f](&passes[f], &moved[f]);
+      }
+
+      CHECK((msg != NULL) && (msgSeq(msg) == matchSeq), "reply not found");
+      modelLen--;
+      matchSeq = 0;
+      freeMsg(msg);
+    }
+
+    ns[f] = (nowNs() - t0) / NUM_BENCH_WAITS;
+  }
+
+  checkQueue();
+
+  printf("  %4d    %8.0f %6d %6d   %8.0f %6d\n", backlog, ns[1], passes[1],
+         moved[1], ns[0], passes[0]);
+}
+
+int main(void)
+{
+  unsigned long maxPasses = 0;
+  int n;
+
+  srand(1);
+
+  for (n = 0; n < POOL_SIZE; n++)
+  {
+    poolFree[n] = n;
+  }
+  numPoolFree = POOL_SIZE;
+
+  ICall_entities[APP_ENTITY].service = ICALL_SERVICE_CLASS_APPLICATION;
+  ICall_entities[APP_ENTITY].task = &waiter;
+  ICall_entities[STACK_ENTITY].service = ICALL_SERVICE_CLASS_BLE;
+
+  // Stress: bursts before, during and between the passes of every wait
+  interruptChance = 8;
+  for (n = 0; n < NUM_WAITS; n++)
+  {
+    unsigned long examined0 = numExamined;
+    int queued = modelLen;
+    uint32_t seq0 = nextSeq;
+    int passes;
+    void *msg;
+
+    matchSeq = 0;
+    postBurst(rand() % 16);
+    if (rand() % 4 == 0)
+    {
+      postMatch();
+    }
+
+    msg = waitMatch(&passes);
+    CHECK((msg != NULL) && (msgSeq(msg) == matchSeq), "wrong message matched");
+    if (msg != NULL)
+    {
+      modelRemove(msgSeq(msg));
+      freeMsg(msg);
+    }
+    checkQueue();
+
+    // Each message queued before or during the wait is looked at once
+    CHECK(numExamined - examined0 <= queued + (nextSeq - seq0),
+          "wait examined more messages than were queued");
+    if (passes > maxPasses)
+    {
+      maxPasses = passes;
+    }
+
+    drain((modelLen > 64) ? modelLen / 2 : rand() % 8);
+    CHECK(csDepth == 0, "critical section left open");
+  }
+
+  printf("%d waits, %lu messages examined, %lu bursts during a pass, "
+         "at most %lu passes per wait\n", NUM_WAITS, numExamined,
+         numInterrupts, maxPasses);
+
+  // Benchmark, without bursts during the passes
+  interruptChance = 0;
+  printf("backlog   fetch and prepend           in place\n");
+  printf("          ns/wait passes  moved    ns/wait passes\n");
+  bench(0);
+  bench(8);
+  bench(32);
+  bench(128);
+  bench(512);
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("icall_match_stress: OK\n");
+
+  return (0);
+}
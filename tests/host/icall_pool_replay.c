@@ -0,0 +1,569 @@
+/*
+ * Replays a heap trace recorded with HEAPMGR_TRACE through the ICall block
+ * pools (ICALL_MSG_POOLS) in SensorTag_cc2640r2lp_app/ICall/icall.c, and
+ * through the heap alone, at the same RAM budget.
+ *
+ * icall.c needs TI-RTOS, so its pool code (ICall_msgPoolInit,
+ * ICall_blockAlloc, ICall_blockFree and ICall_blockRealloc) and the pool
+ * configuration of icall.h are extracted unchanged into icall_pools.inc
+ * and icall_pools_cfg.inc. The heap behind them is the real heapmgr.h,
+ * instantiated by heapmgr_replay_heap.h; with the pools it gets the RAM
+ * budget less the pool storage.
+ *
+ * For each RAM budget it reports the heap peak, the failed allocations,
+ * the share of requests served by the pools and the time per operation.
+ * The checks cover:
+ * - every block keeps its content until it is freed or resized, so no two
+ *   live blocks overlap, and the heap passes HEAPMGR_SANITY_CHECK after
+ *   every operation;
+ * - once the blocks are freed, every pool block is back on its free list;
+ * - a pool block resized past its pool moves with its content.
+ * The trace format is the one of heapmgr_replay.c.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed -n '/^#define ICALL_MSG_POOL_STORE_SIZE/,/^#else \/\* ICALL_MSG_POOLS \*\/$/{/^#else/d;p}' \
+ *       SensorTag_cc2640r2lp_app/ICall/icall.c > _host_tests/icall_pools.inc
+ *   sed -n '/^#ifdef ICALL_MSG_POOLS$/,/^#endif \/\* ICALL_MSG_POOLS \*\/$/p' \
+ *       SensorTag_cc2640r2lp_app/ICall/icall.h > _host_tests/icall_pools_cfg.inc
+ *   gcc -std=gnu11 -Wall -O2 -DICALL_MSG_POOLS -I_host_tests \
+ *       -ISensorTag_cc2640r2lp_app/ICall -Itests/host \
+ *       -o _host_tests/icall_pool_replay tests/host/icall_pool_replay.c
+ *   _host_tests/icall_pool_replay tests/host/data/heapmgr_trace.txt
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define NUM_RUNS   200
+
+#define HEAPMGR_METRICS
+
+// heapmgr.h picks its header alignment per target; use the 32-bit one.
+#ifndef i386
+#define i386 1
+#endif
+
+typedef struct
+{
+  unsigned size;
+  void (*init)(void);
+  void *(*malloc)(uint16_t size);
+  void (*free)(void *ptr);
+  void *(*realloc)(void *ptr, uint16_t size);
+  void (*freeStats)(unsigned *pFree, unsigned *pLargest);
+  unsigned (*peakUse)(void);
+  int (*sanityCheck)(void);
+} ReplayHeap;
+
+#include "icall_pools_cfg.inc"
+
+#define POOL_STORE  (ICALL_MSG_POOL_0_BLKSZ * ICALL_MSG_POOL_0_NUMBLKS + \
+                     ICALL_MSG_POOL_1_BLKSZ * ICALL_MSG_POOL_1_NUMBLKS + \
+                     ICALL_MSG_POOL_2_BLKSZ * ICALL_MSG_POOL_2_NUMBLKS)
+
+// RAM budgets of 3, 4 and 6 KB: the heap alone, and the pools and a heap
+#define REPLAY_HEAP_SIZE 3072
+#define REPLAY_HEAP_NAME heap3k_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE (3072 - POOL_STORE)
+#define REPLAY_HEAP_NAME pooled3k_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 4096
+#define REPLAY_HEAP_NAME heap4k_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE (4096 - POOL_STORE)
+#define REPLAY_HEAP_NAME pooled4k_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE 6144
+#define REPLAY_HEAP_NAME heap6k_
+#include "heapmgr_replay_heap.h"
+#define REPLAY_HEAP_SIZE (6144 - POOL_STORE)
+#define REPLAY_HEAP_NAME pooled6k_
+#include "heapmgr_replay_heap.h"
+
+static const ReplayHeap *budgets[][2] =
+{
+  { &heap3k_Entry, &pooled3k_Entry },
+  { &heap4k_Entry, &pooled4k_Entry },
+  { &heap6k_Entry, &pooled6k_Entry }
+};
+
+#define NUM_BUDGETS  (sizeof(budgets) / sizeof(budgets[0]))
+
+/*
+ * What icall.c provides around the pools, without HEAPMGR_TRACE
+ */
+typedef uint_least32_t ICall_CSState;
+
+static int csDepth;
+
+static ICall_CSState ICall_enterCSImpl(void)
+{
+  csDepth++;
+  return 0;
+}
+
+static void ICall_leaveCSImpl(ICall_CSState key)
+{
+  csDepth--;
+}
+
+static const ReplayHeap *curHeap;
+static unsigned heapOps;
+
+static void *heapMalloc(uint16_t size)
+{
+  heapOps++;
+  return curHeap->malloc(size);
+}
+
+static void heapFree(void *blk)
+{
+  heapOps++;
+  curHeap->free(blk);
+}
+
+static void *heapRealloc(void *blk, uint16_t size)
+{
+  heapOps++;
+  return curHeap->realloc(blk, size);
+}
+
+#define ICall_heapMallocFrom(_size, _caller)        heapMalloc(_size)
+#define ICall_heapFreeFrom(_blk, _caller)           heapFree(_blk)
+#define ICall_heapReallocFrom(_blk, _size, _caller) heapRealloc(_blk, _size)
+
+#include "icall_pools.inc"
+
+/*
+ * Trace, as read by heapmgr_replay.c: time caller offset size op. Only
+ * the offset, size and op are replayed.
+ */
+#define OP_MALLOC   0
+#define OP_FREE     1
+#define OP_REALLOC  2
+
+#define NO_OFFSET   0xFFFFFFFFu
+
+typedef struct
+{
+  uint32_t offset;
+  uint16_t size;
+  uint8_t  op;
+} Record;
+
+static Record *trace;
+static unsigned numRecords;
+
+static int loadTrace(const char *path)
+{
+  char line[256];
+  unsigned cap = 0;
+  unsigned lineNo = 0;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    return 0;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    unsigned long v[5];
+    char *p = line;
+    int i;
+
+    lineNo++;
+    while (*p == ' ' || *p == '\t')
+    {
+      p++;
+    }
+    if (*p == '#' || *p == '\n' || *p == '\0')
+    {
+      continue;
+    }
+
+    for (i = 0; i < 5; i++)
+    {
+      char *end;
+
+      v[i] = strtoul(p, &end, 0);
+      if (end == p)
+      {
+        fprintf(stderr, "%s:%u: expected 5 fields\n", path, lineNo);
+        fclose(f);
+        return 0;
+      }
+      p = end;
+    }
+
+    if (numRecords == cap)
+    {
+      cap = cap ? cap * 2 : 1024;
+      trace = realloc(trace, cap * sizeof(Record));
+      if (trace == NULL)
+      {
+        fclose(f);
+        return 0;
+      }
+    }
+    trace[numRecords].offset = (uint32_t) v[2];
+    trace[numRecords].size = (uint16_t) v[3];
+    trace[numRecords].op = (uint8_t) v[4];
+    numRecords++;
+  }
+
+  fclose(f);
+  return 1;
+}
+
+/*
+ * Blocks live in the replay, by their offset in the traced heap. Each is
+ * filled with a byte of its own.
+ */
+typedef struct
+{
+  uint32_t offset;
+  uint8_t *ptr;
+  uint16_t size;
+  uint8_t  fill;
+} Live;
+
+static Live live[1024];
+static unsigned numLive;
+static int corrupt;
+
+static Live *findLive(uint32_t offset)
+{
+  unsigned i;
+
+  for (i = 0; i < numLive; i++)
+  {
+    if (live[i].offset == offset)
+    {
+      return &live[i];
+    }
+  }
+  return NULL;
+}
+
+static int intact(const Live *l, uint16_t size)
+{
+  uint16_t i;
+
+  for (i = 0; i < size; i++)
+  {
+    if (l->ptr[i] != l->fill)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+typedef struct
+{
+  void *(*alloc)(uint16_t size);
+  void (*free)(void *blk);
+  void *(*realloc)(void *blk, uint16_t size);
+} Allocator;
+
+static void *poolAlloc(uint16_t size)
+{
+  return ICall_blockAlloc(size, 0);
+}
+
+static void poolFree(void *blk)
+{
+  ICall_blockFree(blk, 0);
+}
+
+static void *poolRealloc(void *blk, uint16_t size)
+{
+  return ICall_blockRealloc(blk, size, 0);
+}
+
+static const Allocator heapOnly = { heapMalloc, heapFree, heapRealloc };
+static const Allocator pooled = { poolAlloc, poolFree, poolRealloc };
+
+/*
+ * Replays the trace once and frees what is left. With check set, blocks
+ * are filled and verified and the heap is checked after every operation.
+ * Returns the number of failed allocations.
+ */
+static unsigned replay(const Allocator *a, int check)
+{
+  unsigned fails = 0;
+  unsigned i;
+
+  for (i = 0; i < numRecords; i++)
+  {
+    const Record *rec = &trace[i];
+    Live *l = findLive(rec->offset);
+
+    if (rec->op == OP_MALLOC && rec->offset != NO_OFFSET)
+    {
+      uint8_t *ptr = a->alloc(rec->size);
+
+      if (ptr == NULL)
+      {
+        fails++;
+      }
+      else
+      {
+        if (l == NULL)
+        {
+          l = &live[numLive++];
+        }
+        l->offset = rec->offset;
+        l->ptr = ptr;
+        l->size = rec->size;
+        l->fill = (uint8_t) i;
+        if (check)
+        {
+          memset(ptr, l->fill, rec->size);
+        }
+      }
+    }
+    else if (rec->op == OP_FREE && l != NULL)
+    {
+      if (check && !intact(l, l->size))
+      {
+        corrupt = 1;
+      }
+      a->free(l->ptr);
+      *l = live[--numLive];
+    }
+    else if (rec->op == OP_REALLOC && l != NULL)
+    {
+      uint8_t *ptr = a->realloc(l->ptr, rec->size);
+
+      if (ptr == NULL)
+      {
+        fails++;
+      }
+      else
+      {
+        l->ptr = ptr;
+        if (check)
+        {
+          if (!intact(l, (rec->size < l->size) ? rec->size : l->size))
+          {
+            corrupt = 1;
+          }
+          memset(ptr, l->fill, rec->size);
+        }
+        l->size = rec->size;
+      }
+    }
+
+    if (check && curHeap->sanityCheck() != 0)
+    {
+      corrupt = 1;
+    }
+  }
+
+  while (numLive > 0)
+  {
+    if (check && !intact(&live[numLive - 1], live[numLive - 1].size))
+    {
+      corrupt = 1;
+    }
+    a->free(live[--numLive].ptr);
+  }
+
+  return fails;
+}
+
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+// Checked replay, then timed runs; returns ns per operation
+static double run(const ReplayHeap *heap, const Allocator *a,
+                  unsigned *pFails, unsigned *pPeak, unsigned *pHeapOps)
+{
+  double t0;
+  int r;
+
+  curHeap = heap;
+  heap->init();
+  heapOps = 0;
+  *pFails = replay(a, 1);
+  *pPeak = heap->peakUse();
+  *pHeapOps = heapOps;
+
+  t0 = nowNs();
+  for (r = 0; r < NUM_RUNS; r++)
+  {
+    replay(a, 0);
+  }
+
+  return (nowNs() - t0) / ((double) NUM_RUNS * numRecords);
+}
+
+/*
+ * A pool block resized past its pool is moved with its content and does
+ * not spill into the block next to it.
+ */
+static int reallocMoves(void)
+{
+  uint8_t *blk[ICALL_MSG_POOL_0_NUMBLKS];
+  uint8_t *grown;
+  int ok = 1;
+  int i;
+
+  for (i = 0; i < ICALL_MSG_POOL_0_NUMBLKS; i++)
+  {
+    blk[i] = ICall_blockAlloc(ICALL_MSG_POOL_0_BLKSZ, 0);
+    memset(blk[i], i, ICALL_MSG_POOL_0_BLKSZ);
+  }
+
+  grown = ICall_blockRealloc(blk[0], ICALL_MSG_POOL_1_BLKSZ, 0);
+  if (grown == NULL || grown == blk[0])
+  {
+    ok = 0;
+  }
+  else
+  {
+    for (i = 0; i < ICALL_MSG_POOL_0_BLKSZ; i++)
+    {
+      ok &= (grown[i] == 0);
+    }
+    memset(grown, 0xFF, ICALL_MSG_POOL_1_BLKSZ);
+    blk[0] = grown;
+  }
+
+  for (i = 1; i < ICALL_MSG_POOL_0_NUMBLKS; i++)
+  {
+    uint16_t j;
+
+    for (j = 0; j < ICALL_MSG_POOL_0_BLKSZ; j++)
+    {
+      ok &= (blk[i][j] == i);
+    }
+  }
+
+  for (i = 0; i < ICALL_MSG_POOL_0_NUMBLKS; i++)
+  {
+    ICall_blockFree(blk[i], 0);
+  }
+
+  return ok;
+}
+
+// Every pool block is free and on its free list
+static int poolsFree(void)
+{
+  int i;
+
+  for (i = 0; i < ICALL_MSG_POOL_NUM; i++)
+  {
+    unsigned n = 0;
+    void *blk;
+
+    for (blk = ICall_msgPoolFreeList[i]; blk != NULL; blk = *(void **) blk)
+    {
+      n++;
+    }
+    if (ICall_msgPoolStats[i].inUse != 0 || n != ICall_msgPoolStats[i].numBlks)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  int failures = 0;
+  unsigned b;
+  int i;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <trace>\n", argv[0]);
+    return 2;
+  }
+  if (!loadTrace(argv[1]) || numRecords == 0)
+  {
+    fprintf(stderr, "%s: no trace records\n", argv[1]);
+    return 2;
+  }
+
+  ICall_msgPoolInit();
+  if (!reallocMoves() || !poolsFree())
+  {
+    printf("FAIL: pool block not moved on realloc\n");
+    failures++;
+  }
+
+  printf("%u records; pools of %d/%d/%d bytes x %d/%d/%d, %d bytes\n",
+         numRecords, ICALL_MSG_POOL_0_BLKSZ, ICALL_MSG_POOL_1_BLKSZ,
+         ICALL_MSG_POOL_2_BLKSZ, ICALL_MSG_POOL_0_NUMBLKS,
+         ICALL_MSG_POOL_1_NUMBLKS, ICALL_MSG_POOL_2_NUMBLKS, POOL_STORE);
+  printf("        heap only               pools + heap\n");
+  printf("   RAM | peak fails ns/op | heap  peak fails heap ops ns/op\n");
+
+  for (b = 0; b < NUM_BUDGETS; b++)
+  {
+    unsigned fails[2], peak[2], ops[2];
+    double ns[2];
+
+    ns[0] = run(budgets[b][0], &heapOnly, &fails[0], &peak[0], &ops[0]);
+
+    ICall_msgPoolInit();
+    ns[1] = run(budgets[b][1], &pooled, &fails[1], &peak[1], &ops[1]);
+
+    if (!poolsFree())
+    {
+      printf("FAIL: pool blocks not returned at %u bytes\n",
+             budgets[b][0]->size);
+      failures++;
+    }
+    if (csDepth != 0)
+    {
+      printf("FAIL: critical section left open\n");
+      failures++;
+    }
+
+    printf("%6u | %4u %5u %5.1f | %4u  %4u %5u %7u%% %5.1f\n",
+           budgets[b][0]->size, peak[0], fails[0], ns[0],
+           budgets[b][1]->size, peak[1], fails[1], ops[1] * 100 / ops[0],
+           ns[1]);
+  }
+
+  if (corrupt)
+  {
+    printf("FAIL: block content or heap corrupted\n");
+    failures++;
+  }
+
+  printf("pools, per replay: size  blocks  max in use  allocs  overflows\n");
+  for (i = 0; i < ICALL_MSG_POOL_NUM; i++)
+  {
+    printf("                   %4u  %6u  %10u  %6u  %9u\n",
+           ICall_msgPoolStats[i].blkSize, ICall_msgPoolStats[i].numBlks,
+           ICall_msgPoolStats[i].maxInUse,
+           (unsigned) (ICall_msgPoolStats[i].allocs / (NUM_RUNS + 1)),
+           (unsigned) (ICall_msgPoolStats[i].overflows / (NUM_RUNS + 1)));
+  }
+
+  if (failures)
+  {
+    return 1;
+  }
+
+  printf("icall_pool_replay: OK\n");
+
+  return 0;
+}
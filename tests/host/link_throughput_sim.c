@@ -0,0 +1,378 @@
+/*
+ * Host simulation of the link size negotiation in
+ * SensorTag_cc2640r2lp_app/PROFILES/peripheral.c, measuring the
+ * notification throughput it gets against a simulated central.
+ *
+ * The link size code of peripheral.c (GAPRole_MtuUpdated,
+ * GAPRole_DataLenUpdated, gapRole_startLinkSizeUpdate and the functions
+ * behind them) is extracted as is and runs against stand-ins for the
+ * stack. On connection the simulated central answers the LE data length
+ * request and the ATT_MTU exchange with its own capabilities, and the
+ * results reach the GAPRole as on the target: the exchange response
+ * directly, the ATT_MTU and data length events through the application
+ * task. The checks cover:
+ * - the link size callback reports the ATT_MTU and TX octets both sides
+ *   support, and is not called when nothing changed;
+ * - an update still pending for a previous connection is dropped.
+ *
+ * Throughput is then measured with the 1M PHY: every connection event
+ * the peripheral sends full notifications until the event is over or
+ * MAX_NUM_PDU HCI PDUs are used. Each LL packet takes (octets + 10) * 8 us
+ * plus the empty packet of the central and two inter frame spaces. It is
+ * printed for the link the peripheral stayed at before (23 byte ATT_MTU,
+ * 27 octets) and for the negotiated one. Build with -DMAX_PDU_SIZE=<n> for
+ * other stack builds.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   P=SensorTag_cc2640r2lp_app/PROFILES/peripheral.c
+ *   sed -n '/^\/\/ Link size requested after connection/,/^#define DEFAULT_DATA_LEN_OCTETS/p; /^\/\/ Link size update passed on by the application/,/^} gapRole_linkSizeUpdate_t;/p; /^static uint16_t gapRole_\(AttMtu\|TxOctets\|RxOctets\) = /p; /^static gapRole_linkSizeUpdate_t gapRole_PendingLinkSize /p; /^static gapRolesLinkSizeCB_t \*pGapRoles_LinkSizeCB /p; /^void GAPRole_\(RegisterLinkSizeCB\|MtuUpdated\|DataLenUpdated\)(/,/^}$/p; /@fn      gapRole_startLinkSizeUpdate$/,${ /^static void gapRole_\(startLinkSizeUpdate\|setLinkSize\|postLinkSize\|processLinkSize\)(/,/^}$/p; }' \
+ *       $P > _host_tests/peripheral_link_size.inc
+ *   gcc -std=gnu99 -Wall -I_host_tests -o _host_tests/link_throughput_sim tests/host/link_throughput_sim.c
+ *   _host_tests/link_throughput_sim
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// ble_user_config.h defaults
+#ifndef MAX_PDU_SIZE
+#define MAX_PDU_SIZE            27
+#endif
+#ifndef MAX_NUM_PDU
+#define MAX_NUM_PDU             5
+#endif
+
+#define SIM_US                  1000000
+
+// 1M PHY: an empty packet and the inter frame space, in us
+#define EMPTY_PACKET_US         80
+#define T_IFS_US                150
+
+// Longest LL payload the controllers support
+#define CONTROLLER_MAX_OCTETS   251
+
+#ifndef TRUE
+#define TRUE                    1
+#define FALSE                   0
+#endif
+
+#define VOID                    (void)
+#define MIN(n, m)               (((n) < (m)) ? (n) : (m))
+
+#define ATT_MTU_SIZE            23
+#define L2CAP_HDR_SIZE          4
+
+static int failures = 0;
+
+#define CHECK(_cond, _msg)                                              \
+  do                                                                    \
+  {                                                                     \
+    if (!(_cond))                                                       \
+    {                                                                   \
+      printf("FAIL: %s: %s\n", pCentral->name, _msg);                   \
+      failures++;                                                       \
+    }                                                                   \
+  } while (0)
+
+/*
+ * Stand-ins for TI-RTOS and the stack
+ */
+typedef unsigned int UInt;
+
+static UInt Hwi_disable(void)
+{
+  return (1);
+}
+
+static void Hwi_restore(UInt key)
+{
+}
+
+#define LINK_SIZE_UPDATE_EVT    0x0008
+
+static uint32_t gapRoleEvents;
+
+static void gapRole_setEvent(uint32_t event)
+{
+  gapRoleEvents |= event;
+}
+
+typedef void (*gapRolesLinkSizeCB_t)(uint16_t connHandle,
+                                     uint16_t attMtu,
+                                     uint16_t txOctets);
+
+typedef struct
+{
+  uint16_t clientRxMTU;
+} attExchangeMTUReq_t;
+
+static uint8_t selfEntity;
+static uint16_t gapRole_ConnectionHandle;
+
+// What the peripheral asked the stack for
+static uint16_t reqTxOctets;
+static uint16_t reqTxTime;
+static uint16_t reqMtu;
+
+static uint8_t HCI_LE_SetDataLenCmd(uint16_t connHandle, uint16_t txOctets,
+                                    uint16_t txTime)
+{
+  reqTxOctets = txOctets;
+  reqTxTime = txTime;
+
+  return (0);
+}
+
+static uint8_t GATT_ExchangeMTU(uint16_t connHandle,
+                                attExchangeMTUReq_t *pReq, uint8_t taskId)
+{
+  reqMtu = pReq->clientRxMTU;
+
+  return (0);
+}
+
+static void gapRole_startLinkSizeUpdate(uint16_t connHandle);
+static void gapRole_setLinkSize(uint16_t attMtu, uint16_t txOctets,
+                                uint16_t rxOctets);
+static void gapRole_postLinkSize(uint16_t connHandle, uint16_t attMtu,
+                                 uint16_t txOctets, uint16_t rxOctets);
+static void gapRole_processLinkSize(void);
+
+#include "peripheral_link_size.inc"
+
+/*
+ * The application's link size callback
+ */
+static int numLinkSizeCBs;
+static uint16_t appAttMtu;
+static uint16_t appTxOctets;
+
+static void appLinkSizeCB(uint16_t connHandle, uint16_t attMtu,
+                          uint16_t txOctets)
+{
+  numLinkSizeCBs++;
+  appAttMtu = attMtu;
+  appTxOctets = txOctets;
+}
+
+static gapRolesLinkSizeCB_t appLinkSizeCBPtr = appLinkSizeCB;
+
+/*
+ * The simulated central
+ */
+typedef struct
+{
+  const char *name;
+  uint16_t mtu;       // ATT_MTU it supports
+  uint16_t octets;    // LL payload it supports, 27 without DLE
+} central_t;
+
+static const central_t centrals[] =
+{
+  { "4.0 central",     23,  27 },
+  { "ATT_MTU only",   247,  27 },
+  { "DLE 185 central", 185, 251 },
+  { "DLE 247 central", 247, 251 },
+};
+
+#define NUM_CENTRALS  (sizeof(centrals) / sizeof(centrals[0]))
+
+// The GAPRole task: the GATT_MSG_EVENT case of gapRole_processStackMsg
+static void gapRoleMtuRsp(uint16_t serverRxMTU)
+{
+  gapRole_setLinkSize(MIN(serverRxMTU, GAPROLE_LINK_ATT_MTU), gapRole_TxOctets,
+                      gapRole_RxOctets);
+}
+
+// The GAPRole task: its event loop
+static void gapRoleRun(void)
+{
+  if (gapRoleEvents & LINK_SIZE_UPDATE_EVT)
+  {
+    gapRoleEvents &= ~LINK_SIZE_UPDATE_EVT;
+    gapRole_processLinkSize();
+  }
+}
+
+/*
+ * Connect to a central and negotiate the link size. The order in which
+ * the responses reach the two tasks depends on the scheduling, so it is
+ * varied with order.
+ */
+static void negotiate(const central_t *pCentral, uint16_t connHandle,
+                      int order)
+{
+  uint16_t txOctets, rxOctets, mtu;
+
+  // New connection: gapRole_processGAPMsg resets the link size
+  gapRole_ConnectionHandle = connHandle;
+  gapRole_AttMtu = ATT_MTU_SIZE;
+  gapRole_TxOctets = DEFAULT_DATA_LEN_OCTETS;
+  gapRole_RxOctets = DEFAULT_DATA_LEN_OCTETS;
+  numLinkSizeCBs = 0;
+
+  gapRole_startLinkSizeUpdate(connHandle);
+
+  // Both controllers settle on what the receiving side supports
+  txOctets = MIN(reqTxOctets, pCentral->octets);
+  rxOctets = MIN(CONTROLLER_MAX_OCTETS, pCentral->octets);
+  CHECK(reqTxTime == (reqTxOctets + 14) * 8, "TX time does not match octets");
+
+  // The ATT_MTU is the smaller of both sides
+  mtu = MIN(reqMtu, pCentral->mtu);
+
+  if (order & 1)
+  {
+    gapRoleMtuRsp(pCentral->mtu);
+  }
+
+  // The application passes the events on, the GAPRole task may run between
+  if ((txOctets != DEFAULT_DATA_LEN_OCTETS) ||
+      (rxOctets != DEFAULT_DATA_LEN_OCTETS))
+  {
+    GAPRole_DataLenUpdated(connHandle, txOctets, rxOctets);
+  }
+  if (order & 2)
+  {
+    gapRoleRun();
+  }
+  if (mtu != ATT_MTU_SIZE)
+  {
+    GAPRole_MtuUpdated(connHandle, mtu);
+  }
+  gapRoleRun();
+
+  if (!(order & 1))
+  {
+    gapRoleMtuRsp(pCentral->mtu);
+  }
+
+  CHECK(gapRole_AttMtu == mtu, "GAPRole has the wrong ATT_MTU");
+  CHECK(gapRole_TxOctets == txOctets, "GAPRole has the wrong TX octets");
+  CHECK(gapRole_RxOctets == rxOctets, "GAPRole has the wrong RX octets");
+
+  if ((mtu == ATT_MTU_SIZE) && (txOctets == DEFAULT_DATA_LEN_OCTETS) &&
+      (rxOctets == DEFAULT_DATA_LEN_OCTETS))
+  {
+    CHECK(numLinkSizeCBs == 0, "callback without a change");
+    appAttMtu = ATT_MTU_SIZE;
+    appTxOctets = DEFAULT_DATA_LEN_OCTETS;
+  }
+  else
+  {
+    CHECK(numLinkSizeCBs > 0, "no callback for a change");
+    CHECK((appAttMtu == mtu) && (appTxOctets == txOctets),
+          "callback reports the wrong link size");
+  }
+}
+
+/*
+ * Notification payload bytes per second sent by a peripheral with the
+ * given link size.
+ */
+static unsigned long throughput(uint16_t attMtu, uint16_t txOctets,
+                                unsigned connIntervalUs)
+{
+  unsigned long bytes = 0;
+  unsigned sduLeft = 0;       // L2CAP frame of the current notification
+  unsigned pduLeft = 0;       // HCI PDU being sent
+  unsigned t;
+
+  for (t = 0; t + connIntervalUs <= SIM_US; t += connIntervalUs)
+  {
+    // A PDU sent in part still holds its buffer
+    unsigned pdus = (pduLeft != 0) ? 1 : 0;
+    unsigned eventUs = 0;
+
+    for (;;)
+    {
+      unsigned octets, exchangeUs;
+
+      if (sduLeft == 0)
+      {
+        // Full notification: ATT_MTU bytes of ATT PDU
+        sduLeft = attMtu + L2CAP_HDR_SIZE;
+      }
+
+      octets = MIN(txOctets, (pduLeft != 0) ? pduLeft :
+                             MIN(sduLeft, MAX_PDU_SIZE));
+      exchangeUs = EMPTY_PACKET_US + T_IFS_US + (octets + 10) * 8 + T_IFS_US;
+
+      if ((eventUs + exchangeUs > connIntervalUs) ||
+          ((pduLeft == 0) && (pdus == MAX_NUM_PDU)))
+      {
+        break;
+      }
+
+      if (pduLeft == 0)
+      {
+        pduLeft = MIN(sduLeft, MAX_PDU_SIZE);
+        pdus++;
+      }
+
+      eventUs += exchangeUs;
+      pduLeft -= octets;
+      sduLeft -= octets;
+
+      if (sduLeft == 0)
+      {
+        bytes += attMtu - 3;
+      }
+    }
+  }
+
+  return (bytes);
+}
+
+int main(void)
+{
+  static const unsigned intervals[] = { 7500, 30000 };
+  uint16_t connHandle = 0;
+  unsigned c, i;
+
+  GAPRole_RegisterLinkSizeCB(&appLinkSizeCBPtr);
+
+  printf("MAX_PDU_SIZE %d, MAX_NUM_PDU %d: ATT_MTU requested %d, "
+         "TX octets %d\n", MAX_PDU_SIZE, MAX_NUM_PDU, GAPROLE_LINK_ATT_MTU,
+         GAPROLE_LINK_TX_OCTETS);
+  printf("  central         interval  link (MTU/TX)    kbit/s\n");
+  printf("                            before  after  before   after\n");
+
+  for (c = 0; c < NUM_CENTRALS; c++)
+  {
+    const central_t *pCentral = &centrals[c];
+    int order;
+
+    for (order = 0; order < 4; order++)
+    {
+      // Update left over from the previous connection, then a new one
+      GAPRole_DataLenUpdated(connHandle, 100, 100);
+      connHandle++;
+      negotiate(pCentral, connHandle, order);
+    }
+
+    for (i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++)
+    {
+      unsigned long before = throughput(ATT_MTU_SIZE, DEFAULT_DATA_LEN_OCTETS,
+                                        intervals[i]);
+      unsigned long after = throughput(appAttMtu, appTxOctets, intervals[i]);
+
+      CHECK(after >= before, "negotiated link is slower");
+
+      printf("  %-16s %4.1f ms  %3d/%-3d %3d/%-3d %7.1f %7.1f\n",
+             pCentral->name, intervals[i] / 1000.0, ATT_MTU_SIZE,
+             DEFAULT_DATA_LEN_OCTETS, appAttMtu, appTxOctets,
+             before * 8 / 1000.0, after * 8 / 1000.0);
+    }
+  }
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("link_throughput_sim: OK\n");
+
+  return (0);
+}
@@ -0,0 +1,809 @@
+/*
+ * Host test for the flash sample recorder in
+ * SensorTag_cc2640r2lp_app/Application/sensortag_recorder.c, run end to
+ * end against an emulated flash and an emulated central.
+ *
+ * sensortag_recorder.c only includes SDK headers for types and driver
+ * calls, so it is compiled here with its #include lines removed and the
+ * stand-ins below; the RECORDER_ constants come from recorderservice.h.
+ * - The flash wrapper calls the recorder makes through icall_directAPI
+ *   are emulated on the .recorder pages: an erase sets a page to 0xFF, a
+ *   program can only clear bits. A program that would have to set a bit
+ *   fails the test, and one program can be made to fail half way.
+ * - The central takes as many notifications per connection event as the
+ *   stack has buffers, then the connection event end calls
+ *   SensorTagRecorder_processDownloadEvt as sensortag_lp.c does.
+ * The test records a moving and resting accelerometer long enough to wrap
+ * the ring of pages, downloads the log in one go and again with a
+ * disconnect in the middle, and checks every byte against the flash and
+ * every sample against the readings. Last, a failed program must leave a
+ * torn record that the reader drops and move the writer on to the next
+ * page.
+ *
+ * Arguments: [ATT_MTU] [buffers per connection event], 23 and 6 by default.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed '/^#include /d' SensorTag_cc2640r2lp_app/Application/sensortag_recorder.c \
+ *       > _host_tests/sensortag_recorder_body.inc
+ *   sed -n '/^#define RECORDER_/p' SensorTag_cc2640r2lp_app/PROFILES/recorderservice.h \
+ *       > _host_tests/recorderservice_defs.inc
+ *   gcc -std=gnu99 -Wall -Wno-pointer-to-int-cast -Itests/host/stubs -I_host_tests \
+ *       -o _host_tests/recorder_download_test tests/host/recorder_download_test.c
+ *   _host_tests/recorder_download_test 247 4
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+
+#define NUM_READINGS          8000
+#define FAULT_READINGS        400
+#define CONN_HANDLE           0
+#define CONN_INTERVAL_MS      7.5
+#define MAX_CONN_EVENTS       100000
+
+// bcomdef.h
+typedef uint8 bStatus_t;
+
+#define SUCCESS               0x00
+#define FAILURE               0x01
+#define bleIncorrectMode      0x12
+#define bleNoResources        0x1A
+#define INVALID_CONNHANDLE    0xFFFF
+
+#define LO_UINT16(a)          ((a) & 0xFF)
+#define HI_UINT16(a)          (((a) >> 8) & 0xFF)
+#define BUILD_UINT16(lo, hi)  ((uint16)(((lo) & 0xFF) + (((hi) & 0xFF) << 8)))
+#define BUILD_UINT32(b0, b1, b2, b3) \
+  ((uint32)((uint32)((b0) & 0xFF) + ((uint32)((b1) & 0xFF) << 8) + \
+            ((uint32)((b2) & 0xFF) << 16) + ((uint32)((b3) & 0xFF) << 24)))
+#define BREAK_UINT32(var, n)  ((uint8)((uint32)(((var) >> ((n) * 8)) & 0xFF)))
+#define MIN(a, b)             (((a) < (b)) ? (a) : (b))
+
+// icall.h
+#define ICALL_SERVICE_CLASS_BLE   0x0010
+
+uint32_t icall_directAPI(uint8_t service, uint32_t id, ...);
+
+// TI-RTOS and util.h
+typedef uintptr_t UArg;
+typedef int Clock_Struct;
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+static uint32_t pendingEvents;
+static bool sampleClockRunning;
+
+#define syncEvent             NULL
+#define Event_post(h, ev)     (pendingEvents |= (ev))
+
+static void Util_constructClock(Clock_Struct *pClock, Clock_FuncPtr clockCB,
+                                uint32_t duration, uint32_t period,
+                                uint8_t startFlag, UArg arg)
+{
+}
+
+static void Util_startClock(Clock_Struct *pClock)
+{
+  sampleClockRunning = true;
+}
+
+static void Util_stopClock(Clock_Struct *pClock)
+{
+  sampleClockRunning = false;
+}
+
+// sensortag.h
+#define ST_REC_SAMPLE_EVT     0x0800
+#define ST_REC_DOWNLOAD_EVT   0x1000
+#define SERVICE_ID_RECORDER   0x10
+
+static void SensorTag_charValueChangeCB(uint8_t sensorID, uint8_t paramID)
+{
+}
+
+// st_util.h and recorderservice.h
+typedef void (*sensorChange_t)(uint8_t paramID);
+
+typedef struct
+{
+  sensorChange_t pfnSensorChange;
+} sensorCBs_t;
+
+#include "recorderservice_defs.inc"
+
+static bStatus_t Recorder_addService(void)
+{
+  return (SUCCESS);
+}
+
+static bStatus_t Recorder_registerAppCBs(sensorCBs_t *appCallbacks)
+{
+  return (SUCCESS);
+}
+
+static uint8_t recCommand[RECORDER_COMMAND_LEN];
+static uint8_t recStatus[RECORDER_STATUS_LEN];
+
+static bStatus_t Recorder_setParameter(uint8_t param, uint8_t len, void *value)
+{
+  if ((param == RECORDER_STATUS) && (len == RECORDER_STATUS_LEN))
+  {
+    memcpy(recStatus, value, len);
+  }
+
+  return (SUCCESS);
+}
+
+static bStatus_t Recorder_getParameter(uint8_t param, void *value)
+{
+  memcpy(value, recCommand, RECORDER_COMMAND_LEN);
+
+  return (SUCCESS);
+}
+
+static uint16_t Recorder_getConnHandle(void)
+{
+  return (CONN_HANDLE);
+}
+
+static bStatus_t Recorder_sendData(uint32_t offset, const uint8_t *pData,
+                                   uint16_t len, uint16_t *pSent);
+
+// gatt_tx_queue.h
+static uint16 heldConn = INVALID_CONNHANDLE;
+
+static bStatus_t GATTTxQueue_holdConnEvt(uint16 connHandle, uint8 hold)
+{
+  if (hold)
+  {
+    heldConn = connHandle;
+  }
+  else if (heldConn == connHandle)
+  {
+    heldConn = INVALID_CONNHANDLE;
+  }
+
+  return (SUCCESS);
+}
+
+// bma250.h, the readings are made up by the test
+static int8_t readings[NUM_READINGS + FAULT_READINGS][3];
+static int curReading;
+static int accInits;
+static int accStops;
+
+static void Acc_init(void)
+{
+  accInits++;
+}
+
+static void Acc_stop(void)
+{
+  accStops++;
+}
+
+static void Acc_readAcc(int8_t *pX, int8_t *pY, int8_t *pZ)
+{
+  *pX = readings[curReading][0];
+  *pY = readings[curReading][1];
+  *pZ = readings[curReading][2];
+}
+
+// driverlib, the RTC counts one second per reading
+#define VIMS_BASE             0
+#define VIMS_MODE_DISABLED    0
+#define VIMS_MODE_ENABLED     1
+
+static uint64_t rtcNow;
+static uint32_t vimsMode = VIMS_MODE_ENABLED;
+
+static uint64_t AONRTCCurrent64BitValueGet(void)
+{
+  return (rtcNow);
+}
+
+static uint32_t VIMSModeGet(uint32_t base)
+{
+  return (vimsMode);
+}
+
+static void VIMSModeSet(uint32_t base, uint32_t mode)
+{
+  vimsMode = mode;
+}
+
+#include "sensortag_recorder_body.inc"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do                            \
+  {                             \
+    if (!(cond))                \
+    {                           \
+      printf("FAIL: ");         \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+/*
+ * Flash emulation
+ */
+#define FLASH_SIZE  sizeof(recorderFlash)
+
+static uint8_t *flash;
+static int flashErases[ST_REC_NUM_PAGES];
+static int flashPrograms;
+static int flashFailAfter = -1; // Bytes the next program gets through
+
+static uint32_t flashOffset(uint32_t addr)
+{
+  // The recorder passes 32-bit addresses, keep the low bits of the host's
+  return (addr - (uint32_t)(uintptr_t)recorderFlash);
+}
+
+uint32_t icall_directAPI(uint8_t service, uint32_t id, ...)
+{
+  va_list ap;
+  uint32_t offset;
+
+  CHECK(service == ICALL_SERVICE_CLASS_BLE, "service 0x%X", service);
+  CHECK(vimsMode == VIMS_MODE_DISABLED, "flash operation with the cache on");
+
+  va_start(ap, id);
+  offset = flashOffset(va_arg(ap, uint32_t));
+
+  if (id == ST_REC_IDX_FLASH_ERASE)
+  {
+    CHECK((offset < FLASH_SIZE) && (offset % ST_REC_PAGE_SIZE == 0),
+          "erase at offset %u", offset);
+
+    memset(&flash[offset], 0xFF, ST_REC_PAGE_SIZE);
+    flashErases[offset / ST_REC_PAGE_SIZE]++;
+  }
+  else if (id == ST_REC_IDX_FLASH_WRITE)
+  {
+    const uint8_t *pBuf = va_arg(ap, const uint8_t *);
+    int cnt = va_arg(ap, int);
+    int i;
+
+    CHECK(offset + cnt <= FLASH_SIZE, "program at offset %u", offset);
+
+    if ((flashFailAfter >= 0) && (flashFailAfter < cnt))
+    {
+      cnt = flashFailAfter;
+      flashFailAfter = -1;
+    }
+
+    for (i = 0; i < cnt; i++)
+    {
+      CHECK((pBuf[i] & ~flash[offset + i]) == 0,
+            "program sets bits at offset %u", offset + i);
+
+      flash[offset + i] &= pBuf[i];
+    }
+
+    flashPrograms++;
+  }
+  else
+  {
+    CHECK(0, "jump table index %u", id);
+  }
+
+  va_end(ap);
+
+  return (0);
+}
+
+/*
+ * Central emulation
+ */
+static uint16_t attMtu = 23;
+static int buffersPerEvent = 6;
+
+static bool connected;
+static int buffersLeft;
+static uint8_t rxLog[ST_REC_NUM_PAGES * ST_REC_PAGE_SIZE];
+static uint8_t rxGot[ST_REC_NUM_PAGES * ST_REC_PAGE_SIZE];
+static uint32_t rxBase;     // Log offset of rxLog[0]
+static uint32_t rxNext;     // Log offset after the last byte received
+static bool rxEnd;
+static int rxNotifications;
+static uint32_t rxBytes;
+
+static bStatus_t Recorder_sendData(uint32_t offset, const uint8_t *pData,
+                                   uint16_t len, uint16_t *pSent)
+{
+  *pSent = 0;
+
+  if (!connected)
+  {
+    return (bleIncorrectMode);
+  }
+
+  if (buffersLeft == 0)
+  {
+    return (bleNoResources);
+  }
+
+  buffersLeft--;
+  rxNotifications++;
+
+  if (len > attMtu - 3 - RECORDER_OFFSET_LEN)
+  {
+    len = attMtu - 3 - RECORDER_OFFSET_LEN;
+  }
+
+  CHECK(offset >= rxNext, "offset %u after %u", offset, rxNext);
+  CHECK(!rxEnd, "notification after the end of the log");
+
+  if (len == 0)
+  {
+    rxEnd = true;
+  }
+  else if ((offset >= rxBase) && (offset + len - rxBase <= sizeof(rxLog)))
+  {
+    memcpy(&rxLog[offset - rxBase], pData, len);
+    memset(&rxGot[offset - rxBase], 1, len);
+    rxBytes += len;
+  }
+  else
+  {
+    CHECK(0, "offset %u outside the log", offset);
+  }
+
+  rxNext = offset + len;
+  *pSent = len;
+
+  return (SUCCESS);
+}
+
+static uint32_t statusOffset(int index)
+{
+  return (BUILD_UINT32(recStatus[index], recStatus[index + 1],
+                       recStatus[index + 2], recStatus[index + 3]));
+}
+
+static void sendCommand(uint8_t cmd, uint32_t offset)
+{
+  recCommand[0] = cmd;
+  recCommand[1] = BREAK_UINT32(offset, 0);
+  recCommand[2] = BREAK_UINT32(offset, 1);
+  recCommand[3] = BREAK_UINT32(offset, 2);
+  recCommand[4] = BREAK_UINT32(offset, 3);
+
+  SensorTagRecorder_processCharChangeEvt(RECORDER_COMMAND);
+}
+
+/*
+ * Run connection events until the end of the log arrives or the given
+ * number of events has passed. The event the recorder posts when a
+ * download starts is handled first, on the buffers still free.
+ *
+ * Returns the number of connection events.
+ */
+static int runConnEvents(int maxEvents)
+{
+  int events = 0;
+
+  if (pendingEvents & ST_REC_DOWNLOAD_EVT)
+  {
+    pendingEvents &= ~ST_REC_DOWNLOAD_EVT;
+    SensorTagRecorder_processDownloadEvt();
+  }
+
+  while (!rxEnd && (events < maxEvents))
+  {
+    // The connection event sent the queued notifications
+    buffersLeft = buffersPerEvent;
+    events++;
+
+    if (heldConn == CONN_HANDLE)
+    {
+      SensorTagRecorder_processDownloadEvt();
+    }
+  }
+
+  return (events);
+}
+
+static void startDownload(uint32_t offset, bool newLog)
+{
+  if (newLog)
+  {
+    memset(rxGot, 0, sizeof(rxGot));
+    rxBase = statusOffset(1);
+    rxBytes = 0;
+    rxNotifications = 0;
+  }
+
+  connected = true;
+  buffersLeft = buffersPerEvent;
+  rxNext = offset;
+  rxEnd = false;
+
+  sendCommand(RECORDER_CMD_START, offset);
+
+  CHECK(heldConn == CONN_HANDLE, "connection event notice not held");
+  CHECK(recStatus[0] == RECORDER_STATE_DOWNLOAD, "state %u", recStatus[0]);
+}
+
+/*
+ * Log checks
+ */
+static uint16_t crc16(const uint8_t *pBuf, int len)
+{
+  uint16_t crc = 0xFFFF;
+  int bit;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)(*pBuf++) << 8;
+
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+
+  return (crc);
+}
+
+static bool near(const int8_t *pA, const int8_t *pB)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+  {
+    if (abs(pA[i] - pB[i]) > ST_REC_DEADBAND)
+    {
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+// Physical page holding a sequence number, -1 if none does
+static int findPage(uint32_t seq)
+{
+  int page;
+
+  for (page = 0; page < ST_REC_NUM_PAGES; page++)
+  {
+    const uint8_t *pHdr = &flash[page * ST_REC_PAGE_SIZE];
+
+    if ((BUILD_UINT16(pHdr[0], pHdr[1]) == ST_REC_PAGE_MAGIC) &&
+        (BUILD_UINT32(pHdr[4], pHdr[5], pHdr[6], pHdr[7]) == seq))
+    {
+      return (page);
+    }
+  }
+
+  return (-1);
+}
+
+// The download must hold the whole log, byte for byte as in flash
+static void checkDownload(const char *name)
+{
+  uint32_t oldest = statusOffset(1);
+  uint32_t end = statusOffset(5);
+  uint32_t offset;
+
+  CHECK(rxEnd, "%s: no end of log", name);
+  CHECK(rxNext == end, "%s: ended at %u, log ends at %u", name, rxNext, end);
+  CHECK(oldest == rxBase, "%s: log moved during the download", name);
+  CHECK(heldConn == INVALID_CONNHANDLE, "%s: notice still held", name);
+  CHECK(recStatus[0] != RECORDER_STATE_DOWNLOAD, "%s: still downloading", name);
+
+  for (offset = oldest; offset < end; offset++)
+  {
+    int page = findPage(offset / ST_REC_PAGE_SIZE);
+
+    if ((page < 0) || !rxGot[offset - rxBase] ||
+        (rxLog[offset - rxBase] !=
+         flash[page * ST_REC_PAGE_SIZE + offset % ST_REC_PAGE_SIZE]))
+    {
+      CHECK(0, "%s: byte at log offset %u", name, offset);
+      break;
+    }
+  }
+}
+
+typedef struct
+{
+  int records;
+  int torn;
+  int afterTorn;  // Records written behind a torn one in its page
+  int boots;
+  int samples;
+  int gaps;
+} logInfo_t;
+
+// Walk the downloaded log like a reader would and check the samples
+static void decodeLog(logInfo_t *pInfo)
+{
+  uint32_t oldest = statusOffset(1);
+  uint32_t end = statusOffset(5);
+  uint32_t seq;
+  int lastIndex = -1;
+
+  memset(pInfo, 0, sizeof(*pInfo));
+
+  for (seq = oldest / ST_REC_PAGE_SIZE; seq * ST_REC_PAGE_SIZE < end; seq++)
+  {
+    const uint8_t *pPage = &rxLog[seq * ST_REC_PAGE_SIZE - rxBase];
+    uint32_t pageEnd = MIN(ST_REC_PAGE_SIZE, end - seq * ST_REC_PAGE_SIZE);
+    uint32_t off = ST_REC_PAGE_HDR_LEN;
+    bool torn = false;
+
+    CHECK((BUILD_UINT16(pPage[0], pPage[1]) == ST_REC_PAGE_MAGIC) &&
+          (BUILD_UINT32(pPage[4], pPage[5], pPage[6], pPage[7]) == seq),
+          "page header of sequence %u", seq);
+
+    while ((off + ST_REC_REC_OVERHEAD <= pageEnd) && (pPage[off] != ST_REC_FREE))
+    {
+      const uint8_t *pRec = &pPage[off];
+      uint8_t len = pRec[0];
+
+      if (off + ST_REC_REC_OVERHEAD + len > pageEnd)
+      {
+        CHECK(0, "record at log offset %u runs past the page",
+              seq * ST_REC_PAGE_SIZE + off);
+        break;
+      }
+
+      off += ST_REC_REC_OVERHEAD + len;
+
+      if (crc16(pRec, ST_REC_REC_HDR_LEN + len) !=
+          BUILD_UINT16(pRec[ST_REC_REC_HDR_LEN + len],
+                       pRec[ST_REC_REC_HDR_LEN + len + 1]))
+      {
+        pInfo->torn++;
+        torn = true;
+        continue;
+      }
+
+      pInfo->records++;
+      if (torn)
+      {
+        pInfo->afterTorn++;
+      }
+
+      if (pRec[1] == ST_REC_TYPE_BOOT)
+      {
+        pInfo->boots++;
+      }
+      else if (pRec[1] == ST_REC_TYPE_ACCEL)
+      {
+        const uint8_t *pSample = &pRec[ST_REC_REC_HDR_LEN + ST_REC_ACCEL_HDR_LEN];
+        int num = (len - ST_REC_ACCEL_HDR_LEN) / ST_REC_SAMPLE_LEN;
+        int index = BUILD_UINT32(pRec[2], pRec[3], pRec[4], pRec[5]);
+        int prev = -1;
+        int i;
+
+        CHECK(BUILD_UINT16(pRec[8], pRec[9]) == ST_REC_SAMPLE_PERIOD,
+              "sample period %u", BUILD_UINT16(pRec[8], pRec[9]));
+
+        if ((lastIndex >= 0) && (index != lastIndex + 1))
+        {
+          pInfo->gaps++;
+        }
+
+        for (i = 0; i < num; i++, pSample += ST_REC_SAMPLE_LEN)
+        {
+          int j;
+
+          if (i > 0)
+          {
+            index += pSample[0] + 1;
+          }
+          else
+          {
+            CHECK(pSample[0] == 0, "skip count of the first sample");
+          }
+
+          if (index >= NUM_READINGS + FAULT_READINGS)
+          {
+            CHECK(0, "sample %d past the readings", index);
+            break;
+          }
+
+          CHECK(((int8_t)pSample[1] == readings[index][0]) &&
+                ((int8_t)pSample[2] == readings[index][1]) &&
+                ((int8_t)pSample[3] == readings[index][2]),
+                "sample %d does not match its reading", index);
+
+          // Readings left out must be close to the last stored one
+          for (j = prev + 1; (prev >= 0) && (j < index); j++)
+          {
+            CHECK(near(readings[j], readings[prev]),
+                  "reading %d left out but not near %d", j, prev);
+          }
+
+          prev = index;
+          pInfo->samples++;
+        }
+
+        lastIndex = index;
+      }
+      else
+      {
+        CHECK(0, "record type 0x%02X", pRec[1]);
+      }
+    }
+  }
+}
+
+/*
+ * Test phases
+ */
+
+// Readings alternate between resting, with some noise, and moving
+static void makeReadings(void)
+{
+  uint32_t seed = 12345;
+  int8_t pos[3] = { 0, 0, 64 };
+  bool moving = false;
+  int i, a;
+
+  for (i = 0; i < NUM_READINGS + FAULT_READINGS; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    if (((seed >> 16) % 50) == 0)
+    {
+      moving = !moving;
+    }
+
+    for (a = 0; a < 3; a++)
+    {
+      seed = seed * 1103515245 + 12345;
+      readings[i][a] = pos[a] + (int)((seed >> 16) % (moving ? 41 : 3)) -
+                       (moving ? 20 : 1);
+      if (moving)
+      {
+        pos[a] = readings[i][a];
+      }
+    }
+  }
+}
+
+static void record(int from, int to)
+{
+  int inits = accInits;
+
+  SensorTagRecorder_start();
+  CHECK(SensorTagRecorder_isRecording() && sampleClockRunning,
+        "not recording");
+
+  for (curReading = from; curReading < to; curReading++)
+  {
+    rtcNow = (uint64_t)curReading << 32;
+    SensorTagRecorder_processSampleEvt();
+  }
+
+  CHECK(accInits == inits + 1, "%d accelerometer inits for one recording",
+        accInits - inits);
+
+  SensorTagRecorder_stop();
+  CHECK(!SensorTagRecorder_isRecording() && !sampleClockRunning,
+        "still recording");
+}
+
+static void printDownload(const char *name, int events)
+{
+  printf("%s: %u bytes in %d notifications, %d connection events, "
+         "%.0f bytes/s at %.1f ms\n", name, rxBytes, rxNotifications, events,
+         rxBytes / (events * CONN_INTERVAL_MS / 1000.0), CONN_INTERVAL_MS);
+}
+
+int main(int argc, char **argv)
+{
+  long pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)recorderFlash & ~(uintptr_t)(pageSize - 1);
+  uintptr_t stop = (uintptr_t)recorderFlash + FLASH_SIZE;
+  uint8_t fullLog[sizeof(rxLog)];
+  logInfo_t info;
+  uint32_t end;
+  int events, page, minErases, maxErases;
+
+  if (argc > 1)
+  {
+    attMtu = atoi(argv[1]);
+  }
+  if (argc > 2)
+  {
+    buffersPerEvent = atoi(argv[2]);
+  }
+
+  // The log lives in a read-only section, as in the target's flash
+  if (mprotect((void *)start, stop - start, PROT_READ | PROT_WRITE) != 0)
+  {
+    perror("mprotect");
+    return (1);
+  }
+  flash = (uint8_t *)recorderFlash;
+  memset(flash, 0xFF, FLASH_SIZE);
+
+  makeReadings();
+
+  SensorTagRecorder_init();
+  SensorTagRecorder_open();
+  record(0, NUM_READINGS);
+
+  end = SensorTagRecorder_end();
+  SensorTagRecorder_mount();
+  CHECK(SensorTagRecorder_end() == end, "mounted end %u, was %u",
+        SensorTagRecorder_end(), end);
+
+  // Full download
+  startDownload(0, true);
+  events = runConnEvents(MAX_CONN_EVENTS);
+  checkDownload("download");
+  printDownload("download", events);
+  memcpy(fullLog, rxLog, sizeof(rxLog));
+
+  decodeLog(&info);
+  CHECK((info.torn == 0) && (info.gaps == 0), "%d torn records, %d gaps",
+        info.torn, info.gaps);
+  CHECK(statusOffset(1) > 0, "the log did not wrap");
+  printf("log: %d readings, %d samples in %d records kept, %d erases, "
+         "%d programs\n", NUM_READINGS, info.samples, info.records,
+         flashErases[0] + flashErases[1] + flashErases[2], flashPrograms);
+
+  // The ring wears the pages evenly
+  minErases = maxErases = flashErases[0];
+  for (page = 1; page < ST_REC_NUM_PAGES; page++)
+  {
+    minErases = MIN(minErases, flashErases[page]);
+    maxErases = (flashErases[page] > maxErases) ? flashErases[page] : maxErases;
+  }
+  CHECK(maxErases - minErases <= 1, "page erases from %d to %d", minErases,
+        maxErases);
+
+  // Disconnect half way, then resume from the last offset received
+  startDownload(0, true);
+  runConnEvents(events / 2);
+  CHECK(!rxEnd, "download too short to interrupt");
+  connected = false;
+  SensorTagRecorder_reset();
+  CHECK(heldConn == INVALID_CONNHANDLE, "notice held after the disconnect");
+  CHECK(recStatus[0] == RECORDER_STATE_IDLE, "state %u", recStatus[0]);
+
+  startDownload(rxNext, false);
+  runConnEvents(MAX_CONN_EVENTS);
+  checkDownload("resumed download");
+  CHECK(memcmp(fullLog, rxLog, statusOffset(5) - rxBase) == 0,
+        "resumed download differs");
+
+  // A program that stops half way: the reader drops the torn record and
+  // the writer does not write behind it
+  flashFailAfter = ST_REC_REC_OVERHEAD;
+  record(NUM_READINGS, NUM_READINGS + FAULT_READINGS);
+  CHECK(flashFailAfter < 0, "no program failed");
+
+  startDownload(0, true);
+  runConnEvents(MAX_CONN_EVENTS);
+  checkDownload("download after a failed program");
+  decodeLog(&info);
+  CHECK((info.torn == 1) && (info.afterTorn == 0),
+        "%d torn records, %d records behind them", info.torn, info.afterTorn);
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("recorder_download_test (ATT_MTU %u, %d buffers): OK\n", attMtu,
+         buffersPerEvent);
+
+  return (0);
+}
@@ -0,0 +1,140 @@
+#!/bin/sh
+# Builds and runs the host tests. Run from the repository root.
+# CC and OUT may be overridden, e.g. CC=clang OUT=/tmp/host sh tests/host/run.sh
+set -e
+
+CC=${CC:-gcc}
+OUT=${OUT:-_host_tests}
+CFLAGS="-std=gnu99 -Wall -Wno-pointer-to-int-cast -Itests/host/stubs"
+
+mkdir -p "$OUT"
+
+$CC $CFLAGS -O2 -o "$OUT/crc16_test" tests/host/crc16_test.c
+"$OUT/crc16_test"
+$CC $CFLAGS -O2 -DCRC16_TABLE_IN_RAM -o "$OUT/crc16_test_ram" tests/host/crc16_test.c
+"$OUT/crc16_test_ram"
+
+HEAPMGR_FLAGS="-ISensorTag_cc2640r2lp_app/ICall"
+$CC $CFLAGS $HEAPMGR_FLAGS -o "$OUT/heapmgr_realloc_test" tests/host/heapmgr_realloc_test.c
+"$OUT/heapmgr_realloc_test"
+$CC $CFLAGS $HEAPMGR_FLAGS -DHEAPMGR_TRACE -o "$OUT/heapmgr_realloc_test_trace" tests/host/heapmgr_realloc_test.c
+"$OUT/heapmgr_realloc_test_trace"
+$CC $CFLAGS $HEAPMGR_FLAGS -DHEAPMGR_IDLE_MAINT -o "$OUT/heapmgr_realloc_test_maint" tests/host/heapmgr_realloc_test.c
+"$OUT/heapmgr_realloc_test_maint"
+
+# gapbondmgr.c needs SDK headers, so its bond index and private address
+# resolution code is extracted as is
+GAPBONDMGR=Sensortag_cc2640r2lp_stack/PROFILES/gapbondmgr.c
+sed -n '/^#ifndef GAP_BOND_HASH_SIZE$/,/^#define GAP_BOND_HASH_EMPTY/p' \
+    $GAPBONDMGR > "$OUT/gapbondmgr_hash_size.inc"
+sed -n '/^static [a-z0-9]* gapBondMgr\(HashAddr\|FindHashedAddr\|HashInsert\|IndexBonds\|FindEmpty\)(.*)$/,/^}$/p' \
+    $GAPBONDMGR > "$OUT/gapbondmgr_hash.inc"
+for bonds in 5 10 64; do
+  $CC $CFLAGS -I"$OUT" -DGAP_BONDINGS_MAX=$bonds \
+      -o "$OUT/gapbond_hash_test_$bonds" tests/host/gapbond_hash_test.c
+  "$OUT/gapbond_hash_test_$bonds"
+done
+sed -n '/^#ifndef GAP_BOND_RPA_CACHE_SIZE$/,/^#endif \/\/ GAP_BOND_RPA_CACHE_SIZE$/p; /^\/\/ Structure of a RAM copy of a bonded device.s IRK$/,/^} gapBondRpa_t;$/p; /^static gapBondIrk_t gapBond_irkTbl/,/^static uint8 gapBond_rpaCacheNext/p; /^static [a-z0-9]* gapBondMgr\(ResolvePrivateAddr\|ReadIrks\|SetIrk\)( .*)$/,/^}$/p' \
+    $GAPBONDMGR > "$OUT/gapbondmgr_rpa.inc"
+for bonds in 10 64; do
+  $CC $CFLAGS -I"$OUT" -DGAP_BONDINGS_MAX=$bonds \
+      -o "$OUT/gapbond_rpa_bench_$bonds" tests/host/gapbond_rpa_bench.c
+  "$OUT/gapbond_rpa_bench_$bonds"
+done
+
+# The TI UUID alias list in both copies of gatt_uuid.c must match the generator
+$CC $CFLAGS -o "$OUT/gatt_uuid_gen" tests/host/gatt_uuid_gen.c
+PROFILES=SensorTag_cc2640r2lp_app/PROFILES
+"$OUT/gatt_uuid_gen" $PROFILES/ioservice.h $PROFILES/registerservice.h \
+    $PROFILES/recorderservice.h $PROFILES/diagservice.h $PROFILES/ccservice.h \
+    > "$OUT/gatt_uuid_aliases.txt"
+for f in Sensortag_cc2640r2lp_stack/Host/gatt_uuid.c SensorTag_cc2640r2lp_app/PROFILES/gatt_uuid.c; do
+  sed -n '/^#define GATT_TI_UUID_ALIASES/,/[^\\]$/p' $f | diff -u "$OUT/gatt_uuid_aliases.txt" -
+done
+
+# gatt_uuid.c only needs SDK headers for types, so it is built without its includes
+sed '/^#include /d' Sensortag_cc2640r2lp_stack/Host/gatt_uuid.c > "$OUT/gatt_uuid_body.inc"
+$CC $CFLAGS -O2 -I"$OUT" -ISensortag_cc2640r2lp_stack/Host \
+    -o "$OUT/gatt_uuid_bench" tests/host/gatt_uuid_bench.c
+"$OUT/gatt_uuid_bench"
+
+# gatt_db_hash.c needs SDK headers, so its hash code is extracted as is
+GATTDBHASH=SensorTag_cc2640r2lp_app/PROFILES/gatt_db_hash.c
+sed -n '/^#define GATT_DB_HASH_\(POLY\|INIT\) /p; /^static uint16 gattDbHashValue /p; /^[a-zA-Z0-9_ ]*\(GATTDbHash_[a-zA-Z]*\|gattDbHash_crc\)(.*)$/,/^}$/p' \
+    $GATTDBHASH > "$OUT/gatt_db_hash.inc"
+$CC $CFLAGS -I"$OUT" -o "$OUT/gatt_discovery_sim" tests/host/gatt_discovery_sim.c
+"$OUT/gatt_discovery_sim"
+"$OUT/gatt_discovery_sim" 185
+
+# sensortag_recorder.c only needs SDK headers for types and driver calls,
+# so it is built without its includes against an emulated flash and central
+sed '/^#include /d' SensorTag_cc2640r2lp_app/Application/sensortag_recorder.c \
+    > "$OUT/sensortag_recorder_body.inc"
+sed -n '/^#define RECORDER_/p' SensorTag_cc2640r2lp_app/PROFILES/recorderservice.h \
+    > "$OUT/recorderservice_defs.inc"
+$CC $CFLAGS -I"$OUT" -o "$OUT/recorder_download_test" tests/host/recorder_download_test.c
+"$OUT/recorder_download_test"
+"$OUT/recorder_download_test" 247 4
+
+# icall.c needs TI-RTOS, so its task and service lookups and its message
+# queue code are extracted as is
+sed -n '/^#define ICALL_SERVICE_INDEX(/,/^static ICall_EntityID ICall_serviceEntities/p; /^static ICall_TaskEntry \*ICall_\(searchTask\|newTask\)(.*)$/,/^}$/p; /^static void ICall_setServiceEntity(/,/^}$/p; /^ICall_EntityID ICall_searchServiceEntity(.*)$/,/^}$/p' \
+    SensorTag_cc2640r2lp_app/ICall/icall.c > "$OUT/icall_lookup.inc"
+$CC $CFLAGS -O2 -I"$OUT" -o "$OUT/icall_lookup_bench" tests/host/icall_lookup_bench.c
+"$OUT/icall_lookup_bench"
+$CC $CFLAGS -O2 -I"$OUT" -DICALL_MAX_NUM_TASKS=8 -DICALL_MAX_NUM_ENTITIES=16 \
+    -o "$OUT/icall_lookup_bench_16" tests/host/icall_lookup_bench.c
+"$OUT/icall_lookup_bench_16"
+sed -n '/^#define ICALL_MSG_\(NEXT\|DEST_ID\)(/p; /^static void ICall_msgEnqueue(/,/^}$/p; /^static void \*ICall_msgDequeue(/,/^}$/p; /^static ICall_Errno ICall_primEntityId2ServiceId(/,/^}$/p; /^static void \*ICall_msgSearchMatch(/,/^}$/p' \
+    SensorTag_cc2640r2lp_app/ICall/icall.c > "$OUT/icall_match.inc"
+$CC $CFLAGS -O2 -I"$OUT" -o "$OUT/icall_match_stress" tests/host/icall_match_stress.c
+"$OUT/icall_match_stress"
+
+# The ICall-Lite caller side is extracted from icall.c and the stack side is
+# built without its includes, each in its own thread
+sed -n '/^static bool matchLiteCS(/,/^}$/p; /^static void icall_liteSendAndWait(/,/^}$/p; /^void icall_directAPIBatch(/,/^}$/p' \
+    SensorTag_cc2640r2lp_app/ICall/icall.c > "$OUT/icall_lite_caller.inc"
+sed '/^#include /d' Sensortag_cc2640r2lp_stack/ICallBLE/icall_lite_translation.c \
+    > "$OUT/icall_lite_translation_body.inc"
+$CC $CFLAGS -O2 -pthread -I"$OUT" -o "$OUT/icall_batch_sim" tests/host/icall_batch_sim.c
+"$OUT/icall_batch_sim"
+
+# TRNGCC26XX.c is built without its includes against a simulated TRNG,
+# with and without the entropy pool
+sed '/^#include /d' SensorTag_cc2640r2lp_app/Drivers/TRNG/TRNGCC26XX.c > "$OUT/trngcc26xx_body.inc"
+for words in 16 0; do
+  $CC $CFLAGS -I"$OUT" -ISensorTag_cc2640r2lp_app/Drivers/TRNG -DTRNGCC26XX_POOL_WORDS=$words \
+      -o "$OUT/trng_pool_sim_$words" tests/host/trng_pool_sim.c
+  "$OUT/trng_pool_sim_$words"
+done
+
+# osal_snv_wrapper.c is built without its includes against an emulated
+# one page NV, with and without the SNV cache
+sed '/^#include /d' Sensortag_cc2640r2lp_stack/OSAL/osal_snv_wrapper.c > "$OUT/osal_snv_wrapper_body.inc"
+for cache in "" -DOSAL_SNV_CACHE; do
+  $CC $CFLAGS -I"$OUT" $cache -o "$OUT/snv_cache_sim" tests/host/snv_cache_sim.c
+  "$OUT/snv_cache_sim"
+done
+
+# peripheral.c needs SDK headers, so its link size code is extracted as is
+PERIPHERAL=SensorTag_cc2640r2lp_app/PROFILES/peripheral.c
+sed -n '/^\/\/ Link size requested after connection/,/^#define DEFAULT_DATA_LEN_OCTETS/p; /^\/\/ Link size update passed on by the application/,/^} gapRole_linkSizeUpdate_t;/p; /^static uint16_t gapRole_\(AttMtu\|TxOctets\|RxOctets\) = /p; /^static gapRole_linkSizeUpdate_t gapRole_PendingLinkSize /p; /^static gapRolesLinkSizeCB_t \*pGapRoles_LinkSizeCB /p; /^void GAPRole_\(RegisterLinkSizeCB\|MtuUpdated\|DataLenUpdated\)(/,/^}$/p; /@fn      gapRole_startLinkSizeUpdate$/,${ /^static void gapRole_\(startLinkSizeUpdate\|setLinkSize\|postLinkSize\|processLinkSize\)(/,/^}$/p; }' \
+    $PERIPHERAL > "$OUT/peripheral_link_size.inc"
+for pdu in 27 69 251; do
+  $CC $CFLAGS -I"$OUT" -DMAX_PDU_SIZE=$pdu \
+      -o "$OUT/link_throughput_sim_$pdu" tests/host/link_throughput_sim.c
+  "$OUT/link_throughput_sim_$pdu"
+done
+
+$CC -std=gnu11 -Wall -ISensorTag_cc2640r2lp_app/ICall -o "$OUT/heapmgr_replay" tests/host/heapmgr_replay.c
+"$OUT/heapmgr_replay" tests/host/data/heapmgr_trace.txt
+
+# The ICall block pools are extracted from icall.c and icall.h as is and
+# replayed with the same trace, at the same RAM budget as the heap alone
+sed -n '/^#define ICALL_MSG_POOL_STORE_SIZE/,/^#else \/\* ICALL_MSG_POOLS \*\/$/{/^#else/d;p}' \
+    SensorTag_cc2640r2lp_app/ICall/icall.c > "$OUT/icall_pools.inc"
+sed -n '/^#ifdef ICALL_MSG_POOLS$/,/^#endif \/\* ICALL_MSG_POOLS \*\/$/p' \
+    SensorTag_cc2640r2lp_app/ICall/icall.h > "$OUT/icall_pools_cfg.inc"
+$CC -std=gnu11 -Wall -O2 -DICALL_MSG_POOLS -I"$OUT" -ISensorTag_cc2640r2lp_app/ICall -Itests/host \
+    -o "$OUT/icall_pool_replay" tests/host/icall_pool_replay.c
+"$OUT/icall_pool_replay" tests/host/data/heapmgr_trace.txt
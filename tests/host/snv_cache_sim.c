@@ -0,0 +1,427 @@
+/*
+ * Host simulation of the one page SNV wrapper in
+ * Sensortag_cc2640r2lp_stack/OSAL/osal_snv_wrapper.c, counting the flash
+ * writes and compactions caused by the bond manager's NV traffic, with
+ * and without OSAL_SNV_CACHE.
+ *
+ * osal_snv_wrapper.c includes nvocop.c from the SDK, so it is compiled with
+ * its #include lines removed against an emulated NVOCOP: one flash page to
+ * which every item write appends the item behind a header, and which is
+ * compacted (the latest copy of each item kept, the page erased and
+ * rewritten) when an item no longer fits.
+ *
+ * Bonded phones connect and disconnect. On the way they pair now and then,
+ * rewrite their CCCs, write signed data that bumps their sign counter
+ * a few times per connection event, and an application item too large for
+ * the cache is saved. osal_snv_flush() is called whenever the simulated
+ * OSAL loop goes idle, as osal_run_system does. The checks cover:
+ * - every read returns what was last written;
+ * - after each flush the page holds what was last written;
+ * - a reset through SystemReset, which flushes, loses nothing.
+ * It prints the item writes, bytes programmed, compactions and flash reads.
+ *
+ * Build and run from the repository root, with and without the cache:
+ *   mkdir -p _host_tests
+ *   sed '/^#include /d' Sensortag_cc2640r2lp_stack/OSAL/osal_snv_wrapper.c > _host_tests/osal_snv_wrapper_body.inc
+ *   gcc -std=gnu99 -Wall -Itests/host/stubs -I_host_tests -DOSAL_SNV_CACHE \
+ *       -o _host_tests/snv_cache_sim tests/host/snv_cache_sim.c
+ *   _host_tests/snv_cache_sim
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+
+#define OSAL_SNV                1
+
+#define SUCCESS                 0x00
+#define NV_OPER_FAILED          0x0A
+
+#define NUM_CONNECTIONS         2000
+
+static int failures = 0;
+
+#define CHECK( _cond, ... )                 \
+  do                                        \
+  {                                         \
+    if ( !( _cond ) && failures++ < 10 )    \
+    {                                       \
+      printf( "FAIL: " );                   \
+      printf( __VA_ARGS__ );                \
+      printf( "\n" );                       \
+    }                                       \
+  } while ( 0 )
+
+typedef uint8 osalSnvId_t;
+typedef uint8 osalSnvLen_t;
+
+#define osal_memcpy             memcpy
+
+#if defined(OSAL_SNV_CACHE)
+static uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+#endif // OSAL_SNV_CACHE
+
+/*
+ * NVOCOP: items are appended to the page, each behind a 4 byte header and
+ * padded to a word. The latest copy of an item is the valid one.
+ */
+#define NVINTF_SUCCESS          0
+#define NVINTF_NOTFOUND         2
+#define NVINTF_BADPARAM         3
+#define NVINTF_BADLENGTH        4
+#define NVINTF_FAILURE          6
+#define NVINTF_SYSID_NVDRVR     1
+
+#define FLASH_PAGE_SIZE         4096
+#define NV_HDR_SIZE             4
+#define NV_ITEM_SIZE(_len)      ( NV_HDR_SIZE + ( ( (_len) + 3 ) & ~3 ) )
+
+typedef struct
+{
+  uint8 systemID;
+  uint16 itemID;
+  uint16 subID;
+} NVINTF_itemID_t;
+
+static uint8 nvPage[FLASH_PAGE_SIZE];
+static unsigned nvUsed;
+
+static struct
+{
+  unsigned long itemWrites;
+  unsigned long bytesProgrammed;
+  unsigned long compactions;
+  unsigned long reads;
+} nvStats;
+
+// Offset of the latest copy of an item, -1 if none
+static int nvFind( uint8 id )
+{
+  int found = -1;
+  unsigned offset = 0;
+
+  while ( offset < nvUsed )
+  {
+    if ( nvPage[offset] == id )
+    {
+      found = offset;
+    }
+    offset += NV_ITEM_SIZE( nvPage[offset + 1] );
+  }
+  return ( found );
+}
+
+static void nvAppend( uint8 id, uint8 len, const void *pBuf )
+{
+  nvPage[nvUsed] = id;
+  nvPage[nvUsed + 1] = len;
+  memcpy( &nvPage[nvUsed + NV_HDR_SIZE], pBuf, len );
+  nvUsed += NV_ITEM_SIZE( len );
+}
+
+static void nvCompact( void )
+{
+  static uint8 scratch[FLASH_PAGE_SIZE];
+  unsigned used = nvUsed;
+  unsigned offset = 0;
+
+  memcpy( scratch, nvPage, used );
+  nvUsed = 0;
+  nvStats.compactions++;
+
+  while ( offset < used )
+  {
+    uint8 id = scratch[offset];
+    uint8 len = scratch[offset + 1];
+    unsigned next = offset + NV_ITEM_SIZE( len );
+    unsigned later = next;
+
+    // Keep the copy only if no later one follows
+    while ( later < used && scratch[later] != id )
+    {
+      later += NV_ITEM_SIZE( scratch[later + 1] );
+    }
+    if ( later >= used )
+    {
+      nvAppend( id, len, &scratch[offset + NV_HDR_SIZE] );
+      nvStats.bytesProgrammed += NV_ITEM_SIZE( len );
+    }
+    offset = next;
+  }
+}
+
+static uint8 NVOCOP_initNV( void *param )
+{
+  return ( NVINTF_SUCCESS );
+}
+
+static uint8 NVOCOP_readItem( NVINTF_itemID_t id, uint16 offset, uint16 len,
+                              void *pBuf )
+{
+  int found = nvFind( (uint8) id.itemID );
+
+  nvStats.reads++;
+  if ( found < 0 )
+  {
+    return ( NVINTF_NOTFOUND );
+  }
+  if ( offset + len > nvPage[found + 1] )
+  {
+    return ( NVINTF_BADLENGTH );
+  }
+  memcpy( pBuf, &nvPage[found + NV_HDR_SIZE + offset], len );
+  return ( NVINTF_SUCCESS );
+}
+
+static uint8 NVOCOP_writeItem( NVINTF_itemID_t id, uint16 len, void *pBuf )
+{
+  if ( nvUsed + NV_ITEM_SIZE( len ) > FLASH_PAGE_SIZE )
+  {
+    nvCompact();
+    if ( nvUsed + NV_ITEM_SIZE( len ) > FLASH_PAGE_SIZE )
+    {
+      return ( NVINTF_FAILURE );
+    }
+  }
+  nvAppend( (uint8) id.itemID, (uint8) len, pBuf );
+  nvStats.itemWrites++;
+  nvStats.bytesProgrammed += NV_ITEM_SIZE( len );
+  return ( NVINTF_SUCCESS );
+}
+
+// Compacts if fewer than minAvail bytes are free
+static uint8 NVOCOP_compactNV( uint16 minAvail )
+{
+  if ( FLASH_PAGE_SIZE - nvUsed < minAvail )
+  {
+    nvCompact();
+  }
+  return ( NVINTF_SUCCESS );
+}
+
+#include "osal_snv_wrapper_body.inc"
+
+/*
+ * The bond manager's NV items, as laid out by gapbondmgr.c for 5 bonds
+ */
+#define NUM_BONDS               5
+#define BOND_REC_IDS            6
+#define NV_BOND_START           0x20
+#define NV_LRU_LIST             0x10
+#define NV_APP_ITEM             0x11
+
+#define mainRecordNvID(b)       ( NV_BOND_START + (b) * BOND_REC_IDS + 0 )
+#define localLTKNvID(b)         ( NV_BOND_START + (b) * BOND_REC_IDS + 1 )
+#define devLTKNvID(b)           ( NV_BOND_START + (b) * BOND_REC_IDS + 2 )
+#define devIRKNvID(b)           ( NV_BOND_START + (b) * BOND_REC_IDS + 3 )
+#define devCSRKNvID(b)          ( NV_BOND_START + (b) * BOND_REC_IDS + 4 )
+#define devSignCounterNvID(b)   ( NV_BOND_START + (b) * BOND_REC_IDS + 5 )
+#define gattCfgNvID(b)          ( NV_BOND_START + NUM_BONDS * BOND_REC_IDS + (b) )
+
+#define BOND_REC_LEN            14
+#define LTK_LEN                 28
+#define KEYLEN                  16
+#define CHAR_CFG_LEN            12
+#define APP_ITEM_LEN            64
+
+// What was last written, by NV ID
+static uint8 model[256][APP_ITEM_LEN];
+static uint8 modelLen[256];
+
+static void nvWrite( uint8 id, uint8 len, void *pBuf )
+{
+  CHECK( osal_snv_write( id, len, pBuf ) == SUCCESS, "write of 0x%02X failed",
+         id );
+  memcpy( model[id], pBuf, len );
+  modelLen[id] = len;
+}
+
+static void nvRead( uint8 id, uint8 len, void *pBuf )
+{
+  CHECK( osal_snv_read( id, len, pBuf ) == SUCCESS, "read of 0x%02X failed",
+         id );
+  CHECK( memcmp( pBuf, model[id], len ) == 0, "read of 0x%02X is stale", id );
+}
+
+// The page holds what was last written
+static void checkPage( const char *pWhen )
+{
+  unsigned id;
+
+  for ( id = 0; id < 256; id++ )
+  {
+    int found = nvFind( (uint8) id );
+
+    if ( modelLen[id] == 0 )
+    {
+      continue;
+    }
+    CHECK( found >= 0 && nvPage[found + 1] == modelLen[id] &&
+           memcmp( &nvPage[found + NV_HDR_SIZE], model[id], modelLen[id] ) == 0,
+           "item 0x%02X not in NV %s", id, pWhen );
+  }
+}
+
+// The OSAL loop finds no event pending
+static void osalIdle( void )
+{
+#if defined(OSAL_SNV_CACHE)
+  VOID osal_snv_flush();
+  checkPage( "after a flush" );
+#endif // OSAL_SNV_CACHE
+}
+
+// SystemReset() of onboard.h; the RAM contents are lost
+static void systemReset( void )
+{
+#if defined(OSAL_SNV_CACHE)
+  VOID osal_snv_flush();
+  memset( osalSnvCache, 0, sizeof( osalSnvCache ) );
+#endif // OSAL_SNV_CACHE
+  checkPage( "after a reset" );
+}
+
+static void fill( uint8 *pBuf, uint8 len )
+{
+  uint8 i;
+
+  for ( i = 0; i < len; i++ )
+  {
+    pBuf[i] = (uint8) rand();
+  }
+}
+
+// gapBondMgrAddBond: the bond record and keys of a new bond
+static void pair( uint8 bond )
+{
+  uint8 buf[APP_ITEM_LEN];
+  uint32 zero = 0;
+
+  fill( buf, BOND_REC_LEN );
+  nvWrite( mainRecordNvID( bond ), BOND_REC_LEN, buf );
+  fill( buf, LTK_LEN );
+  nvWrite( localLTKNvID( bond ), LTK_LEN, buf );
+  fill( buf, LTK_LEN );
+  nvWrite( devLTKNvID( bond ), LTK_LEN, buf );
+  fill( buf, KEYLEN );
+  nvWrite( devIRKNvID( bond ), KEYLEN, buf );
+  fill( buf, KEYLEN );
+  nvWrite( devCSRKNvID( bond ), KEYLEN, buf );
+  nvWrite( devSignCounterNvID( bond ), sizeof( uint32 ), &zero );
+  memset( buf, 0, CHAR_CFG_LEN );
+  nvWrite( gattCfgNvID( bond ), CHAR_CFG_LEN, buf );
+}
+
+int main( void )
+{
+  uint8 lru[NUM_BONDS];
+  uint8 buf[APP_ITEM_LEN];
+  uint8 last = NUM_BONDS;
+  int conn;
+  uint8 b;
+
+  srand( 1 );
+
+  osal_snv_init();
+  for ( b = 0; b < NUM_BONDS; b++ )
+  {
+    pair( b );
+    lru[b] = b;
+  }
+  nvWrite( NV_LRU_LIST, NUM_BONDS, lru );
+  fill( buf, APP_ITEM_LEN );
+  nvWrite( NV_APP_ITEM, APP_ITEM_LEN, buf );
+  osalIdle();
+  systemReset();
+
+  memset( &nvStats, 0, sizeof( nvStats ) );
+
+  for ( conn = 0; conn < NUM_CONNECTIONS; conn++ )
+  {
+    // Mostly the same phone as last time
+    uint8 bond = ( rand() % 4 && last < NUM_BONDS ) ? last : rand() % NUM_BONDS;
+    uint32 signCounter;
+    int events = 20 + rand() % 40;
+    int e;
+
+    if ( rand() % 50 == 0 )
+    {
+      pair( bond );
+      osalIdle();
+    }
+
+    // Reconnection: keys read, the bond moves to the front of the LRU list
+    nvRead( devLTKNvID( bond ), LTK_LEN, buf );
+    nvRead( gattCfgNvID( bond ), CHAR_CFG_LEN, buf );
+    for ( b = 0; lru[b] != bond; b++ );
+    memmove( &lru[1], &lru[0], b );
+    lru[0] = bond;
+    nvWrite( NV_LRU_LIST, NUM_BONDS, lru );
+    osalIdle();
+
+    // The phone rewrites its CCCs, mostly with the same values
+    nvRead( gattCfgNvID( bond ), CHAR_CFG_LEN, buf );
+    if ( rand() % 8 == 0 )
+    {
+      buf[rand() % CHAR_CFG_LEN] ^= 1;
+    }
+    nvWrite( gattCfgNvID( bond ), CHAR_CFG_LEN, buf );
+    osalIdle();
+
+    // Signed writes: GAP_EVENT_SIGN_COUNTER_CHANGED for each, several per
+    // connection event
+    for ( e = 0; e < events; e++ )
+    {
+      int writes = rand() % 5;
+
+      while ( writes-- )
+      {
+        nvRead( devSignCounterNvID( bond ), sizeof( uint32 ), &signCounter );
+        signCounter++;
+        nvWrite( devSignCounterNvID( bond ), sizeof( uint32 ), &signCounter );
+      }
+      osalIdle();
+    }
+
+    // Now and then the application saves an item too large for the cache
+    if ( rand() % 10 == 0 )
+    {
+      fill( buf, APP_ITEM_LEN );
+      nvWrite( NV_APP_ITEM, APP_ITEM_LEN, buf );
+      osalIdle();
+    }
+
+    if ( rand() % 100 == 0 )
+    {
+      systemReset();
+    }
+    last = bond;
+  }
+
+  osalIdle();
+  systemReset();
+
+#if defined(OSAL_SNV_CACHE)
+  printf( "SNV with a cache of %d items of up to %d bytes, %d connections\n",
+          OSAL_SNV_CACHE_ENTRIES, OSAL_SNV_CACHE_ITEM_LEN, NUM_CONNECTIONS );
+#else // !OSAL_SNV_CACHE
+  printf( "SNV without a cache, %d connections\n", NUM_CONNECTIONS );
+#endif // OSAL_SNV_CACHE
+  printf( "  item writes %8lu\n", nvStats.itemWrites );
+  printf( "  programmed  %8lu bytes\n", nvStats.bytesProgrammed );
+  printf( "  compactions %8lu\n", nvStats.compactions );
+  printf( "  flash reads %8lu\n", nvStats.reads );
+
+  if ( failures )
+  {
+    return ( 1 );
+  }
+
+  printf( "snv_cache_sim: OK\n" );
+
+  return ( 0 );
+}
@@ -0,0 +1,26 @@
+/* Host stand-in for the SDK hal_types.h, enough for the host tests. */
+#ifndef HAL_TYPES_H
+#define HAL_TYPES_H
+
+#include <stdint.h>
+
+typedef int8_t   int8;
+typedef uint8_t  uint8;
+typedef int16_t  int16;
+typedef uint16_t uint16;
+typedef int32_t  int32;
+typedef uint32_t uint32;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef VOID
+#define VOID (void)
+#endif
+
+#endif /* HAL_TYPES_H */
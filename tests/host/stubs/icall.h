@@ -0,0 +1,20 @@
+/* Host stand-in for icall.h, enough for Startup/icall_startup.c. */
+#ifndef ICALL_H
+#define ICALL_H
+
+typedef int (*ICall_Dispatcher)(void *args);
+typedef unsigned (*ICall_EnterCS)(void);
+typedef void (*ICall_LeaveCS)(unsigned key);
+
+typedef struct
+{
+  ICall_Dispatcher dispatch;
+  ICall_EnterCS    entercs;
+  ICall_LeaveCS    leavecs;
+} ICall_RemoteTaskArg;
+
+extern ICall_Dispatcher ICall_dispatcher;
+extern ICall_EnterCS    ICall_enterCriticalSection;
+extern ICall_LeaveCS    ICall_leaveCriticalSection;
+
+#endif /* ICALL_H */
@@ -0,0 +1 @@
+/* Host stand-in for the SDK rom_jt.h: no ROM jump table on the host. */
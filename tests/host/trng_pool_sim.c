@@ -0,0 +1,403 @@
+/*
+ * Host simulation of the TRNG driver in
+ * SensorTag_cc2640r2lp_app/Drivers/TRNG/TRNGCC26XX.c, measuring how long
+ * it keeps hardware interrupts disabled.
+ *
+ * TRNGCC26XX.c is compiled with its #include lines removed against a
+ * simulated CPU clock, TRNG peripheral, Hwi module and power manager. The
+ * simulated TRNG takes maxSamples * (clocksPerSample + 1) * 16 cycles per
+ * number, so 8192 cycles (171 us at 48 MHz) with the default settings,
+ * and tags every number with the settings it was generated with. The
+ * simulation issues random requests with idle time in between: default
+ * numbers, numbers with other settings and byte strings. It checks:
+ * - every number is returned once, generated with the settings asked for
+ *   (the pool is refilled with the default settings after a request with
+ *   other ones);
+ * - the TRNG is powered whenever it runs, and standby is only held off
+ *   while the pool is refilled.
+ * It prints the longest and the average time interrupts stay disabled per
+ * request. Build with -DTRNGCC26XX_POOL_WORDS=0 for the driver without the
+ * pool.
+ *
+ * Build and run from the repository root:
+ *   mkdir -p _host_tests
+ *   sed '/^#include /d' SensorTag_cc2640r2lp_app/Drivers/TRNG/TRNGCC26XX.c > _host_tests/trngcc26xx_body.inc
+ *   gcc -std=gnu99 -Wall -I_host_tests -ISensorTag_cc2640r2lp_app/Drivers/TRNG \
+ *       -o _host_tests/trng_pool_sim tests/host/trng_pool_sim.c
+ *   _host_tests/trng_pool_sim
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TRNGCC26XX.h"
+
+#define NUM_REQUESTS            20000
+#define CPU_MHZ                 48
+
+// Cycles a register access or a status poll takes
+#define REG_CYCLES              4
+#define POLL_CYCLES             8
+
+#ifndef TRUE
+#define TRUE                    1
+#define FALSE                   0
+#endif
+
+// Tags of the settings a number was generated with
+#define TAG_DEFAULT             1
+#define TAG_OTHER               2
+
+static unsigned long long simNow;
+
+static void simAdvance(unsigned cycles)
+{
+  simNow += cycles;
+}
+
+static int failures = 0;
+
+#define CHECK(_cond, _msg)                                              \
+  do                                                                    \
+  {                                                                     \
+    if (!(_cond) && failures++ < 10)                                    \
+    {                                                                   \
+      printf("FAIL at cycle %llu: %s\n", simNow, _msg);                 \
+    }                                                                   \
+  } while (0)
+
+/*
+ * Hwi: one interrupt line, the TRNG's. Interrupts disabled are timed.
+ * The peripheral stand-ins are not static: without the pool the driver
+ * does not call all of them.
+ */
+typedef unsigned long UArg;
+typedef unsigned int UInt;
+typedef void (*Hwi_FuncPtr)(UArg arg);
+typedef struct { int unused; } Hwi_Struct;
+typedef struct { int priority; } Hwi_Params;
+
+#define INT_TRNG_IRQ            48
+
+static Hwi_FuncPtr hwiFxn;
+static UInt hwiEnabled = TRUE;
+static unsigned long long hwiOffSince;
+static unsigned long long hwiOffLongest;   // Longest stretch, this request
+static unsigned long long hwiOffTotal;     // All stretches, this request
+
+void Hwi_Params_init(Hwi_Params *params)
+{
+  params->priority = ~0;
+}
+
+void Hwi_construct(Hwi_Struct *hwi, int intNum, Hwi_FuncPtr fxn,
+                   Hwi_Params *params, void *eb)
+{
+  hwiFxn = fxn;
+}
+
+UInt Hwi_disable(void)
+{
+  UInt key = hwiEnabled;
+
+  if (hwiEnabled)
+  {
+    hwiEnabled = FALSE;
+    hwiOffSince = simNow;
+  }
+
+  return (key);
+}
+
+void Hwi_restore(UInt key)
+{
+  if (key && !hwiEnabled)
+  {
+    unsigned long long off = simNow - hwiOffSince;
+
+    hwiOffTotal += off;
+    if (off > hwiOffLongest)
+    {
+      hwiOffLongest = off;
+    }
+    hwiEnabled = TRUE;
+  }
+}
+
+/*
+ * Power manager: the TRNG dependency and the standby constraint.
+ */
+#define PowerCC26XX_PERIPH_TRNG     5
+#define PowerCC26XX_SB_DISALLOW     1
+
+static int trngDependency;
+static int standbyConstraint;
+
+void Power_setDependency(int id)
+{
+  trngDependency++;
+}
+
+void Power_releaseDependency(int id)
+{
+  trngDependency--;
+}
+
+void Power_setConstraint(int id)
+{
+  standbyConstraint++;
+}
+
+void Power_releaseConstraint(int id)
+{
+  standbyConstraint--;
+}
+
+/*
+ * TRNG peripheral. Reading a number starts the next one.
+ */
+#define TRNG_NUMBER_READY       0x00000001
+#define TRNG_LOW_WORD           0
+
+static struct
+{
+  unsigned minSamples;
+  unsigned maxSamples;
+  unsigned clocksPerSample;
+  int enabled;
+  int intEnabled;
+  unsigned long long readyAt;
+  unsigned serial;
+} trng;
+
+static unsigned trngTag(void)
+{
+  return ((trng.maxSamples == 256 && trng.clocksPerSample == 1) ?
+          TAG_DEFAULT : TAG_OTHER);
+}
+
+static void trngStart(void)
+{
+  CHECK(trngDependency > 0, "TRNG runs unpowered");
+  trng.readyAt = simNow + trng.maxSamples * (trng.clocksPerSample + 1) * 16;
+}
+
+void TRNGConfigure(uint32_t minSamples, uint32_t maxSamples,
+                   uint32_t clocksPerSample)
+{
+  simAdvance(REG_CYCLES);
+  trng.minSamples = minSamples;
+  trng.maxSamples = maxSamples;
+  trng.clocksPerSample = clocksPerSample;
+  trng.enabled = FALSE;
+}
+
+void TRNGEnable(void)
+{
+  simAdvance(REG_CYCLES);
+  trng.enabled = TRUE;
+  trngStart();
+}
+
+void TRNGDisable(void)
+{
+  simAdvance(REG_CYCLES);
+  trng.enabled = FALSE;
+}
+
+uint32_t TRNGStatusGet(void)
+{
+  simAdvance(POLL_CYCLES);
+
+  return ((trng.enabled && simNow >= trng.readyAt) ? TRNG_NUMBER_READY : 0);
+}
+
+uint32_t TRNGNumberGet(uint32_t word)
+{
+  uint32_t value;
+
+  simAdvance(REG_CYCLES);
+  CHECK(trng.enabled && simNow >= trng.readyAt, "number read before ready");
+  value = (++trng.serial << 8) | trngTag();
+  trngStart();
+
+  return (value);
+}
+
+void TRNGIntClear(uint32_t flags)
+{
+  simAdvance(REG_CYCLES);
+}
+
+void TRNGIntEnable(uint32_t flags)
+{
+  simAdvance(REG_CYCLES);
+  trng.intEnabled = TRUE;
+}
+
+void TRNGIntDisable(uint32_t flags)
+{
+  simAdvance(REG_CYCLES);
+  trng.intEnabled = FALSE;
+}
+
+static TRNGCC26XX_Object trngObject;
+static const TRNGCC26XX_HWAttrs trngHWAttrs = { PowerCC26XX_PERIPH_TRNG };
+const TRNGCC26XX_Config TRNGCC26XX_config[] =
+{
+  { &trngObject, &trngHWAttrs }
+};
+
+#include "trngcc26xx_body.inc"
+
+/*
+ * Let time pass with interrupts enabled, taking the TRNG interrupt
+ * whenever a number is ready.
+ */
+static void simIdle(unsigned long long cycles)
+{
+  unsigned long long end = simNow + cycles;
+
+  while (trng.enabled && trng.intEnabled && (trng.readyAt <= end))
+  {
+    if (trng.readyAt > simNow)
+    {
+      simNow = trng.readyAt;
+    }
+    simAdvance(12);   // Interrupt entry
+    hwiFxn(0);
+  }
+
+  if (simNow < end)
+  {
+    simNow = end;
+  }
+
+  CHECK(standbyConstraint == (trng.intEnabled ? 1 : 0),
+        "standby held off without a refill");
+}
+
+static unsigned char seen[NUM_REQUESTS * 8 + 256];
+
+static void checkNumber(uint32_t value, unsigned tag)
+{
+  unsigned serial = value >> 8;
+
+  CHECK((value & 0xFF) == tag, "number generated with the wrong settings");
+  CHECK(serial < sizeof(seen) && !seen[serial], "number returned twice");
+  if (serial < sizeof(seen))
+  {
+    seen[serial] = 1;
+  }
+}
+
+typedef struct
+{
+  const char *name;
+  unsigned long count;
+  unsigned long long longest;
+  unsigned long long total;
+} stats_t;
+
+static void account(stats_t *pStats)
+{
+  pStats->count++;
+  pStats->total += hwiOffTotal;
+  if (hwiOffLongest > pStats->longest)
+  {
+    pStats->longest = hwiOffLongest;
+  }
+}
+
+static void printStats(const stats_t *pStats)
+{
+  if (pStats->count == 0)
+  {
+    return;
+  }
+
+  printf("  %-16s %6lu %9.1f %9.1f\n", pStats->name, pStats->count,
+         (double)pStats->longest / CPU_MHZ,
+         (double)pStats->total / pStats->count / CPU_MHZ);
+}
+
+int main(void)
+{
+  stats_t defaults = { "default number" };
+  stats_t others = { "other settings" };
+  stats_t bytes = { "16 bytes" };
+  TRNGCC26XX_Params params;
+  TRNGCC26XX_Handle handle;
+  int8_t status;
+  int i;
+
+  srand(1);
+
+  TRNGCC26XX_init();
+  handle = TRNGCC26XX_open(0);
+
+  for (i = 0; i < NUM_REQUESTS; i++)
+  {
+    int kind = rand() % 20;
+
+    // Between requests: 0 to 2 ms, sometimes right after the previous one
+    simIdle((rand() % 4 == 0) ? 0 : (unsigned)(rand() % 2000) * CPU_MHZ);
+
+    hwiOffLongest = 0;
+    hwiOffTotal = 0;
+
+    if (kind < 17)
+    {
+      TRNGCC26XX_Params_init(&params);
+      checkNumber(TRNGCC26XX_getNumber(handle, (kind < 15) ? NULL : &params,
+                                       &status), TAG_DEFAULT);
+      CHECK(status == TRNGCC26XX_STATUS_SUCCESS, "default number failed");
+      account(&defaults);
+    }
+    else if (kind < 19)
+    {
+      uint32_t words[4];
+      int k;
+
+      CHECK(TRNGCC26XX_getBytes(handle, (uint8_t *)words, sizeof(words)) ==
+            TRNGCC26XX_STATUS_SUCCESS, "bytes failed");
+      for (k = 0; k < 4; k++)
+      {
+        checkNumber(words[k], TAG_DEFAULT);
+      }
+      account(&bytes);
+    }
+    else
+    {
+      params.minSamplesPerCycle = 256;
+      params.maxSamplesPerCycle = 512;
+      params.clocksPerSample = 0;
+      checkNumber(TRNGCC26XX_getNumber(handle, &params, &status), TAG_OTHER);
+      CHECK(status == TRNGCC26XX_STATUS_SUCCESS, "other settings failed");
+      account(&others);
+    }
+
+    CHECK(hwiEnabled, "interrupts left disabled");
+  }
+
+  simIdle(100 * CPU_MHZ);
+  TRNGCC26XX_close(handle);
+  CHECK(standbyConstraint == 0, "standby still held off after close");
+  CHECK(trngDependency == 0, "TRNG still powered after close");
+
+  printf("TRNG pool of %d words; interrupts disabled per request, us\n",
+         TRNGCC26XX_POOL_WORDS);
+  printf("  request           count   longest   average\n");
+  printStats(&defaults);
+  printStats(&others);
+  printStats(&bytes);
+
+  if (failures)
+  {
+    return (1);
+  }
+
+  printf("trng_pool_sim: OK\n");
+
+  return (0);
+}